@@ -131,7 +131,7 @@ class PostTodoHandler : public http::router::RouterHandler
 public:
     void handle(const http::HttpRequest& req, http::HttpResponse* resp) override
     {
-        std::string text = parseTextField(req.getBody());
+        std::string text = parseTextField(std::string(req.getBody()));
         if (text.empty())
         {
             resp->setStatusLine("HTTP/1.1", http::HttpResponse::k400BadRequest, "Bad Request");
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <muduo/net/EventLoop.h>
+
+#include "../http/HttpResponse.h"
+#include "../http/WorkerPool.h"
+
+namespace http
+{
+namespace coro
+{
+
+namespace detail
+{
+
+// void 的结果用一个占位类型存，省得每个 awaiter 都特化一遍
+template <typename T>
+using Stored = std::conditional_t<std::is_void_v<T>, bool, T>;
+
+inline HttpResponse serviceUnavailable()
+{
+    HttpResponse response;
+    response.setStatusCode(HttpResponse::k503ServiceUnavailable);
+    response.setContentType("application/json");
+    response.setBody(std::string(R"({"error":"server busy"})"));
+    return response;
+}
+
+// 协程当前所在的 EventLoop；只能在 I/O 线程里 co_await
+inline muduo::net::EventLoop* currentLoop()
+{
+    muduo::net::EventLoop* loop = muduo::net::EventLoop::getEventLoopOfCurrentThread();
+    assert(loop != nullptr);
+    return loop;
+}
+
+} // namespace detail
+
+/*
+    co_await runBlocking(pool, fn)：fn 在工作线程池里执行（查 MySQL、redis++ 的同步调用、curl 请求上游），
+    I/O 线程在此期间照常服务其他连接；fn 返回后协程回到原来的 EventLoop 继续，结果或异常原样带回。
+      - pool 为空（没有配置工作线程）时 fn 直接在当前线程执行，行为和同步调用一样
+      - 工作线程的队列满时不执行 fn，抛出 503 的 HttpResponse（CoroutineHandler 会把它作为响应）
+ */
+template <typename F>
+class BlockingAwaiter
+{
+public:
+    using Result = std::invoke_result_t<F&>;
+
+    BlockingAwaiter(WorkerPool* pool, F fn)
+        : pool_(pool)
+        , fn_(std::move(fn))
+        , busy_(false)
+    {}
+
+    bool await_ready() const noexcept
+    { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        if (!pool_)
+        {
+            invoke();
+            return false;
+        }
+        muduo::net::EventLoop* loop = detail::currentLoop();
+        // awaiter 在协程帧里，协程恢复之前一直有效
+        if (!pool_->tryRun([this, loop, h]()
+        {
+            invoke();
+            loop->queueInLoop([h]() { h.resume(); });
+        }))
+        {
+            busy_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    Result await_resume()
+    {
+        if (busy_)
+        {
+            throw detail::serviceUnavailable();
+        }
+        if (exception_)
+        {
+            std::rethrow_exception(exception_);
+        }
+        if constexpr (!std::is_void_v<Result>)
+        {
+            return std::move(*result_);
+        }
+    }
+
+private:
+    void invoke()
+    {
+        try
+        {
+            if constexpr (std::is_void_v<Result>)
+            {
+                fn_();
+            }
+            else
+            {
+                result_.emplace(fn_());
+            }
+        }
+        catch (...)
+        {
+            exception_ = std::current_exception();
+        }
+    }
+
+private:
+    WorkerPool*                             pool_;
+    F                                       fn_;
+    bool                                    busy_;
+    std::optional<detail::Stored<Result>>   result_;
+    std::exception_ptr                      exception_;
+};
+
+template <typename F>
+BlockingAwaiter<F> runBlocking(WorkerPool* pool, F fn)
+{
+    return BlockingAwaiter<F>(pool, std::move(fn));
+}
+
+/*
+    co_await callback<T>(start)：把回调式的异步接口接进协程。
+    start 收到一个 done(T) 函数，发起异步操作后立即返回；done 可以在任意线程调用（只有第一次有效），
+    协程随后在原来的 EventLoop 上恢复，co_await 的值就是传给 done 的值。
+    T 为 void 时 done 不带参数。
+ */
+template <typename T, typename Start>
+class CallbackAwaiter
+{
+public:
+    explicit CallbackAwaiter(Start start)
+        : start_(std::move(start))
+    {}
+
+    bool await_ready() const noexcept
+    { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        // done 可能被异步操作拷贝、晚于协程结束才析构，状态放在共享的 State 里
+        auto state = std::make_shared<State>();
+        state->loop = detail::currentLoop();
+        state->handle = h;
+        state_ = state;
+        if constexpr (std::is_void_v<T>)
+        {
+            start_([state]() { state->finish(true); });
+        }
+        else
+        {
+            start_([state](T value) { state->finish(std::move(value)); });
+        }
+    }
+
+    T await_resume()
+    {
+        if constexpr (!std::is_void_v<T>)
+        {
+            return std::move(*state_->result);
+        }
+    }
+
+private:
+    struct State
+    {
+        muduo::net::EventLoop*                loop;
+        std::coroutine_handle<>               handle;
+        std::atomic<bool>                     called { false };
+        std::optional<detail::Stored<T>>      result;
+
+        void finish(detail::Stored<T> value)
+        {
+            if (called.exchange(true))
+            {
+                return;
+            }
+            result.emplace(std::move(value));
+            std::coroutine_handle<> h = handle;
+            loop->queueInLoop([h]() { h.resume(); });
+        }
+    };
+
+    Start                   start_;
+    std::shared_ptr<State>  state_;
+};
+
+template <typename T, typename Start>
+CallbackAwaiter<T, Start> callback(Start start)
+{
+    return CallbackAwaiter<T, Start>(std::move(start));
+}
+
+} // namespace coro
+} // namespace http
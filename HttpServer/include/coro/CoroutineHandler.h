@@ -0,0 +1,41 @@
+#pragma once
+
+#include <muduo/net/TcpConnection.h>
+
+#include "Awaitables.h"
+#include "Task.h"
+#include "../router/RouterHandler.h"
+
+namespace http
+{
+namespace coro
+{
+
+/*
+    协程 handler：实现 handleAsync()，在里面 co_await runBlocking(...) / callback<T>(...) 等待数据库、
+    Redis、上游服务，不阻塞 I/O 线程，也不用另起线程、层层嵌套回调。
+      - 协程始终在连接所在的 I/O 线程上执行，可以直接读写 req、resp
+      - 第一次挂起时响应变成延迟完成（DeferredResponse），协程结束后才执行后置中间件并发送；
+        一次都没挂起的请求和普通 handler 完全一样
+      - 协程里抛出的 HttpResponse 直接作为响应，其他异常回 500
+    注意：conn 按值传入，协程挂起后依然有效；不要在协程里持有调用方传进来的其他引用
+ */
+class CoroutineHandler : public router::RouterHandler
+{
+public:
+    void handle(const muduo::net::TcpConnectionPtr& conn,
+                const HttpRequest& req,
+                HttpResponse* resp) final;
+
+    // 协程自己负责不阻塞 I/O 线程，不能再交给工作线程池
+    bool offload() const final
+    { return false; }
+
+protected:
+    virtual Task<> handleAsync(muduo::net::TcpConnectionPtr conn,
+                               const HttpRequest& req,
+                               HttpResponse* resp) = 0;
+};
+
+} // namespace coro
+} // namespace http
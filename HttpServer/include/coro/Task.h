@@ -0,0 +1,182 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace http
+{
+namespace coro
+{
+
+template <typename T>
+class Task;
+
+namespace detail
+{
+
+struct PromiseBase
+{
+    // 结束时直接切回等待者（对称转移），嵌套再深也不会在栈上堆积 resume 调用
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+        {
+            std::coroutine_handle<> continuation = h.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept
+    { return {}; }
+
+    FinalAwaiter final_suspend() const noexcept
+    { return {}; }
+
+    void unhandled_exception() noexcept
+    { exception_ = std::current_exception(); }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr      exception_;
+};
+
+template <typename T>
+struct Promise : PromiseBase
+{
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value)
+    { value_.emplace(std::forward<U>(value)); }
+
+    T result()
+    {
+        if (exception_)
+        {
+            std::rethrow_exception(exception_);
+        }
+        return std::move(*value_);
+    }
+
+    std::optional<T> value_;
+};
+
+template <>
+struct Promise<void> : PromiseBase
+{
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void result()
+    {
+        if (exception_)
+        {
+            std::rethrow_exception(exception_);
+        }
+    }
+};
+
+} // namespace detail
+
+/*
+    协程 handler 的返回类型：惰性启动，被 co_await 时才开始执行，结束后回到等待它的协程。
+    不带调度器 —— 在哪个线程被恢复就在哪个线程继续；本库的 awaitable（runBlocking 等）
+    都把协程恢复到发起它的 EventLoop 上，所以整个协程始终在同一个 I/O 线程里执行。
+    异常沿着 co_await 链向上传播。
+ */
+template <typename T = void>
+class Task
+{
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() noexcept = default;
+
+    explicit Task(Handle handle) noexcept
+        : handle_(handle)
+    {}
+
+    Task(Task&& that) noexcept
+        : handle_(std::exchange(that.handle_, nullptr))
+    {}
+
+    Task& operator=(Task&& that) noexcept
+    {
+        if (this != &that)
+        {
+            destroy();
+            handle_ = std::exchange(that.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    { destroy(); }
+
+    bool valid() const noexcept
+    { return static_cast<bool>(handle_); }
+
+    bool done() const noexcept
+    { return !handle_ || handle_.done(); }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            Handle handle;
+
+            bool await_ready() const noexcept
+            { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation_ = awaiting;
+                return handle;
+            }
+
+            T await_resume()
+            { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    void destroy() noexcept
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+private:
+    Handle handle_;
+};
+
+namespace detail
+{
+
+template <typename T>
+inline Task<T> Promise<T>::get_return_object() noexcept
+{ return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+
+inline Task<void> Promise<void>::get_return_object() noexcept
+{ return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this)); }
+
+} // namespace detail
+
+} // namespace coro
+} // namespace http
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+
+namespace http
+{
+
+/*
+    连接准入和过载保护的阈值，由 HttpServer::setAdmissionLimits() 在 start() 之前设置，0 表示不限制：
+      - maxConnections 为 0 时按 RLIMIT_NOFILE 减去 AdmissionControl::kReservedFds 推出，
+        保证连接不会把 fd 用光（否则 accept、打开文件、连数据库都会 EMFILE）
+      - 超过连接上限的新连接回 503 后关闭（TLS 连接直接关闭）
+      - 在途请求数、事件循环延迟、工作线程排队超过阈值时，新请求在收请求体之前就回 503 + Retry-After，
+        并关闭连接，过载时快速失败，而不是所有请求一起超时
+ */
+struct AdmissionLimits
+{
+    size_t maxConnections      { 0 };
+    size_t maxConnectionsPerIp { 0 };
+    size_t maxInflightRequests { 0 }; // 请求头已收完、响应还没完成的请求（含进行中的流式响应）
+    int    maxLoopLagMs        { 0 }; // 所在 I/O 线程的事件循环延迟
+    size_t maxWorkerQueue      { 0 }; // 只对要 offload 的请求检查；队列满（WorkerPool 的上限）时总是拒绝
+    int    retryAfter          { 1 }; // 503 响应的 Retry-After（秒）
+};
+
+// 线程安全，所有 I/O 线程共用一个
+class AdmissionControl : muduo::noncopyable
+{
+public:
+    // maxConnections 自动推算时给监听 socket、日志、数据库连接等留的 fd
+    static const size_t kReservedFds = 64;
+    // 事件循环延迟的采样间隔（秒）
+    static constexpr double kLagProbeInterval = 0.1;
+
+    explicit AdmissionControl(const AdmissionLimits& limits = AdmissionLimits());
+
+    // 需在任何连接建立之前调用
+    void setLimits(const AdmissionLimits& limits);
+
+    const AdmissionLimits& limits() const
+    { return limits_; }
+
+    // 实际生效的连接上限
+    size_t maxConnections() const
+    { return maxConnections_; }
+
+    // 新连接：超过总数或单 IP 上限时返回 false，且不计数
+    bool acquireConnection(const muduo::net::InetAddress& peer);
+    void releaseConnection(const muduo::net::InetAddress& peer);
+
+    // 请求头收完时调用：过载时返回拒绝原因（写日志用），否则计入在途请求并返回 nullptr
+    const char* admitRequest(bool offload, size_t workerQueue);
+    void finishRequest();
+
+    size_t connections() const
+    { return connections_.load(std::memory_order_relaxed); }
+
+    size_t inflightRequests() const
+    { return inflight_.load(std::memory_order_relaxed); }
+
+    // 在 loop 线程里开始采样本线程的事件循环延迟（maxLoopLagMs 为 0 时不采样）
+    void startLagProbe(muduo::net::EventLoop* loop);
+
+    // 当前线程事件循环的延迟（毫秒）
+    static double loopLagMs();
+
+private:
+    // IPv4 4 字节、IPv6 16 字节的原始地址，短字符串不分配内存
+    static std::string addressKey(const muduo::net::InetAddress& peer);
+
+private:
+    AdmissionLimits                         limits_;
+    size_t                                  maxConnections_; // 0 表示不限
+    std::atomic<size_t>                     connections_ { 0 };
+    std::atomic<size_t>                     inflight_ { 0 };
+    std::mutex                              mutex_;          // 保护 perIp_
+    std::unordered_map<std::string, size_t> perIp_;
+};
+
+} // namespace http
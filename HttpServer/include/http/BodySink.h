@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+#include "HttpResponse.h"
+
+namespace http
+{
+
+/*
+    请求体的流式接收器。
+    路由通过 RouterHandler::createBodySink() 为单个请求创建一个 sink 后，
+    HttpContext 不再把请求体攒在内存里，而是每收到一段就调用 onData()，
+    Content-Length 和 chunked 两种编码对 sink 来说没有区别（拿到的都是解码后的数据）。
+    所有回调都在连接所属的 I/O 线程上执行，不要在里面做长时间阻塞的操作。
+    请求体收完后照常调用 handler 的 handle()，handler 可通过 HttpRequest::bodySink() 取回结果。
+ */
+class BodySink
+{
+public:
+    virtual ~BodySink() = default;
+
+    // 收到一段请求体；返回 false 表示放弃接收，服务器回 errorCode() 并关闭连接
+    virtual bool onData(const char* data, size_t len) = 0;
+
+    // 请求体接收完毕（chunked 的 trailer 也已读完）
+    virtual void onFinish() {}
+
+    // onData() 返回 false 时回给客户端的状态码
+    virtual HttpResponse::HttpStatusCode errorCode() const
+    { return HttpResponse::k500InternalServerError; }
+};
+
+} // namespace http
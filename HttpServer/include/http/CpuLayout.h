@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+
+namespace http
+{
+
+/*
+    按 CPU 拓扑给线程分配 CPU：I/O 线程每个绑一个物理核，数据库、LLM、工具调用等阻塞型的工作线程组
+    各自分到一组不重叠的 CPU，不和事件循环抢核，也不被调度器在核之间来回迁移。
+
+    只在本进程可用的 CPU（sched_getaffinity，即 taskset / cgroup cpuset 的限制）里分配，
+    按 NUMA 节点、物理核排序：I/O 线程从前往后取，工作线程组从后往前取整核，各组尽量落在同一个节点上。
+
+    配置串（空格或分号分隔），如 "db=2 llm=4 tools=1"：
+      - name=N      从末尾划出 N 个逻辑 CPU 给 name 组
+      - name=0-3,8  指定 CPU 列表（单个 CPU 写成 8-8，以免和个数混淆）
+      - io=N        I/O 线程数，默认剩下的每个物理核一个；io=列表 时只用这些 CPU
+      - pin=0       只按 CPU 数确定 I/O 线程数，不绑核
+ */
+class CpuLayout : muduo::noncopyable
+{
+public:
+    static CpuLayout& instance();
+
+    // 解析配置串并重新划分；出错时记日志、保持原来的划分并返回 false。需在创建线程之前调用
+    bool configure(const std::string& spec);
+
+    // 可用 CPU，按分配顺序排列
+    const std::vector<int>& available() const
+    { return available_; }
+
+    // I/O 线程用的 CPU，每个物理核一个
+    const std::vector<int>& ioCpus() const
+    { return ioCpus_; }
+
+    // name 组的 CPU；没有单独划分的组为空
+    const std::vector<int>& cpus(const std::string& pool) const;
+
+    int ioThreads() const
+    { return ioThreads_; }
+
+    bool pinning() const
+    { return pin_; }
+
+    // 第 index 个 I/O 线程绑到 ioCpus() 中的一个
+    void pinIoThread(int index) const;
+
+    // 把当前线程绑到 pool 组的 CPU 上。没有单独划分的组绑到 I/O 线程以外的 CPU：
+    // 从 I/O 线程里创建的线程会继承它的单核绑定，必须在线程开始时改掉
+    void pinCurrentThread(const std::string& pool) const;
+
+    // 划分结果，写日志用
+    std::string describe() const;
+
+    // "0-3,8" 形式的 CPU 列表；格式错误时返回 false
+    static bool parseCpuList(const std::string& list, std::vector<int>* cpus);
+    static std::string formatCpuList(const std::vector<int>& cpus);
+
+private:
+    CpuLayout();
+
+    static bool pinCurrentThreadTo(const std::vector<int>& cpus);
+
+private:
+    std::vector<int>                                  available_;
+    std::vector<int>                                  ioCpus_;
+    std::vector<int>                                  sharedCpus_; // 没有单独划分的组用
+    std::unordered_map<std::string, std::vector<int>> pools_;
+    int                                               ioThreads_;
+    bool                                              pin_;
+};
+
+} // namespace http
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "HttpResponse.h"
+
+namespace http
+{
+
+/*
+    延迟完成的响应：handler 返回时响应还没准备好（协程 handler 在等数据库、上游服务），
+    之后在连接所在的 EventLoop 上继续填写同一个 HttpResponse，填好后调用 complete()。
+      - handler 返回到 complete() 之间，连接上的请求对象、响应对象保持有效，后面的（流水线）请求暂不处理
+      - complete() 之后由 HttpServer 执行后置中间件、发出响应，再继续处理后面的请求
+      - handler 返回后、挂起之前，请求体从输入缓冲区拷进请求自己（HttpRequest::detachBody），
+        之后通过 getBody() 重新取；handler 返回前拿到的 string_view 不要跨过挂起继续用
+ */
+class DeferredResponse : public std::enable_shared_from_this<DeferredResponse>,
+                         muduo::noncopyable
+{
+public:
+    using Callback = std::function<void()>;
+
+    // 在 handler 中（I/O 线程）调用，把 resp 标记为延迟完成
+    static std::shared_ptr<DeferredResponse> start(const muduo::net::TcpConnectionPtr& conn,
+                                                   HttpResponse* resp);
+
+    // 响应已经填好；任意线程可调用，重复调用无效
+    void complete();
+
+    const muduo::net::TcpConnectionPtr& connection() const
+    { return conn_; }
+
+    // 由 HttpServer 在 handler 返回后调用（I/O 线程）：complete() 之后在 I/O 线程回调 onComplete
+    void open(Callback onComplete);
+
+private:
+    explicit DeferredResponse(const muduo::net::TcpConnectionPtr& conn);
+
+private:
+    muduo::net::TcpConnectionPtr conn_;
+    std::mutex                   mutex_;
+    bool                         completed_;
+    Callback                     onComplete_;  // open() 之前为空
+};
+
+} // namespace http
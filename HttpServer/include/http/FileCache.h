@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+// 一个已加载的静态文件，加载后只读，多个响应共享
+struct CachedFile
+{
+    std::shared_ptr<const void> owner;        // 数据的持有者（内存副本或 mmap 映射）
+    std::string_view            data;         // 文件内容
+    time_t                      mtime;        // 修改时间（秒）
+    std::string                 etag;         // 强 ETag："\"<大小>-<修改时间纳秒>\""（十六进制）
+    std::string                 lastModified; // HTTP 日期格式的修改时间
+    std::string_view            contentType;  // 按扩展名推断
+};
+
+/*
+    静态文件缓存：文件内容和元数据（ETag、Last-Modified、Content-Type）只在第一次访问时加载。
+      - 不超过 kMaxInMemorySize 的文件整份读进内存；更大的文件 mmap，
+        响应体直接引用映射的内存；发送时内核写不完的部分仍会被 muduo 拷进输出缓冲区（见 SlicedSender）
+      - 用 inotify 监听已缓存文件所在的目录，文件被改写、替换、删除时立即失效；
+        inotify 不可用时退化为每秒最多 stat 一次
+      - 最多缓存 kMaxEntries 个文件，满了淘汰最久没访问的一个
+      - get() 线程安全，inotify 事件在构造时传入的 loop 上处理
+
+    注意：mmap 的文件如果被其他进程原地截断，访问截断部分会收到 SIGBUS。
+    部署静态资源时应当写新文件再 rename 覆盖（多数构建工具和编辑器都是这样做的）。
+ */
+class FileCache : muduo::noncopyable
+{
+public:
+    static const size_t kMaxInMemorySize = 1024 * 1024;
+    static const size_t kMaxEntries = 1024;
+
+    // 需要在 loop 所在线程构造和析构
+    explicit FileCache(muduo::net::EventLoop* loop);
+    ~FileCache();
+
+    // path 是文件系统路径；不存在或不是普通文件时返回 nullptr
+    std::shared_ptr<const CachedFile> get(const std::string& path);
+
+    // 按扩展名推断 Content-Type，不认识的返回 application/octet-stream
+    static std::string_view contentTypeOf(std::string_view path);
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const CachedFile> file;
+        time_t                            checked; // 上次 stat 校验的时间（无 inotify 时使用）
+        std::list<std::string>::iterator  lru;     // 在 lru_ 中的位置
+    };
+    using FileMap = std::unordered_map<std::string, Entry>;
+
+    static std::shared_ptr<const CachedFile> load(const std::string& path);
+
+    // 以下调用方已持有 mutex_
+    void watchLocked(const std::string& path);
+    FileMap::iterator eraseLocked(FileMap::iterator it);
+    void clearLocked();
+    void onInotify(muduo::Timestamp);
+
+private:
+    muduo::net::EventLoop*                        loop_;
+    int                                           inotifyFd_;   // -1 表示 inotify 不可用
+    std::unique_ptr<muduo::net::Channel>          channel_;
+    std::mutex                                    mutex_;       // 保护下面三个 map 和 lru_
+    FileMap                                       files_;
+    std::list<std::string>                        lru_;         // files_ 的 key，最近访问的在前
+    std::unordered_map<int, std::string>          watchDirs_;   // watch 描述符 -> 目录
+    std::unordered_map<std::string, int>          dirWatches_;  // 目录 -> watch 描述符
+    std::atomic<uint64_t>                         generation_ { 0 }; // 每批 inotify 事件加一
+};
+
+} // namespace http
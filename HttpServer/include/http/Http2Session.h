@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "HttpLimits.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "../ssl/SslConnection.h"
+
+struct nghttp2_session;
+
+namespace http
+{
+
+/*
+    HTTP/2 连接上的一个流（一个请求）。请求、响应对象归流所有，流关闭之前一直有效；
+    handler 交给工作线程、延迟完成时由任务持有 shared_ptr，流关闭之后 HttpServer 不再发送响应。
+    除了工作线程里执行 handler 期间的 request/response，都只在连接的 I/O 线程上访问
+ */
+struct Http2Stream
+{
+    explicit Http2Stream(int32_t streamId)
+        : id(streamId)
+        , error(HttpResponse::kUnknown)
+        , headerBytes(0)
+        , bodyBytes(0)
+        , unconsumed(0)
+        , rejected(false)
+        , admitted(false)
+        , offload(false)
+        , running(false)
+        , closed(false)
+        , outputEnd(false)
+        , deferred(false)
+    {}
+
+    int32_t                      id;
+    HttpRequest                  request;
+    HttpResponse                 response;
+    std::string                  cookie;      // HTTP/2 允许把 Cookie 拆成多个字段，收完之后合并
+    HttpResponse::HttpStatusCode error;       // 请求头阶段发现的错误，请求头收完时回这个状态码
+    size_t                       headerBytes;
+    size_t                       bodyBytes;   // 缓存在 request 里的请求体字节数，计入会话的 bufferedBody_
+    size_t                       unconsumed;  // 收到了但还没归还流量控制窗口的请求体字节数
+    muduo::Timestamp             deadline;    // 请求头/请求体的收取期限，请求收完或者不再接收之后无效
+    bool                         rejected;    // 已经回了错误响应，后面的请求体丢弃
+    bool                         admitted;    // 已计入 AdmissionControl 的在途请求
+    bool                         offload;     // 路由要求在工作线程池中执行
+    bool                         running;     // handler 正在工作线程里执行，流关闭了也要等它结束
+    bool                         closed;
+    muduo::net::Buffer           output;      // 还没交给 nghttp2 的响应体，按流量控制窗口取走
+    bool                         outputEnd;   // 响应体已经全部放进 output
+    bool                         deferred;    // output 取空时让 nghttp2 暂停了这个流，有新数据时要恢复
+    std::function<void()>        drainedCallback; // output 取空时（流式响应的背压）
+    std::function<void()>        closeCallback;   // 流关闭时（对方取消、连接断开）
+};
+
+/*
+    一条 HTTP/2 连接（h2 或 h2c）的服务端状态，基于 nghttp2：帧的解析和生成、HPACK、
+    流量控制和流的多路复用都由 nghttp2 完成，这里只负责和连接、HttpRequest/HttpResponse 之间的转换。
+      - 收到的请求头（伪头部 :method/:path/:authority 对应请求行和 Host）转换成 HttpRequest，
+        请求收完后交给 HttpServer 按原来的路由、中间件处理，handler 不需要区分 HTTP/1.1 和 HTTP/2
+      - 响应的头部按 HPACK 编码，Connection、Transfer-Encoding 等逐跳字段不发送；
+        响应体按对方的流量控制窗口分帧，许多个流式响应（SSE）共用一条连接
+      - 每个流各自按 HttpLimits 的 headerTimeout/bodyTimeout 计时（见 nextDeadline），
+        一个慢速发送的流不会因为连接上还有别的流而逃过超时
+      - 缓存在内存中的请求体按连接合计，超过 kMaxBufferedBody 之后收到的数据暂不归还流量控制窗口，
+        对方发完窗口就得停下，等有流结束、内存释放之后再归还
+      - 和 SslConnection 一样放在连接的 HttpContext 里，只在连接所属的 I/O 线程上使用
+
+    编译时没有定义 HTTP_WITH_NGHTTP2 时 supported() 返回 false，HttpServer 不会创建这个对象
+ */
+class Http2Session : muduo::noncopyable
+{
+public:
+    using StreamPtr = std::shared_ptr<Http2Stream>;
+    // 请求头收完（请求体还没开始收）：返回 false 表示已经提交了最终响应（如过载 503），请求体不再接收
+    using HeadersCallback = std::function<bool (const StreamPtr&)>;
+    // 请求（含请求体）收完
+    using RequestCallback = std::function<void (const StreamPtr&)>;
+    // 流关闭：响应发完、对方取消或者连接断开，之后不会再有这个流的回调
+    using CloseCallback = std::function<void (const StreamPtr&)>;
+
+    // SETTINGS_MAX_CONCURRENT_STREAMS
+    static const uint32_t kMaxConcurrentStreams = 128;
+    // 连接的输出缓冲区超过这个值时不再从 nghttp2 取帧，各个流的数据留在各自的 output 里
+    static const size_t kHighWaterMark = 256 * 1024;
+    // 连接上所有流缓存在内存中的请求体合计超过这个值（至少是 maxBodySize）时不再发 WINDOW_UPDATE
+    static const size_t kMaxBufferedBody = 16 * 1024 * 1024;
+
+    // 编译时启用了 nghttp2
+    static bool supported();
+
+    // TLS 的 ALPN 里 HTTP/2 的协议名
+    static std::string_view alpnProtocol()
+    { return "h2"; }
+
+    // 明文连接上客户端的连接前言（prior knowledge）
+    static std::string_view clientPreface()
+    { return "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"; }
+
+    // conn 持有这个对象（经由 HttpContext），这里只存裸指针；ssl 为空表示明文连接
+    Http2Session(muduo::net::TcpConnection* conn, ssl::SslConnection* ssl, const HttpLimits& limits);
+    ~Http2Session();
+
+    void setHeadersCallback(const HeadersCallback& cb)
+    { headersCallback_ = cb; }
+
+    void setRequestCallback(const RequestCallback& cb)
+    { requestCallback_ = cb; }
+
+    void setCloseCallback(const CloseCallback& cb)
+    { closeCallback_ = cb; }
+
+    // h2c 升级（RFC 7540 3.2）：settings 是 HTTP2-Settings 字段的值（base64url），
+    // request 是发起升级的那个请求，内容移到流 1 上返回，由调用方在回 101 之后交给 requestCallback。
+    // settings 不合法时返回空，调用方按普通的 HTTP/1.1 请求处理
+    StreamPtr upgrade(std::string_view settings, HttpRequest* request);
+
+    // 发送服务端的 SETTINGS（连接前言），在收到任何数据之前调用；之后连接的 write complete 回调归这个对象使用
+    void start();
+
+    // 取走 buf 里的全部数据交给 nghttp2，处理完之后把产生的帧发出去。
+    // 返回 false 表示协议错误：已经发出 GOAWAY 并关闭写端
+    bool onRead(muduo::net::Buffer* buf);
+
+    // 提交流的响应：头部和 stream->response 里的响应体；流式响应（isStreaming()）只提交头部，
+    // 之后由 sendData 追加，因此要在 releaseStream() 之前调用。流已经关闭时什么也不做
+    void submitResponse(const StreamPtr& stream);
+
+    // 流式响应追加一段响应体（取走 data），end 为 true 时结束这个流。流已经关闭时返回 false
+    bool sendData(int32_t streamId, muduo::net::Buffer* data, bool end);
+
+    // 流上还没交给 nghttp2 的响应体字节数（对方的流量控制窗口用完之后在这里积压）
+    size_t bufferedBytes(int32_t streamId) const;
+
+    // 设置流式响应的回调：drained 在积压的数据取空时调用，closed 在流关闭时调用；传空函数即取消
+    void observeStream(int32_t streamId, std::function<void()> drained, std::function<void()> closed);
+
+    // 放弃一个流（RST_STREAM）
+    void resetStream(int32_t streamId);
+
+    // 优雅关闭（drain、空闲超时）：发 GOAWAY，不再接受新的流，已有的流处理完之后关闭连接
+    void shutdown();
+
+    // 连接已断开：对还没关闭的流逐个回调关闭
+    void onDisconnected();
+
+    // 没有打开着的流
+    bool idle() const
+    { return streams_.empty(); }
+
+    // 还在收请求头/请求体的流里最早的期限；没有这样的流（或者不限时）时返回无效的 Timestamp
+    muduo::Timestamp nextDeadline() const;
+
+    // 期限已过的流：还没回响应的回 408，然后 RST_STREAM(NO_ERROR) 让对方别再发请求体
+    void expireStreams(muduo::Timestamp now);
+
+    // 连接上缓存在内存中的请求体字节数
+    size_t bufferedBody() const
+    { return bufferedBody_; }
+
+    // 把 nghttp2 攒下的帧发给连接；连接的输出缓冲区积压太多时先停下，等它发完（write complete）再继续
+    void flush();
+
+private:
+    // nghttp2 的回调（见 Http2Session.cpp），要访问下面的私有成员
+    friend struct Http2Callbacks;
+
+    // 没有或已关闭时返回空
+    StreamPtr findStream(int32_t streamId) const;
+    // 请求头收完：检查伪头部，补上 Host、Cookie
+    void finishHeaders(const StreamPtr& stream);
+    // 请求收完：交给 requestCallback_
+    void finishRequest(const StreamPtr& stream);
+    // 不经过 handler 直接回一个错误响应
+    void rejectStream(const StreamPtr& stream, HttpResponse::HttpStatusCode code);
+    // 归还流量控制窗口；buffered 为 true 表示这些数据缓存在了内存里，超过 kMaxBufferedBody 时先记在流上
+    void consume(Http2Stream* stream, int32_t streamId, size_t length, bool buffered);
+    // 流关闭：释放它缓存的请求体，内存降下来之后归还暂扣的窗口
+    void releaseBody(Http2Stream* stream);
+    // GOAWAY 之后流都结束了，或者双方都不再收发：关闭连接
+    void checkClose();
+
+private:
+    nghttp2_session*                           session_;
+    muduo::net::TcpConnection*                 conn_;
+    ssl::SslConnection*                        ssl_;
+    HttpLimits                                 limits_;
+    std::unordered_map<int32_t, StreamPtr>     streams_;
+    muduo::net::Buffer                         output_;    // mem_send 取出的帧，凑齐之后一次发给连接
+    size_t                                     bufferedBody_; // 各个流缓存在内存中的请求体合计
+    size_t                                     maxBufferedBody_;
+    bool                                       inRead_;    // 正在 onRead 里，flush 推迟到最后一起做
+    bool                                       goingAway_; // 已发 GOAWAY
+    bool                                       closing_;   // 已关闭写端
+    HeadersCallback                            headersCallback_;
+    RequestCallback                            requestCallback_;
+    CloseCallback                              closeCallback_;
+};
+
+} // namespace http
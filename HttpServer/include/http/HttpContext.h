@@ -1,10 +1,18 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <string_view>
 
 #include <muduo/net/TcpServer.h>
 
+#include "Http2Session.h"
+#include "HttpLimits.h"
 #include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "TimingWheel.h"
+#include "WebSocket.h"
+#include "../ssl/SslConnection.h"
 
 namespace http
 {
@@ -16,23 +24,78 @@ public:
     {
         kExpectRequestLine, // 解析请求行
         kExpectHeaders, // 解析请求头
-        kExpectBody, // 解析请求体
+        kGotHeaders, // 请求头解析完成（没有请求体的请求也经过这一步），等待调用方 startBody()
+        kExpectBody, // 按 Content-Length 读取请求体
+        kExpectChunkSize, // chunked：读取 chunk-size 行
+        kExpectChunkData, // chunked：读取 chunk 数据
+        kExpectChunkCrlf, // chunked：chunk 数据后面的 \r\n
+        kExpectTrailers, // chunked：最后一个 chunk 之后的 trailer
         kGotAll, // 解析完成
     };
     
-    HttpContext()
+    // 连接当前计时的是哪一种超时（见 HttpLimits）
+    enum TimeoutKind
+    {
+        kNoTimeout,
+        kIdleTimeout,
+        kHeaderTimeout,
+        kBodyTimeout,
+    };
+
+    explicit HttpContext(const HttpLimits& limits = HttpLimits())
     : state_(kExpectRequestLine)
+    , limits_(limits)
+    , chunked_(false)
+    , bodyRemaining_(0)
+    , headerBytes_(0)
+    , errorCode_(HttpResponse::k400BadRequest)
+    , timeoutKind_(kNoTimeout)
+    , beforeDone_(false)
+    , suspended_(false)
+    , offload_(false)
+    , admitted_(false)
     {}
 
+    // 返回 false 表示报文有误，errorCode() 给出应该回给客户端的状态码
     bool parseRequest(muduo::net::Buffer* buf, muduo::Timestamp receiveTime);
+
+    // 请求头已经完整但请求体还没开始读：调用方可以在这里根据路由给请求挂上 BodySink，
+    // 然后调用 startBody() 继续解析
+    bool gotHeaders() const
+    { return state_ == kGotHeaders; }
+
+    // 按请求头确定的长度/编码开始读取请求体；没有请求体时直接进入 gotAll()。超出限制时返回 false
+    bool startBody();
+
+    // 请求头表明后面有请求体
+    bool hasBody() const
+    { return chunked_ || request_.contentLength() > 0; }
+
     bool gotAll() const 
     { return state_ == kGotAll;  }
 
+    // 请求行或请求头还没收完（kExpectRequestLine 时要结合缓冲区里是否已有数据判断）
+    bool inHeaderPhase() const
+    { return state_ == kExpectRequestLine || state_ == kExpectHeaders; }
+
+    // 正在读请求体（含 chunked 的各个阶段）
+    bool inBodyPhase() const
+    { return state_ >= kExpectBody && state_ <= kExpectTrailers; }
+
+    HttpResponse::HttpStatusCode errorCode() const
+    { return errorCode_; }
+
     void reset()
     {
         state_ = kExpectRequestLine;
-        HttpRequest dummyData;
-        request_.swap(dummyData);
+        chunked_ = false;
+        bodyRemaining_ = 0;
+        headerBytes_ = 0;
+        errorCode_ = HttpResponse::k400BadRequest;
+        timeoutKind_ = kNoTimeout; // 下一个请求重新开始计时
+        beforeDone_ = false;
+        offload_ = false;
+        request_.reset(); // 保留容量，不再换一个新构造的 HttpRequest
     }
 
     const HttpRequest& request() const
@@ -41,11 +104,112 @@ public:
     HttpRequest& request()
     { return request_;}
 
+    // 连接复用的响应对象，每个请求开始前由 HttpServer 调用 HttpResponse::reset()
+    HttpResponse& response()
+    { return response_; }
+
+    // 一次读回调内攒下的（流水线）响应，send 之后 Buffer 保留容量
+    muduo::net::Buffer* outputBuffer()
+    { return &output_; }
+
+    // 前置中间件是否已经对当前请求执行过（100-continue 时在收请求体之前提前执行）
+    bool beforeMiddlewareDone() const
+    { return beforeDone_; }
+
+    void setBeforeMiddlewareDone(bool done)
+    { beforeDone_ = done; }
+
+    // 当前请求的响应还没有完成（流式响应正在发送、handler 在工作线程中执行）：
+    // 期间到达的（流水线）请求先留在输入缓冲区，完成后再处理。跨请求的状态，reset() 不清除
+    bool suspended() const
+    { return suspended_; }
+
+    void setSuspended(bool on)
+    { suspended_ = on; }
+
+    // 当前请求的路由要求在工作线程池中执行（请求头解析完成时确定）
+    bool offload() const
+    { return offload_; }
+
+    void setOffload(bool on)
+    { offload_ = on; }
+
+    // 当前请求已计入 AdmissionControl 的在途请求，完成时要减掉。跨请求的状态，reset() 不清除
+    bool admitted() const
+    { return admitted_; }
+
+    void setAdmitted(bool on)
+    { admitted_ = on; }
+
+    // 挂在所属 EventLoop 时间轮上的超时节点
+    TimingWheel::Entry& timer()
+    { return timer_; }
+
+    TimeoutKind timeoutKind() const
+    { return timeoutKind_; }
+
+    void setTimeoutKind(TimeoutKind kind)
+    { timeoutKind_ = kind; }
+
+    // TLS 连接的加解密状态，明文连接为空。跟着连接走，只在它的 I/O 线程上访问
+    ssl::SslConnection* ssl() const
+    { return ssl_.get(); }
+
+    void setSsl(std::unique_ptr<ssl::SslConnection> ssl)
+    { ssl_ = std::move(ssl); }
+
+    // 协商成 HTTP/2 的连接上的会话，HTTP/1.x 连接为空。之后的数据都交给它，不再按 HTTP/1.x 解析
+    Http2Session* http2() const
+    { return http2_.get(); }
+
+    void setHttp2(std::unique_ptr<Http2Session> session)
+    { http2_ = std::move(session); }
+
+    // 升级成 WebSocket 的连接，之后的数据都交给它。handler 也可能持有它，它只持有连接的 weak_ptr
+    WebSocket* webSocket() const
+    { return webSocket_.get(); }
+
+    void setWebSocket(std::shared_ptr<WebSocket> ws)
+    { webSocket_ = std::move(ws); }
+
+    // 连接上挂的 HttpContext，连接建立回调之前为空
+    static HttpContext* of(const muduo::net::TcpConnectionPtr& conn);
+
+    // 发给连接：TLS 连接先加密再发，明文连接直接发。只能在连接所属的 I/O 线程调用
+    static void send(const muduo::net::TcpConnectionPtr& conn, muduo::net::Buffer* buf);
+    static void send(const muduo::net::TcpConnectionPtr& conn, std::string_view data);
+
 private:
     bool processRequestLine(const char* begin, const char* end);
+    bool processHeadersEnd();
+    bool processChunkSize(const char* begin, const char* end);
+    bool consumeBody(muduo::net::Buffer* buf);
+    void finishBody();
+    bool fail(HttpResponse::HttpStatusCode code)
+    {
+        errorCode_ = code;
+        return false;
+    }
+
 private:
-    HttpRequestParseState state_;
-    HttpRequest           request_;
+    HttpRequestParseState        state_;
+    HttpLimits                   limits_;
+    bool                         chunked_;       // 请求体是否为 chunked 编码
+    uint64_t                     bodyRemaining_; // 当前 Content-Length 请求体或 chunk 还剩多少字节
+    size_t                       headerBytes_;   // 已经收到的请求行 + 请求头字节数
+    HttpResponse::HttpStatusCode errorCode_;     // 解析失败时的状态码
+    TimeoutKind                  timeoutKind_;
+    bool                         beforeDone_;    // 前置中间件已执行
+    bool                         suspended_;     // 响应尚未完成，暂不解析后面的请求
+    bool                         offload_;       // 路由的 handler 要在工作线程池中执行
+    bool                         admitted_;      // 已计入在途请求
+    TimingWheel::Entry           timer_;
+    HttpRequest                  request_;
+    HttpResponse                 response_;
+    muduo::net::Buffer           output_;
+    std::unique_ptr<ssl::SslConnection> ssl_;
+    std::unique_ptr<Http2Session> http2_; // 先于 ssl_ 析构
+    std::shared_ptr<WebSocket>    webSocket_;
 };
 
-} // namespace http
\ No newline at end of file
+} // namespace http
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace http
+{
+
+// 只处理 ASCII：HTTP 字段名以及 close/chunked 这类取值都是 ASCII
+inline char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (toLowerAscii(a[i]) != toLowerAscii(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 去掉首尾的空白（空格和水平制表符），字段值和逗号分隔的列表项都这样处理
+inline std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+/*
+    请求头存储：
+      - fields_ 按到达顺序平铺保存所有字段，key/value 都是指向请求 arena 的 view
+      - 常用字段名（请求头和响应头共用一张表）在编译期用完美哈希映射到固定的 id，slots_[id] 记录它在 fields_ 中的位置，
+        热路径上用 get(HttpHeaders::kConnection) 这样的 id 直接取值，不做任何字符串比较
+      - 字段名按 RFC 9110 不区分大小写，"content-length" 和 "Content-Length" 是同一个字段
+ */
+class HttpHeaders
+{
+public:
+    using Header = std::pair<std::string_view, std::string_view>;
+    using const_iterator = std::vector<Header>::const_iterator;
+
+    // 顺序需与 HttpHeaders.cpp 中的 kKnownNames 一致
+    enum Known : uint8_t
+    {
+        kHost,
+        kConnection,
+        kContentLength,
+        kContentType,
+        kTransferEncoding,
+        kCookie,
+        kXForwardedFor,
+        kXRealIp,
+        kOrigin,
+        kExpect,
+        kAccept,
+        kAcceptEncoding,
+        kAuthorization,
+        kUserAgent,
+        kIfNoneMatch,
+        kIfModifiedSince,
+        kRange,
+        kIfRange,
+        kUpgrade,
+        kSecWebSocketKey,
+        kSecWebSocketVersion,
+        kSecWebSocketExtensions,
+        kSecWebSocketProtocol,
+        kAccessControlRequestMethod,
+        kAccessControlRequestHeaders,
+        kReferer,
+        kCacheControl,
+        kKeepAlive,
+        kTe,
+        kHttp2Settings,
+        kLastEventId,
+        // 以下主要用于响应头
+        kDate,
+        kServer,
+        kLocation,
+        kSetCookie,
+        kETag,
+        kLastModified,
+        kRetryAfter,
+        kContentEncoding,
+        kContentRange,
+        kAcceptRanges,
+        kVary,
+        kWwwAuthenticate,
+        kAccessControlAllowOrigin,
+        kAccessControlAllowMethods,
+        kAccessControlAllowHeaders,
+        kAccessControlAllowCredentials,
+        kAccessControlMaxAge,
+        kAccessControlExposeHeaders,
+        kSecWebSocketAccept,
+        kExpires,
+        kContentDisposition,
+        kXContentTypeOptions,
+        kKnownCount,
+        kUnknown = kKnownCount,
+    };
+
+    // 字段名 -> 常用字段 id（不区分大小写），不是常用字段返回 kUnknown
+    static Known lookup(std::string_view name);
+
+    // 常用字段的规范写法，如 kContentLength -> "Content-Length"
+    static std::string_view name(Known id);
+
+    // 取值是逗号分隔列表的字段（RFC 9110 5.3），重复出现时应合并而不是覆盖。
+    // Cookie 也算在内，只是合并时用 "; "（RFC 6265 5.4）
+    static bool isList(Known id);
+
+    HttpHeaders()
+    { slots_.fill(0); }
+
+    // 同名字段（不区分大小写）已存在时覆盖旧值
+    void set(std::string_view key, std::string_view value);
+
+    // 同名字段的值，调用方可以就地改写；没有时返回 nullptr。id 是 lookup(key) 的结果
+    std::string_view *find(Known id, std::string_view key);
+
+    // 追加一个字段，调用方已用 find 确认没有同名字段
+    void add(Known id, std::string_view key, std::string_view value)
+    {
+        fields_.emplace_back(key, value);
+        if (id != kUnknown)
+        {
+            slots_[id] = static_cast<uint16_t>(fields_.size());
+        }
+    }
+
+    std::string_view get(Known id) const
+    {
+        uint16_t slot = slots_[id];
+        return slot ? fields_[slot - 1].second : std::string_view();
+    }
+
+    std::string_view get(std::string_view key) const;
+
+    bool has(Known id) const
+    { return slots_[id] != 0; }
+
+    size_t size() const
+    { return fields_.size(); }
+
+    bool empty() const
+    { return fields_.empty(); }
+
+    const_iterator begin() const
+    { return fields_.begin(); }
+
+    const_iterator end() const
+    { return fields_.end(); }
+
+    // 清空字段但保留 vector 的容量
+    void clear()
+    {
+        fields_.clear();
+        slots_.fill(0);
+    }
+
+    void swap(HttpHeaders& that)
+    {
+        fields_.swap(that.fields_);
+        slots_.swap(that.slots_);
+    }
+
+private:
+    std::vector<Header>                fields_; // 所有字段，按到达顺序
+    std::array<uint16_t, kKnownCount>  slots_;  // 常用字段在 fields_ 中的下标 + 1，0 表示没有
+};
+
+} // namespace http
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace http
+{
+
+/*
+    请求解析的大小限制和连接超时，由 HttpServer::setLimits() 统一配置，每个连接的 HttpContext 各持一份。
+    流式接收请求体的路由（见 BodySink）不受 maxBodySize 限制，请求体不在内存中整份保存。
+    超时都以秒为单位，由每个 EventLoop 的 TimingWheel 计时，0 表示不限制：
+      - idleTimeout   keep-alive 连接上两个请求之间（以及新连接上第一个字节到来之前）的等待时间
+      - headerTimeout 从请求的第一个字节到请求头全部收完的总时间，慢速发送请求头（slowloris）在这里被切断
+      - bodyTimeout   读请求体时两次收到数据之间的最长间隔
+ */
+struct HttpLimits
+{
+    uint64_t maxBodySize      { 8 * 1024 * 1024 }; // 内存中缓存的请求体上限，超过回 413
+    size_t   maxChunkLineSize { 1024 };            // chunk-size 行（含扩展）的最大长度
+    size_t   maxHeaderBytes   { 16 * 1024 };       // 请求行 + 请求头的总字节数，超过回 431
+    size_t   maxHeaderCount   { 100 };             // 请求头个数，超过回 431
+
+    int      idleTimeout      { 60 };
+    int      headerTimeout    { 10 };
+    int      bodyTimeout      { 30 };
+};
+
+} // namespace http
@@ -1,14 +1,30 @@
 #pragma once
 
-#include <map>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <muduo/base/Timestamp.h>
 
+#include "BodySink.h"
+#include "HttpHeaders.h"
+#include "RequestArena.h"
+
 namespace http
 {
 
+/*
+    HttpRequest 中的字符串字段都是 string_view：
+      - 请求行、请求头、查询参数、路径参数指向请求自己的 arena_
+      - 查询字符串第一次被访问时才拆分；参数和路径参数都做百分号解码，
+        不含 '%'（查询参数还有 '+'）的部分直接引用原字符串，需要解码的才写进 arena_
+      - Content-Length 请求体直接指向连接的输入缓冲区，只在本次请求分发期间有效，
+        handler 若要在返回之后继续使用，需要自行拷贝（交给工作线程池的请求由 HttpServer 先 detachBody()）
+      - chunked 请求体解码后存放在请求自己的 bodyBuffer_ 里
+      - 路由注册了 BodySink 时请求体交给 sink，getBody() 为空
+ */
 class HttpRequest
 {
 public:
@@ -16,75 +32,156 @@ public:
     {
         kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions
     };
-    
+
+    using Header = HttpHeaders::Header;
+
+    // reset() 时 bodyBuffer_ 超过这个容量就释放
+    static const size_t kMaxRetainedBodyCapacity = 64 * 1024;
+    using Param = std::pair<std::string_view, std::string_view>;
+
     HttpRequest()
         : method_(kInvalid)
         , version_("Unknown")
     {
     }
-    
+
+    HttpRequest(const HttpRequest&) = delete;
+    HttpRequest& operator=(const HttpRequest&) = delete;
+    HttpRequest(HttpRequest&&) = default;
+    HttpRequest& operator=(HttpRequest&&) = default;
+
     void setReceiveTime(muduo::Timestamp t);
     muduo::Timestamp receiveTime() const
     { return receiveTime_; }
-    
+
     bool setMethod(const char* start, const char* end);
     Method method() const
     { return method_; }
 
     void setPath(const char* start, const char* end);
-    std::string path() const
+    std::string_view path() const
     { return path_; }
 
-    void setPathParameters(const std::string &key, const std::string &value);
-    std::string getPathParameters(const std::string &key) const;
+    // value 是未解码的原始片段，保存时完成百分号解码
+    void setPathParameters(std::string_view key, std::string_view value);
+    std::string_view getPathParameters(std::string_view key) const;
 
+    // 只记录原始查询字符串，真正的拆分和解码推迟到第一次读取参数时
     void setQueryParameters(const char* start, const char* end);
-    std::string getQueryParameters(const std::string &key) const;
-    
-    void setVersion(std::string v)
+
+    std::string_view getQuery() const
+    { return rawQuery_; }
+
+    // 重复的 key 以最后一次出现为准
+    std::string_view getQueryParameters(std::string_view key) const;
+
+    // 某个 key 的所有取值，按出现顺序（?tag=a&tag=b）
+    std::vector<std::string_view> getQueryParameterValues(std::string_view key) const;
+
+    // 全部查询参数（已解码），按出现顺序
+    const std::vector<Param>& queryParameters() const
+    {
+        parseQueryParameters();
+        return queryParameters_;
+    }
+
+    // 只接受静态字符串（"HTTP/1.1" 之类），不做拷贝
+    void setVersion(std::string_view v)
     { version_ = v; }
 
-    std::string getVersion() const
+    std::string_view getVersion() const
     { return version_; }
-    
-    void addHeader(const char* start, const char* colon, const char* end);
-    std::string getHeader(const std::string& field) const;
 
-    const std::map<std::string, std::string>& headers() const
-    { return headers_; }
+    // 重复的列表字段（HttpHeaders::isList）和不认识的字段合并成一个值，其余字段以最后一次为准。
+    // 返回 false 表示 Host、Transfer-Encoding 重复或 Content-Length 取值不一致（请求走私），调用方回 400
+    bool addHeader(const char* start, const char* colon, const char* end);
+    // 字段名和值已经拆好（HTTP/2 的请求头），都拷进 arena。重复字段同样合并列表，其余覆盖
+    void addHeader(std::string_view key, std::string_view value);
+    // 字段名不区分大小写
+    std::string_view getHeader(std::string_view field) const
+    { return headers_.get(field); }
+
+    // 常用字段按 id 直接取值，如 getHeader(HttpHeaders::kContentLength)
+    std::string_view getHeader(HttpHeaders::Known id) const
+    { return headers_.get(id); }
 
-    void setBody(const std::string& body) 
-    { content_ = body; }
+    const HttpHeaders& headers() const
+    { return headers_; }
 
-    void setBody(const char* start, const char* end) 
-    { 
-        if (end >= start) 
+    // 请求体不拷贝，只记录在输入缓冲区中的位置
+    void setBody(const char* start, const char* end)
+    {
+        if (end >= start)
         {
-            content_.assign(start, end - start); 
+            content_ = std::string_view(start, end - start);
         }
     }
-    
-    std::string getBody() const
+
+    // chunked 解码后的数据追加到请求自己的缓冲区
+    void appendBody(const char* data, size_t len)
+    {
+        bodyBuffer_.insert(bodyBuffer_.end(), data, data + len);
+        content_ = std::string_view(bodyBuffer_.data(), bodyBuffer_.size());
+    }
+
+    std::string_view getBody() const
     { return content_; }
 
+    // 请求体还指向输入缓冲区时拷进请求自己的缓冲区，之后请求可以在本次分发之外继续使用（如交给工作线程）
+    void detachBody()
+    {
+        if (!content_.empty() && content_.data() != bodyBuffer_.data())
+        {
+            bodyBuffer_.assign(content_.begin(), content_.end());
+            content_ = std::string_view(bodyBuffer_.data(), bodyBuffer_.size());
+        }
+    }
+
+    void setBodySink(std::unique_ptr<BodySink> sink)
+    { bodySink_ = std::move(sink); }
+
+    BodySink* bodySink() const
+    { return bodySink_.get(); }
+
     void setContentLength(uint64_t length)
     { contentLength_ = length; }
-    
+
     uint64_t contentLength() const
     { return contentLength_; }
 
+    // HTTP/2 请求所在的流，HTTP/1.x 的请求为 0
+    void setStreamId(int32_t id)
+    { streamId_ = id; }
+
+    int32_t streamId() const
+    { return streamId_; }
+
+    // 为同一连接上的下一个请求清空内容：vector、arena 等保留已分配的容量，稳定状态下不再分配内存
+    void reset();
+
     void swap(HttpRequest& that);
 
 private:
-    Method                                       method_; // 请求方法
-    std::string                                  version_; // http版本
-    std::string                                  path_; // 请求路径
-    std::unordered_map<std::string, std::string> pathParameters_; // 路径参数
-    std::unordered_map<std::string, std::string> queryParameters_; // 查询参数
-    muduo::Timestamp                             receiveTime_; // 接收时间
-    std::map<std::string, std::string>           headers_; // 请求头
-    std::string                                  content_; // 请求体
-    uint64_t                                     contentLength_ { 0 }; // 请求体长度
-};  
-
-} // namespace http
\ No newline at end of file
+    void parseQueryParameters() const;
+    std::string_view decodeComponent(std::string_view s, bool plusAsSpace) const;
+    bool mergeHeader(HttpHeaders::Known id, std::string_view *existing, std::string_view value);
+
+private:
+    Method                 method_; // 请求方法
+    std::string_view       version_; // http版本
+    std::string_view       path_; // 请求路径
+    std::vector<Param>     pathParameters_; // 路径参数
+    std::string_view       rawQuery_; // 原始查询字符串（'?' 之后）
+    mutable bool           queryParsed_ { false }; // queryParameters_ 是否已经从 rawQuery_ 拆出来
+    mutable std::vector<Param> queryParameters_; // 查询参数（惰性拆分）
+    muduo::Timestamp       receiveTime_; // 接收时间
+    HttpHeaders            headers_; // 请求头
+    std::string_view       content_; // 请求体
+    uint64_t               contentLength_ { 0 }; // 请求体长度
+    int32_t                streamId_ { 0 }; // HTTP/2 的流 id
+    std::vector<char>      bodyBuffer_; // chunked 请求体的存储
+    std::unique_ptr<BodySink> bodySink_; // 流式接收请求体（可为空）
+    mutable RequestArena   arena_; // 请求行/请求头/解码结果的存储
+};
+
+} // namespace http
@@ -1,43 +1,91 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 #include <muduo/net/TcpServer.h>
 
+#include "HttpHeaders.h"
+
 namespace http
 {
 
+class DeferredResponse;
+class ResponseStream;
+class WebSocket;
+
 class HttpResponse 
 {
 public:
     enum HttpStatusCode
     {
         kUnknown,
+        k100Continue = 100,
+        k101SwitchingProtocols = 101,
         k200Ok = 200,
         k204NoContent = 204,
+        k206PartialContent = 206,
         k301MovedPermanently = 301,
+        k302Found = 302,
+        k304NotModified = 304,
         k400BadRequest = 400,
         k401Unauthorized = 401,
         k403Forbidden = 403,
         k404NotFound = 404,
+        k405MethodNotAllowed = 405,
+        k408RequestTimeout = 408,
         k409Conflict = 409,
+        k413PayloadTooLarge = 413,
+        k414UriTooLong = 414,
+        k416RangeNotSatisfiable = 416,
+        k417ExpectationFailed = 417,
+        k426UpgradeRequired = 426,
+        k429TooManyRequests = 429,
+        k431RequestHeaderFieldsTooLarge = 431,
         k500InternalServerError = 500,
+        k501NotImplemented = 501,
+        k503ServiceUnavailable = 503,
+    };
+
+    // 标准原因短语，如 404 -> "Not Found"；不认识的状态码返回空
+    static std::string_view reasonPhrase(int code);
+
+    // 响应体中的一段不可变内存，由 owner 保证生命周期，多个响应可以共享同一份
+    struct BodySegment
+    {
+        std::shared_ptr<const void> owner;
+        std::string_view            data;
     };
 
+    // 不小于这个大小的共享段单独发送，不拷进输出缓冲区
+    static const size_t kInlineSegmentSize = 4096;
+
     HttpResponse(bool close = true)
         : statusCode_(kUnknown)
         , closeConnection_(close)
+        , contentLength_(-1)
+        , headerCount_(0)
+        , isFile_(false)
         , sseUpgraded_(false)   // SSE 标志
     {}
 
-    void setVersion(std::string version)
-    { httpVersion_ = version; }
+    // 连接上的下一个请求复用同一个响应对象：清空内容，但保留各个 string/vector 的容量
+    void reset(bool close);
+
+    void setVersion(std::string_view version)
+    { httpVersion_.assign(version.data(), version.size()); }
     void setStatusCode(HttpStatusCode code)
     { statusCode_ = code; }
 
     HttpStatusCode getStatusCode() const
     { return statusCode_; }
 
-    void setStatusMessage(const std::string message)
-    { statusMessage_ = message; }
+    // 和标准原因短语相同时可以不设置，序列化时使用预先格式化好的状态行
+    void setStatusMessage(std::string_view message)
+    { statusMessage_.assign(message.data(), message.size()); }
 
     void setCloseConnection(bool on)
     { closeConnection_ = on; }
@@ -45,17 +93,78 @@ public:
     bool closeConnection() const
     { return closeConnection_; }
     
-    void setContentType(const std::string& contentType)
-    { addHeader("Content-Type", contentType); }
+    void setContentType(std::string_view contentType)
+    { addHeader(HttpHeaders::kContentType, contentType); }
 
+    // Content-Length 默认按 bodySize() 计算，只有响应体和实际长度不一致时（HEAD）才需要显式设置
     void setContentLength(uint64_t length)
-    { addHeader("Content-Length", std::to_string(length)); }
+    { contentLength_ = static_cast<int64_t>(length); }
 
-    void addHeader(const std::string& key, const std::string& value)
-    { headers_[key] = value; }
+    // 同名字段（不区分大小写）已存在时覆盖旧值。
+    // Content-Length 由序列化时统一生成，这里设置的会被忽略；Connection: close 等价于 setCloseConnection(true)
+    void addHeader(std::string_view key, std::string_view value);
+
+    // 常用字段按 id 设置，省掉一次字段名查找
+    void addHeader(HttpHeaders::Known id, std::string_view value);
+
+    // 已设置的字段值（字段名不区分大小写），没有返回空
+    std::string_view getHeader(HttpHeaders::Known id) const;
+    std::string_view getHeader(std::string_view key) const;
     
+    // 拷贝一份（适合小的 JSON）
     void setBody(const std::string& body)
-    { body_ = body; }
+    {
+        segments_.clear();
+        body_.assign(body);
+    }
+
+    // 接管字符串，不拷贝
+    void setBody(std::string&& body)
+    {
+        segments_.clear();
+        body_ = std::move(body);
+    }
+
+    // 共享不可变的响应体（静态页面、缓存的 JSON）：每个响应只增加一次引用计数
+    void setBody(std::shared_ptr<const std::string> body)
+    {
+        body_.clear();
+        segments_.clear();
+        std::string_view data(*body);
+        segments_.push_back(BodySegment{std::move(body), data});
+    }
+
+    // 在响应体末尾追加一段共享内存（如 mmap 的文件）
+    void addBodySegment(std::shared_ptr<const void> owner, std::string_view data)
+    { segments_.push_back(BodySegment{std::move(owner), data}); }
+
+    size_t bodySize() const
+    {
+        size_t size = body_.size();
+        for (const auto& segment : segments_)
+        {
+            size += segment.data.size();
+        }
+        return size;
+    }
+
+    // 整个响应体恰好是一段共享内存时返回它（可按 owner 缓存派生结果，如压缩后的版本），否则返回 nullptr
+    const BodySegment* sharedBody() const
+    { return body_.empty() && segments_.size() == 1 ? &segments_[0] : nullptr; }
+
+    // 以连续内存的形式取响应体；有多段时会先合并成一份拷贝（中间件改写响应体时用）
+    std::string_view body();
+
+    // HEAD：丢掉响应体，Content-Length 保持为 GET 时的长度（handler 已显式设置的不变）
+    void discardBody()
+    {
+        if (contentLength_ < 0)
+        {
+            contentLength_ = static_cast<int64_t>(bodySize());
+        }
+        body_.clear();
+        segments_.clear();
+    }
 
     void setStatusLine(const std::string& version,
                          HttpStatusCode statusCode,
@@ -65,18 +174,99 @@ public:
 
     void appendToBuffer(muduo::net::Buffer* outputBuf) const;
 
+    // 只追加响应体（HTTP/2 的头部和响应体分开成帧）
+    void appendBodyToBuffer(muduo::net::Buffer* outputBuf) const;
+
+    // 序列化时 Content-Length 的值；1xx、204、304 和流式响应不带 Content-Length，返回 -1
+    int64_t contentLengthValue() const;
+
+    // 依次取出 handler 设置的字段 f(name, value)，name 为规范写法（HTTP/2 按 HPACK 编码头部时用）。
+    // Content-Length、Connection 不在其中，分别见 contentLengthValue()、closeConnection()
+    template <typename F>
+    void forEachHeader(F f) const
+    {
+        for (size_t i = 0; i < headerCount_; ++i)
+        {
+            const Field& field = headers_[i];
+            f(field.id == HttpHeaders::kUnknown ? std::string_view(field.key) : HttpHeaders::name(field.id),
+              std::string_view(field.value));
+        }
+    }
+
+    // 当前时间的 HTTP 日期（"Sun, 06 Nov 1994 08:49:37 GMT"），每个线程每秒格式化一次
+    static std::string_view currentDate();
+
+    // 状态行和头部（含结尾的空行），先算好总长度再一次性写进 outputBuf
+    void appendHeadersToBuffer(muduo::net::Buffer* outputBuf) const;
+
+    // 发送整个响应：小的部分追加到 output 由调用方统一发送，大的共享段直接写到连接上
+    void writeTo(const muduo::net::TcpConnectionPtr& conn, muduo::net::Buffer* output) const;
+
+    // 大响应体分片发送（SlicedSender）时用：头部和 body_ 追加到 output，共享段移交给调用方
+    std::vector<BodySegment> releaseSegments(muduo::net::Buffer* output);
+
+    // 由 ResponseStream::start() 设置：响应体随后分块发送，头部里不再带 Content-Length
+    void setStream(std::shared_ptr<ResponseStream> stream)
+    { stream_ = std::move(stream); }
+
+    bool isStreaming() const
+    { return stream_ != nullptr; }
+
+    // 头部发出后 HttpServer 取走流，响应对象不再持有（否则 连接 -> 响应 -> 流 -> 连接 成环）
+    std::shared_ptr<ResponseStream> releaseStream()
+    { return std::move(stream_); }
+
+    // 由 DeferredResponse::start() 设置：handler 返回后响应还没填好，完成后才执行后置中间件并发送
+    void setDeferred(std::shared_ptr<DeferredResponse> deferred)
+    { deferred_ = std::move(deferred); }
+
+    bool isDeferred() const
+    { return deferred_ != nullptr; }
+
+    std::shared_ptr<DeferredResponse> releaseDeferred()
+    { return std::move(deferred_); }
+
+    // 由 WebSocket::accept() 设置：101 发出之后连接交给这个 WebSocket
+    void setWebSocket(std::shared_ptr<WebSocket> ws)
+    { webSocket_ = std::move(ws); }
+
+    bool isWebSocket() const
+    { return webSocket_ != nullptr; }
+
+    std::shared_ptr<WebSocket> releaseWebSocket()
+    { return std::move(webSocket_); }
+
     // ===== SSE 扩展 =====
     // 标记此响应已被 SSE 处理器接管，HttpServer 不应再发送响应
     void markAsSseUpgraded() { sseUpgraded_ = true; }
     bool isSseUpgraded() const { return sseUpgraded_; }
 
+private:
+    // id 为 kUnknown 时字段名存在 key 里，否则序列化时用 HttpHeaders::name(id)
+    struct Field
+    {
+        HttpHeaders::Known id;
+        std::string        key;
+        std::string        value;
+    };
+
+    void setField(HttpHeaders::Known id, std::string_view key, std::string_view value);
+    char* appendStatusLine(char* p) const;
+    size_t statusLineLength() const;
+
 private:
     std::string                        httpVersion_; 
     HttpStatusCode                     statusCode_;
     std::string                        statusMessage_;
     bool                               closeConnection_;
-    std::map<std::string, std::string> headers_;
-    std::string                        body_;
+    int64_t                            contentLength_; // 显式设置的 Content-Length，-1 表示按 bodySize() 计算
+    std::vector<Field>                 headers_; // 前 headerCount_ 个有效，后面的槽位留给下次复用
+    size_t                             headerCount_;
+    std::string                        body_;     // 自有的响应体
+    std::vector<BodySegment>           segments_; // 跟在 body_ 后面的共享段
+    std::shared_ptr<ResponseStream>    stream_;   // 流式响应
+    std::shared_ptr<DeferredResponse>  deferred_; // 延迟完成的响应
+    std::shared_ptr<WebSocket>         webSocket_; // WebSocket 握手
     bool                               isFile_;
     bool                               sseUpgraded_;   // SSE 升级标志
 };
@@ -4,20 +4,37 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <muduo/net/TcpServer.h>
+#include <muduo/net/Channel.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThread.h>
 #include <muduo/base/Logging.h>
 
+#include "AdmissionControl.h"
+#include "CpuLayout.h"
+#include "FileCache.h"
+#include "DeferredResponse.h"
+#include "Http2Session.h"
 #include "HttpContext.h"
+#include "HttpLimits.h"
 #include "HttpRequest.h"
 #include "HttpResponse.h"
+#include "ListenerDrain.h"
+#include "ResponseStream.h"
+#include "TimingWheel.h"
+#include "UringTransport.h"
+#include "WebSocket.h"
+#include "WorkerPool.h"
 #include "../router/Router.h"
+#include "../router/StaticFileHandler.h"
 #include "../session/SessionManager.h"
 #include "../middleware/MiddlewareChain.h"
 #include "../middleware/cors/CorsMiddleware.h"
@@ -34,17 +51,78 @@ class HttpServer : muduo::noncopyable
 {
 public:
     using HttpCallback = std::function<void (const http::HttpRequest&, http::HttpResponse*)>;
+
+    // 网络层
+    enum Backend
+    {
+        kEpoll, // muduo 的 EventLoop，每条连接各自 read/write
+        kUring, // io_uring，见 UringTransport
+    };
+
+    static const size_t kDefaultWorkerQueueSize = 1024;
     
     HttpServer(int port,
                const std::string& name,
                bool useSSL = false,
                muduo::net::TcpServer::Option option = muduo::net::TcpServer::kNoReusePort);
+    ~HttpServer();
     
     void setThreadNum(int numThreads)
     {
         server_.setThreadNum(numThreads);
     }
 
+    // 按 CPU 拓扑放置 I/O 线程，需在 start() 之前设置：线程数取 layout.ioThreads()，
+    // 每个 I/O 线程（多 acceptor 模式下为各 acceptor 线程）绑到一个物理核。
+    // 主线程不绑核：之后由它创建的线程和 upgrade() 启动的新进程都会继承它的 CPU 集合
+    void setThreadPlacement(const CpuLayout& layout)
+    {
+        cpuLayout_ = &layout;
+        server_.setThreadNum(layout.ioThreads());
+    }
+
+    // SO_REUSEPORT 多 acceptor 模式：构造时须传 kReusePort，需在 start() 之前设置。
+    // 开 numAcceptors 个监听 socket，各自在一个 EventLoop 上 accept 并处理自己的连接（第 0 个用主循环），
+    // 新连接由内核分给各 socket，不再全部经过主循环 accept；此模式下 setThreadNum 不生效。
+    // steerByCpu 时挂一个 CBPF 程序，按收到 SYN 的 CPU 选 socket（cpu % numAcceptors），
+    // 配合网卡 RSS 和线程绑核，连接从收包到处理都留在同一个 CPU 上
+    void setReusePortAcceptors(int numAcceptors, bool steerByCpu = false)
+    {
+        numAcceptors_ = numAcceptors;
+        steerByCpu_ = steerByCpu;
+    }
+
+    // 选择网络层，需在 start() 之前设置，默认 kEpoll。
+    // kUring：每个 I/O 线程各开一个 SO_REUSEPORT 监听 socket，accept/recv/send 都经过本线程的 io_uring，
+    // 一批完成事件只要一次 epoll_wait 和一次 io_uring_enter；需要构造时传 kReusePort，setReusePortAcceptors 不生效。
+    // 请求仍经过同样的 HttpContext 解析、中间件和路由；needsConnection() 为 true 的路由
+    // （SSE、流式响应等）和带 Expect 的请求在请求头解析完之后把连接交还给 epoll 处理。
+    // 内核不支持、没有传 kReusePort 或启用了 TLS 时记日志并使用 kEpoll。
+    // 实验性：只有以 HTTP_WITH_IO_URING 编译时才可用，否则同样记日志并使用 kEpoll
+    void setBackend(Backend backend)
+    {
+        backend_ = backend;
+    }
+
+    Backend backend() const
+    {
+        return backend_;
+    }
+
+    // 工作线程池：offload() 返回 true 的路由在这里执行，需在 start() 之前设置。
+    // numThreads 为 0（默认）时所有 handler 都在 I/O 线程执行；排队超过 maxQueueSize 的请求直接回 503
+    void setWorkerThreadNum(int numThreads, size_t maxQueueSize = kDefaultWorkerQueueSize)
+    {
+        workerPool_.reset(numThreads > 0 ? new WorkerPool(server_.name() + "-worker", numThreads, maxQueueSize)
+                                         : nullptr);
+    }
+
+    // 协程 handler 通过 coro::runBlocking() 把阻塞调用放到这里执行；没有设置工作线程时为空
+    WorkerPool* workerPool() const
+    {
+        return workerPool_.get();
+    }
+
     void start();
 
     muduo::net::EventLoop* getLoop() const 
@@ -87,6 +165,21 @@ public:
         router_.addRegexCallback(method, path, callback);
     }
 
+    // 把回调包装成在工作线程池中执行的 handler，如 server.Get("/api/x", HttpServer::offloaded(cb))
+    static router::Router::HandlerPtr offloaded(const HttpCallback& cb);
+
+    // urlPrefix 下的 GET/HEAD 请求映射到 root 目录中的静态文件，如 serveStatic("/static/", "./public")
+    void serveStatic(const std::string& urlPrefix, const std::string& root,
+                     const std::string& cacheControl = "no-cache");
+
+    // 单个路径映射到一个文件，如 serveFile("/", "./index.html")
+    void serveFile(const std::string& path, const std::string& file,
+                   const std::string& cacheControl = "no-cache");
+
+    // path 上的 GET 请求按 WebSocket 握手处理（前置中间件照常执行，可以做鉴权），
+    // 升级之后的消息交给 handler，在连接所属的 I/O 线程回调。同一个 handler 可以注册到多个路径
+    void serveWebSocket(const std::string& path, std::shared_ptr<WebSocketHandler> handler);
+
     void setSessionManager(std::unique_ptr<session::SessionManager> manager)
     {
         sessionManager_ = std::move(manager);
@@ -109,31 +202,223 @@ public:
 
     void setSslConfig(const ssl::SslConfig& config);
 
+    // HTTP/2，需在 setSslConfig() 和 start() 之前设置，编译时要定义 HTTP_WITH_NGHTTP2（否则记日志后忽略）。
+    // TLS 连接经 ALPN 协商 h2（配置里没有指定 ALPN 时默认提供 "h2"、"http/1.1"）；
+    // 明文连接支持 prior knowledge 和不带请求体的 Upgrade: h2c。
+    // 每个流的请求照常经过中间件和路由，handler 不需要区分协议；只支持 epoll 后端
+    void enableHttp2(bool enable)
+    {
+        http2_ = enable;
+    }
+
+    // 请求体/请求头大小限制和连接超时，需在 start() 之前设置
+    void setLimits(const HttpLimits& limits)
+    {
+        limits_ = limits;
+    }
+
+    // 连接数上限和过载时的快速 503，需在 start() 之前设置；默认只按 fd 上限限制连接数
+    void setAdmissionLimits(const AdmissionLimits& limits)
+    {
+        admission_.setLimits(limits);
+    }
+
+    const AdmissionControl& admission() const
+    {
+        return admission_;
+    }
+
+    // 优雅退出：停止监听（accept 队列里已经握手完成的连接先接进来，见 ListenerDrain），空闲的 keep-alive 连接立即关闭，之后的响应都带 Connection: close；
+    // 在途请求和流式响应（SSE）最多再等 timeout 秒，到期后 start() 返回，剩下的连接随服务器析构关闭。
+    // 任意线程可调用，重复调用无效
+    void drain(double timeout);
+
+    bool draining() const
+    {
+        return draining_.load(std::memory_order_relaxed);
+    }
+
+    // 热升级：用同样的命令行和环境变量启动新版本的可执行文件，新进程开始监听之后本进程 drain。
+    // 新旧进程靠 SO_REUSEPORT 同时监听同一端口，构造时须传 kReusePort；
+    // 新进程启动失败（监听之前退出）时本进程照常服务。任意线程可调用
+    void upgrade(double drainTimeout);
+
+    // SIGTERM/SIGINT 触发 drain，SIGUSR2 触发 upgrade，需在 start() 之前调用
+    void handleSignals(double drainTimeout);
+
+    // 屏蔽上面几个信号，之后它们只能从 signalfd 读到。要在 main 开头、创建任何线程之前调用，
+    // 否则没屏蔽的线程收到信号会按默认动作直接退出进程
+    static void blockSignals();
+
 private:
+    // 单个请求处理完之后连接的去向
+    enum RequestResult
+    {
+        kContinue, // 继续处理缓冲区里的下一个请求
+        kClose,    // 响应发出后关闭连接
+        kUpgraded, // 连接已被 handler 接管（流式响应、SSE）或请求交给了工作线程，暂不按 HTTP 请求解析
+        kDeferred, // 响应延迟完成（DeferredResponse），请求对象要保留到完成为止
+        kHandOver, // io_uring 后端：路由要用到连接，交还给 epoll 之后再处理这个请求
+    };
+
+    // 发送之后输出缓冲区超过这个容量就收缩
+    static const size_t kMaxRetainedOutputCapacity = 64 * 1024;
+
+    static bool isSafeMethod(HttpRequest::Method method)
+    {
+        return method == HttpRequest::kGet || method == HttpRequest::kHead ||
+               method == HttpRequest::kOptions;
+    }
+
     void initialize();
+    void setCallbacks(muduo::net::TcpServer* server);
+    // 多 acceptor 模式下依次启动各个监听 socket
+    void startAcceptors();
+    // kUring 的前提不满足时退回 kEpoll
+    void checkBackend();
 
+    void onThreadInit(muduo::net::EventLoop* loop);
     void onConnection(const muduo::net::TcpConnectionPtr& conn);
     void onMessage(const muduo::net::TcpConnectionPtr& conn,
                    muduo::net::Buffer* buf,
                    muduo::Timestamp receiveTime);
-    void onRequest(const muduo::net::TcpConnectionPtr&, const HttpRequest&);
+    void processInput(const muduo::net::TcpConnectionPtr& conn,
+                      muduo::net::Buffer* buf,
+                      muduo::Timestamp receiveTime);
+    RequestResult onRequest(const muduo::net::TcpConnectionPtr&, HttpContext* context);
+    // handler 执行完之后：序列化响应（或开始流式响应），返回连接的去向
+    RequestResult sendResponse(const muduo::net::TcpConnectionPtr& conn,
+                               HttpContext* context,
+                               const HttpRequest& req,
+                               HttpResponse& response);
+    // 把请求交给工作线程池；队列满时直接回 503
+    RequestResult offloadRequest(const muduo::net::TcpConnectionPtr& conn, HttpContext* context, bool close);
+    void onOffloadComplete(const muduo::net::TcpConnectionPtr& conn,
+                           const std::shared_ptr<HttpRequest>& req,
+                           const std::shared_ptr<HttpResponse>& resp);
+    void onDeferredComplete(const std::weak_ptr<muduo::net::TcpConnection>& weakConn);
+    // 请求头解析完成、请求体尚未读取时调用：按路由决定是否流式接收请求体
+    RequestResult onHeaders(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    // Expect: 100-continue 的提前检查；返回 false 时 context->response() 为最终响应
+    bool checkContinue(const muduo::net::TcpConnectionPtr& conn,
+                       HttpContext* context,
+                       std::string_view expect,
+                       bool routed,
+                       router::RouterHandler* handler);
+    // drain/upgrade 的实际执行，都在 mainLoop_ 里
+    void startDrain(double timeout);
+    void startUpgrade(double drainTimeout);
+    // 找出本进程里监听 listenAddr_ 的 socket，交给 listenerDrain_ 在 accept 队列清空后关闭
+    void stopListening();
+    // drain 期间定时调用：关闭 accept 队列已空的监听 socket，全部关闭后再清理一遍空闲连接
+    void closeListeners();
+    // 在各个 I/O 线程里关闭没有请求在处理的连接
+    void closeIdleConnections();
+    void checkDrained();
+    // 处理连接的所有 EventLoop
+    std::vector<muduo::net::EventLoop*> ioLoops();
+    // 连接在等下一个请求，缓冲区里也没有半个请求
+    static bool isIdle(HttpContext* context, muduo::net::Buffer* input);
+    void onSignal();
+    void onUpgradeReady(double drainTimeout);
+    // 本进程是由 upgrade() 启动的新版本：开始监听之后通知旧进程
+    void notifyUpgradeReady();
+    // 当前请求（如果计入了在途请求）结束
+    void endRequest(HttpContext* context);
+    // 按连接所处阶段重新安排超时；pendingBytes 是输入缓冲区里尚未解析完的字节数
+    void armTimeout(HttpContext* context, size_t pendingBytes);
+    void scheduleTimeout(HttpContext* context, HttpContext::TimeoutKind kind);
+    void onTimeout(const std::weak_ptr<muduo::net::TcpConnection>& weakConn);
+    // 挂起的请求（流式响应、工作线程中的 handler）完成后：继续处理缓冲区里的请求，或关闭连接
+    void resume(const std::weak_ptr<muduo::net::TcpConnection>& weakConn, bool close);
+    const std::shared_ptr<FileCache>& fileCache();
+    // 响应之后是否关闭连接
+    bool closeAfter(const HttpRequest& req) const;
+    // 请求头解析完成后的过载检查：拒绝时返回原因，context->outputBuffer() 里是 503
+    const char* admitRequest(HttpContext* context);
+
+    // io_uring 后端上的请求处理，和上面 epoll 的各个函数一一对应；
+    // handler 拿到的 conn 为空，响应整份序列化到输出缓冲区
+    void onUringConnection(const UringConnectionPtr& conn);
+    void processUringInput(const UringConnectionPtr& conn,
+                           muduo::net::Buffer* buf,
+                           muduo::Timestamp receiveTime);
+    RequestResult onUringRequest(const UringConnectionPtr& conn, HttpContext* context);
+    RequestResult sendUringResponse(HttpContext* context, const HttpRequest& req, HttpResponse& response);
+    RequestResult offloadUringRequest(const UringConnectionPtr& conn, HttpContext* context, bool close);
+    void onUringOffloadComplete(const UringConnectionPtr& conn,
+                                const std::shared_ptr<HttpRequest>& req,
+                                const std::shared_ptr<HttpResponse>& resp);
+    void resumeUring(const UringConnectionPtr& conn, bool close);
+    void onUringTimeout(const std::weak_ptr<UringConnection>& weakConn);
+    // 交接完成：fd 包成 TcpConnection，从请求头之后接着处理
+    void adoptConnection(const std::shared_ptr<HttpContext>& context,
+                         muduo::net::EventLoop* loop,
+                         const muduo::net::InetAddress& peer,
+                         int fd,
+                         muduo::net::Buffer* input,
+                         muduo::net::Buffer* output);
+
+    // HTTP/2 连接（见 Http2Session）：连接上的数据都交给会话，每个流收完请求之后走 handleRequest
+    Http2Session* startHttp2(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void processHttp2Input(HttpContext* context, muduo::net::Buffer* buf);
+    // 按会话的状态安排连接的计时：空闲超时，或者还在收请求的流里最早的期限
+    void scheduleHttp2Timeout(HttpContext* context);
+    // 刚收完的请求要求 Upgrade: h2c：回 101 并把它作为流 1 处理；条件不满足时返回 false，照常按 HTTP/1.1 处理
+    bool upgradeHttp2(const muduo::net::TcpConnectionPtr& conn, HttpContext* context, muduo::net::Buffer* buf);
+    // 流的请求头收完：过载检查和请求体的接收方式，对应 onHeaders
+    bool onHttp2Headers(const std::weak_ptr<muduo::net::TcpConnection>& weakConn,
+                        const Http2Session::StreamPtr& stream);
+    void onHttp2Request(const std::weak_ptr<muduo::net::TcpConnection>& weakConn,
+                        const Http2Session::StreamPtr& stream);
+    void onHttp2OffloadComplete(const muduo::net::TcpConnectionPtr& conn, const Http2Session::StreamPtr& stream);
+    void sendHttp2Response(const muduo::net::TcpConnectionPtr& conn, const Http2Session::StreamPtr& stream);
+    void onHttp2DeferredComplete(const std::weak_ptr<muduo::net::TcpConnection>& weakConn,
+                                 const Http2Session::StreamPtr& stream);
+    void onHttp2StreamClose(const std::weak_ptr<muduo::net::TcpConnection>& weakConn,
+                            const Http2Session::StreamPtr& stream);
+    // 流结束时释放它占的在途请求（handler 还在工作线程里执行的除外）
+    void finishHttp2Stream(const Http2Session::StreamPtr& stream);
 
     // ★ handleRequest 新增 conn 参数，供 SSE handler 直接持有连接
     void handleRequest(const muduo::net::TcpConnectionPtr& conn,
-                       const HttpRequest& req,
-                       HttpResponse* resp);
+                       HttpRequest& req,
+                       HttpResponse* resp,
+                       bool beforeDone = false);
     
 private:
+    muduo::net::EventLoop                        mainLoop_; // 先于 server_ 构造、后于它析构
     muduo::net::InetAddress                      listenAddr_;
     muduo::net::TcpServer                        server_; 
-    muduo::net::EventLoop                        mainLoop_;
     HttpCallback                                 httpCallback_;
     router::Router                               router_;
     std::unique_ptr<session::SessionManager>     sessionManager_;
     middleware::MiddlewareChain                  middlewareChain_;
     std::unique_ptr<ssl::SslContext>             sslCtx_;
     bool                                         useSSL_;
-    std::map<muduo::net::TcpConnectionPtr, std::unique_ptr<ssl::SslConnection>> sslConns_;
+    bool                                         http2_;
+    Backend                                      backend_;
+    HttpLimits                                   limits_;
+    AdmissionControl                             admission_;
+    const CpuLayout*                             cpuLayout_;
+    std::atomic<int>                             ioThreadIndex_; // 下一个初始化的 I/O 线程绑第几个核
+    bool                                         reusePort_;    // 构造时传了 kReusePort
+    int                                          numAcceptors_; // 大于 1 时为多 acceptor 模式
+    bool                                         steerByCpu_;
+    std::vector<std::unique_ptr<muduo::net::EventLoopThread>> acceptorThreads_;
+    std::vector<std::unique_ptr<muduo::net::TcpServer>>       acceptors_; // 第 1..n-1 个，第 0 个是 server_
+    std::atomic<bool>                            draining_;
+    muduo::Timestamp                             drainDeadline_;
+    std::unique_ptr<ListenerDrain>               listenerDrain_; // 还没关闭的监听 socket
+    muduo::Timestamp                             listenerDeadline_; // 到期后不再等 accept 队列清空
+    double                                       drainTimeout_; // 信号触发 drain/upgrade 时用
+    int                                          signalFd_;
+    std::unique_ptr<muduo::net::Channel>         signalChannel_;
+    pid_t                                        upgradePid_;   // 正在启动的新进程
+    int                                          upgradeFd_;    // 新进程监听之后往管道里写一个字节
+    std::unique_ptr<muduo::net::Channel>         upgradeChannel_;
+    std::shared_ptr<FileCache>                   fileCache_; // 第一次注册静态文件路由时创建，inotify 挂在 mainLoop_ 上
+    std::unique_ptr<WorkerPool>                  workerPool_; // 最后声明、最先析构：先等工作线程退出
 }; 
 
 } // namespace http
\ No newline at end of file
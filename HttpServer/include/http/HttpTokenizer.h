@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "HttpRequest.h"
+
+namespace http
+{
+namespace tokenizer
+{
+
+/*
+    HTTP/1.x 请求行和请求头的分隔符扫描。
+    思路来自 picohttpparser：一次比较 16/32 个字节，用 movemask 拿到命中位置，
+    只在尾部不足一个向量宽度时退回逐字节扫描。
+      - 编译时带 -mavx2        走 32 字节的 AVX2 路径
+      - 带 -msse4.2           找多个字符时用 pcmpestri
+      - x86-64 默认的 SSE2    16 字节路径
+      - 其他平台              标量实现
+    所有函数都只读 [begin, end)，不会越界读取。
+ */
+
+// 查找第一个 c，找不到返回 end
+const char* findByte(const char* begin, const char* end, char c);
+
+// 查找第一个 a 或 b，找不到返回 end
+const char* findEither(const char* begin, const char* end, char a, char b);
+
+// 查找第一个 "\r\n"，返回指向 '\r' 的指针；找不到返回 nullptr（和 Buffer::findCRLF 一致）
+const char* findCRLF(const char* begin, const char* end);
+
+// 去掉首尾的空白（空格和水平制表符）
+inline const char* skipSpaces(const char* begin, const char* end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+inline const char* trimTrailingSpaces(const char* begin, const char* end)
+{
+    while (end > begin && (*(end - 1) == ' ' || *(end - 1) == '\t'))
+    {
+        --end;
+    }
+    return end;
+}
+
+// 方法名最长 7 个字节，连同长度（放在最高字节）装进一个 64 位整数，
+// 再用一次 switch 判断，不再构造 std::string
+constexpr uint64_t packMethod(const char* s, size_t len)
+{
+    uint64_t word = static_cast<uint64_t>(len) << 56;
+    for (size_t i = 0; i < len; ++i)
+    {
+        word |= static_cast<uint64_t>(static_cast<unsigned char>(s[i])) << (8 * i);
+    }
+    return word;
+}
+
+inline HttpRequest::Method parseMethod(const char* begin, const char* end)
+{
+    size_t len = static_cast<size_t>(end - begin);
+    if (len < 3 || len > 7)
+    {
+        return HttpRequest::kInvalid;
+    }
+
+    switch (packMethod(begin, len))
+    {
+        case packMethod("GET", 3):     return HttpRequest::kGet;
+        case packMethod("POST", 4):    return HttpRequest::kPost;
+        case packMethod("HEAD", 4):    return HttpRequest::kHead;
+        case packMethod("PUT", 3):     return HttpRequest::kPut;
+        case packMethod("DELETE", 6):  return HttpRequest::kDelete;
+        case packMethod("OPTIONS", 7): return HttpRequest::kOptions;
+        default:                       return HttpRequest::kInvalid;
+    }
+}
+
+} // namespace tokenizer
+} // namespace http
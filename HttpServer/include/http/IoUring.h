@@ -0,0 +1,115 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+
+namespace http
+{
+
+/*
+    io_uring 的最小封装，直接用系统调用，不依赖 liburing：
+      - 一个 SQ/CQ 环，getSqe() 取到的 SQE 先攒着，submit() 一次 io_uring_enter 全部提交
+      - 一组预先交给内核的接收缓冲区（provided buffers），multishot recv 收到数据时由内核从中挑一块，
+        CQE 里带回块号，用完后 recycleBuffer() 还回去；连接再多也只占这一组内存。
+        归还用 IORING_OP_PROVIDE_BUFFERS，随下一次提交一起进内核。没有用 buffer ring
+        （IORING_REGISTER_PBUF_RING）：部分内核/沙箱上注册成功、取缓冲区时却总是 ENOBUFS
+      - 环本身的 fd 可以放进 epoll：CQ 里有完成事件时可读，由所在的 EventLoop 统一等待
+
+    只在创建它的线程上使用
+ */
+class IoUring : muduo::noncopyable
+{
+public:
+    // entries：SQ 大小（CQ 为两倍）；bufferCount 个 bufferSize 字节的接收缓冲区
+    IoUring(unsigned entries, unsigned bufferCount, size_t bufferSize);
+    ~IoUring();
+
+    // 内核支持本封装用到的全部特性（multishot accept/recv、provided buffers）。
+    // 在 seccomp、io_uring_disabled 等限制下也返回 false
+    static bool supported();
+
+    // 创建失败（内存不足、超出 RLIMIT_MEMLOCK 等）时为 false，此时不能使用
+    bool valid() const
+    { return ringFd_ >= 0; }
+
+    int fd() const
+    { return ringFd_; }
+
+    // 取一个清零的 SQE；SQ 满时先提交已有的，仍取不到时返回 nullptr
+    struct io_uring_sqe* getSqe();
+
+    // 提交 getSqe() 之后攒下的 SQE，不等待完成；返回提交的个数，出错时为 -1
+    int submit();
+
+    // 提交并等待至少 minComplete 个完成事件（只在退出时用，正常运行中由 EventLoop 等待）
+    int submitAndWait(unsigned minComplete);
+
+    // 尚未提交的 SQE 个数
+    unsigned pending() const
+    { return sqeTail_ - submitted_; }
+
+    // 依次处理 CQ 里的完成事件，回调中可以继续 getSqe()；返回处理的个数
+    unsigned forEachCqe(const std::function<void (const struct io_uring_cqe*)>& fn);
+
+    // provided buffer 的组号，prepRecvMultishot 时使用
+    static const uint16_t kBufferGroup = 0;
+
+    // CQE 里带回的块号对应的内存
+    char* buffer(uint16_t bid) const
+    { return buffers_ + static_cast<size_t>(bid) * bufferSize_; }
+
+    size_t bufferSize() const
+    { return bufferSize_; }
+
+    // 数据取走之后把块还给内核（占一个 SQE）；SQ 满、暂时取不到 SQE 时先记下，由 returnBuffers() 补交
+    void recycleBuffer(uint16_t bid);
+
+    // 补交之前没能归还的块，返回仍未归还的个数
+    size_t returnBuffers();
+
+    static void prepProvideBuffers(struct io_uring_sqe* sqe, char* addr, unsigned len, unsigned count,
+                                   uint16_t firstBid);
+    static void prepAcceptMultishot(struct io_uring_sqe* sqe, int fd, uint64_t userData);
+    static void prepRecvMultishot(struct io_uring_sqe* sqe, int fd, uint64_t userData);
+    static void prepSend(struct io_uring_sqe* sqe, int fd, const void* data, size_t len, uint64_t userData);
+    // 取消 user_data 为 target 的请求（multishot 的请求也随之结束）
+    static void prepCancel(struct io_uring_sqe* sqe, uint64_t target, uint64_t userData);
+    // 取消所有在途的请求
+    static void prepCancelAll(struct io_uring_sqe* sqe, uint64_t userData);
+
+private:
+    bool setupRing(unsigned entries);
+    bool setupBuffers();
+
+private:
+    int                        ringFd_;
+    void*                      sqRing_;
+    size_t                     sqRingSize_;
+    void*                      cqRing_;   // IORING_FEAT_SINGLE_MMAP 时和 sqRing_ 相同
+    size_t                     cqRingSize_;
+    struct io_uring_sqe*       sqes_;
+    size_t                     sqesSize_;
+    unsigned*                  sqHead_;
+    unsigned*                  sqTail_;
+    unsigned                   sqMask_;
+    unsigned                   sqEntries_;
+    unsigned*                  cqHead_;
+    unsigned*                  cqTail_;
+    unsigned                   cqMask_;
+    struct io_uring_cqe*       cqes_;
+    unsigned                   sqeTail_;   // 已取出的 SQE，之后提交时写进 *sqTail_
+    unsigned                   submitted_;
+    unsigned                   bufCount_;
+    size_t                     bufferSize_;
+    char*                      buffers_;
+    std::vector<uint16_t>      unreturned_; // 取不到 SQE 没能归还的块，丢掉的话共用的缓冲区会越用越少
+};
+
+} // namespace http
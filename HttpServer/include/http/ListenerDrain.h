@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+
+namespace http
+{
+
+/*
+    drain 时关闭监听 socket。SO_REUSEPORT 组里的 socket 一关闭，已经完成握手、还排在它 accept 队列里的连接
+    都会被内核 RST（5.14 以后的内核开了 net.ipv4.tcp_migrate_req 才会转给组里其他 socket，不能指望）。
+    所以不立即关闭：Acceptor 照常 accept，每次 poll() 只关闭 accept 队列已经空了的 socket。
+    新进程已经加入同一个 reuseport 组分担新连接，队列一般在下一次检查时就是空的；
+    一直过载、队列总不空的，到了期限由调用方 poll(true) 强制关闭。
+    队列长度的查询和关闭操作由构造时传入，单元测试里换成假的
+ */
+class ListenerDrain : muduo::noncopyable
+{
+public:
+    using QueueLength = std::function<int(int fd)>; // 小于 0 表示查询失败
+    using Close = std::function<void(int fd)>;
+
+    ListenerDrain(std::vector<int> fds, QueueLength queueLength, Close close);
+
+    // 检查一次：关闭 accept 队列已空（或查询失败）的 socket，force 为 true 时全部关闭。返回这次关闭的个数
+    size_t poll(bool force);
+
+    bool done() const
+    { return fds_.empty(); }
+
+    size_t remaining() const
+    { return fds_.size(); }
+
+    // 监听 socket 的 accept 队列里等着 accept 的连接数（TCP_INFO 的 tcpi_unacked），失败返回 -1
+    static int acceptQueueLength(int fd);
+
+private:
+    std::vector<int> fds_;
+    QueueLength      queueLength_;
+    Close            close_;
+};
+
+} // namespace http
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace http
+{
+
+/*
+    每个请求独占的小型内存池（按块分配，只增不减）。
+    请求行、请求头等解析结果整段拷贝进来，HttpRequest 只保存指向这里的 string_view，
+    省掉每个字段一次 malloc。块一旦分配地址就不再移动，所以已经发出去的 view 一直有效，
+    直到 reset() 为止。
+ */
+class RequestArena
+{
+public:
+    static const size_t kDefaultBlockSize = 4096;
+
+    explicit RequestArena(size_t blockSize = kDefaultBlockSize)
+        : blockSize_(blockSize)
+        , current_(0)
+        , used_(0)
+    {}
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+    RequestArena(RequestArena&&) = default;
+    RequestArena& operator=(RequestArena&&) = default;
+
+    // 分配 n 字节（不对齐，只用于存放字符数据）
+    char* allocate(size_t n)
+    {
+        if (current_ < blocks_.size() && blocks_[current_].size - used_ >= n)
+        {
+            char* p = blocks_[current_].data.get() + used_;
+            used_ += n;
+            return p;
+        }
+        return allocateSlow(n);
+    }
+
+    // 把 [begin, end) 拷贝进内存池，返回指向副本的 view
+    std::string_view copy(const char* begin, const char* end)
+    {
+        size_t n = static_cast<size_t>(end - begin);
+        if (n == 0)
+        {
+            return std::string_view();
+        }
+        char* p = allocate(n);
+        std::copy(begin, end, p);
+        return std::string_view(p, n);
+    }
+
+    std::string_view copy(std::string_view s)
+    { return copy(s.data(), s.data() + s.size()); }
+
+    // 回收全部内存供下一个请求复用；超大的块直接释放，避免长期占着
+    void reset();
+
+    void swap(RequestArena& that)
+    {
+        std::swap(blockSize_, that.blockSize_);
+        blocks_.swap(that.blocks_);
+        std::swap(current_, that.current_);
+        std::swap(used_, that.used_);
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t                  size;
+    };
+
+    char* allocateSlow(size_t n);
+
+private:
+    size_t             blockSize_; // 常规块大小
+    std::vector<Block> blocks_;    // 已分配的块
+    size_t             current_;   // 当前正在使用的块下标
+    size_t             used_;      // 当前块已用字节数
+};
+
+} // namespace http
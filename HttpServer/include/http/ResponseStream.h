@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "Http2Session.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+namespace http
+{
+
+/*
+    流式响应：响应体边生成边发送，长度事先未知（导出、SSE、大模型逐 token 输出）。
+      - HTTP/1.1 用 chunked 编码，finish() 之后连接回到 keep-alive，继续处理后面的请求；
+        HTTP/1.0 没有 chunked，响应体以关闭连接结束
+      - write()/sendEvent()/finish() 可以在任意线程调用：数据先按帧格式追加到 pending_，
+        再投递一次 flush 到连接所在的 I/O 线程，同一轮里多次写入只发一次
+      - 背压：连接输出缓冲区超过高水位时暂停（writable() 返回 false），
+        对端读完（write complete）后恢复并调用 writableCallback；
+        不理会背压、积压超过 maxBufferedBytes 的流直接断开，内存不会无限增长
+      - HTTP/2 的请求：数据按 DATA 帧交给连接的 Http2Session，finish() 结束的是这个流而不是连接；
+        背压看的是这个流在对方流量控制窗口之外积压的数据，abort() 只重置这个流
+ */
+class ResponseStream : public std::enable_shared_from_this<ResponseStream>,
+                       muduo::noncopyable
+{
+public:
+    using Callback = std::function<void()>;
+
+    static const size_t kDefaultHighWaterMark = 256 * 1024;
+    static const size_t kDefaultMaxBufferedBytes = 8 * 1024 * 1024;
+
+    // 在 handler 中（I/O 线程）调用，把 resp 变成流式响应。
+    // 状态码和头部照常设置在 resp 上，由 HttpServer 在 handler 返回后连同前面流水线的响应按序发出；
+    // 在那之前写入的数据先缓存着
+    static std::shared_ptr<ResponseStream> start(const muduo::net::TcpConnectionPtr& conn,
+                                                 const HttpRequest& req,
+                                                 HttpResponse* resp);
+
+    // 追加一段响应体；返回 false 表示应暂停生产（背压或流已结束）
+    bool write(std::string_view data);
+
+    // 按 text/event-stream 格式写一个事件，多行 data 会拆成多个 "data:" 行
+    bool sendEvent(std::string_view data, std::string_view event = std::string_view(),
+                   std::string_view id = std::string_view());
+
+    // SSE 注释行（": text"），用作心跳
+    bool sendComment(std::string_view text);
+
+    // 正常结束：写出 chunked 的结束块；重复调用无效
+    void finish();
+
+    // 异常结束：丢弃未发送的数据并断开连接
+    void abort();
+
+    // 当前是否可以继续写
+    bool writable() const;
+
+    // 流已结束或连接已断开
+    bool closed() const;
+
+    // 暂停后恢复可写时在 I/O 线程回调
+    void setWritableCallback(Callback cb);
+
+    // 需在 start() 之后、handler 返回之前设置
+    void setHighWaterMark(size_t bytes)
+    { highWaterMark_ = bytes; }
+
+    void setMaxBufferedBytes(size_t bytes)
+    { maxBufferedBytes_ = bytes; }
+
+    const muduo::net::TcpConnectionPtr& connection() const
+    { return conn_; }
+
+    // HTTP/2 的流 id，HTTP/1.x 为 0。同一条 HTTP/2 连接上可以同时有多个流式响应，要区分时用它
+    int32_t streamId() const
+    { return streamId_; }
+
+    // 由 HttpServer 在响应头发出之后调用（I/O 线程）：开始真正发送数据，
+    // 流结束并把剩余数据交给连接后，在 I/O 线程回调 onComplete
+    void open(Callback onComplete);
+
+private:
+    ResponseStream(const muduo::net::TcpConnectionPtr& conn, bool chunked, int32_t streamId);
+
+    // HTTP/2 流所在的会话，连接已经断开时为空
+    Http2Session* http2Session() const;
+
+    // 调用方已持有 mutex_
+    bool scheduleFlushLocked();
+    void appendChunkLocked(std::string_view data);
+
+    void flushInLoop();
+    void abortInLoop();
+    void detachInLoop();
+    void onHighWaterMark();
+    void onWriteComplete();
+    void onStreamClosed();
+
+private:
+    muduo::net::TcpConnectionPtr conn_;
+    const bool                   chunked_;          // chunked 编码，否则以关闭连接结束
+    const int32_t                streamId_;         // HTTP/2 的流，0 表示 HTTP/1.x
+    size_t                       highWaterMark_;
+    size_t                       maxBufferedBytes_;
+
+    mutable std::mutex           mutex_;            // 保护以下到 completed_ 为止的成员
+    muduo::net::Buffer           pending_;          // 已经编码好、等待 flush 的数据
+    bool                         opened_;           // 响应头已发出
+    bool                         flushScheduled_;   // 已投递 flush 尚未执行
+    bool                         finished_;         // 调用过 finish()
+    bool                         aborted_;          // 调用过 abort() 或积压超限
+    bool                         completed_;        // 结束块已交给连接
+
+    muduo::net::Buffer           sending_;          // 仅 I/O 线程使用，和 pending_ 交换
+    std::atomic<bool>            paused_;           // 连接输出缓冲区（HTTP/2 为流的积压）超过高水位
+    Callback                     writableCallback_; // 仅 I/O 线程使用
+    Callback                     onComplete_;       // 仅 I/O 线程使用
+};
+
+} // namespace http
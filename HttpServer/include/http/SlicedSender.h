@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "HttpResponse.h"
+
+namespace http
+{
+
+/*
+    大的共享响应体（mmap 的静态文件）分片发送。
+    TcpConnection::send 写不进内核的部分会整份拷进连接的输出缓冲区，几百 MB 的文件遇上慢客户端，
+    堆上就多了一份同样大的拷贝。这里每次只交给连接 kSliceSize，和 ResponseStream 一样借用连接的
+    write complete 回调：输出缓冲区发空之后再发下一片，堆上的积压不超过一片。
+      - 发送期间连接挂起，后面流水线上的请求等全部发完、onComplete 之后再处理
+      - 只持有连接的 weak_ptr，连接断开时随连接的回调一起释放，mmap 的引用也随之释放
+      - 只在连接所属的 I/O 线程使用
+ */
+class SlicedSender : public std::enable_shared_from_this<SlicedSender>,
+                     muduo::noncopyable
+{
+public:
+    using Callback = std::function<void()>;
+
+    // 响应体不小于这个大小才分片（和 FileCache 改用 mmap 的界限一致）
+    static const size_t kMinSize = 1024 * 1024;
+    // 每次交给连接的字节数
+    static const size_t kSliceSize = 256 * 1024;
+
+    SlicedSender(const muduo::net::TcpConnectionPtr& conn, std::vector<HttpResponse::BodySegment> segments);
+
+    // 发出第一片，之后由 write complete 驱动；全部交给连接之后在 I/O 线程回调 onComplete
+    void start(Callback onComplete);
+
+private:
+    void sendNext();
+
+private:
+    std::weak_ptr<muduo::net::TcpConnection> conn_;
+    std::vector<HttpResponse::BodySegment>   segments_;
+    size_t                                   index_;  // 正在发送的段
+    size_t                                   offset_; // 段内已经交给连接的字节数
+    Callback                                 onComplete_;
+};
+
+} // namespace http
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TimerId.h>
+
+namespace http
+{
+
+/*
+    每个 EventLoop 一个的哈希时间轮，用来做连接的空闲/读请求头/读请求体超时。
+      - 轮子每秒走一格，超时时间按秒取整落到 (当前格 + 秒数) % 格数 的格子里，
+        超过一圈的记录剩余圈数 rounds_
+      - Entry 是侵入式双向链表节点，嵌在 HttpContext 里，重新计时/取消都是 O(1)，
+        不为每次计时分配内存，也不像 muduo runAfter 那样每次都进定时器堆
+    所有操作都必须在所属 EventLoop 的线程里调用；轮子应当和 EventLoop 活得一样久
+    （HttpServer 在线程初始化回调里创建，线程退出时销毁）。
+ */
+class TimingWheel : muduo::noncopyable
+{
+public:
+    class Entry : muduo::noncopyable
+    {
+    public:
+        using Callback = std::function<void()>;
+
+        Entry()
+            : wheel_(nullptr)
+            , prev_(nullptr)
+            , next_(nullptr)
+            , slot_(0)
+            , rounds_(0)
+        {}
+
+        ~Entry()
+        { cancel(); }
+
+        // 到期时在 EventLoop 线程上调用；到期后 Entry 自动从轮子上摘下
+        void setCallback(Callback cb)
+        { callback_ = std::move(cb); }
+
+        bool scheduled() const
+        { return wheel_ != nullptr; }
+
+        void cancel();
+
+    private:
+        friend class TimingWheel;
+
+        TimingWheel* wheel_;  // 所在的轮子，未计时为空
+        Entry*       prev_;
+        Entry*       next_;
+        size_t       slot_;   // 所在格子
+        size_t       rounds_; // 还要再转几圈
+        Callback     callback_;
+    };
+
+    explicit TimingWheel(muduo::net::EventLoop* loop, size_t numSlots = 64);
+    ~TimingWheel();
+
+    // 开始每秒走一格，需在 loop 线程里调用
+    void start();
+
+    // （重新）开始计时，seconds 秒后触发；已经在计时的 Entry 先取消
+    void schedule(Entry* entry, int seconds);
+
+    // 走一格，触发到期的 Entry。start() 之后由 loop 每秒调用；不 start() 时可以手动推进（单元测试）
+    void tick();
+
+    muduo::net::EventLoop* getLoop() const
+    { return loop_; }
+
+private:
+    void link(Entry* entry, size_t slot);
+    void unlink(Entry* entry);
+
+private:
+    muduo::net::EventLoop* loop_;
+    std::vector<Entry*>    slots_;   // 每格一条链表；最后一格存放本次 tick 正在触发的 Entry
+    size_t                 current_; // 当前格
+    muduo::net::TimerId    timer_;
+    bool                   started_;
+};
+
+} // namespace http
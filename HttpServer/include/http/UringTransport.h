@@ -0,0 +1,211 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/any.hpp>
+#include <muduo/base/noncopyable.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TimerId.h>
+
+#include "IoUring.h"
+
+namespace http
+{
+
+class UringTransport;
+
+/*
+    io_uring 上的一条 TCP 连接，接口取 muduo::net::TcpConnection 里 HTTP 处理用到的那部分。
+    只在所属 I/O 线程上使用；别的线程只能持有它，再通过 getLoop()->runInLoop() 回到 I/O 线程
+ */
+class UringConnection : public std::enable_shared_from_this<UringConnection>,
+                        muduo::noncopyable
+{
+public:
+    // 交接给 epoll：fd 连同还没处理的输入和还没发出去的输出
+    using DetachCallback = std::function<void (int fd, muduo::net::Buffer* input, muduo::net::Buffer* output)>;
+
+    UringConnection(UringTransport* transport, int fd, const muduo::net::InetAddress& peer);
+    ~UringConnection();
+
+    int fd() const
+    { return fd_; }
+
+    const muduo::net::InetAddress& peerAddress() const
+    { return peer_; }
+
+    muduo::net::EventLoop* getLoop() const
+    { return loop_; }
+
+    bool connected() const
+    { return state_ == kConnected; }
+
+    muduo::net::Buffer* inputBuffer()
+    { return &input_; }
+
+    // 还没发出去的字节数（含在途的 send）
+    size_t pendingBytes() const
+    { return output_.readableBytes() + inflight_.readableBytes(); }
+
+    // 取走 buf 里的全部数据，和同一轮里其他连接的发送一起提交
+    void send(muduo::net::Buffer* buf);
+
+    // 已排队的数据发完之后关闭写端
+    void shutdown();
+
+    // 立即断开，没发出去的数据丢弃
+    void forceClose();
+
+    // 停止在 io_uring 上收发：取消在途的接收、等在途的发送完成之后，在 I/O 线程里调用 cb。
+    // 之后 fd 归 cb 所有，这个对象不再碰它；交接完成之前对方断开的，照常触发连接关闭回调
+    void detach(const DetachCallback& cb);
+
+    void setContext(const boost::any& context)
+    { context_ = context; }
+
+    const boost::any& getContext() const
+    { return context_; }
+
+    boost::any* getMutableContext()
+    { return &context_; }
+
+private:
+    friend class UringTransport;
+
+    enum State
+    {
+        kConnected,
+        kDisconnecting, // 已调用 shutdown()，等输出发完
+        kDetaching,
+        kClosed,        // 已关闭或已交接，等在途的请求结束后释放
+    };
+
+    UringTransport*         transport_; // 传输层先于连接析构时置空
+    muduo::net::EventLoop*  loop_;
+    int                     fd_;
+    muduo::net::InetAddress peer_;
+    State                   state_;
+    int                     ops_;        // 在途的请求数，归零之前 fd 和缓冲区都不能释放
+    bool                    receiving_;  // multishot recv 在途
+    bool                    sending_;    // send 在途，每条连接同时只有一个，保证顺序
+    bool                    queued_;     // 已在待发送列表里
+    bool                    detached_;
+    muduo::net::Buffer      input_;
+    muduo::net::Buffer      output_;     // 等待发送
+    muduo::net::Buffer      inflight_;   // 在途的 send 引用的数据，完成之前不能改动
+    DetachCallback          detachCallback_;
+    boost::any              context_;
+};
+
+using UringConnectionPtr = std::shared_ptr<UringConnection>;
+
+/*
+    一个 I/O 线程上的 io_uring 网络层：本线程自己的 SO_REUSEPORT 监听 socket 上 multishot accept，
+    每条连接一个 multishot recv（数据落在共用的 provided buffer 里，拷进连接的输入缓冲区后立即归还），
+    发送在处理完一批完成事件之后一起提交。一批完成事件（不管涉及多少连接）只需要一次 epoll_wait
+    和一次 io_uring_enter，不再是每条连接各自 read、write。
+
+    环的 fd 挂在所在 EventLoop 上，定时器、runInLoop 等照常使用
+ */
+class UringTransport : muduo::noncopyable
+{
+public:
+    // 建立和断开都回调，用 connected() 区分
+    using ConnectionCallback = std::function<void (const UringConnectionPtr&)>;
+    using MessageCallback = std::function<void (const UringConnectionPtr&,
+                                                muduo::net::Buffer*,
+                                                muduo::Timestamp)>;
+
+    static const unsigned kQueueDepth = 1024;
+    static const unsigned kBufferCount = 512;
+    static const size_t   kBufferSize = 16 * 1024;
+
+    UringTransport(muduo::net::EventLoop* loop, const std::string& name);
+    // 取消所有在途请求并等它们结束，之后才释放连接的缓冲区
+    ~UringTransport();
+
+    bool valid() const
+    { return ring_.valid(); }
+
+    // 在本线程上开一个 SO_REUSEPORT 监听 socket 并开始 accept
+    bool listen(const muduo::net::InetAddress& addr);
+
+    // 关闭监听 socket（drain 时），已有连接不受影响
+    void stopAccepting();
+
+    void setConnectionCallback(const ConnectionCallback& cb)
+    { connectionCallback_ = cb; }
+
+    void setMessageCallback(const MessageCallback& cb)
+    { messageCallback_ = cb; }
+
+    muduo::net::EventLoop* getLoop() const
+    { return loop_; }
+
+    // 本线程上还没关闭的连接
+    std::vector<UringConnectionPtr> connections() const;
+
+private:
+    friend class UringConnection;
+
+    // user_data 的低 3 位是请求类型，其余是连接的地址（accept 为 0）
+    enum Op
+    {
+        kAccept = 1,
+        kRecv,
+        kSend,
+        kCancel,
+    };
+
+    static uint64_t userData(UringConnection* conn, Op op)
+    { return reinterpret_cast<uint64_t>(conn) | op; }
+
+    void onCompletion(muduo::Timestamp receiveTime);
+    void handleCompletion(const struct io_uring_cqe* cqe, muduo::Timestamp now);
+    void handleAccept(const struct io_uring_cqe* cqe);
+    void handleRecv(const UringConnectionPtr& conn, const struct io_uring_cqe* cqe, muduo::Timestamp now);
+    void handleSend(const UringConnectionPtr& conn, const struct io_uring_cqe* cqe);
+    void armAccept();
+    void armRecv(UringConnection* conn);
+    // 接收缓冲区用完（ENOBUFS）的连接不立即重新 recv，等一小段时间再挂上，免得空转
+    void waitForBuffers(const UringConnectionPtr& conn);
+    void scheduleRetry();
+    void retryRecv();
+    void cancel(UringConnection* conn);
+    // 连接有数据要发：批处理中先排队，否则立即提交
+    void queueSend(UringConnection* conn);
+    void startSend(UringConnection* conn);
+    void flush();
+    // 对端关闭、出错或本端 forceClose
+    void closeConnection(const UringConnectionPtr& conn);
+    // 没有在途请求之后关闭 fd（或交接出去）并释放
+    void release(const UringConnectionPtr& conn);
+
+private:
+    muduo::net::EventLoop*                                loop_;
+    const std::string                                     name_;
+    IoUring                                               ring_;
+    std::unique_ptr<muduo::net::Channel>                  channel_;
+    int                                                   listenFd_;
+    int                                                   idleFd_;    // fd 用完时腾出来接下连接再关掉
+    bool                                                  accepting_;
+    bool                                                  inBatch_;   // 正在处理一批完成事件
+    unsigned                                              pendingOps_; // 全部在途请求数，退出时等它归零
+    std::unordered_map<UringConnection*, UringConnectionPtr> connections_;
+    std::vector<UringConnectionPtr>                       sendQueue_;
+    std::vector<UringConnectionPtr>                       starved_;   // 等接收缓冲区的连接
+    bool                                                  retryScheduled_;
+    muduo::net::TimerId                                   retryTimer_;
+    ConnectionCallback                                    connectionCallback_;
+    MessageCallback                                       messageCallback_;
+};
+
+} // namespace http
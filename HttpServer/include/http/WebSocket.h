@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <boost/any.hpp>
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+namespace http
+{
+
+class WebSocket;
+using WebSocketPtr = std::shared_ptr<WebSocket>;
+
+/*
+    一个 WebSocket 路由上的事件（HttpServer::serveWebSocket），所有连接共用一个对象。
+    回调都在连接所属的 I/O 线程上执行，会阻塞的工作要交给别的线程，结果再用 send 发回来
+ */
+class WebSocketHandler
+{
+public:
+    virtual ~WebSocketHandler() = default;
+
+    // 握手请求通过协议检查之后、回 101 之前调用（中间件已执行），可以检查 Origin、鉴权等。
+    // 返回 false 表示拒绝，resp 即为最终响应（如 403）
+    virtual bool acceptHandshake(const HttpRequest& req, HttpResponse* resp)
+    { return true; }
+
+    // 101 已经发出
+    virtual void onOpen(const WebSocketPtr& ws)
+    {}
+
+    // 一条完整的消息：分片已经拼好、permessage-deflate 已经解压，文本消息已经检查过 UTF-8
+    virtual void onMessage(const WebSocketPtr& ws, std::string_view message, bool binary) = 0;
+
+    // 收到对方的关闭帧或者连接断开（1006），每条连接只调用一次，之后 send 都返回 false
+    virtual void onClose(const WebSocketPtr& ws, uint16_t code)
+    {}
+};
+
+/*
+    服务端的一条 WebSocket 连接（RFC 6455），由 HttpServer 在握手请求的响应是 101 时接管连接。
+      - 收：解析帧、去掩码、拼接分片，控制帧（ping/pong/close）插在分片中间也能处理；
+        协议错误、消息超过 maxMessageSize 时按 RFC 回关闭帧并断开
+      - 发：send/ping/close 可以在任意线程调用，和 ResponseStream 一样先编码进 pending_，
+        再投递一次 flush 到连接所在的 I/O 线程；对方读得太慢、积压超过 kMaxBufferedBytes 时断开
+      - permessage-deflate（RFC 7692）：客户端提供时默认启用，双方都保留压缩上下文，
+        逐 token 推送的小消息也能压缩（重复的 JSON 结构只在第一次出现时占字节）
+      - 保活：连接空闲时由 HttpServer 的空闲超时调用 keepAlive() 发 ping，再空闲一个周期还没有任何数据就断开
+ */
+class WebSocket : public std::enable_shared_from_this<WebSocket>,
+                  muduo::noncopyable
+{
+public:
+    enum Opcode
+    {
+        kContinuation = 0x0,
+        kText         = 0x1,
+        kBinary       = 0x2,
+        kClose        = 0x8,
+        kPing         = 0x9,
+        kPong         = 0xA,
+    };
+
+    // 关闭帧里的状态码（RFC 6455 7.4.1）
+    enum CloseCode : uint16_t
+    {
+        kNormalClosure   = 1000,
+        kGoingAway       = 1001,
+        kProtocolError   = 1002,
+        kUnsupportedData = 1003,
+        kNoStatus        = 1005, // 关闭帧里没有状态码，不能出现在发出的帧里
+        kAbnormalClosure = 1006, // 连接直接断开，不能出现在发出的帧里
+        kInvalidPayload  = 1007,
+        kPolicyViolation = 1008,
+        kMessageTooBig   = 1009,
+        kInternalError   = 1011,
+    };
+
+    static const size_t kDefaultMaxMessageSize = 1024 * 1024;
+    static const size_t kMaxBufferedBytes = 8 * 1024 * 1024;
+    // 比这短的消息不压缩，省下的字节抵不上 deflate 的开销
+    static const size_t kMinDeflateSize = 32;
+
+    // 在 handler 中（I/O 线程）调用：检查握手请求，合格时把 resp 变成 101 并返回连接对象，
+    // 由 HttpServer 在 handler 返回后发出 101 并接管连接；不合格时 resp 为错误响应（400/426），返回空
+    static WebSocketPtr accept(const muduo::net::TcpConnectionPtr& conn,
+                               const HttpRequest& req,
+                               HttpResponse* resp,
+                               std::shared_ptr<WebSocketHandler> handler);
+
+    ~WebSocket();
+
+    // 发一条消息；连接已关闭或积压超限时返回 false
+    bool sendText(std::string_view message)
+    { return sendMessage(kText, message); }
+
+    bool sendBinary(std::string_view message)
+    { return sendMessage(kBinary, message); }
+
+    bool ping(std::string_view payload = std::string_view());
+
+    // 发关闭帧，等对方回关闭帧之后断开；重复调用无效
+    void close(uint16_t code = kNormalClosure, std::string_view reason = std::string_view());
+
+    // 已经发出或收到关闭帧，或者连接已断开
+    bool closed() const;
+
+    // 握手时协商了 permessage-deflate
+    bool deflateEnabled() const
+    { return deflate_; }
+
+    // 需在 onOpen 返回之前设置
+    void setMaxMessageSize(size_t bytes)
+    { maxMessageSize_ = bytes; }
+
+    // 连接已经断开时为空
+    muduo::net::TcpConnectionPtr connection() const
+    { return conn_.lock(); }
+
+    // 握手请求的路径，handler 用它区分同一个对象服务的不同路由
+    const std::string& path() const
+    { return path_; }
+
+    // 供 handler 挂自己的状态（用户 id、订阅的频道等）。只在 I/O 线程上访问
+    void setContext(const boost::any& context)
+    { context_ = context; }
+
+    boost::any* getMutableContext()
+    { return &context_; }
+
+    // 以下由 HttpServer 在连接所属的 I/O 线程调用
+
+    // 101 已经发出：开始发送，回调 onOpen
+    void open();
+
+    // 取走 buf 里的全部数据，逐帧处理
+    void onRead(muduo::net::Buffer* buf);
+
+    // 空闲超时：上次的 ping 之后还没收到任何数据，或者关闭握手没有完成时返回 false，由调用方断开连接；
+    // 否则发一个 ping
+    bool keepAlive();
+
+    // 连接已断开
+    void onDisconnected();
+
+private:
+    class Deflater;
+    class Inflater;
+
+    WebSocket(const muduo::net::TcpConnectionPtr& conn,
+              std::string path,
+              std::shared_ptr<WebSocketHandler> handler);
+
+    bool sendMessage(Opcode opcode, std::string_view message);
+    // 调用方已持有 mutex_
+    void appendFrameLocked(Opcode opcode, std::string_view payload, bool compressed);
+    bool scheduleFlushLocked();
+    void flushInLoop();
+
+    // 一条消息的最后一帧收完：解压、检查之后交给 handler
+    void onMessage();
+    void onControlFrame(int opcode, std::string_view payload);
+    // 协议错误：回关闭帧并断开，不再处理后面的数据
+    void fail(uint16_t code, std::string_view reason);
+    void notifyClose(uint16_t code);
+
+private:
+    std::weak_ptr<muduo::net::TcpConnection> conn_; // 连接经由 HttpContext 持有这个对象，这里不能再反过来持有连接
+    muduo::net::EventLoop*                   loop_;
+    const std::string                        path_;
+    std::shared_ptr<WebSocketHandler>        handler_;
+    size_t                                   maxMessageSize_;
+    boost::any                               context_;
+    bool                                     deflate_;         // 以下三项是握手时协商的 permessage-deflate 参数
+    bool                                     deflateNoContextTakeover_;
+    int                                      deflateWindowBits_;
+
+    mutable std::mutex                       mutex_;           // 保护以下到 closeSent_ 为止的成员
+    std::unique_ptr<Deflater>                deflater_;        // 第一次压缩时创建
+    std::string                              compressed_;
+    muduo::net::Buffer                       pending_;         // 已经编码好、等待 flush 的帧
+    bool                                     opened_;          // 101 已发出
+    bool                                     flushScheduled_;
+    bool                                     closeSent_;
+
+    // 以下只在 I/O 线程使用
+    std::unique_ptr<Inflater>                inflater_;        // 第一条压缩消息到达时创建
+    muduo::net::Buffer                       sending_;
+    std::string                              message_;         // 正在拼接的分片消息
+    std::string                              inflated_;
+    int                                      messageOpcode_;   // 分片消息的类型，kContinuation 表示没有
+    bool                                     messageCompressed_;
+    bool                                     closeReceived_;
+    bool                                     closeNotified_;   // 已回调 onClose
+    bool                                     failed_;          // 协议错误，之后收到的数据丢弃
+    bool                                     pingSent_;        // keepAlive 发了 ping，之后还没收到数据
+};
+
+} // namespace http
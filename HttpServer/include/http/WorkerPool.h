@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/base/Thread.h>
+
+namespace http
+{
+
+/*
+    执行阻塞型 handler（数据库、外部服务）的工作线程池，I/O 线程只负责投递和发送结果。
+    和 muduo::ThreadPool 的区别：队列满时 tryRun() 立即返回 false 而不是阻塞调用方 ——
+    调用方是 EventLoop，阻塞它等于让整个 I/O 线程上的连接陪着排队，不如直接回 503
+ */
+class WorkerPool : muduo::noncopyable
+{
+public:
+    using Task = std::function<void()>;
+
+    WorkerPool(const std::string& name, int numThreads, size_t maxQueueSize);
+    ~WorkerPool();
+
+    // 每个工作线程开始时先执行，如绑核；需在 start() 之前设置
+    void setThreadInitCallback(const Task& cb)
+    { threadInitCallback_ = cb; }
+
+    void start();
+
+    // 等正在执行的任务结束后退出，队列里还没开始的任务直接丢弃
+    void stop();
+
+    // 线程安全；队列已满或线程池未运行时返回 false，task 不会执行
+    bool tryRun(Task task);
+
+    size_t queueSize() const;
+
+    int numThreads() const
+    { return numThreads_; }
+
+private:
+    void runInThread();
+
+private:
+    std::string                                 name_;
+    int                                         numThreads_;
+    size_t                                      maxQueueSize_;
+    mutable std::mutex                          mutex_;
+    std::condition_variable                     notEmpty_;
+    std::deque<Task>                            queue_;
+    std::vector<std::unique_ptr<muduo::Thread>> threads_;
+    Task                                        threadInitCallback_;
+    bool                                        running_;
+};
+
+} // namespace http
@@ -18,6 +18,12 @@ public:
     
     // 响应后处理
     virtual void after(HttpResponse& response) = 0;
+
+    // 需要参考请求的响应后处理（如按 Accept-Encoding 压缩），默认转给 after(response)
+    virtual void after(const HttpRequest& request, HttpResponse& response)
+    {
+        after(response);
+    }
     
     // 设置下一个中间件
     void setNext(std::shared_ptr<Middleware> next) 
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace http 
+{
+namespace middleware 
+{
+
+struct CompressionConfig 
+{
+    size_t minSize = 1024;            // 小于这个大小的响应体不压缩，压缩头的开销抵不上收益
+    int level = 6;                    // gzip/deflate 压缩级别（1-9）
+    int brotliQuality = 5;            // brotli 质量（0-11），编译时开启 HTTP_WITH_BROTLI 才生效
+    std::vector<std::string> mimeTypes;     // Content-Type 前缀，命中才压缩
+    std::vector<std::string> excludedPaths; // 路径前缀，这些路由不压缩（如已经压缩过的下载）
+    
+    static CompressionConfig defaultConfig() 
+    {
+        CompressionConfig config;
+        config.mimeTypes = {"text/", "application/json", "application/javascript",
+                            "application/xml", "image/svg+xml"};
+        return config;
+    }
+};
+
+} // namespace middleware
+} // namespace http
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../Middleware.h"
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "CompressionConfig.h"
+
+namespace http 
+{
+namespace middleware 
+{
+
+/*
+    响应压缩：按 Accept-Encoding 协商 br（需编译时开启 HTTP_WITH_BROTLI）> gzip > deflate。
+      - 每个 I/O 线程复用一个 z_stream（deflateReset），不再每个响应 deflateInit/deflateEnd
+      - 整个响应体是一段共享内存（如静态页面）时，压缩结果按 owner 缓存，之后的响应直接共享
+      - 流式响应、1xx/204/304/206、已经带 Content-Encoding 的响应不处理；
+        handler 设置 "Content-Encoding: identity" 即可让单个响应不被压缩
+    after 按注册的逆序执行，压缩应最后执行，所以要最先 addMiddleware
+ */
+class CompressionMiddleware : public Middleware 
+{
+public:
+    enum Encoding
+    {
+        kIdentity, kDeflate, kGzip, kBrotli, kEncodingCount
+    };
+
+    explicit CompressionMiddleware(const CompressionConfig& config = CompressionConfig::defaultConfig());
+    
+    void before(HttpRequest& request) override {}
+    void after(HttpResponse& response) override {}
+    void after(const HttpRequest& request, HttpResponse& response) override;
+
+    // 按 Accept-Encoding 选出双方都支持的最优编码
+    static Encoding negotiate(std::string_view acceptEncoding);
+
+    // 压缩到 out（覆盖原内容），失败返回 false
+    bool compress(Encoding encoding, std::string_view in, std::string* out) const;
+
+private:
+    bool shouldCompress(const HttpRequest& request, const HttpResponse& response) const;
+    std::shared_ptr<const std::string> compressShared(Encoding encoding, const HttpResponse::BodySegment& body);
+
+private:
+    // 共享响应体的压缩缓存，以数据地址为 key，owner 失效的条目视为过期
+    struct CacheEntry
+    {
+        std::weak_ptr<const void>           owner;
+        size_t                              size;
+        std::shared_ptr<const std::string>  encoded[kEncodingCount];
+    };
+
+    static const size_t kMaxCacheEntries = 64;
+
+    CompressionConfig                             config_;
+    std::mutex                                    cacheMutex_;
+    std::unordered_map<const void*, CacheEntry>   cache_;
+};
+
+} // namespace middleware
+} // namespace http
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace http 
+{
+namespace middleware 
+{
+
+struct EtagConfig 
+{
+    std::vector<std::string> paths;  // 路径前缀，只有命中的路由才计算 ETag；为空表示所有路由
+    size_t maxSize = 4 * 1024 * 1024; // 超过这个大小的响应体不计算（大响应应当由 handler 自己给出 ETag）
+    std::string cacheControl = "private, no-cache"; // 响应没有 Cache-Control 时补上：允许缓存但每次都要验证
+    
+    static EtagConfig defaultConfig() 
+    {
+        return EtagConfig();
+    }
+};
+
+} // namespace middleware
+} // namespace http
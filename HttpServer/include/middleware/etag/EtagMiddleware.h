@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string_view>
+
+#include "../Middleware.h"
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "EtagConfig.h"
+
+namespace http 
+{
+namespace middleware 
+{
+
+/*
+    动态响应的 ETag：对 GET/HEAD 的 200 响应体做 64 位快速哈希，设置弱 ETag（W/"<16 位十六进制>"）。
+    请求的 If-None-Match 命中时改成 304、丢掉响应体，内容没变的轮询只回几十字节的头部。
+      - handler 仍然要完整执行一次，省下的是带宽和客户端的解析，不是服务端的计算
+      - 已经带 ETag 的响应（如静态文件）、流式响应不处理
+      - 弱 ETag 只表示语义相同，压缩中间件改变编码后依然有效
+    注册顺序：要在 CompressionMiddleware 之后 addMiddleware（after 逆序执行，先算 ETag 再压缩）
+ */
+class EtagMiddleware : public Middleware 
+{
+public:
+    explicit EtagMiddleware(const EtagConfig& config = EtagConfig::defaultConfig());
+    
+    void before(HttpRequest& request) override {}
+    void after(HttpResponse& response) override {}
+    void after(const HttpRequest& request, HttpResponse& response) override;
+
+    // If-None-Match 按弱比较是否包含 etag（"*" 匹配任何 ETag）
+    static bool matches(std::string_view ifNoneMatch, std::string_view etag);
+
+private:
+    bool shouldTag(const HttpRequest& request, const HttpResponse& response) const;
+
+private:
+    EtagConfig config_;
+};
+
+} // namespace middleware
+} // namespace http
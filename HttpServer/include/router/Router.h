@@ -1,4 +1,5 @@
 #pragma once
+#include <deque>
 #include <iostream>
 #include <unordered_map>
 #include <string>
@@ -22,10 +23,12 @@ public:
     using HandlerPtr = std::shared_ptr<RouterHandler>;
     using HandlerCallback = std::function<void(const HttpRequest &, HttpResponse *)>;
 
+    // path 指向 paths_ 中保存的路由字符串（注册时）或请求自己的路径（查找时），
+    // 查找不再为每个请求构造一个 std::string
     struct RouteKey
     {
         HttpRequest::Method method;
-        std::string path;
+        std::string_view    path;
 
         bool operator==(const RouteKey &other) const
         {
@@ -38,11 +41,16 @@ public:
         size_t operator()(const RouteKey &key) const
         {
             size_t methodHash = std::hash<int>{}(static_cast<int>(key.method));
-            size_t pathHash = std::hash<std::string>{}(key.path);
+            size_t pathHash = std::hash<std::string_view>{}(key.path);
             return methodHash * 31 + pathHash;
         }
     };
 
+    Router() = default;
+    // handlers_/callbacks_ 的 key 指向 paths_，不能拷贝
+    Router(const Router &) = delete;
+    Router &operator=(const Router &) = delete;
+
     void registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler);
     void registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback);
 
@@ -58,6 +66,9 @@ public:
         regexCallbacks_.emplace_back(method, pathRegex, callback);
     }
 
+    // 前缀路由：路径以 prefix 开头即命中（如静态文件目录），在精确路由之后、正则路由之前匹配，最长前缀优先
+    void addPrefixHandler(HttpRequest::Method method, const std::string &prefix, HandlerPtr handler);
+
     // ★ 主要版本：携带 conn，供 SSE handler 注入连接
     bool route(const muduo::net::TcpConnectionPtr &conn,
                const HttpRequest &req,
@@ -66,18 +77,33 @@ public:
     // ★ 兼容旧代码的重载（conn 传空指针，普通路由不受影响）
     bool route(const HttpRequest &req, HttpResponse *resp);
 
+    // 只查找不分发：请求有对应的路由时返回 true，是 Handler 路由时通过 handler 带回
+    // （回调路由 handler 为空），正则路由会顺带填好路径参数
+    bool findRoute(HttpRequest &req, HandlerPtr *handler) const;
+
 private:
+    // 按 method 匹配（HEAD 回退到 GET 时 method 和 req.method() 不同）
+    bool dispatch(HttpRequest::Method method,
+                  const muduo::net::TcpConnectionPtr &conn,
+                  const HttpRequest &req,
+                  HttpResponse *resp);
+    bool lookup(HttpRequest::Method method, HttpRequest &req, HandlerPtr *handler) const;
+
+    // 把注册的路径拷贝一份长期保存，返回指向副本的 view
+    std::string_view internPath(const std::string &path);
+
     std::regex convertToRegex(const std::string &pathPattern)
     {
         std::string regexPattern = "^" + std::regex_replace(pathPattern, std::regex(R"(/:([^/]+))"), R"(/([^/]+))") + "$";
         return std::regex(regexPattern);
     }
 
-    void extractPathParameters(const std::smatch &match, HttpRequest &request)
+    static void extractPathParameters(const std::cmatch &match, HttpRequest &request)
     {
         for (size_t i = 1; i < match.size(); ++i)
         {
-            request.setPathParameters("param" + std::to_string(i), match[i].str());
+            request.setPathParameters("param" + std::to_string(i),
+                                      std::string_view(match[i].first, match[i].length()));
         }
     }
 
@@ -100,8 +126,20 @@ private:
             : method_(method), pathRegex_(pathRegex), handler_(handler) {}
     };
 
+    struct RoutePrefixObj
+    {
+        HttpRequest::Method method_;
+        std::string         prefix_;
+        HandlerPtr          handler_;
+    };
+
+    // 按前缀长度从长到短排列
+    const RoutePrefixObj *findPrefixRoute(HttpRequest::Method method, std::string_view path) const;
+
+    std::deque<std::string>                                     paths_; // 精确路由的路径（deque 追加元素不移动已有元素）
     std::unordered_map<RouteKey, HandlerPtr, RouteKeyHash>      handlers_;
     std::unordered_map<RouteKey, HandlerCallback, RouteKeyHash> callbacks_;
+    std::vector<RoutePrefixObj>                                 prefixHandlers_;
     std::vector<RouteHandlerObj>                                regexHandlers_;
     std::vector<RouteCallbackObj>                               regexCallbacks_;
 };
@@ -2,6 +2,7 @@
 #include <string>
 #include <memory>
 #include <muduo/net/TcpConnection.h>
+#include "../http/BodySink.h"
 #include "../http/HttpRequest.h"
 #include "../http/HttpResponse.h"
 
@@ -17,6 +18,35 @@ public:
     virtual void handle(const muduo::net::TcpConnectionPtr& conn,
                         const HttpRequest& req,
                         HttpResponse* resp) = 0;
+
+    // 需要流式接收请求体的 handler 重写它：请求头解析完成后调用，
+    // 返回非空时请求体逐段交给这个 sink，不再整份缓存在内存中（也不受 HttpLimits::maxBodySize 限制）。
+    // 此时中间件尚未执行，鉴权等检查需要在 handle() 中完成。
+    virtual std::unique_ptr<BodySink> createBodySink(const muduo::net::TcpConnectionPtr& conn,
+                                                     const HttpRequest& req)
+    { return nullptr; }
+
+    // 请求带 Expect: 100-continue 时，在回 100 Continue、客户端上传请求体之前调用（此时中间件已执行）。
+    // 返回 false 表示拒绝，resp 即为最终响应（如 401），请求体不会被接收，连接随后关闭。
+    // 只能依赖请求行和请求头，getBody() 此时为空。
+    virtual bool acceptHeaders(const muduo::net::TcpConnectionPtr& conn,
+                               const HttpRequest& req,
+                               HttpResponse* resp)
+    { return true; }
+
+    // handle() 会阻塞（查数据库、调外部服务）时重写为返回 true：前置中间件、handle()、后置中间件
+    // 改在 HttpServer 的工作线程池中执行，响应回到连接所在的 EventLoop 再发出，I/O 线程不被拖住。
+    // 此时 handle() 不在 I/O 线程上，不能向 conn 写任何数据：TLS 连接的加密状态只能在 I/O 线程上用，
+    // 直接写也会和流水线上前后请求的响应交错。输出一律写进 resp，流式响应、WebSocket 升级照常在 resp 上设置，
+    // 回到 EventLoop 后才开始；直接往 conn 写握手头的 SSE handler 不能返回 true
+    virtual bool offload() const
+    { return false; }
+
+    // handle()、createBodySink()、acceptHeaders() 都用不到 conn 时重写为返回 false。
+    // io_uring 后端（HttpServer::setBackend）上这样的路由拿到的 conn 为空，其余路由的连接在请求头
+    // 解析完之后交还给 epoll 处理。流式响应、SSE、DeferredResponse 都要用到连接，返回 false 的 handler 不能使用
+    virtual bool needsConnection() const
+    { return true; }
 };
 
 } // namespace router
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "RouterHandler.h"
+#include "../http/FileCache.h"
+
+namespace http
+{
+namespace router
+{
+
+/*
+    静态文件路由：GET/HEAD，内容来自 FileCache（共享内存或 mmap，不逐响应读文件）。
+      - 带 ETag、Last-Modified，If-None-Match / If-Modified-Since 命中时回 304，不带响应体
+      - 单个区间的 Range 请求回 206（If-Range 不匹配时回整个文件），多区间按整个文件返回
+      - 路径做百分号解码，含 ".." 的路径一律 404，不会访问 root 之外的文件
+ */
+class StaticFileHandler : public RouterHandler
+{
+public:
+    // urlPrefix 之后的部分映射到 root 目录下的文件，以 '/' 结尾的路径返回 index.html；
+    // root 是普通文件时，命中这个路由的请求都返回它
+    StaticFileHandler(std::shared_ptr<FileCache> cache,
+                      const std::string& urlPrefix,
+                      const std::string& root,
+                      const std::string& cacheControl = "no-cache");
+
+    void handle(const muduo::net::TcpConnectionPtr& conn,
+                const HttpRequest& req,
+                HttpResponse* resp) override;
+
+    bool needsConnection() const override
+    { return false; }
+
+private:
+    bool resolve(std::string_view urlPath, std::string* path) const;
+    static bool notModified(const HttpRequest& req, const CachedFile& file);
+
+    // 解析 "bytes=first-last"；返回 -1 不是可处理的单区间，0 区间不可满足，1 成功
+    static int parseRange(std::string_view range, uint64_t size, uint64_t* first, uint64_t* last);
+
+private:
+    std::shared_ptr<FileCache> cache_;
+    std::string                urlPrefix_;
+    std::string                root_;         // 不带结尾的 '/'
+    bool                       singleFile_;   // root_ 是单个文件
+    std::string                cacheControl_; // 默认 no-cache：允许缓存，但每次都要验证（命中时 304）
+};
+
+} // namespace router
+} // namespace http
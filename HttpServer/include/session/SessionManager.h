@@ -4,6 +4,7 @@
 #include "../http/HttpRequest.h"
 #include "../http/HttpResponse.h"
 #include <memory>
+#include <mutex>
 #include <random>
 
 namespace http
@@ -18,6 +19,9 @@ public:
 
     // 从请求中获取或创建会话
     std::shared_ptr<Session> getSession(const HttpRequest& req, HttpResponse* resp);
+
+    // 只查找请求 Cookie 对应的有效会话，不创建、不续期；没有返回空
+    std::shared_ptr<Session> findSession(const HttpRequest& req);
     
      // 销毁会话
     void destroySession(const std::string& sessionId);
@@ -37,6 +41,7 @@ private:
 
 private:
     std::unique_ptr<SessionStorage> storage_;
+    std::mutex   rngMutex_; // I/O 线程和工作线程都会创建会话，mt19937 本身不是线程安全的
     std::mt19937 rng_; // 用于生成随机会话id
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "Session.h"
 #include <memory>
+#include <mutex>
 
 namespace http
 {
@@ -24,6 +25,7 @@ public:
     std::shared_ptr<Session> load(const std::string& sessionId) override;
     void remove(const std::string& sessionId) override;
 private:
+    std::mutex                                                mutex_; // 多个 I/O 线程、工作线程并发访问
     std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
 };
 
@@ -29,6 +29,9 @@ public:
     void setSessionTimeout(int seconds) { sessionTimeout_ = seconds; }
     void setSessionCacheSize(long size) { sessionCacheSize_ = size; }
 
+    // ALPN：按服务端的优先顺序排列，如 {"h2", "http/1.1"}；为空时不参与协商
+    void setAlpnProtocols(const std::vector<std::string>& protocols) { alpnProtocols_ = protocols; }
+
     // Getters
     const std::string& getCertificateFile() const { return certFile_; }
     const std::string& getPrivateKeyFile() const { return keyFile_; }
@@ -39,6 +42,7 @@ public:
     int getVerifyDepth() const { return verifyDepth_; }
     int getSessionTimeout() const { return sessionTimeout_; }
     long getSessionCacheSize() const { return sessionCacheSize_; }
+    const std::vector<std::string>& getAlpnProtocols() const { return alpnProtocols_; }
 
 private:
     std::string certFile_; // 证书文件
@@ -50,6 +54,7 @@ private:
     int         verifyDepth_; // 验证深度
     int         sessionTimeout_; // 会话超时时间
     long        sessionCacheSize_; // 会话缓存大小
+    std::vector<std::string> alpnProtocols_; // ALPN 协议，按优先顺序
 };
 
 } // namespace ssl
\ No newline at end of file
@@ -1,57 +1,56 @@
 #pragma once
 #include "SslContext.h"
+#include "SslTypes.h"
 #include <muduo/net/TcpConnection.h>
 #include <muduo/net/Buffer.h>
 #include <muduo/base/noncopyable.h>
 #include <openssl/ssl.h>
 #include <memory>
+#include <string_view>
 
-namespace ssl 
+namespace ssl
 {
 
-// 添加消息回调函数类型定义
-using MessageCallback = std::function<void(const std::shared_ptr<muduo::net::TcpConnection>&,
-                                         muduo::net::Buffer*,
-                                         muduo::Timestamp)>;
-
-class SslConnection : muduo::noncopyable 
+/*
+    一条 TLS 连接的加解密状态，放在连接自己的 HttpContext 里，随连接一起销毁。
+    只在连接所属的 I/O 线程上使用，不需要加锁；同一个连接的查找也不再经过全局 map。
+    密文经过两个内存 BIO：收到的数据写进 readBio_，SSL 产生的输出从 writeBio_ 取出发给连接
+ */
+class SslConnection : muduo::noncopyable
 {
 public:
-    using TcpConnectionPtr = std::shared_ptr<muduo::net::TcpConnection>;
-    using BufferPtr = muduo::net::Buffer*;
-    
-    SslConnection(const TcpConnectionPtr& conn, SslContext* ctx);
+    // conn 持有这个对象（经由 HttpContext），生命周期一定比它长，这里只存裸指针，避免循环引用
+    SslConnection(muduo::net::TcpConnection* conn, SslContext* ctx);
     ~SslConnection();
 
     void startHandshake();
+    // 加密后发给连接；握手完成之前调用会被丢弃
     void send(const void* data, size_t len);
-    void onRead(const TcpConnectionPtr& conn, BufferPtr buf, muduo::Timestamp time);
+    // 取走 buf 里的全部密文：推进握手，握手完成后解密到 getDecryptedBuffer()。
+    // 返回 false 表示 TLS 出错，连接已被关闭
+    bool onRead(muduo::net::Buffer* buf);
     bool isHandshakeCompleted() const { return state_ == SSLState::ESTABLISHED; }
     muduo::net::Buffer* getDecryptedBuffer() { return &decryptedBuffer_; }
-    // SSL BIO 操作回调
-    static int bioWrite(BIO* bio, const char* data, int len);
-    static int bioRead(BIO* bio, char* data, int len);
-    static long bioCtrl(BIO* bio, int cmd, long num, void* ptr);
-    // 设置消息回调函数
-    void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
+    // 握手时 ALPN 选定的协议（如 "h2"），没有协商时为空
+    std::string_view alpnProtocol() const;
+
 private:
     void handleHandshake();
-    void onEncrypted(const char* data, size_t len);
-    void onDecrypted(const char* data, size_t len);
+    void decrypt();
+    // 把 writeBio_ 里 SSL 产生的密文（握手消息、加密后的数据）发给连接
+    void flush();
     SSLError getLastError(int ret);
     void handleError(SSLError error);
 
 private:
-    SSL*                ssl_; // SSL 连接
-    SslContext*         ctx_; // SSL 上下文
-    TcpConnectionPtr    conn_; // TCP 连接
-    SSLState            state_; // SSL 状态
-    BIO*                readBio_;   // 网络数据 -> SSL
-    BIO*                writeBio_;  // SSL -> 网络数据
-    muduo::net::Buffer  readBuffer_; // 读缓冲区
-    muduo::net::Buffer  writeBuffer_; // 写缓冲区
-    muduo::net::Buffer  decryptedBuffer_; // 解密后的数据
-    MessageCallback     messageCallback_; // 消息回调
+    SSL*                        ssl_; // SSL 连接
+    SslContext*                 ctx_; // SSL 上下文
+    muduo::net::TcpConnection*  conn_; // TCP 连接
+    SSLState                    state_; // SSL 状态
+    BIO*                        readBio_;   // 网络数据 -> SSL
+    BIO*                        writeBio_;  // SSL -> 网络数据
+    muduo::net::Buffer          writeBuffer_; // flush 时的中转缓冲区，保留容量
+    muduo::net::Buffer          decryptedBuffer_; // 解密后的数据
 };
 
-} // namespace ssl
\ No newline at end of file
+} // namespace ssl
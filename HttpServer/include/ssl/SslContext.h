@@ -2,6 +2,7 @@
 #include "SslConfig.h"
 #include <openssl/ssl.h>
 #include <memory>
+#include <vector>
 #include <muduo/base/noncopyable.h>
 
 namespace ssl 
@@ -20,11 +21,16 @@ private:
     bool loadCertificates();
     bool setupProtocol();
     void setupSessionCache();
+    void setupAlpn();
+    // 从客户端提供的协议里按服务端的优先顺序选一个
+    static int selectAlpn(SSL* ssl, const unsigned char** out, unsigned char* outLen,
+                          const unsigned char* in, unsigned int inLen, void* arg);
     static void handleSslError(const char* msg);
 
 private:
     SSL_CTX*  ctx_; // SSL上下文
     SslConfig config_; // SSL配置
+    std::vector<unsigned char> alpnWire_; // ALPN 协议列表的线上格式（每项一个长度字节加名字）
 };
 
 } // namespace ssl
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+
+// HTTP 日期（RFC 9110 的 IMF-fixdate）："Sun, 06 Nov 1994 08:49:37 GMT"
+// 星期和月份用固定的英文缩写，不受 locale 影响
+class DateUtil
+{
+public:
+    static const size_t kHttpDateLength = 29;
+
+    // 写入 buf（至少 kHttpDateLength + 1 字节），返回长度
+    static size_t format(time_t t, char* buf)
+    {
+        struct tm tm;
+        ::gmtime_r(&t, &tm);
+        int n = snprintf(buf, kHttpDateLength + 1, "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                         kDays[tm.tm_wday], tm.tm_mday, kMonths[tm.tm_mon], tm.tm_year + 1900,
+                         tm.tm_hour, tm.tm_min, tm.tm_sec);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    // 只接受 IMF-fixdate（现今客户端发送的格式），解析失败返回 false
+    static bool parse(std::string_view s, time_t* t)
+    {
+        if (s.size() != kHttpDateLength || s.substr(3, 2) != ", " || s.substr(26) != "GMT")
+        {
+            return false;
+        }
+
+        struct tm tm;
+        std::memset(&tm, 0, sizeof tm);
+        tm.tm_mon = -1;
+        for (int i = 0; i < 12; ++i)
+        {
+            if (s.substr(8, 3) == kMonths[i])
+            {
+                tm.tm_mon = i;
+                break;
+            }
+        }
+        if (tm.tm_mon < 0 ||
+            !number(s.substr(5, 2), &tm.tm_mday) || !number(s.substr(12, 4), &tm.tm_year) ||
+            !number(s.substr(17, 2), &tm.tm_hour) || !number(s.substr(20, 2), &tm.tm_min) ||
+            !number(s.substr(23, 2), &tm.tm_sec))
+        {
+            return false;
+        }
+        tm.tm_year -= 1900;
+        *t = ::timegm(&tm);
+        return true;
+    }
+
+private:
+    static bool number(std::string_view s, int* value)
+    {
+        *value = 0;
+        for (char c : s)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            *value = *value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    static constexpr const char* kDays[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static constexpr const char* kMonths[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+};
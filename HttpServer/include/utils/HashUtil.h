@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// 快速的非加密 64 位哈希（wyhash 算法，和 xxh3 同一量级：每 48 字节三路 128 位乘法并行混合）。
+// 用于 ETag、缓存 key 等只要求分布均匀的场合，不能抵抗刻意构造的碰撞
+class HashUtil
+{
+public:
+    static uint64_t hash64(const void* data, size_t len, uint64_t seed = 0)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        seed ^= mix(seed ^ kSecret[0], kSecret[1]);
+        uint64_t a = 0;
+        uint64_t b = 0;
+        if (len <= 16)
+        {
+            if (len >= 4)
+            {
+                // 头尾各取两个可能重叠的 4 字节，覆盖 4..16 字节的所有输入
+                size_t offset = (len >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + offset);
+                b = (read32(p + len - 4) << 32) | read32(p + len - 4 - offset);
+            }
+            else if (len > 0)
+            {
+                a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+            }
+        }
+        else
+        {
+            size_t i = len;
+            if (i > 48)
+            {
+                uint64_t see1 = seed;
+                uint64_t see2 = seed;
+                do
+                {
+                    seed = mix(read64(p) ^ kSecret[1], read64(p + 8) ^ seed);
+                    see1 = mix(read64(p + 16) ^ kSecret[2], read64(p + 24) ^ see1);
+                    see2 = mix(read64(p + 32) ^ kSecret[3], read64(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = mix(read64(p) ^ kSecret[1], read64(p + 8) ^ seed);
+                p += 16;
+                i -= 16;
+            }
+            a = read64(p + i - 16);
+            b = read64(p + i - 8);
+        }
+
+        a ^= kSecret[1];
+        b ^= seed;
+        multiply(&a, &b);
+        return mix(a ^ kSecret[0] ^ len, b ^ kSecret[1]);
+    }
+
+    static uint64_t hash64(std::string_view s, uint64_t seed = 0)
+    {
+        return hash64(s.data(), s.size(), seed);
+    }
+
+    // 16 位小写十六进制，写入 buf（至少 17 字节），返回长度
+    static size_t toHex(uint64_t value, char* buf)
+    {
+        static const char kDigits[] = "0123456789abcdef";
+        for (int i = 15; i >= 0; --i)
+        {
+            buf[i] = kDigits[value & 0xf];
+            value >>= 4;
+        }
+        buf[16] = '\0';
+        return 16;
+    }
+
+private:
+    static constexpr uint64_t kSecret[4] = {
+        0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+    };
+
+    // 128 位乘积的低 64 位和高 64 位分别写回 a、b
+    static void multiply(uint64_t* a, uint64_t* b)
+    {
+        __uint128_t r = static_cast<__uint128_t>(*a) * *b;
+        *a = static_cast<uint64_t>(r);
+        *b = static_cast<uint64_t>(r >> 64);
+    }
+
+    static uint64_t mix(uint64_t a, uint64_t b)
+    {
+        multiply(&a, &b);
+        return a ^ b;
+    }
+
+    // 按小端读取，memcpy 避免未对齐访问
+    static uint64_t read64(const uint8_t* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    static uint64_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// URL 百分号编码的解码（RFC 3986），查询参数额外把 '+' 当作空格（application/x-www-form-urlencoded）
+class UrlUtil
+{
+public:
+    // s 中是否有需要解码的字符；没有时调用方可以直接使用原字符串，不用拷贝
+    static bool needsDecode(std::string_view s, bool plusAsSpace)
+    {
+        for (char c : s)
+        {
+            if (c == '%' || (plusAsSpace && c == '+'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 把 s 解码写入 out（至少 s.size() 字节），返回解码后的长度。
+    // 不完整或非法的 %xx 原样保留，不报错
+    static size_t decode(std::string_view s, char* out, bool plusAsSpace)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            char c = s[i];
+            if (c == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0)
+            {
+                out[n++] = static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+                i += 2;
+            }
+            else if (c == '+' && plusAsSpace)
+            {
+                out[n++] = ' ';
+            }
+            else
+            {
+                out[n++] = c;
+            }
+        }
+        return n;
+    }
+
+private:
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+};
@@ -0,0 +1,93 @@
+#include "../../include/coro/CoroutineHandler.h"
+
+#include <functional>
+#include <memory>
+
+#include "../../include/http/DeferredResponse.h"
+
+namespace http
+{
+namespace coro
+{
+
+namespace
+{
+
+// 不被任何人等待的顶层协程：立即开始执行，结束时协程帧自行销毁
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() const noexcept
+        { return {}; }
+
+        std::suspend_never initial_suspend() const noexcept
+        { return {}; }
+
+        std::suspend_never final_suspend() const noexcept
+        { return {}; }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept
+        { std::terminate(); }
+    };
+};
+
+// 一次请求的完成状态，挂起期间由协程帧和 I/O 线程共同持有
+struct Completion
+{
+    bool                              done = false;
+    std::shared_ptr<DeferredResponse> deferred;
+};
+
+Detached run(Task<> task, HttpResponse* resp, std::shared_ptr<Completion> completion)
+{
+    try
+    {
+        co_await std::move(task);
+    }
+    catch (const HttpResponse& res)
+    {
+        *resp = res; // 挂起过的话 HttpServer 已经取走了 DeferredResponse，这里整个覆盖没有问题
+    }
+    catch (const std::exception& e)
+    {
+        resp->setStatusCode(HttpResponse::k500InternalServerError);
+        resp->setBody(std::string(e.what()));
+    }
+    catch (...)
+    {
+        // 漏出 run() 的异常会走到 Detached 的 unhandled_exception()，直接 terminate
+        resp->setStatusCode(HttpResponse::k500InternalServerError);
+        resp->setBody(std::string("Internal Server Error"));
+    }
+
+    completion->done = true;
+    if (completion->deferred)
+    {
+        completion->deferred->complete();
+    }
+}
+
+} // namespace
+
+void CoroutineHandler::handle(const muduo::net::TcpConnectionPtr& conn,
+                              const HttpRequest& req,
+                              HttpResponse* resp)
+{
+    // 请求体可能指向输入缓冲区，挂起期间新到的数据会让缓冲区搬家，先拷出来
+    const_cast<HttpRequest&>(req).detachBody();
+
+    auto completion = std::make_shared<Completion>();
+    run(handleAsync(conn, req, resp), resp, completion);
+
+    // 协程挂起了：之后都在这个 I/O 线程上恢复，不会早于这里执行
+    if (!completion->done)
+    {
+        completion->deferred = DeferredResponse::start(conn, resp);
+    }
+}
+
+} // namespace coro
+} // namespace http
@@ -0,0 +1,139 @@
+#include "../../include/http/AdmissionControl.h"
+
+#include <sys/resource.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+
+#include <muduo/base/Timestamp.h>
+
+namespace http
+{
+
+namespace
+{
+// 每个 I/O 线程各自采样，判断的是请求所在线程是否已经忙不过来
+thread_local double           t_loopLagMs = 0;
+thread_local muduo::Timestamp t_lastProbe;
+
+size_t defaultMaxConnections()
+{
+    struct rlimit rl;
+    if (::getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY)
+    {
+        return 0;
+    }
+    size_t limit = static_cast<size_t>(rl.rlim_cur);
+    return limit > 2 * AdmissionControl::kReservedFds ? limit - AdmissionControl::kReservedFds : limit / 2;
+}
+} // namespace
+
+AdmissionControl::AdmissionControl(const AdmissionLimits& limits)
+    : limits_(limits)
+    , maxConnections_(0)
+{
+    setLimits(limits);
+}
+
+void AdmissionControl::setLimits(const AdmissionLimits& limits)
+{
+    limits_ = limits;
+    maxConnections_ = limits.maxConnections > 0 ? limits.maxConnections : defaultMaxConnections();
+}
+
+std::string AdmissionControl::addressKey(const muduo::net::InetAddress& peer)
+{
+    const struct sockaddr* addr = peer.getSockAddr();
+    if (addr->sa_family == AF_INET6)
+    {
+        const struct sockaddr_in6* addr6 = reinterpret_cast<const struct sockaddr_in6*>(addr);
+        return std::string(reinterpret_cast<const char*>(&addr6->sin6_addr), sizeof addr6->sin6_addr);
+    }
+    const struct sockaddr_in* addr4 = reinterpret_cast<const struct sockaddr_in*>(addr);
+    return std::string(reinterpret_cast<const char*>(&addr4->sin_addr), sizeof addr4->sin_addr);
+}
+
+bool AdmissionControl::acquireConnection(const muduo::net::InetAddress& peer)
+{
+    size_t n = connections_.fetch_add(1, std::memory_order_relaxed);
+    if (maxConnections_ > 0 && n >= maxConnections_)
+    {
+        connections_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (limits_.maxConnectionsPerIp > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t& count = perIp_[addressKey(peer)];
+        if (count >= limits_.maxConnectionsPerIp)
+        {
+            connections_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        ++count;
+    }
+    return true;
+}
+
+void AdmissionControl::releaseConnection(const muduo::net::InetAddress& peer)
+{
+    connections_.fetch_sub(1, std::memory_order_relaxed);
+    if (limits_.maxConnectionsPerIp > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = perIp_.find(addressKey(peer));
+        if (it != perIp_.end() && --it->second == 0)
+        {
+            perIp_.erase(it);
+        }
+    }
+}
+
+const char* AdmissionControl::admitRequest(bool offload, size_t workerQueue)
+{
+    if (limits_.maxLoopLagMs > 0 && t_loopLagMs > limits_.maxLoopLagMs)
+    {
+        return "event loop lag";
+    }
+    if (offload && limits_.maxWorkerQueue > 0 && workerQueue >= limits_.maxWorkerQueue)
+    {
+        return "worker queue depth";
+    }
+    size_t n = inflight_.fetch_add(1, std::memory_order_relaxed);
+    if (limits_.maxInflightRequests > 0 && n >= limits_.maxInflightRequests)
+    {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+        return "in-flight requests";
+    }
+    return nullptr;
+}
+
+void AdmissionControl::finishRequest()
+{
+    inflight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void AdmissionControl::startLagProbe(muduo::net::EventLoop* loop)
+{
+    if (limits_.maxLoopLagMs <= 0)
+    {
+        return;
+    }
+    t_lastProbe = muduo::Timestamp::now();
+    // 定时器本该每 kLagProbeInterval 触发一次，实际晚了多少就是循环被 handler 占住了多久。
+    // 延迟上升时立即生效，之后每次采样减半，忙过去之后很快恢复放行
+    loop->runEvery(kLagProbeInterval, []()
+    {
+        muduo::Timestamp now = muduo::Timestamp::now();
+        double lag = (muduo::timeDifference(now, t_lastProbe) - kLagProbeInterval) * 1000;
+        t_lastProbe = now;
+        t_loopLagMs = std::max(lag, t_loopLagMs / 2);
+    });
+}
+
+double AdmissionControl::loopLagMs()
+{
+    return t_loopLagMs;
+}
+
+} // namespace http
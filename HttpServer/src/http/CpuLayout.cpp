@@ -0,0 +1,380 @@
+#include "../../include/http/CpuLayout.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+namespace
+{
+struct CpuInfo
+{
+    int id;
+    int node;
+    int package;
+    int core;
+};
+
+int readInt(const std::string& path, int defaultValue)
+{
+    std::ifstream in(path);
+    int value;
+    return (in >> value) ? value : defaultValue;
+}
+
+// cpuN 所在的 NUMA 节点：sysfs 里 cpuN 目录下有一个 nodeM 链接；没有 NUMA 时为 0
+int nodeOf(int cpu)
+{
+    int node = 0;
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    if (DIR *dir = ::opendir(path.c_str()))
+    {
+        while (struct dirent *entry = ::readdir(dir))
+        {
+            if (std::string(entry->d_name).compare(0, 4, "node") == 0 && std::isdigit(entry->d_name[4]))
+            {
+                node = std::atoi(entry->d_name + 4);
+                break;
+            }
+        }
+        ::closedir(dir);
+    }
+    return node;
+}
+
+// 按 NUMA 节点、物理核排序，同一个物理核的超线程相邻
+std::vector<CpuInfo> detectCpus()
+{
+    std::vector<CpuInfo> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof set, &set) != 0)
+    {
+        LOG_SYSERR << "sched_getaffinity";
+        return cpus;
+    }
+    for (int id = 0; id < CPU_SETSIZE; ++id)
+    {
+        if (!CPU_ISSET(id, &set))
+        {
+            continue;
+        }
+        std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+        CpuInfo cpu;
+        cpu.id = id;
+        cpu.node = nodeOf(id);
+        cpu.package = readInt(topology + "physical_package_id", 0);
+        cpu.core = readInt(topology + "core_id", id);
+        cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b)
+    {
+        return std::tie(a.node, a.package, a.core, a.id) < std::tie(b.node, b.package, b.core, b.id);
+    });
+    return cpus;
+}
+
+// cgroup v2 的 CPU 配额（cpu.max）折合的 CPU 数，没有配额时为 0。
+// 配额限制的是总的 CPU 时间，容器里能看到 32 个 CPU 但只给 4 个核的时间，线程开多了只会互相抢
+int cpuQuota()
+{
+    std::ifstream in("/sys/fs/cgroup/cpu.max");
+    std::string quota;
+    double period = 0;
+    if (!(in >> quota >> period) || quota == "max" || period <= 0)
+    {
+        return 0;
+    }
+    return static_cast<int>(std::ceil(std::atof(quota.c_str()) / period));
+}
+
+bool parseCount(const std::string& value, int* count)
+{
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+    *count = std::atoi(value.c_str());
+    return true;
+}
+} // namespace
+
+CpuLayout& CpuLayout::instance()
+{
+    static CpuLayout layout;
+    return layout;
+}
+
+CpuLayout::CpuLayout()
+    : ioThreads_(0)
+    , pin_(false)
+{
+    configure("pin=0");
+}
+
+bool CpuLayout::configure(const std::string& spec)
+{
+    std::vector<CpuInfo> cpus = detectCpus();
+    if (cpus.empty())
+    {
+        return false;
+    }
+    std::set<int> allowed;
+    for (const CpuInfo& cpu : cpus)
+    {
+        allowed.insert(cpu.id);
+    }
+
+    // 先处理指定了列表的组，再从末尾给按个数划分的组取 CPU
+    std::set<int> used;
+    std::unordered_map<std::string, std::vector<int>> pools;
+    std::vector<std::pair<std::string, int>> counted;
+    std::vector<int> ioList;
+    int ioCount = 0;
+    bool pin = true;
+
+    std::string normalized = spec;
+    std::replace(normalized.begin(), normalized.end(), ';', ' ');
+    std::istringstream tokens(normalized);
+    std::string token;
+    while (tokens >> token)
+    {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos || eq == 0)
+        {
+            LOG_ERROR << "CpuLayout: bad entry '" << token << "' in '" << spec << "'";
+            return false;
+        }
+        std::string name = token.substr(0, eq);
+        std::string value = token.substr(eq + 1);
+        int count = 0;
+        std::vector<int> list;
+        if (name == "pin")
+        {
+            pin = value != "0";
+        }
+        else if (parseCount(value, &count))
+        {
+            if (name == "io")
+            {
+                ioCount = count;
+            }
+            else
+            {
+                counted.emplace_back(name, count);
+            }
+        }
+        else if (parseCpuList(value, &list))
+        {
+            for (int cpu : list)
+            {
+                if (!allowed.count(cpu) || !used.insert(cpu).second)
+                {
+                    LOG_ERROR << "CpuLayout: CPU " << cpu << " of '" << name
+                              << "' is not available or already assigned";
+                    return false;
+                }
+            }
+            (name == "io" ? ioList : pools[name]) = list;
+        }
+        else
+        {
+            LOG_ERROR << "CpuLayout: bad CPU list '" << value << "' for '" << name << "'";
+            return false;
+        }
+    }
+
+    for (const auto& entry : counted)
+    {
+        std::vector<int>& list = pools[entry.first];
+        for (auto it = cpus.rbegin(); it != cpus.rend() && static_cast<int>(list.size()) < entry.second; ++it)
+        {
+            if (!used.count(it->id))
+            {
+                used.insert(it->id);
+                list.push_back(it->id);
+            }
+        }
+        if (static_cast<int>(list.size()) < entry.second)
+        {
+            LOG_ERROR << "CpuLayout: not enough CPUs for '" << entry.first << "' in '" << spec << "'";
+            return false;
+        }
+        std::sort(list.begin(), list.end());
+    }
+
+    // I/O 线程：剩下的（或指定的）CPU 中每个物理核取第一个逻辑 CPU，超线程兄弟留给别的线程
+    std::set<int> ioSet(ioList.begin(), ioList.end());
+    std::vector<int> ioCpus;
+    std::vector<int> shared;
+    std::set<std::pair<int, int>> cores;
+    for (const CpuInfo& cpu : cpus)
+    {
+        bool forIo = ioList.empty() ? !used.count(cpu.id) : ioSet.count(cpu.id) > 0;
+        if (!forIo)
+        {
+            if (!used.count(cpu.id))
+            {
+                shared.push_back(cpu.id);
+            }
+            continue;
+        }
+        if (cores.insert(std::make_pair(cpu.package, cpu.core)).second)
+        {
+            ioCpus.push_back(cpu.id);
+        }
+        else
+        {
+            shared.push_back(cpu.id);
+        }
+    }
+    if (ioCpus.empty())
+    {
+        LOG_ERROR << "CpuLayout: no CPU left for I/O threads in '" << spec << "'";
+        return false;
+    }
+
+    int ioThreads = ioCount > 0 ? ioCount : static_cast<int>(ioCpus.size());
+    int quota = cpuQuota();
+    if (ioCount == 0 && quota > 0 && ioThreads > quota)
+    {
+        ioThreads = quota;
+    }
+
+    available_.clear();
+    for (const CpuInfo& cpu : cpus)
+    {
+        available_.push_back(cpu.id);
+    }
+    ioCpus_.swap(ioCpus);
+    // 没有空闲 CPU 时，没单独划分的组和 I/O 线程共用全部 CPU
+    sharedCpus_ = shared.empty() ? available_ : shared;
+    pools_.swap(pools);
+    ioThreads_ = ioThreads;
+    pin_ = pin;
+    return true;
+}
+
+const std::vector<int>& CpuLayout::cpus(const std::string& pool) const
+{
+    static const std::vector<int> kEmpty;
+    auto it = pools_.find(pool);
+    return it != pools_.end() ? it->second : kEmpty;
+}
+
+void CpuLayout::pinIoThread(int index) const
+{
+    if (pin_ && !ioCpus_.empty())
+    {
+        pinCurrentThreadTo({ ioCpus_[index % ioCpus_.size()] });
+    }
+}
+
+void CpuLayout::pinCurrentThread(const std::string& pool) const
+{
+    if (!pin_)
+    {
+        return;
+    }
+    const std::vector<int>& list = cpus(pool);
+    pinCurrentThreadTo(list.empty() ? sharedCpus_ : list);
+}
+
+bool CpuLayout::pinCurrentThreadTo(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        CPU_SET(cpu, &set);
+    }
+    int err = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+    if (err != 0)
+    {
+        errno = err;
+        LOG_SYSERR << "pthread_setaffinity_np " << formatCpuList(cpus);
+        return false;
+    }
+    return true;
+}
+
+std::string CpuLayout::describe() const
+{
+    std::string result = "io=" + formatCpuList(ioCpus_) + " (" + std::to_string(ioThreads_) + " threads)";
+    for (const auto& pool : pools_)
+    {
+        result += " " + pool.first + "=" + formatCpuList(pool.second);
+    }
+    result += " shared=" + formatCpuList(sharedCpus_);
+    if (!pin_)
+    {
+        result += " pin=0";
+    }
+    return result;
+}
+
+bool CpuLayout::parseCpuList(const std::string& list, std::vector<int>* cpus)
+{
+    cpus->clear();
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ','))
+    {
+        size_t dash = range.find('-');
+        int first = 0;
+        int last = 0;
+        if (!parseCount(range.substr(0, dash), &first) ||
+            !parseCount(dash == std::string::npos ? range : range.substr(dash + 1), &last) ||
+            first > last || last >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus->push_back(cpu);
+        }
+    }
+    return !cpus->empty();
+}
+
+std::string CpuLayout::formatCpuList(const std::vector<int>& cpus)
+{
+    std::vector<int> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    std::string result;
+    for (size_t i = 0; i < sorted.size();)
+    {
+        size_t j = i;
+        while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1)
+        {
+            ++j;
+        }
+        if (!result.empty())
+        {
+            result += ",";
+        }
+        result += std::to_string(sorted[i]);
+        if (j > i)
+        {
+            result += "-" + std::to_string(sorted[j]);
+        }
+        i = j + 1;
+    }
+    return result;
+}
+
+} // namespace http
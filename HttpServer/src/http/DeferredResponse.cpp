@@ -0,0 +1,56 @@
+#include "../../include/http/DeferredResponse.h"
+
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+std::shared_ptr<DeferredResponse> DeferredResponse::start(const muduo::net::TcpConnectionPtr& conn,
+                                                          HttpResponse* resp)
+{
+    std::shared_ptr<DeferredResponse> deferred(new DeferredResponse(conn));
+    resp->setDeferred(deferred);
+    return deferred;
+}
+
+DeferredResponse::DeferredResponse(const muduo::net::TcpConnectionPtr& conn)
+    : conn_(conn)
+    , completed_(false)
+{
+}
+
+void DeferredResponse::complete()
+{
+    Callback onComplete;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (completed_)
+        {
+            return;
+        }
+        completed_ = true;
+        onComplete.swap(onComplete_);
+    }
+    // 还没 open() 的（handler 返回前就完成了）由 open() 投递
+    if (onComplete)
+    {
+        conn_->getLoop()->queueInLoop(std::move(onComplete));
+    }
+}
+
+void DeferredResponse::open(Callback onComplete)
+{
+    conn_->getLoop()->assertInLoopThread();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!completed_)
+        {
+            onComplete_ = std::move(onComplete);
+            return;
+        }
+    }
+    // 推迟到当前回调之后，避免在 HttpServer::onRequest 里重入
+    conn_->getLoop()->queueInLoop(std::move(onComplete));
+}
+
+} // namespace http
@@ -0,0 +1,330 @@
+#include "../../include/http/FileCache.h"
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iterator>
+
+#include <muduo/base/Logging.h>
+
+#include "../../include/utils/DateUtil.h"
+
+namespace http
+{
+
+namespace
+{
+
+bool endsWith(std::string_view s, std::string_view suffix)
+{
+    return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+}
+
+// 映射整个文件，返回的 owner 析构时 munmap
+std::shared_ptr<const void> mapFile(int fd, size_t size)
+{
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    return std::shared_ptr<const void>(addr, [size](const void* p)
+    {
+        ::munmap(const_cast<void*>(p), size);
+    });
+}
+
+std::string_view dirOf(const std::string& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string_view(".") : std::string_view(path).substr(0, slash);
+}
+
+} // namespace
+
+FileCache::FileCache(muduo::net::EventLoop* loop)
+    : loop_(loop)
+    , inotifyFd_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if (inotifyFd_ < 0)
+    {
+        LOG_WARN << "inotify_init1 failed, static files are revalidated by stat";
+        return;
+    }
+    channel_.reset(new muduo::net::Channel(loop_, inotifyFd_));
+    channel_->setReadCallback(std::bind(&FileCache::onInotify, this, std::placeholders::_1));
+    channel_->enableReading();
+}
+
+FileCache::~FileCache()
+{
+    if (channel_)
+    {
+        channel_->disableAll();
+        channel_->remove();
+    }
+    if (inotifyFd_ >= 0)
+    {
+        ::close(inotifyFd_);
+    }
+}
+
+std::string_view FileCache::contentTypeOf(std::string_view path)
+{
+    static const struct
+    {
+        const char* ext;
+        const char* type;
+    } kTypes[] = {
+        { ".html", "text/html; charset=utf-8" },
+        { ".htm",  "text/html; charset=utf-8" },
+        { ".css",  "text/css; charset=utf-8" },
+        { ".js",   "application/javascript; charset=utf-8" },
+        { ".mjs",  "application/javascript; charset=utf-8" },
+        { ".json", "application/json" },
+        { ".txt",  "text/plain; charset=utf-8" },
+        { ".xml",  "application/xml" },
+        { ".svg",  "image/svg+xml" },
+        { ".png",  "image/png" },
+        { ".jpg",  "image/jpeg" },
+        { ".jpeg", "image/jpeg" },
+        { ".gif",  "image/gif" },
+        { ".webp", "image/webp" },
+        { ".ico",  "image/x-icon" },
+        { ".woff", "font/woff" },
+        { ".woff2","font/woff2" },
+        { ".wasm", "application/wasm" },
+        { ".pdf",  "application/pdf" },
+        { ".mp4",  "video/mp4" },
+    };
+    for (const auto& t : kTypes)
+    {
+        if (endsWith(path, t.ext))
+        {
+            return t.type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+std::shared_ptr<const CachedFile> FileCache::load(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto file = std::make_shared<CachedFile>();
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size > kMaxInMemorySize)
+    {
+        file->owner = mapFile(fd, size);
+        if (file->owner)
+        {
+            file->data = std::string_view(static_cast<const char*>(file->owner.get()), size);
+        }
+    }
+    else
+    {
+        auto content = std::make_shared<std::string>(size, '\0');
+        size_t done = 0;
+        while (done < size)
+        {
+            ssize_t n = ::pread(fd, &(*content)[done], size - done, static_cast<off_t>(done));
+            if (n <= 0)
+            {
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        content->resize(done); // 读的过程中文件被截断，以实际读到的为准
+        file->data = *content;
+        file->owner = std::move(content);
+    }
+    ::close(fd); // mmap 之后映射独立于 fd
+    if (!file->owner)
+    {
+        LOG_ERROR << "Failed to load static file " << path;
+        return nullptr;
+    }
+
+    file->mtime = st.st_mtim.tv_sec;
+    char buf[64];
+    int n = snprintf(buf, sizeof buf, "\"%zx-%llx\"", file->data.size(),
+                     static_cast<unsigned long long>(st.st_mtim.tv_sec) * 1000000000ULL +
+                     static_cast<unsigned long long>(st.st_mtim.tv_nsec));
+    file->etag.assign(buf, n);
+    file->lastModified.assign(buf, DateUtil::format(file->mtime, buf));
+    file->contentType = contentTypeOf(path);
+    return file;
+}
+
+std::shared_ptr<const CachedFile> FileCache::get(const std::string& path)
+{
+    time_t now = ::time(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(path);
+        if (it != files_.end())
+        {
+            if (inotifyFd_ >= 0 || it->second.checked == now)
+            {
+                lru_.splice(lru_.begin(), lru_, it->second.lru);
+                return it->second.file;
+            }
+            // 没有 inotify：每秒最多 stat 一次，大小和修改时间都没变就继续用
+            struct stat st;
+            if (::stat(path.c_str(), &st) == 0 && st.st_mtim.tv_sec == it->second.file->mtime &&
+                static_cast<size_t>(st.st_size) == it->second.file->data.size())
+            {
+                it->second.checked = now;
+                lru_.splice(lru_.begin(), lru_, it->second.lru);
+                return it->second.file;
+            }
+            eraseLocked(it);
+        }
+        // 先建立监听再读文件，读的过程中发生的修改不会漏掉
+        watchLocked(path);
+    }
+
+    // 读文件放在锁外；并发的首次访问可能各自加载一次，结果相同
+    uint64_t generation = generation_.load();
+    std::shared_ptr<const CachedFile> file = load(path);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 加载期间收到过失效事件，读到的可能是修改到一半的内容，这次用完不缓存
+    if (generation != generation_.load())
+    {
+        return file;
+    }
+    auto it = files_.find(path);
+    if (it != files_.end())
+    {
+        // 并发的首次访问已经放进去了一份
+        it->second.file = file;
+        it->second.checked = now;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return file;
+    }
+    if (files_.size() >= kMaxEntries)
+    {
+        // 淘汰最久没访问的一个；正在发送的响应各自持有引用，不受影响
+        eraseLocked(files_.find(lru_.back()));
+    }
+    lru_.push_front(path);
+    files_.emplace(path, Entry{file, now, lru_.begin()});
+    return file;
+}
+
+FileCache::FileMap::iterator FileCache::eraseLocked(FileMap::iterator it)
+{
+    lru_.erase(it->second.lru);
+    return files_.erase(it);
+}
+
+void FileCache::clearLocked()
+{
+    files_.clear();
+    lru_.clear();
+}
+
+void FileCache::watchLocked(const std::string& path)
+{
+    if (inotifyFd_ < 0)
+    {
+        return;
+    }
+    std::string dir(dirOf(path));
+    if (dirWatches_.count(dir))
+    {
+        return;
+    }
+    // 监听目录而不是文件本身：rename 覆盖会换掉 inode，监听文件会漏掉
+    int wd = ::inotify_add_watch(inotifyFd_, dir.c_str(),
+                                 IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO |
+                                 IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF);
+    if (wd < 0)
+    {
+        LOG_WARN << "inotify_add_watch " << dir << " failed";
+        return;
+    }
+    watchDirs_[wd] = dir;
+    dirWatches_[dir] = wd;
+}
+
+void FileCache::onInotify(muduo::Timestamp)
+{
+    alignas(struct inotify_event) char buf[4096];
+    while (true)
+    {
+        ssize_t n = ::read(inotifyFd_, buf, sizeof buf);
+        if (n <= 0)
+        {
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        for (char* p = buf; p < buf + n;)
+        {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                clearLocked(); // 丢了事件，不知道哪些文件变了
+                continue;
+            }
+            auto dir = watchDirs_.find(event->wd);
+            if (dir == watchDirs_.end())
+            {
+                continue;
+            }
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+            {
+                // 目录本身没了：丢掉这个目录下的所有缓存，下次访问重新建立监听
+                std::string prefix = dir->second + "/";
+                for (auto it = files_.begin(); it != files_.end();)
+                {
+                    it = it->first.compare(0, prefix.size(), prefix) == 0 ? eraseLocked(it) : std::next(it);
+                }
+                if (event->mask & IN_MOVE_SELF)
+                {
+                    ::inotify_rm_watch(inotifyFd_, event->wd); // 随后收到 IN_IGNORED 再清理映射
+                }
+                if (event->mask & IN_IGNORED)
+                {
+                    dirWatches_.erase(dir->second);
+                    watchDirs_.erase(dir);
+                }
+                continue;
+            }
+            if (event->len > 0)
+            {
+                auto it = files_.find(dir->second + "/" + event->name);
+                if (it != files_.end())
+                {
+                    eraseLocked(it);
+                }
+            }
+        }
+    }
+}
+
+} // namespace http
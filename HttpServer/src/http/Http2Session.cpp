@@ -0,0 +1,837 @@
+#include "../../include/http/Http2Session.h"
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+
+#ifdef HTTP_WITH_NGHTTP2
+#include <nghttp2/nghttp2.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#endif
+
+namespace http
+{
+
+#ifdef HTTP_WITH_NGHTTP2
+
+namespace
+{
+
+// HTTP2-Settings 的取值是不带填充的 base64url（RFC 7540 3.2.1）
+bool decodeBase64Url(std::string_view in, std::string* out)
+{
+    uint32_t bits = 0;
+    int count = 0;
+    out->clear();
+    out->reserve(in.size() * 3 / 4);
+    for (char c : in)
+    {
+        int v;
+        if (c >= 'A' && c <= 'Z')
+            v = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            v = c - '0' + 52;
+        else if (c == '-')
+            v = 62;
+        else if (c == '_')
+            v = 63;
+        else if (c == '=')
+            break;
+        else
+            return false;
+
+        bits = (bits << 6) | static_cast<uint32_t>(v);
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            out->push_back(static_cast<char>((bits >> count) & 0xff));
+        }
+    }
+    return true;
+}
+
+// 只在 HTTP/1.1 上有意义的逐跳字段，HTTP/2 的响应里不能出现（RFC 9113 8.2.2）
+bool isConnectionSpecific(HttpHeaders::Known id)
+{
+    return id == HttpHeaders::kConnection || id == HttpHeaders::kKeepAlive ||
+           id == HttpHeaders::kTransferEncoding || id == HttpHeaders::kUpgrade;
+}
+
+nghttp2_nv makeNv(std::string_view name, std::string_view value)
+{
+    nghttp2_nv nv;
+    nv.name = reinterpret_cast<uint8_t*>(const_cast<char*>(name.data()));
+    nv.namelen = name.size();
+    nv.value = reinterpret_cast<uint8_t*>(const_cast<char*>(value.data()));
+    nv.valuelen = value.size();
+    nv.flags = NGHTTP2_NV_FLAG_NONE;
+    return nv;
+}
+
+} // namespace
+
+struct Http2Callbacks
+{
+    static int onBeginHeaders(nghttp2_session* session, const nghttp2_frame* frame, void* userData)
+    {
+        Http2Session* self = static_cast<Http2Session*>(userData);
+        if (frame->hd.type != NGHTTP2_HEADERS || frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        {
+            return 0;
+        }
+        auto stream = std::make_shared<Http2Stream>(frame->hd.stream_id);
+        muduo::Timestamp now = muduo::Timestamp::now();
+        stream->request.setReceiveTime(now);
+        // 和 HTTP/1.1 一样，headerTimeout 是收完请求头的总时间
+        if (self->limits_.headerTimeout > 0)
+        {
+            stream->deadline = muduo::addTime(now, self->limits_.headerTimeout);
+        }
+        self->streams_[stream->id] = stream;
+        nghttp2_session_set_stream_user_data(session, stream->id, stream.get());
+        return 0;
+    }
+
+    static int onHeader(nghttp2_session* session, const nghttp2_frame* frame,
+                        const uint8_t* name, size_t nameLen,
+                        const uint8_t* value, size_t valueLen,
+                        uint8_t, void* userData)
+    {
+        Http2Session* self = static_cast<Http2Session*>(userData);
+        // trailer 字段直接丢弃，和 HTTP/1.1 的 chunked trailer 一样
+        if (frame->hd.type != NGHTTP2_HEADERS || frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        {
+            return 0;
+        }
+        auto* stream = static_cast<Http2Stream*>(nghttp2_session_get_stream_user_data(session, frame->hd.stream_id));
+        if (!stream || stream->error != HttpResponse::kUnknown)
+        {
+            return 0;
+        }
+        // 和 SETTINGS_MAX_HEADER_LIST_SIZE 一样，每个字段另加 32 字节
+        stream->headerBytes += nameLen + valueLen + 32;
+        if (stream->headerBytes > self->limits_.maxHeaderBytes)
+        {
+            stream->error = HttpResponse::k431RequestHeaderFieldsTooLarge;
+            return 0;
+        }
+
+        // 字段名的合法性（小写、没有逐跳字段、伪头部齐全）nghttp2 已经检查过
+        std::string_view key(reinterpret_cast<const char*>(name), nameLen);
+        std::string_view val(reinterpret_cast<const char*>(value), valueLen);
+        HttpRequest& req = stream->request;
+        if (key[0] == ':')
+        {
+            if (key == ":method")
+            {
+                if (!req.setMethod(val.data(), val.data() + val.size()))
+                {
+                    stream->error = HttpResponse::k501NotImplemented;
+                }
+            }
+            else if (key == ":path")
+            {
+                size_t question = val.find('?');
+                if (question == std::string_view::npos)
+                {
+                    req.setPath(val.data(), val.data() + val.size());
+                }
+                else
+                {
+                    req.setPath(val.data(), val.data() + question);
+                    req.setQueryParameters(val.data() + question + 1, val.data() + val.size());
+                }
+            }
+            else if (key == ":authority" && !req.headers().has(HttpHeaders::kHost))
+            {
+                req.addHeader(HttpHeaders::name(HttpHeaders::kHost), val);
+            }
+            // :scheme 用不到
+        }
+        else if (key == "cookie")
+        {
+            if (!stream->cookie.empty())
+            {
+                stream->cookie.append("; ");
+            }
+            stream->cookie.append(val.data(), val.size());
+        }
+        else if (req.headers().size() >= self->limits_.maxHeaderCount)
+        {
+            stream->error = HttpResponse::k431RequestHeaderFieldsTooLarge;
+        }
+        else
+        {
+            req.addHeader(key, val);
+        }
+        return 0;
+    }
+
+    static int onFrameRecv(nghttp2_session*, const nghttp2_frame* frame, void* userData)
+    {
+        Http2Session* self = static_cast<Http2Session*>(userData);
+        if (frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA)
+        {
+            return 0;
+        }
+        Http2Session::StreamPtr stream = self->findStream(frame->hd.stream_id);
+        if (!stream)
+        {
+            return 0;
+        }
+        if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST)
+        {
+            self->finishHeaders(stream);
+        }
+        if (frame->hd.flags & NGHTTP2_FLAG_END_STREAM)
+        {
+            self->finishRequest(stream);
+        }
+        return 0;
+    }
+
+    static int onDataChunkRecv(nghttp2_session*, uint8_t, int32_t streamId,
+                               const uint8_t* data, size_t len, void* userData)
+    {
+        Http2Session* self = static_cast<Http2Session*>(userData);
+        Http2Session::StreamPtr stream = self->findStream(streamId);
+        if (!stream || stream->rejected)
+        {
+            // 已经回了错误响应的请求，剩下的请求体丢弃，流量控制窗口照常归还；期限也不再顺延
+            self->consume(stream.get(), streamId, len, false);
+            return 0;
+        }
+        // bodyTimeout 是两次收到请求体之间的间隔
+        if (self->limits_.bodyTimeout > 0)
+        {
+            stream->deadline = muduo::addTime(muduo::Timestamp::now(), self->limits_.bodyTimeout);
+        }
+        HttpRequest& req = stream->request;
+        const char* p = reinterpret_cast<const char*>(data);
+        bool buffered = false;
+        if (BodySink* sink = req.bodySink())
+        {
+            if (!sink->onData(p, len))
+            {
+                self->rejectStream(stream, sink->errorCode());
+            }
+        }
+        else if (req.getBody().size() + len > self->limits_.maxBodySize)
+        {
+            self->rejectStream(stream, HttpResponse::k413PayloadTooLarge);
+        }
+        else
+        {
+            req.appendBody(p, len);
+            stream->bodyBytes += len;
+            self->bufferedBody_ += len;
+            buffered = true;
+        }
+        self->consume(stream.get(), streamId, len, buffered);
+        return 0;
+    }
+
+    static int onStreamClose(nghttp2_session*, int32_t streamId, uint32_t, void* userData)
+    {
+        Http2Session* self = static_cast<Http2Session*>(userData);
+        auto it = self->streams_.find(streamId);
+        if (it == self->streams_.end())
+        {
+            return 0;
+        }
+        Http2Session::StreamPtr stream = std::move(it->second);
+        self->streams_.erase(it);
+        stream->closed = true;
+        self->releaseBody(stream.get());
+        stream->drainedCallback = nullptr;
+        if (stream->closeCallback)
+        {
+            std::function<void()> cb;
+            cb.swap(stream->closeCallback);
+            cb();
+        }
+        if (self->closeCallback_)
+        {
+            self->closeCallback_(stream);
+        }
+        return 0;
+    }
+
+    // 响应体的数据源：从流的 output 里取，取空了但响应还没结束时让 nghttp2 暂停这个流
+    static ssize_t readBody(nghttp2_session*, int32_t, uint8_t* buf, size_t length,
+                            uint32_t* dataFlags, nghttp2_data_source* source, void* userData)
+    {
+        Http2Session* self = static_cast<Http2Session*>(userData);
+        auto* stream = static_cast<Http2Stream*>(source->ptr);
+        muduo::net::Buffer& output = stream->output;
+        size_t n = std::min(length, output.readableBytes());
+        std::memcpy(buf, output.peek(), n);
+        output.retrieve(n);
+        if (output.readableBytes() == 0)
+        {
+            if (stream->outputEnd)
+            {
+                *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+            }
+            else if (n == 0)
+            {
+                stream->deferred = true;
+                return NGHTTP2_ERR_DEFERRED;
+            }
+            else if (stream->drainedCallback)
+            {
+                // 在 nghttp2 的调用栈里，推迟到当前回调之后
+                self->conn_->getLoop()->queueInLoop(stream->drainedCallback);
+            }
+        }
+        return static_cast<ssize_t>(n);
+    }
+};
+
+bool Http2Session::supported()
+{
+    return true;
+}
+
+Http2Session::Http2Session(muduo::net::TcpConnection* conn, ssl::SslConnection* ssl, const HttpLimits& limits)
+    : session_(nullptr)
+    , conn_(conn)
+    , ssl_(ssl)
+    , limits_(limits)
+    , bufferedBody_(0)
+    , maxBufferedBody_(std::max<size_t>(kMaxBufferedBody, limits.maxBodySize))
+    , inRead_(false)
+    , goingAway_(false)
+    , closing_(false)
+{
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, &Http2Callbacks::onBeginHeaders);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &Http2Callbacks::onHeader);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, &Http2Callbacks::onFrameRecv);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &Http2Callbacks::onDataChunkRecv);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &Http2Callbacks::onStreamClose);
+    // 请求体的流量控制窗口由 consume() 归还，缓存的请求体太多时暂扣
+    nghttp2_option* option;
+    nghttp2_option_new(&option);
+    nghttp2_option_set_no_auto_window_update(option, 1);
+    int rv = nghttp2_session_server_new2(&session_, callbacks, this, option);
+    nghttp2_option_del(option);
+    nghttp2_session_callbacks_del(callbacks);
+    if (rv != 0)
+    {
+        LOG_FATAL << "nghttp2_session_server_new: " << nghttp2_strerror(rv);
+    }
+}
+
+Http2Session::~Http2Session()
+{
+    nghttp2_session_del(session_);
+}
+
+Http2Session::StreamPtr Http2Session::upgrade(std::string_view settings, HttpRequest* request)
+{
+    std::string payload;
+    if (!decodeBase64Url(settings, &payload))
+    {
+        return nullptr;
+    }
+    auto stream = std::make_shared<Http2Stream>(1);
+    int rv = nghttp2_session_upgrade2(session_, reinterpret_cast<const uint8_t*>(payload.data()), payload.size(),
+                                      request->method() == HttpRequest::kHead, stream.get());
+    if (rv != 0)
+    {
+        LOG_DEBUG << "Ignore h2c upgrade from " << conn_->peerAddress().toIpPort() << ": " << nghttp2_strerror(rv);
+        return nullptr;
+    }
+    stream->request.swap(*request);
+    stream->request.setVersion("HTTP/2");
+    stream->request.setStreamId(stream->id);
+    streams_[stream->id] = stream;
+    return stream;
+}
+
+void Http2Session::start()
+{
+    nghttp2_settings_entry settings[] = {
+        { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, kMaxConcurrentStreams },
+        { NGHTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, static_cast<uint32_t>(limits_.maxHeaderBytes) },
+    };
+    nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, settings, sizeof settings / sizeof settings[0]);
+    // 连接的输出缓冲区发空之后接着取帧（见 flush）。连接经由 HttpContext 持有这个对象，回调时一定还在
+    conn_->setWriteCompleteCallback([this](const muduo::net::TcpConnectionPtr&) { flush(); });
+    flush();
+}
+
+bool Http2Session::onRead(muduo::net::Buffer* buf)
+{
+    // 回调里 handler 产生的响应先攒着，整批数据处理完之后一起发
+    inRead_ = true;
+    ssize_t n = nghttp2_session_mem_recv(session_, reinterpret_cast<const uint8_t*>(buf->peek()),
+                                         buf->readableBytes());
+    inRead_ = false;
+    buf->retrieveAll();
+    if (n < 0)
+    {
+        LOG_DEBUG << "HTTP/2 error from " << conn_->peerAddress().toIpPort() << ": " << nghttp2_strerror(static_cast<int>(n));
+        // 连接前言不对等错误 nghttp2 不会自己发 GOAWAY
+        nghttp2_session_terminate_session(session_, NGHTTP2_PROTOCOL_ERROR);
+        flush();
+        closing_ = true;
+        conn_->shutdown();
+        return false;
+    }
+    flush();
+    return true;
+}
+
+void Http2Session::submitResponse(const StreamPtr& stream)
+{
+    if (stream->closed)
+    {
+        return;
+    }
+    const HttpResponse& response = stream->response;
+    // HEAD 的流式响应只发头部
+    bool streaming = response.isStreaming() && stream->request.method() != HttpRequest::kHead;
+
+    // HPACK 要求字段名小写；nghttp2 提交时会拷贝，这些临时存储只需要活到 submit 返回
+    char status[8];
+    int statusLength = std::snprintf(status, sizeof status, "%d",
+                                     response.getStatusCode() == HttpResponse::kUnknown
+                                         ? static_cast<int>(HttpResponse::k200Ok)
+                                         : static_cast<int>(response.getStatusCode()));
+    std::string contentLength;
+    std::vector<std::pair<std::string, std::string_view>> fields;
+    bool withDate = true;
+    response.forEachHeader([&](std::string_view name, std::string_view value)
+    {
+        HttpHeaders::Known id = HttpHeaders::lookup(name);
+        if (isConnectionSpecific(id))
+        {
+            return;
+        }
+        withDate = withDate && id != HttpHeaders::kDate;
+        std::string lower(name);
+        for (char& c : lower)
+        {
+            c = toLowerAscii(c);
+        }
+        fields.emplace_back(std::move(lower), value);
+    });
+
+    std::vector<nghttp2_nv> nva;
+    nva.reserve(fields.size() + 3);
+    nva.push_back(makeNv(":status", std::string_view(status, statusLength)));
+    if (withDate)
+    {
+        nva.push_back(makeNv("date", HttpResponse::currentDate()));
+    }
+    int64_t length = response.contentLengthValue();
+    if (length >= 0)
+    {
+        contentLength = std::to_string(length);
+        nva.push_back(makeNv("content-length", contentLength));
+    }
+    for (const auto& field : fields)
+    {
+        nva.push_back(makeNv(field.first, field.second));
+    }
+
+    if (!streaming)
+    {
+        response.appendBodyToBuffer(&stream->output);
+        stream->outputEnd = true;
+    }
+    nghttp2_data_provider provider;
+    provider.source.ptr = stream.get();
+    provider.read_callback = &Http2Callbacks::readBody;
+    bool withBody = streaming || stream->output.readableBytes() > 0;
+    int rv = nghttp2_submit_response(session_, stream->id, nva.data(), nva.size(), withBody ? &provider : nullptr);
+    if (rv != 0)
+    {
+        LOG_ERROR << "nghttp2_submit_response on stream " << stream->id << ": " << nghttp2_strerror(rv);
+        nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, stream->id, NGHTTP2_INTERNAL_ERROR);
+    }
+    flush();
+}
+
+bool Http2Session::sendData(int32_t streamId, muduo::net::Buffer* data, bool end)
+{
+    StreamPtr stream = findStream(streamId);
+    if (!stream)
+    {
+        data->retrieveAll();
+        return false;
+    }
+    if (stream->output.readableBytes() == 0)
+    {
+        stream->output.swap(*data);
+    }
+    else
+    {
+        stream->output.append(data->peek(), data->readableBytes());
+        data->retrieveAll();
+    }
+    stream->outputEnd = stream->outputEnd || end;
+    if (stream->deferred && (stream->output.readableBytes() > 0 || stream->outputEnd))
+    {
+        stream->deferred = false;
+        nghttp2_session_resume_data(session_, streamId);
+    }
+    flush();
+    return true;
+}
+
+size_t Http2Session::bufferedBytes(int32_t streamId) const
+{
+    StreamPtr stream = findStream(streamId);
+    return stream ? stream->output.readableBytes() : 0;
+}
+
+void Http2Session::observeStream(int32_t streamId, std::function<void()> drained, std::function<void()> closed)
+{
+    if (StreamPtr stream = findStream(streamId))
+    {
+        stream->drainedCallback = std::move(drained);
+        stream->closeCallback = std::move(closed);
+    }
+}
+
+void Http2Session::resetStream(int32_t streamId)
+{
+    if (findStream(streamId))
+    {
+        nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, streamId, NGHTTP2_INTERNAL_ERROR);
+        flush();
+    }
+}
+
+void Http2Session::shutdown()
+{
+    if (goingAway_ || closing_)
+    {
+        return;
+    }
+    goingAway_ = true;
+    // 告诉对方最后处理的流，之后新开的流不会被处理，客户端可以放心地在新连接上重试
+    nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE, nghttp2_session_get_last_proc_stream_id(session_),
+                          NGHTTP2_NO_ERROR, nullptr, 0);
+    flush();
+}
+
+muduo::Timestamp Http2Session::nextDeadline() const
+{
+    muduo::Timestamp earliest;
+    for (const auto& entry : streams_)
+    {
+        const muduo::Timestamp& deadline = entry.second->deadline;
+        if (deadline.valid() && (!earliest.valid() || deadline < earliest))
+        {
+            earliest = deadline;
+        }
+    }
+    return earliest;
+}
+
+void Http2Session::expireStreams(muduo::Timestamp now)
+{
+    // 回 408、RST_STREAM 时流可能当场关闭，先挑出来再处理
+    std::vector<StreamPtr> expired;
+    for (const auto& entry : streams_)
+    {
+        const muduo::Timestamp& deadline = entry.second->deadline;
+        if (deadline.valid() && !(now < deadline))
+        {
+            expired.push_back(entry.second);
+        }
+    }
+    for (const StreamPtr& stream : expired)
+    {
+        LOG_DEBUG << "Request timeout on " << conn_->name() << " stream " << stream->id;
+        stream->deadline = muduo::Timestamp();
+        if (!stream->rejected)
+        {
+            rejectStream(stream, HttpResponse::k408RequestTimeout);
+        }
+        // 响应之后请求体不用再发了（RFC 9113 8.1）
+        if (!stream->closed)
+        {
+            nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, stream->id, NGHTTP2_NO_ERROR);
+        }
+    }
+    flush();
+}
+
+void Http2Session::onDisconnected()
+{
+    std::unordered_map<int32_t, StreamPtr> streams;
+    streams.swap(streams_);
+    for (auto& entry : streams)
+    {
+        const StreamPtr& stream = entry.second;
+        stream->closed = true;
+        stream->drainedCallback = nullptr;
+        if (stream->closeCallback)
+        {
+            std::function<void()> cb;
+            cb.swap(stream->closeCallback);
+            cb();
+        }
+        if (closeCallback_)
+        {
+            closeCallback_(stream);
+        }
+    }
+    closing_ = true;
+}
+
+void Http2Session::flush()
+{
+    if (inRead_ || closing_)
+    {
+        return;
+    }
+    // 对方读得慢时帧留在 nghttp2 和各个流里，不在连接的输出缓冲区里无限堆积
+    while (conn_->outputBuffer()->readableBytes() < kHighWaterMark)
+    {
+        const uint8_t* data = nullptr;
+        ssize_t n = nghttp2_session_mem_send(session_, &data);
+        if (n < 0)
+        {
+            LOG_ERROR << "nghttp2_session_mem_send: " << nghttp2_strerror(static_cast<int>(n));
+            closing_ = true;
+            conn_->forceClose();
+            return;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        output_.append(data, static_cast<size_t>(n));
+        if (output_.readableBytes() >= kHighWaterMark)
+        {
+            break;
+        }
+    }
+    if (output_.readableBytes() > 0)
+    {
+        if (ssl_)
+        {
+            ssl_->send(output_.peek(), output_.readableBytes());
+            output_.retrieveAll();
+        }
+        else
+        {
+            conn_->send(&output_);
+        }
+    }
+    checkClose();
+}
+
+Http2Session::StreamPtr Http2Session::findStream(int32_t streamId) const
+{
+    auto it = streams_.find(streamId);
+    return it == streams_.end() ? nullptr : it->second;
+}
+
+void Http2Session::finishHeaders(const StreamPtr& stream)
+{
+    // 接下来按 bodyTimeout 等请求体；没有请求体的紧接着在 finishRequest 里清掉
+    stream->deadline = limits_.bodyTimeout > 0 ? muduo::addTime(muduo::Timestamp::now(), limits_.bodyTimeout)
+                                               : muduo::Timestamp();
+    HttpRequest& req = stream->request;
+    if (!stream->cookie.empty())
+    {
+        req.addHeader(HttpHeaders::name(HttpHeaders::kCookie), stream->cookie);
+        stream->cookie.clear();
+    }
+    req.setVersion("HTTP/2");
+    req.setStreamId(stream->id);
+    if (stream->error != HttpResponse::kUnknown)
+    {
+        rejectStream(stream, stream->error);
+        return;
+    }
+    if (headersCallback_ && !headersCallback_(stream))
+    {
+        stream->rejected = true;
+    }
+}
+
+void Http2Session::finishRequest(const StreamPtr& stream)
+{
+    stream->deadline = muduo::Timestamp();
+    if (stream->rejected)
+    {
+        return;
+    }
+    HttpRequest& req = stream->request;
+    if (BodySink* sink = req.bodySink())
+    {
+        sink->onFinish();
+    }
+    else
+    {
+        req.setContentLength(req.getBody().size());
+    }
+    if (requestCallback_)
+    {
+        requestCallback_(stream);
+    }
+}
+
+void Http2Session::rejectStream(const StreamPtr& stream, HttpResponse::HttpStatusCode code)
+{
+    stream->rejected = true;
+    stream->response.reset(false);
+    stream->response.setStatusCode(code);
+    submitResponse(stream);
+}
+
+void Http2Session::consume(Http2Stream* stream, int32_t streamId, size_t length, bool buffered)
+{
+    if (buffered && bufferedBody_ > maxBufferedBody_)
+    {
+        stream->unconsumed += length;
+        return;
+    }
+    // 流已经不在了时只归还连接的窗口
+    nghttp2_session_consume(session_, streamId, length);
+}
+
+void Http2Session::releaseBody(Http2Stream* stream)
+{
+    bufferedBody_ -= stream->bodyBytes;
+    stream->bodyBytes = 0;
+    if (stream->unconsumed > 0)
+    {
+        nghttp2_session_consume_connection(session_, stream->unconsumed);
+        stream->unconsumed = 0;
+    }
+    if (bufferedBody_ > maxBufferedBody_)
+    {
+        return;
+    }
+    for (auto& entry : streams_)
+    {
+        Http2Stream* other = entry.second.get();
+        if (other->unconsumed > 0)
+        {
+            nghttp2_session_consume(session_, other->id, other->unconsumed);
+            other->unconsumed = 0;
+        }
+    }
+}
+
+void Http2Session::checkClose()
+{
+    if (closing_)
+    {
+        return;
+    }
+    // GOAWAY 之后流都结束了；或者对方发了 GOAWAY、出了连接级错误，nghttp2 不再收发
+    if ((goingAway_ && streams_.empty() && !nghttp2_session_want_write(session_)) ||
+        (!nghttp2_session_want_read(session_) && !nghttp2_session_want_write(session_)))
+    {
+        closing_ = true;
+        conn_->shutdown();
+    }
+}
+
+#else // HTTP_WITH_NGHTTP2
+
+// 没有 nghttp2：HttpServer 看到 supported() 为 false 就不会创建会话，下面只为链接通过
+
+bool Http2Session::supported()
+{
+    return false;
+}
+
+Http2Session::Http2Session(muduo::net::TcpConnection* conn, ssl::SslConnection* ssl, const HttpLimits& limits)
+    : session_(nullptr)
+    , conn_(conn)
+    , ssl_(ssl)
+    , limits_(limits)
+    , bufferedBody_(0)
+    , maxBufferedBody_(kMaxBufferedBody)
+    , inRead_(false)
+    , goingAway_(false)
+    , closing_(false)
+{
+}
+
+Http2Session::~Http2Session() = default;
+
+Http2Session::StreamPtr Http2Session::upgrade(std::string_view, HttpRequest*)
+{
+    return nullptr;
+}
+
+void Http2Session::start()
+{
+}
+
+bool Http2Session::onRead(muduo::net::Buffer* buf)
+{
+    buf->retrieveAll();
+    conn_->forceClose();
+    return false;
+}
+
+void Http2Session::submitResponse(const StreamPtr&)
+{
+}
+
+bool Http2Session::sendData(int32_t, muduo::net::Buffer* data, bool)
+{
+    data->retrieveAll();
+    return false;
+}
+
+size_t Http2Session::bufferedBytes(int32_t) const
+{
+    return 0;
+}
+
+void Http2Session::observeStream(int32_t, std::function<void()>, std::function<void()>)
+{
+}
+
+void Http2Session::resetStream(int32_t)
+{
+}
+
+void Http2Session::shutdown()
+{
+    conn_->shutdown();
+}
+
+muduo::Timestamp Http2Session::nextDeadline() const
+{
+    return muduo::Timestamp();
+}
+
+void Http2Session::expireStreams(muduo::Timestamp)
+{
+}
+
+void Http2Session::onDisconnected()
+{
+}
+
+void Http2Session::flush()
+{
+}
+
+#endif // HTTP_WITH_NGHTTP2
+
+} // namespace http
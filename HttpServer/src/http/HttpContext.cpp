@@ -1,4 +1,11 @@
 #include "../../include/http/HttpContext.h"
+#include "../../include/http/HttpTokenizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <climits>
+#include <limits>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -31,16 +38,24 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
     {
         // 第1轮循环：解析请求行
         // buf内容: "POST /api/login?id=123 HTTP/1.1\r\nHost:..."
-        // findCRLF()找到第一个\r\n的位置
+        // findCRLF()找到第一个\r\n的位置（向量化扫描，见 HttpTokenizer）
         if (state_ == kExpectRequestLine)
         {
-            const char *crlf = buf->findCRLF(); // 注意这个返回值边界可能有错
-            if (crlf)
+            const char *crlf = tokenizer::findCRLF(buf->peek(), buf->peek() + buf->readableBytes());
+            size_t lineBytes = crlf ? static_cast<size_t>(crlf + 2 - buf->peek()) : buf->readableBytes();
+            if (lineBytes > limits_.maxHeaderBytes)
+            {
+                // 请求行本身就超过了请求头的总限制（一般是超长的 URL）
+                ok = fail(HttpResponse::k414UriTooLong);
+                hasMore = false;
+            }
+            else if (crlf)
             {
                 ok = processRequestLine(buf->peek(), crlf);
                 if (ok)
                 {
                     request_.setReceiveTime(receiveTime);
+                    headerBytes_ = lineBytes;
                     buf->retrieveUntil(crlf + 2);
                     state_ = kExpectHeaders;
                 }
@@ -58,49 +73,46 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
         // buf现在内容: "Host: www.example.com\r\nContent-Type:..."
         else if (state_ == kExpectHeaders)
         {
-            const char *crlf = buf->findCRLF();
-            if (crlf)
+            // 一趟扫描同时找 ':' 和 '\r'，冒号之后再接着找行尾
+            const char *begin = buf->peek();
+            const char *end = begin + buf->readableBytes();
+            const char *colon = tokenizer::findEither(begin, end, ':', '\r');
+            const char *crlf = tokenizer::findCRLF(colon, end);
+            size_t lineBytes = crlf ? static_cast<size_t>(crlf + 2 - begin) : buf->readableBytes();
+            if (headerBytes_ + lineBytes > limits_.maxHeaderBytes)
             {
-                const char *colon = std::find(buf->peek(), crlf, ':');
-                if (colon < crlf)
+                // 请求头总长度超限；没找到行尾时也检查，避免对方一直不发 \r\n
+                ok = fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+                hasMore = false;
+            }
+            else if (crlf)
+            {
+                headerBytes_ += lineBytes;
+                if (colon < crlf && *colon != ':')
                 {
-                    request_.addHeader(buf->peek(), colon, crlf);
+                    // 行内出现了单独的 '\r'，在剩下的部分里继续找冒号
+                    colon = tokenizer::findByte(colon, crlf, ':');
                 }
-                else if (buf->peek() == crlf)
-                { 
-                    // 空行，结束Header
-                    // 根据请求方法和Content-Length判断是否需要继续读取body
-                    if (request_.method() == HttpRequest::kPost || 
-                        request_.method() == HttpRequest::kPut)
+                if (colon < crlf)
+                {
+                    if (request_.headers().size() >= limits_.maxHeaderCount)
                     {
-                        std::string contentLength = request_.getHeader("Content-Length");
-                        if (!contentLength.empty())
-                        {
-                            request_.setContentLength(std::stoi(contentLength));
-                            if (request_.contentLength() > 0)
-                            {
-                                state_ = kExpectBody;
-                            }
-                            else
-                            {
-                                state_ = kGotAll;
-                                hasMore = false;
-                            }
-                        }
-                        else
-                        {
-                            // POST/PUT 请求没有 Content-Length，是HTTP语法错误
-                            ok = false;
-                            hasMore = false;
-                        }
+                        ok = fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+                        hasMore = false;
                     }
-                    else
+                    else if (!request_.addHeader(buf->peek(), colon, crlf))
                     {
-                        // GET/HEAD/DELETE 等方法直接完成（没有请求体）
-                        state_ = kGotAll; 
+                        ok = fail(HttpResponse::k400BadRequest);
                         hasMore = false;
                     }
                 }
+                else if (buf->peek() == crlf)
+                { 
+                    // 空行，结束Header
+                    // 根据 Transfer-Encoding / Content-Length 判断是否需要继续读取body
+                    ok = processHeadersEnd();
+                    hasMore = false;
+                }
                 else
                 {
                     ok = false; // Header行格式错误
@@ -115,40 +127,289 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
         }
         else if (state_ == kExpectBody)
         {
-            // 检查缓冲区中是否有足够的数据
-            if (buf->readableBytes() < request_.contentLength())
+            if (request_.bodySink())
             {
-                hasMore = false; // 数据不完整，等待更多数据
-                return true;
+                // 流式接收：缓冲区里有多少就交给 sink 多少，不等整个请求体到齐
+                ok = consumeBody(buf);
+                if (ok && bodyRemaining_ == 0)
+                {
+                    finishBody();
+                }
+                hasMore = false;
             }
+            else
+            {
+                // 检查缓冲区中是否有足够的数据
+                if (buf->readableBytes() < request_.contentLength())
+                {
+                    hasMore = false; // 数据不完整，等待更多数据
+                    return true;
+                }
 
-            // 只读取 Content-Length 指定的长度
-            std::string body(buf->peek(), buf->peek() + request_.contentLength());
-            request_.setBody(body);
+                // 只读取 Content-Length 指定的长度，不拷贝：
+                // retrieve 只移动读指针，在下一次向缓冲区写入之前这段内存都不会被改动
+                request_.setBody(buf->peek(), buf->peek() + request_.contentLength());
 
-            // 准确移动读指针
-            buf->retrieve(request_.contentLength());
+                // 准确移动读指针
+                buf->retrieve(request_.contentLength());
 
-            state_ = kGotAll;
+                state_ = kGotAll;
+                hasMore = false;
+            }
+        }
+        /*
+            chunked 请求体：
+                5\r\n
+                hello\r\n
+                0\r\n
+                \r\n
+            每个 chunk 先是十六进制长度（后面可能跟 ";扩展"），再是数据和 \r\n，
+            长度为 0 的 chunk 表示结束，之后是可选的 trailer 和一个空行。
+         */
+        else if (state_ == kExpectChunkSize)
+        {
+            const char *crlf = tokenizer::findCRLF(buf->peek(), buf->peek() + buf->readableBytes());
+            size_t lineSize = crlf ? static_cast<size_t>(crlf - buf->peek()) : buf->readableBytes();
+            if (lineSize > limits_.maxChunkLineSize)
+            {
+                ok = fail(HttpResponse::k400BadRequest);
+                hasMore = false;
+            }
+            else if (crlf)
+            {
+                ok = processChunkSize(buf->peek(), crlf);
+                buf->retrieveUntil(crlf + 2);
+                hasMore = ok;
+            }
+            else
+            {
+                hasMore = false;
+            }
+        }
+        else if (state_ == kExpectChunkData)
+        {
+            ok = consumeBody(buf);
+            if (ok && bodyRemaining_ == 0)
+            {
+                state_ = kExpectChunkCrlf;
+            }
+            else
+            {
+                hasMore = false;
+            }
+        }
+        else if (state_ == kExpectChunkCrlf)
+        {
+            if (buf->readableBytes() < 2)
+            {
+                hasMore = false;
+            }
+            else if (buf->peek()[0] == '\r' && buf->peek()[1] == '\n')
+            {
+                buf->retrieve(2);
+                state_ = kExpectChunkSize;
+            }
+            else
+            {
+                ok = fail(HttpResponse::k400BadRequest);
+                hasMore = false;
+            }
+        }
+        else if (state_ == kExpectTrailers)
+        {
+            const char *crlf = tokenizer::findCRLF(buf->peek(), buf->peek() + buf->readableBytes());
+            size_t lineBytes = crlf ? static_cast<size_t>(crlf + 2 - buf->peek()) : buf->readableBytes();
+            if (lineBytes > limits_.maxHeaderBytes)
+            {
+                ok = fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+                hasMore = false;
+            }
+            else if (!crlf)
+            {
+                hasMore = false;
+            }
+            else if (crlf == buf->peek())
+            {
+                buf->retrieve(2);
+                finishBody();
+                hasMore = false;
+            }
+            else
+            {
+                // trailer 字段直接丢弃：不并入请求头，免得绕过前面已经对请求头做过的检查
+                buf->retrieveUntil(crlf + 2);
+            }
+        }
+        else
+        {
+            // kGotHeaders 等待调用方 startBody()；kGotAll 等待 reset()
             hasMore = false;
         }
     }
     return ok; // ok为false代表报文语法解析错误
 }
 
+// 请求头结束：确定请求体的长度和编码
+bool HttpContext::processHeadersEnd()
+{
+    std::string_view transferEncoding = request_.getHeader(HttpHeaders::kTransferEncoding);
+    std::string_view contentLength = request_.getHeader(HttpHeaders::kContentLength);
+
+    if (!transferEncoding.empty())
+    {
+        // 同时带 Transfer-Encoding 和 Content-Length 是典型的请求走私手法，直接拒绝
+        if (!contentLength.empty())
+        {
+            return fail(HttpResponse::k400BadRequest);
+        }
+        // 只支持单独的 chunked，gzip 等其他编码不做解码
+        if (!equalsIgnoreCase(transferEncoding, "chunked"))
+        {
+            return fail(HttpResponse::k501NotImplemented);
+        }
+        chunked_ = true;
+        state_ = kGotHeaders;
+        return true;
+    }
+
+    if (contentLength.empty())
+    {
+        // 既没有 Transfer-Encoding 也没有 Content-Length 的请求，请求体长度为 0（RFC 9112 6.3）。
+        // 同样停在 kGotHeaders，让调用方按路由做完准入、offload 等判断
+        state_ = kGotHeaders;
+        return true;
+    }
+
+    uint64_t length = 0;
+    auto result = std::from_chars(contentLength.data(),
+                                  contentLength.data() + contentLength.size(),
+                                  length);
+    if (result.ec != std::errc() || result.ptr != contentLength.data() + contentLength.size())
+    {
+        return fail(HttpResponse::k400BadRequest); // 非法的 Content-Length
+    }
+
+    request_.setContentLength(length);
+    state_ = kGotHeaders;
+    return true;
+}
+
+bool HttpContext::startBody()
+{
+    assert(state_ == kGotHeaders);
+    if (chunked_)
+    {
+        state_ = kExpectChunkSize;
+        return true;
+    }
+    if (request_.contentLength() == 0)
+    {
+        finishBody();
+        return true;
+    }
+
+    // 没有 sink 的请求体要整份放在内存里，先按 Content-Length 检查上限
+    if (!request_.bodySink() && request_.contentLength() > limits_.maxBodySize)
+    {
+        return fail(HttpResponse::k413PayloadTooLarge);
+    }
+    bodyRemaining_ = request_.contentLength();
+    state_ = kExpectBody;
+    return true;
+}
+
+// 解析 chunk-size 行：1*HEXDIG [ BWS ";" chunk-ext ]
+bool HttpContext::processChunkSize(const char *begin, const char *end)
+{
+    uint64_t size = 0;
+    const char *p = begin;
+    for (; p < end; ++p)
+    {
+        int digit;
+        if (*p >= '0' && *p <= '9')
+            digit = *p - '0';
+        else if (*p >= 'a' && *p <= 'f')
+            digit = *p - 'a' + 10;
+        else if (*p >= 'A' && *p <= 'F')
+            digit = *p - 'A' + 10;
+        else
+            break;
+
+        if (size > (std::numeric_limits<uint64_t>::max() >> 4))
+        {
+            return fail(HttpResponse::k400BadRequest); // 溢出
+        }
+        size = (size << 4) | static_cast<uint64_t>(digit);
+    }
+
+    p = tokenizer::skipSpaces(p, end);
+    if (p == begin || (p != end && *p != ';'))
+    {
+        return fail(HttpResponse::k400BadRequest);
+    }
+
+    if (size == 0)
+    {
+        state_ = kExpectTrailers;
+        return true;
+    }
+
+    if (!request_.bodySink() && size > limits_.maxBodySize - request_.getBody().size())
+    {
+        return fail(HttpResponse::k413PayloadTooLarge);
+    }
+    bodyRemaining_ = size;
+    state_ = kExpectChunkData;
+    return true;
+}
+
+// 把缓冲区里属于当前请求体（或当前 chunk）的数据交给 sink 或追加到请求上
+bool HttpContext::consumeBody(Buffer *buf)
+{
+    size_t n = static_cast<size_t>(std::min<uint64_t>(buf->readableBytes(), bodyRemaining_));
+    if (n == 0)
+    {
+        return true;
+    }
+
+    if (BodySink *sink = request_.bodySink())
+    {
+        if (!sink->onData(buf->peek(), n))
+        {
+            return fail(sink->errorCode());
+        }
+    }
+    else
+    {
+        request_.appendBody(buf->peek(), n);
+    }
+    buf->retrieve(n);
+    bodyRemaining_ -= n;
+    return true;
+}
+
+void HttpContext::finishBody()
+{
+    if (BodySink *sink = request_.bodySink())
+    {
+        sink->onFinish();
+    }
+    state_ = kGotAll;
+}
+
 // 解析请求行：解析HTTP请求的第一行，提取方法、路径、查询参数、版本。
 bool HttpContext::processRequestLine(const char *begin, const char *end)
 {
     bool succeed = false;
     const char *start = begin;
-    const char *space = std::find(start, end, ' ');
+    const char *space = tokenizer::findByte(start, end, ' ');
     if (space != end && request_.setMethod(start, space))
     {
         start = space + 1;
-        space = std::find(start, end, ' ');
+        space = tokenizer::findByte(start, end, ' ');
         if (space != end)
         {
-            const char *argumentStart = std::find(start, space, '?');
+            const char *argumentStart = tokenizer::findByte(start, space, '?');
             if (argumentStart != space) // 请求带参数
             {
                 request_.setPath(start, argumentStart); // 注意这些返回值边界
@@ -181,4 +442,39 @@ bool HttpContext::processRequestLine(const char *begin, const char *end)
     return succeed;
 }
 
+HttpContext* HttpContext::of(const TcpConnectionPtr& conn)
+{
+    auto* context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext());
+    return context ? context->get() : nullptr;
+}
+
+void HttpContext::send(const TcpConnectionPtr& conn, Buffer* buf)
+{
+    HttpContext* context = of(conn);
+    if (context && context->ssl_)
+    {
+        context->ssl_->send(buf->peek(), buf->readableBytes());
+        buf->retrieveAll();
+        return;
+    }
+    conn->send(buf);
+}
+
+void HttpContext::send(const TcpConnectionPtr& conn, std::string_view data)
+{
+    HttpContext* context = of(conn);
+    if (context && context->ssl_)
+    {
+        context->ssl_->send(data.data(), data.size());
+        return;
+    }
+    // TcpConnection::send 的长度是 int，2 GiB 以上的大文件分片发送
+    while (data.size() > static_cast<size_t>(INT_MAX))
+    {
+        conn->send(data.data(), INT_MAX);
+        data.remove_prefix(INT_MAX);
+    }
+    conn->send(data.data(), static_cast<int>(data.size()));
+}
+
 } // namespace http
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "../../include/http/HttpHeaders.h"
+
+namespace http
+{
+
+namespace
+{
+
+constexpr std::string_view kKnownNames[HttpHeaders::kKnownCount] = {
+    "Host",
+    "Connection",
+    "Content-Length",
+    "Content-Type",
+    "Transfer-Encoding",
+    "Cookie",
+    "X-Forwarded-For",
+    "X-Real-IP",
+    "Origin",
+    "Expect",
+    "Accept",
+    "Accept-Encoding",
+    "Authorization",
+    "User-Agent",
+    "If-None-Match",
+    "If-Modified-Since",
+    "Range",
+    "If-Range",
+    "Upgrade",
+    "Sec-WebSocket-Key",
+    "Sec-WebSocket-Version",
+    "Sec-WebSocket-Extensions",
+    "Sec-WebSocket-Protocol",
+    "Access-Control-Request-Method",
+    "Access-Control-Request-Headers",
+    "Referer",
+    "Cache-Control",
+    "Keep-Alive",
+    "TE",
+    "HTTP2-Settings",
+    "Last-Event-ID",
+    "Date",
+    "Server",
+    "Location",
+    "Set-Cookie",
+    "ETag",
+    "Last-Modified",
+    "Retry-After",
+    "Content-Encoding",
+    "Content-Range",
+    "Accept-Ranges",
+    "Vary",
+    "WWW-Authenticate",
+    "Access-Control-Allow-Origin",
+    "Access-Control-Allow-Methods",
+    "Access-Control-Allow-Headers",
+    "Access-Control-Allow-Credentials",
+    "Access-Control-Max-Age",
+    "Access-Control-Expose-Headers",
+    "Sec-WebSocket-Accept",
+    "Expires",
+    "Content-Disposition",
+    "X-Content-Type-Options",
+};
+
+/*
+    完美哈希：对转成小写的字段名做带种子的 FNV-1a，取高位落到 256 个槽里。
+    种子是离线搜出来的，保证上面这组字段名两两不冲突（由下面的 static_assert 在编译期检查）。
+    新增字段名后如果 static_assert 失败，换一个种子即可。
+ */
+constexpr size_t   kTableSize = 256;
+constexpr uint32_t kHashSeed = 12;
+
+constexpr uint32_t lowerByte(char c)
+{
+    return static_cast<unsigned char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+}
+
+constexpr size_t hashName(std::string_view name)
+{
+    uint32_t h = kHashSeed;
+    for (char c : name)
+    {
+        h = (h ^ lowerByte(c)) * 16777619u;
+    }
+    return (h >> 16) & (kTableSize - 1);
+}
+
+struct KnownTable
+{
+    uint8_t ids[kTableSize];
+};
+
+constexpr KnownTable buildTable()
+{
+    KnownTable table {};
+    for (size_t i = 0; i < kTableSize; ++i)
+    {
+        table.ids[i] = HttpHeaders::kUnknown;
+    }
+    for (size_t i = 0; i < HttpHeaders::kKnownCount; ++i)
+    {
+        table.ids[hashName(kKnownNames[i])] = static_cast<uint8_t>(i);
+    }
+    return table;
+}
+
+constexpr bool collisionFree()
+{
+    KnownTable table = buildTable();
+    for (size_t i = 0; i < HttpHeaders::kKnownCount; ++i)
+    {
+        if (table.ids[hashName(kKnownNames[i])] != i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(collisionFree(), "well-known header names collide in the perfect hash table");
+
+constexpr KnownTable kTable = buildTable();
+
+} // namespace
+
+HttpHeaders::Known HttpHeaders::lookup(std::string_view name)
+{
+    if (name.empty())
+    {
+        return kUnknown;
+    }
+    uint8_t id = kTable.ids[hashName(name)];
+    if (id != kUnknown && equalsIgnoreCase(name, kKnownNames[id]))
+    {
+        return static_cast<Known>(id);
+    }
+    return kUnknown;
+}
+
+std::string_view HttpHeaders::name(Known id)
+{
+    return id < kKnownCount ? kKnownNames[id] : std::string_view();
+}
+
+bool HttpHeaders::isList(Known id)
+{
+    switch (id)
+    {
+    case kConnection:
+    case kCookie:
+    case kXForwardedFor:
+    case kExpect:
+    case kAccept:
+    case kAcceptEncoding:
+    case kIfNoneMatch:
+    case kUpgrade:
+    case kSecWebSocketExtensions:
+    case kSecWebSocketProtocol:
+    case kAccessControlRequestHeaders:
+    case kCacheControl:
+    case kKeepAlive:
+    case kTe:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string_view *HttpHeaders::find(Known id, std::string_view key)
+{
+    if (id != kUnknown)
+    {
+        return slots_[id] ? &fields_[slots_[id] - 1].second : nullptr;
+    }
+    // 不常见的字段数量很少，线性查找
+    for (auto &field : fields_)
+    {
+        if (equalsIgnoreCase(field.first, key))
+        {
+            return &field.second;
+        }
+    }
+    return nullptr;
+}
+
+void HttpHeaders::set(std::string_view key, std::string_view value)
+{
+    Known id = lookup(key);
+    if (std::string_view *existing = find(id, key))
+    {
+        *existing = value;
+        return;
+    }
+    add(id, key, value);
+}
+
+std::string_view HttpHeaders::get(std::string_view key) const
+{
+    Known id = lookup(key);
+    if (id != kUnknown)
+    {
+        return get(id);
+    }
+    for (const auto &field : fields_)
+    {
+        if (equalsIgnoreCase(field.first, key))
+        {
+            return field.second;
+        }
+    }
+    return std::string_view();
+}
+
+} // namespace http
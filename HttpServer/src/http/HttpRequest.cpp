@@ -1,4 +1,9 @@
 #include "../../include/http/HttpRequest.h"
+#include "../../include/http/HttpTokenizer.h"
+#include "../../include/utils/UrlUtil.h"
+
+#include <cassert>
+#include <cstring>
 
 namespace http
 {
@@ -11,166 +16,255 @@ void HttpRequest::setReceiveTime(muduo::Timestamp t)
 bool HttpRequest::setMethod(const char *start, const char *end)
 {
     assert(method_ == kInvalid);
-    std::string m(start, end); // [start, end)
-    if (m == "GET")
-    {
-        method_ = kGet;
-    }
-    else if (m == "POST")
-    {
-        method_ = kPost;
-    }
-    else if (m == "PUT")
-    {
-        method_ = kPut;
-    }
-    else if (m == "DELETE")
-    {
-        method_ = kDelete;
-    }
-    else if (m == "OPTIONS")
-    {
-        method_ = kOptions;
-    }
-    else
-    {
-        method_ = kInvalid;
-    }
-
+    method_ = tokenizer::parseMethod(start, end); // [start, end)
     return method_ != kInvalid;
 }
 
 void HttpRequest::setPath(const char *start, const char *end)
 {
-    path_.assign(start, end);
+    path_ = arena_.copy(start, end);
+}
+
+void HttpRequest::setPathParameters(std::string_view key, std::string_view value)
+{
+    // 参数个数很少，线性查找比哈希表更省
+    std::string_view v = UrlUtil::needsDecode(value, false) ? decodeComponent(value, false)
+                                                           : arena_.copy(value);
+    for (auto &param : pathParameters_)
+    {
+        if (param.first == key)
+        {
+            param.second = v;
+            return;
+        }
+    }
+    pathParameters_.emplace_back(arena_.copy(key), v);
 }
 
-void HttpRequest::setPathParameters(const std::string &key, const std::string &value)
+std::string_view HttpRequest::getPathParameters(std::string_view key) const
 {
-    pathParameters_[key] = value;
+    for (const auto &param : pathParameters_)
+    {
+        if (param.first == key)
+        {
+            return param.second;
+        }
+    }
+    return std::string_view();
 }
 
-std::string HttpRequest::getPathParameters(const std::string &key) const
+std::string_view HttpRequest::getQueryParameters(std::string_view key) const
 {
-    auto it = pathParameters_.find(key);
-    if (it != pathParameters_.end())
+    parseQueryParameters();
+    // 重复的 key 以最后一次出现为准
+    for (auto it = queryParameters_.rbegin(); it != queryParameters_.rend(); ++it)
     {
-        return it->second;
+        if (it->first == key)
+        {
+            return it->second;
+        }
     }
-    return "";
+    return std::string_view();
 }
 
-std::string HttpRequest::getQueryParameters(const std::string &key) const
+std::vector<std::string_view> HttpRequest::getQueryParameterValues(std::string_view key) const
 {
-    auto it = queryParameters_.find(key);
-    if (it != queryParameters_.end())
+    parseQueryParameters();
+    std::vector<std::string_view> values;
+    for (const auto &param : queryParameters_)
     {
-        return it->second;
+        if (param.first == key)
+        {
+            values.push_back(param.second);
+        }
     }
-    return "";
+    return values;
+}
+
+void HttpRequest::setQueryParameters(const char *start, const char *end)
+{
+    rawQuery_ = arena_.copy(start, end);
+    queryParsed_ = false;
 }
 
 /* 
-    setQueryParameters
+    parseQueryParameters（第一次读取查询参数时调用）
         解析过程：
-        假设 start 指向 "name=john&age=25&city=New%20York"
-        end 指向字符串末尾
-        setQueryParameters("name=john&age=25&city=New%20York", end);
+        假设 rawQuery_ 为 "name=john&age=25&city=New%20York&tag=a&tag=b"
 
-        函数内部处理：
         1. 按 '&' 分割得到：
         - "name=john"
         - "age=25" 
         - "city=New%20York"
+        - "tag=a"、"tag=b"
 
-        2. 对每个参数按 '=' 分割，存入 queryParameters_：
-        queryParameters_["name"] = "john"
-        queryParameters_["age"] = "25"
-        queryParameters_["city"] = "New%20York"
+        2. 对每个参数按 '=' 分割并做百分号解码，没有 '=' 的参数值为空：
+        queryParameters_ = {{"name", "john"}, {"age", "25"}, {"city", "New York"},
+                            {"tag", "a"}, {"tag", "b"}}
 
         使用：
-        std::string name = getQueryParameters("name");  // 返回 "john"
-        std::string age = getQueryParameters("age");    // 返回 "25"
-
-       
- */
-// 这是从问号后面分割参数
-
-/* 
-     while ((pos = argumentStr.find('&', prev)) != std::string::npos){
-
-     }
-     这种用法可以学习一下
+        std::string_view name = getQueryParameters("name");    // 返回 "john"
+        std::string_view city = getQueryParameters("city");    // 返回 "New York"
+        auto tags = getQueryParameterValues("tag");            // 返回 {"a", "b"}
  */
-void HttpRequest::setQueryParameters(const char *start, const char *end)
+void HttpRequest::parseQueryParameters() const
 {
-    std::string argumentStr(start, end);
-    std::string::size_type pos = 0;
-    std::string::size_type prev = 0;
+    if (queryParsed_)
+    {
+        return;
+    }
+    queryParsed_ = true;
 
-    // 按 & 分割多个参数
-    while ((pos = argumentStr.find('&', prev)) != std::string::npos)
+    std::string_view::size_type prev = 0;
+    // 按 & 分割多个参数，最后一段没有 & 结尾，统一在循环里处理
+    while (prev < rawQuery_.size())
     {
-        std::string pair = argumentStr.substr(prev, pos - prev);
-        std::string::size_type equalPos = pair.find('=');
+        std::string_view::size_type pos = rawQuery_.find('&', prev);
+        if (pos == std::string_view::npos)
+        {
+            pos = rawQuery_.size();
+        }
 
-        if (equalPos != std::string::npos)
+        std::string_view pair = rawQuery_.substr(prev, pos - prev);
+        if (!pair.empty())
         {
-            std::string key = pair.substr(0, equalPos);
-            std::string value = pair.substr(equalPos + 1);
-            queryParameters_[key] = value;
+            std::string_view::size_type equalPos = pair.find('=');
+            std::string_view key = pair.substr(0, equalPos);
+            std::string_view value = (equalPos == std::string_view::npos) ? std::string_view()
+                                                                          : pair.substr(equalPos + 1);
+            queryParameters_.emplace_back(decodeComponent(key, true), decodeComponent(value, true));
         }
 
         prev = pos + 1;
     }
+}
+
+// rawQuery_ 本身就在 arena 里，不需要解码时直接返回原 view
+std::string_view HttpRequest::decodeComponent(std::string_view s, bool plusAsSpace) const
+{
+    if (!UrlUtil::needsDecode(s, plusAsSpace))
+    {
+        return s;
+    }
+    char *out = arena_.allocate(s.size());
+    size_t n = UrlUtil::decode(s, out, plusAsSpace);
+    return std::string_view(out, n);
+}
+
+bool HttpRequest::addHeader(const char *start, const char *colon, const char *end)
+{
+    const char *valueStart = tokenizer::skipSpaces(colon + 1, end);
+    const char *valueEnd = tokenizer::trimTrailingSpaces(valueStart, end); // 消除尾部空格
+
+    std::string_view name(start, colon - start);
+    HttpHeaders::Known id = HttpHeaders::lookup(name);
+    if (std::string_view *existing = headers_.find(id, name))
+    {
+        return mergeHeader(id, existing, std::string_view(valueStart, valueEnd - valueStart));
+    }
+
+    // 第一次出现：整行一次拷进 arena，key 和 value 都指向这份副本
+    std::string_view line = arena_.copy(start, valueEnd);
+    headers_.add(id, line.substr(0, colon - start), line.substr(valueStart - start));
+    return true;
+}
 
-    // 处理最后一个参数
-    std::string lastPair = argumentStr.substr(prev);
-    std::string::size_type equalPos = lastPair.find('=');
-    if (equalPos != std::string::npos)
+void HttpRequest::addHeader(std::string_view key, std::string_view value)
+{
+    HttpHeaders::Known id = HttpHeaders::lookup(key);
+    if (std::string_view *existing = headers_.find(id, key))
     {
-        std::string key = lastPair.substr(0, equalPos);
-        std::string value = lastPair.substr(equalPos + 1);
-        queryParameters_[key] = value;
+        // 伪首部 :authority 先写进了 Host，随后的 host 字段照旧覆盖它（RFC 9113 8.3.1）
+        if (!mergeHeader(id, existing, value))
+        {
+            *existing = arena_.copy(value);
+        }
+        return;
     }
+    headers_.add(id, arena_.copy(key), arena_.copy(value));
 }
 
-void HttpRequest::addHeader(const char *start, const char *colon, const char *end)
+// 同名字段第二次出现时的处理，existing 指向已保存的值
+bool HttpRequest::mergeHeader(HttpHeaders::Known id, std::string_view *existing, std::string_view value)
 {
-    std::string key(start, colon);
-    ++colon;
-    while (colon < end && isspace(*colon))
+    switch (id)
+    {
+    // 重复的 Host、Transfer-Encoding 或取值不同的 Content-Length，前后两个代理可能各取一个，
+    // 覆盖成最后一个就成了请求走私的入口（RFC 9112 3.2、6.1、6.3）
+    case HttpHeaders::kHost:
+    case HttpHeaders::kTransferEncoding:
+        return false;
+    case HttpHeaders::kContentLength:
+        return *existing == value;
+    default:
+        break;
+    }
+
+    if (id != HttpHeaders::kUnknown && !HttpHeaders::isList(id))
+    {
+        *existing = arena_.copy(value); // 单值字段以最后一次为准
+        return true;
+    }
+    // 列表字段按出现顺序接起来（RFC 9110 5.3），不认识的字段也这样处理，不丢信息
+    if (value.empty())
     {
-        ++colon;
+        return true;
     }
-    std::string value(colon, end);
-    while (!value.empty() && isspace(value[value.size() - 1])) // 消除尾部空格
+    if (existing->empty())
     {
-        value.resize(value.size() - 1);
+        *existing = arena_.copy(value);
+        return true;
     }
-    headers_[key] = value;
+    std::string_view separator = id == HttpHeaders::kCookie ? "; " : ", ";
+    size_t n = existing->size() + separator.size() + value.size();
+    char *out = arena_.allocate(n);
+    std::memcpy(out, existing->data(), existing->size());
+    std::memcpy(out + existing->size(), separator.data(), separator.size());
+    std::memcpy(out + existing->size() + separator.size(), value.data(), value.size());
+    *existing = std::string_view(out, n);
+    return true;
 }
 
-std::string HttpRequest::getHeader(const std::string &field) const
+void HttpRequest::reset()
 {
-    std::string result;
-    auto it = headers_.find(field);
-    if (it != headers_.end())
+    method_ = kInvalid;
+    version_ = "Unknown";
+    path_ = std::string_view();
+    pathParameters_.clear();
+    rawQuery_ = std::string_view();
+    queryParsed_ = false;
+    queryParameters_.clear();
+    receiveTime_ = muduo::Timestamp();
+    headers_.clear();
+    content_ = std::string_view();
+    contentLength_ = 0;
+    streamId_ = 0;
+    bodyBuffer_.clear();
+    if (bodyBuffer_.capacity() > kMaxRetainedBodyCapacity)
     {
-        result = it->second;
+        std::vector<char>().swap(bodyBuffer_); // 大的 chunked 请求体不长期占着
     }
-    return result;
+    bodySink_.reset();
+    arena_.reset();
 }
 
 void HttpRequest::swap(HttpRequest &that)
 {
     std::swap(method_, that.method_);
     std::swap(path_, that.path_);
-    std::swap(pathParameters_, that.pathParameters_);
-    std::swap(queryParameters_, that.queryParameters_);
+    pathParameters_.swap(that.pathParameters_);
+    std::swap(rawQuery_, that.rawQuery_);
+    std::swap(queryParsed_, that.queryParsed_);
+    queryParameters_.swap(that.queryParameters_);
     std::swap(version_, that.version_);
-    std::swap(headers_, that.headers_);
+    headers_.swap(that.headers_);
     std::swap(receiveTime_, that.receiveTime_);
+    std::swap(content_, that.content_);
+    std::swap(contentLength_, that.contentLength_);
+    std::swap(streamId_, that.streamId_);
+    bodyBuffer_.swap(that.bodyBuffer_);
+    bodySink_.swap(that.bodySink_);
+    arena_.swap(that.arena_);
 }
 
 } // namespace http
\ No newline at end of file
@@ -1,40 +1,387 @@
 #include "../../include/http/HttpResponse.h"
+#include "../../include/http/HttpContext.h"
+#include "../../include/http/HttpHeaders.h"
+#include "../../include/utils/DateUtil.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 
 namespace http
 {
 
+namespace
+{
+
+// 预先格式化好的 HTTP/1.1 状态行，其他版本只替换前 8 个字节
+std::string_view defaultStatusLine(int code)
+{
+    switch (code)
+    {
+        case 100: return "HTTP/1.1 100 Continue\r\n";
+        case 101: return "HTTP/1.1 101 Switching Protocols\r\n";
+        case 200: return "HTTP/1.1 200 OK\r\n";
+        case 204: return "HTTP/1.1 204 No Content\r\n";
+        case 206: return "HTTP/1.1 206 Partial Content\r\n";
+        case 301: return "HTTP/1.1 301 Moved Permanently\r\n";
+        case 302: return "HTTP/1.1 302 Found\r\n";
+        case 304: return "HTTP/1.1 304 Not Modified\r\n";
+        case 400: return "HTTP/1.1 400 Bad Request\r\n";
+        case 401: return "HTTP/1.1 401 Unauthorized\r\n";
+        case 403: return "HTTP/1.1 403 Forbidden\r\n";
+        case 404: return "HTTP/1.1 404 Not Found\r\n";
+        case 405: return "HTTP/1.1 405 Method Not Allowed\r\n";
+        case 408: return "HTTP/1.1 408 Request Timeout\r\n";
+        case 409: return "HTTP/1.1 409 Conflict\r\n";
+        case 413: return "HTTP/1.1 413 Payload Too Large\r\n";
+        case 414: return "HTTP/1.1 414 URI Too Long\r\n";
+        case 416: return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+        case 417: return "HTTP/1.1 417 Expectation Failed\r\n";
+        case 426: return "HTTP/1.1 426 Upgrade Required\r\n";
+        case 429: return "HTTP/1.1 429 Too Many Requests\r\n";
+        case 431: return "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+        case 500: return "HTTP/1.1 500 Internal Server Error\r\n";
+        case 501: return "HTTP/1.1 501 Not Implemented\r\n";
+        case 503: return "HTTP/1.1 503 Service Unavailable\r\n";
+        default:  return std::string_view();
+    }
+}
+
+const size_t kVersionLength = 8;                 // "HTTP/1.1"
+const size_t kStatusPrefixLength = kVersionLength + 5; // "HTTP/1.1 200 "
+
+// 无符号整数转十进制，返回写入的末尾
+char* appendDecimal(char* p, uint64_t value)
+{
+    char digits[20];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0)
+    {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+char* appendString(char* p, std::string_view s)
+{
+    if (s.empty())
+    {
+        return p;
+    }
+    std::memcpy(p, s.data(), s.size());
+    return p + s.size();
+}
+
+/*
+    "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"。
+    每个 I/O 线程缓存一份，同一秒内的响应直接复用，不再每次调用 gmtime 和格式化。
+ */
+std::string_view cachedDateHeader()
+{
+    thread_local time_t cachedSecond = -1;
+    thread_local char   line[64] = "Date: ";
+    thread_local size_t length = 0;
+
+    time_t now = ::time(nullptr);
+    if (now != cachedSecond)
+    {
+        size_t n = 6; // "Date: "
+        n += DateUtil::format(now, line + n);
+        line[n++] = '\r';
+        line[n++] = '\n';
+        length = n;
+        cachedSecond = now;
+    }
+    return std::string_view(line, length);
+}
+
+} // namespace
+
+std::string_view HttpResponse::reasonPhrase(int code)
+{
+    std::string_view line = defaultStatusLine(code);
+    if (line.empty())
+    {
+        return line;
+    }
+    return line.substr(kStatusPrefixLength, line.size() - kStatusPrefixLength - 2);
+}
+
+// 原因短语和标准的一致（或没有设置）时直接用预格式化的状态行
+size_t HttpResponse::statusLineLength() const
+{
+    std::string_view line = defaultStatusLine(statusCode_);
+    if (!line.empty() && (statusMessage_.empty() || statusMessage_ == reasonPhrase(statusCode_)))
+    {
+        return line.size();
+    }
+    // 版本 + 空格 + 最多 20 位状态码 + 空格 + 原因短语 + CRLF
+    return kVersionLength + 1 + 20 + 1 + statusMessage_.size() + 2;
+}
+
+char* HttpResponse::appendStatusLine(char* p) const
+{
+    std::string_view version = httpVersion_.size() == kVersionLength
+                             ? std::string_view(httpVersion_)
+                             : std::string_view("HTTP/1.1");
+    std::string_view line = defaultStatusLine(statusCode_);
+    if (!line.empty() && (statusMessage_.empty() || statusMessage_ == reasonPhrase(statusCode_)))
+    {
+        p = appendString(p, version);
+        return appendString(p, line.substr(kVersionLength));
+    }
+
+    p = appendString(p, version);
+    *p++ = ' ';
+    p = appendDecimal(p, static_cast<uint64_t>(statusCode_));
+    *p++ = ' ';
+    p = appendString(p, statusMessage_);
+    return appendString(p, "\r\n");
+}
+
+void HttpResponse::appendHeadersToBuffer(muduo::net::Buffer* outputBuf) const
+{
+    static const std::string_view kClose = "Connection: close\r\n";
+    static const std::string_view kKeepAlive = "Connection: Keep-Alive\r\n";
+    static const std::string_view kUpgrade = "Connection: Upgrade\r\n";
+    static const std::string_view kContentLength = "Content-Length: ";
+
+    int64_t contentLength = contentLengthValue();
+    bool withDate = true;
+
+    // 先算出上限，一次 ensureWritableBytes，之后直接往缓冲区里写，中间不再扩容
+    size_t size = statusLineLength() + kKeepAlive.size() + kContentLength.size() + 20 + 2 + 2;
+    for (size_t i = 0; i < headerCount_; ++i)
+    {
+        const Field& field = headers_[i];
+        std::string_view key = field.id == HttpHeaders::kUnknown ? std::string_view(field.key)
+                                                                 : HttpHeaders::name(field.id);
+        size += key.size() + field.value.size() + 4;
+        if (field.id == HttpHeaders::kDate)
+        {
+            withDate = false;
+        }
+    }
+    std::string_view date;
+    if (withDate)
+    {
+        date = cachedDateHeader();
+        size += date.size();
+    }
+
+    outputBuf->ensureWritableBytes(size);
+    char* begin = outputBuf->beginWrite();
+    char* p = appendStatusLine(begin);
+    p = appendString(p, date);
+    // 101 之后连接换了协议（WebSocket、h2c），不是 keep-alive
+    p = appendString(p, statusCode_ == k101SwitchingProtocols ? kUpgrade
+                                                               : closeConnection_ ? kClose : kKeepAlive);
+    if (contentLength >= 0)
+    {
+        p = appendString(p, kContentLength);
+        p = appendDecimal(p, static_cast<uint64_t>(contentLength));
+        p = appendString(p, "\r\n");
+    }
+
+    for (size_t i = 0; i < headerCount_; ++i)
+    {
+        const Field& field = headers_[i];
+        p = appendString(p, field.id == HttpHeaders::kUnknown ? std::string_view(field.key)
+                                                              : HttpHeaders::name(field.id));
+        p = appendString(p, ": ");
+        p = appendString(p, field.value);
+        p = appendString(p, "\r\n");
+    }
+    p = appendString(p, "\r\n");
+    outputBuf->hasWritten(p - begin);
+}
+
+int64_t HttpResponse::contentLengthValue() const
+{
+    // 1xx、204、304 不能带 Content-Length，流式响应的长度事先不知道
+    if ((statusCode_ >= 100 && statusCode_ < 200) || statusCode_ == k204NoContent ||
+        statusCode_ == k304NotModified || stream_)
+    {
+        return -1;
+    }
+    return contentLength_ >= 0 ? contentLength_ : static_cast<int64_t>(bodySize());
+}
+
+std::string_view HttpResponse::currentDate()
+{
+    std::string_view line = cachedDateHeader();
+    return line.substr(6, line.size() - 8); // 去掉 "Date: " 和 "\r\n"
+}
+
 void HttpResponse::appendToBuffer(muduo::net::Buffer* outputBuf) const
 {
-    // HttpResponse封装的信息格式化输出
-    char buf[32]; 
-    // 为什么不把状态信息放入格式化字符串中，因为状态信息有长有短，不方便定义一个固定大小的内存存储
-    snprintf(buf, sizeof buf, "%s %d ", httpVersion_.c_str(), statusCode_);
-    
-    outputBuf->append(buf);
-    outputBuf->append(statusMessage_);
-    outputBuf->append("\r\n");
+    appendHeadersToBuffer(outputBuf);
+    appendBodyToBuffer(outputBuf);
+}
+
+void HttpResponse::appendBodyToBuffer(muduo::net::Buffer* outputBuf) const
+{
+    outputBuf->append(body_);
+    for (const auto& segment : segments_)
+    {
+        outputBuf->append(segment.data.data(), segment.data.size());
+    }
+}
+
+/*
+    muduo 的 TcpConnection 没有暴露 writev，这里用分段发送代替：
+    头部和小的响应体攒进 output（调用方最后一次性 send，流水线请求也能合并），
+    大段的共享响应体先把 output 里已有的内容发出去，再直接 send 原始内存。
+    在 I/O 线程里 send 会先尝试直接 write，内核缓冲区放得下时用户态一次拷贝都没有，
+    只有写不完的部分才会进 TcpConnection 自己的输出缓冲区。
+ */
+void HttpResponse::writeTo(const muduo::net::TcpConnectionPtr& conn, muduo::net::Buffer* output) const
+{
+    appendHeadersToBuffer(output);
+    output->append(body_);
+    for (const auto& segment : segments_)
+    {
+        if (segment.data.size() < kInlineSegmentSize)
+        {
+            output->append(segment.data.data(), segment.data.size());
+        }
+        else
+        {
+            if (output->readableBytes() > 0)
+            {
+                HttpContext::send(conn, output);
+            }
+            HttpContext::send(conn, segment.data);
+        }
+    }
+}
+
+std::vector<HttpResponse::BodySegment> HttpResponse::releaseSegments(muduo::net::Buffer* output)
+{
+    appendHeadersToBuffer(output); // Content-Length 按移交之前的响应体计算
+    output->append(body_);
+    body_.clear();
+    return std::move(segments_);
+}
+
+std::string_view HttpResponse::body()
+{
+    if (segments_.empty())
+    {
+        return body_;
+    }
+    if (body_.empty() && segments_.size() == 1)
+    {
+        return segments_[0].data;
+    }
+    for (const auto& segment : segments_)
+    {
+        body_.append(segment.data.data(), segment.data.size());
+    }
+    segments_.clear();
+    return body_;
+}
+
+void HttpResponse::reset(bool close)
+{
+    statusCode_ = kUnknown;
+    statusMessage_.clear();
+    closeConnection_ = close;
+    contentLength_ = -1;
+    headerCount_ = 0; // 槽位里的字符串不释放，下次 addHeader 直接 assign
+    body_.clear();
+    segments_.clear(); // 释放对共享响应体的引用
+    stream_.reset();
+    deferred_.reset();
+    webSocket_.reset();
+    isFile_ = false;
+    sseUpgraded_ = false;
+}
 
-    if (closeConnection_) // 思考一下这些地方是不是可以直接移入近headers_中
+void HttpResponse::addHeader(std::string_view key, std::string_view value)
+{
+    HttpHeaders::Known id = HttpHeaders::lookup(key);
+    if (id == HttpHeaders::kUnknown)
     {
-        outputBuf->append("Connection: close\r\n");
+        setField(id, key, value);
     }
     else
     {
-        snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
-        outputBuf->append(buf);
-        outputBuf->append("Connection: Keep-Alive\r\n");
+        addHeader(id, value);
     }
+}
 
-    for (const auto& header : headers_)
-    { // 为什么这里不用格式化字符串？因为key和value的长度不定
-        outputBuf->append(header.first);
-        outputBuf->append(": "); 
-        outputBuf->append(header.second);
-        outputBuf->append("\r\n");
+void HttpResponse::addHeader(HttpHeaders::Known id, std::string_view value)
+{
+    if (id == HttpHeaders::kContentLength)
+    {
+        return; // 序列化时按实际长度生成，避免出现两个不一致的 Content-Length
     }
-    outputBuf->append("\r\n");
-    
-    outputBuf->append(body_);
+    if (id == HttpHeaders::kConnection)
+    {
+        if (equalsIgnoreCase(value, "close"))
+        {
+            closeConnection_ = true;
+        }
+        return;
+    }
+    setField(id, std::string_view(), value);
+}
+
+std::string_view HttpResponse::getHeader(HttpHeaders::Known id) const
+{
+    for (size_t i = 0; i < headerCount_; ++i)
+    {
+        if (headers_[i].id == id)
+        {
+            return headers_[i].value;
+        }
+    }
+    return std::string_view();
+}
+
+std::string_view HttpResponse::getHeader(std::string_view key) const
+{
+    HttpHeaders::Known id = HttpHeaders::lookup(key);
+    if (id != HttpHeaders::kUnknown)
+    {
+        return getHeader(id);
+    }
+    for (size_t i = 0; i < headerCount_; ++i)
+    {
+        if (headers_[i].id == HttpHeaders::kUnknown && equalsIgnoreCase(headers_[i].key, key))
+        {
+            return headers_[i].value;
+        }
+    }
+    return std::string_view();
+}
+
+void HttpResponse::setField(HttpHeaders::Known id, std::string_view key, std::string_view value)
+{
+    for (size_t i = 0; i < headerCount_; ++i)
+    {
+        Field& field = headers_[i];
+        if (field.id == id && (id != HttpHeaders::kUnknown || equalsIgnoreCase(field.key, key)))
+        {
+            field.value.assign(value.data(), value.size());
+            return;
+        }
+    }
+
+    if (headerCount_ == headers_.size())
+    {
+        headers_.emplace_back();
+    }
+    Field& field = headers_[headerCount_++];
+    field.id = id;
+    field.key.assign(key.data(), key.size());
+    field.value.assign(value.data(), value.size());
 }
 
 void HttpResponse::setStatusLine(const std::string& version,
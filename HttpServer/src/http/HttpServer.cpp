@@ -1,20 +1,205 @@
 #include "../../include/http/HttpServer.h"
+#include "../../include/http/SlicedSender.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/filter.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <algorithm>
 #include <any>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <future>
 #include <memory>
+#include <unordered_set>
+
+#include <muduo/net/EventLoopThreadPool.h>
 
 namespace http
 {
 
+namespace
+{
+// 每个 I/O 线程一个时间轮，在线程初始化回调里创建，线程退出时随之销毁
+thread_local std::unique_ptr<TimingWheel> t_timingWheel;
+// 本 I/O 线程上已准入的连接，drain 时从这里找出空闲连接
+thread_local std::unordered_set<muduo::net::TcpConnectionPtr> t_connections;
+// io_uring 后端时本 I/O 线程的传输层，同样在线程初始化回调里创建
+thread_local std::unique_ptr<UringTransport> t_uring;
+
+// upgrade() 启动的新进程从这个环境变量拿到通知管道的写端
+const char* const kUpgradeReadyEnv = "HTTP_UPGRADE_READY_FD";
+// drain 期间检查连接是否都已关闭的间隔（秒）
+const double kDrainCheckInterval = 0.1;
+// drain 开始后最多等这么久让监听 socket 的 accept 队列清空（秒），一直过载时到期强制关闭
+const double kListenerDrainTimeout = 1.0;
+
+// HttpServer::offloaded() 包装出来的回调路由
+class OffloadedCallback : public router::RouterHandler
+{
+public:
+    explicit OffloadedCallback(const HttpServer::HttpCallback& cb)
+        : cb_(cb)
+    {}
+
+    void handle(const muduo::net::TcpConnectionPtr&, const HttpRequest& req, HttpResponse* resp) override
+    { cb_(req, resp); }
+
+    bool offload() const override
+    { return true; }
+
+    bool needsConnection() const override
+    { return false; }
+
+private:
+    HttpServer::HttpCallback cb_;
+};
+
+// HttpServer::serveWebSocket() 注册的握手路由
+class WebSocketRoute : public router::RouterHandler
+{
+public:
+    explicit WebSocketRoute(std::shared_ptr<WebSocketHandler> handler)
+        : handler_(std::move(handler))
+    {}
+
+    void handle(const muduo::net::TcpConnectionPtr& conn, const HttpRequest& req, HttpResponse* resp) override
+    { WebSocket::accept(conn, req, resp, handler_); }
+
+private:
+    std::shared_ptr<WebSocketHandler> handler_;
+};
+
+// io_uring 连接上挂的 HttpContext，被准入控制拒绝的连接为空
+HttpContext* contextOf(const UringConnectionPtr& conn)
+{
+    auto* context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext());
+    return context ? context->get() : nullptr;
+}
+
+// 在 loop 线程执行 fn 并等它执行完
+void runInLoopAndWait(muduo::net::EventLoop* loop, const std::function<void()>& fn)
+{
+    std::promise<void> done;
+    loop->runInLoop([&fn, &done]() { fn(); done.set_value(); });
+    done.get_future().wait();
+}
+
+// drain/upgrade 处理的信号
+sigset_t shutdownSignals()
+{
+    sigset_t mask;
+    ::sigemptyset(&mask);
+    ::sigaddset(&mask, SIGTERM);
+    ::sigaddset(&mask, SIGINT);
+    ::sigaddset(&mask, SIGUSR2);
+    return mask;
+}
+
+// fd 是否是监听 addr 端口的 socket
+bool isListeningOn(int fd, const muduo::net::InetAddress& addr)
+{
+    int accepting = 0;
+    socklen_t len = sizeof accepting;
+    if (::getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &len) != 0 || !accepting)
+    {
+        return false;
+    }
+    struct sockaddr_storage local;
+    len = sizeof local;
+    if (::getsockname(fd, reinterpret_cast<struct sockaddr*>(&local), &len) != 0 ||
+        local.ss_family != addr.family())
+    {
+        return false;
+    }
+    uint16_t port = local.ss_family == AF_INET6 ? reinterpret_cast<struct sockaddr_in6*>(&local)->sin6_port
+                                                : reinterpret_cast<struct sockaddr_in*>(&local)->sin_port;
+    return port == addr.portNetEndian();
+}
+
+// 本进程启动时的命令行
+std::vector<std::string> selfCommandLine()
+{
+    std::vector<std::string> args;
+    std::ifstream in("/proc/self/cmdline", std::ios::binary);
+    std::string arg;
+    while (std::getline(in, arg, '\0'))
+    {
+        args.push_back(arg);
+    }
+    return args;
+}
+
+/*
+    给 addr 上的 reuseport 组挂 CBPF 程序：返回 cpu % n，即按处理 SYN 的 CPU 选第几个 socket。
+    muduo 不暴露监听 fd，这里另开一个 socket 加入同一个组（排在最后，下标为 n，程序永远不会选中它），
+    挂上程序后关闭；程序属于整个组，关闭最后一个成员也不会打乱其他 socket 的下标。
+    挂上之前的极短时间内若有连接被哈希到这个 socket，关闭时会被 RST，只在启动时发生一次
+ */
+bool attachCpuSteering(const muduo::net::InetAddress& addr, int n)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0)
+    {
+        return false;
+    }
+    int on = 1;
+    socklen_t len = addr.family() == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n) },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog prog = { static_cast<unsigned short>(sizeof code / sizeof code[0]), code };
+    bool ok = ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == 0 &&
+              ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on) == 0 &&
+              ::bind(fd, addr.getSockAddr(), len) == 0 &&
+              ::listen(fd, 1) == 0 &&
+              ::setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof prog) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)addr;
+    (void)n;
+    return false;
+#endif
+}
+}
+
 // 默认http回应函数
 void defaultHttpCallback(const HttpRequest &, HttpResponse *resp)
 {
     resp->setStatusCode(HttpResponse::k404NotFound);
-    resp->setStatusMessage("Not Found");
     resp->setCloseConnection(true);
 }
 
+// 解析失败时直接回的错误响应，不经过路由和中间件
+static void appendErrorResponse(muduo::net::Buffer *output, HttpResponse::HttpStatusCode code)
+{
+    HttpResponse response(true);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(code); // 原因短语取自预格式化的状态行
+    response.appendToBuffer(output);
+}
+
+// 过载时的快速拒绝：503 + Retry-After，并关闭连接
+static void appendOverloadResponse(muduo::net::Buffer *output, int retryAfter)
+{
+    HttpResponse response(true);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k503ServiceUnavailable);
+    response.addHeader(HttpHeaders::kRetryAfter, std::to_string(retryAfter));
+    response.appendToBuffer(output);
+}
+
 HttpServer::HttpServer(int port,
                        const std::string &name,
                        bool useSSL,
@@ -22,196 +207,1619 @@ HttpServer::HttpServer(int port,
     : listenAddr_(port)
     , server_(&mainLoop_, listenAddr_, name, option)
     , useSSL_(useSSL)
+    , http2_(false)
+    , backend_(kEpoll)
+    , cpuLayout_(nullptr)
+    , ioThreadIndex_(0)
+    , reusePort_(option == muduo::net::TcpServer::kReusePort)
+    , numAcceptors_(0)
+    , steerByCpu_(false)
+    , draining_(false)
+    , drainTimeout_(30)
+    , signalFd_(-1)
+    , upgradePid_(-1)
+    , upgradeFd_(-1)
 {
     initialize();
 }
 
+HttpServer::~HttpServer()
+{
+    if (signalChannel_)
+    {
+        signalChannel_->disableAll();
+        signalChannel_->remove();
+        ::close(signalFd_);
+    }
+    if (upgradeChannel_)
+    {
+        upgradeChannel_->disableAll();
+        upgradeChannel_->remove();
+        ::close(upgradeFd_);
+    }
+    // io_uring 的传输层和交还给 epoll 的连接都不归 TcpServer 管，要在各自的 loop 线程里先拆掉，
+    // 否则它们会在 EventLoop 析构之后才随线程退出析构
+    if (backend_ == kUring && server_.threadPool()->started())
+    {
+        for (muduo::net::EventLoop *loop : ioLoops())
+        {
+            runInLoopAndWait(loop, []()
+            {
+                std::vector<muduo::net::TcpConnectionPtr> adopted(t_connections.begin(), t_connections.end());
+                for (const muduo::net::TcpConnectionPtr &conn : adopted)
+                {
+                    conn->connectDestroyed();
+                }
+                t_uring.reset();
+            });
+        }
+    }
+    // TcpServer 要在自己的 loop 线程析构，之后 EventLoopThread 析构时退出循环并 join
+    for (size_t i = 0; i < acceptors_.size(); ++i)
+    {
+        runInLoopAndWait(acceptors_[i]->getLoop(), [this, i]() { acceptors_[i].reset(); });
+    }
+}
+
 // 服务器运行函数
 void HttpServer::start()
 {
+    if (http2_ && !Http2Session::supported())
+    {
+        LOG_ERROR << "HttpServer[" << server_.name() << "] HTTP/2 is disabled: built without HTTP_WITH_NGHTTP2";
+        http2_ = false;
+    }
+    checkBackend();
     LOG_WARN << "HttpServer[" << server_.name() << "] starts listening on" << server_.ipPort();
-    server_.start();
+    if (workerPool_)
+    {
+        workerPool_->start();
+    }
+    if (backend_ == kUring)
+    {
+        // 不调用 server_.start()：它的 socket 只绑定不 listen，连接都由各 I/O 线程自己的监听 socket 接收。
+        // 线程初始化回调（开始监听）都执行完之后才返回
+        server_.threadPool()->start(std::bind(&HttpServer::onThreadInit, this, std::placeholders::_1));
+    }
+    else if (numAcceptors_ > 1)
+    {
+        startAcceptors();
+    }
+    else
+    {
+        server_.start();
+    }
+    notifyUpgradeReady();
     mainLoop_.loop();
 }
 
 void HttpServer::initialize()
+{
+    setCallbacks(&server_);
+}
+
+void HttpServer::setCallbacks(muduo::net::TcpServer* server)
 {
     // 设置回调函数
-    server_.setConnectionCallback(
+    server->setConnectionCallback(
         std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
-    server_.setMessageCallback(
+    server->setMessageCallback(
         std::bind(&HttpServer::onMessage, this,
                   std::placeholders::_1,
                   std::placeholders::_2,
                   std::placeholders::_3));
+    server->setThreadInitCallback(
+        std::bind(&HttpServer::onThreadInit, this, std::placeholders::_1));
 }
 
-void HttpServer::setSslConfig(const ssl::SslConfig& config)
+void HttpServer::checkBackend()
 {
+    if (backend_ != kUring)
+    {
+        return;
+    }
+#ifndef HTTP_WITH_IO_URING
+    // 和 epoll 的对比（bench_login 的 QPS、P99、每请求系统调用次数）还没有实测数据，默认构建不带这个后端
+    LOG_ERROR << "HttpServer[" << server_.name() << "] io_uring backend is disabled: built without HTTP_WITH_IO_URING";
+    backend_ = kEpoll;
+    return;
+#endif
+    const char *reason = nullptr;
     if (useSSL_)
     {
-        sslCtx_ = std::make_unique<ssl::SslContext>(config);
-        if (!sslCtx_->initialize())
-        {
-            LOG_ERROR << "Failed to initialize SSL context";
-            abort();
-        }
+        reason = "TLS is only supported by the epoll backend";
+    }
+    else if (http2_)
+    {
+        reason = "HTTP/2 is only supported by the epoll backend";
+    }
+    else if (!reusePort_)
+    {
+        // 各 I/O 线程的监听 socket 要和 server_ 已经绑定的 socket 共用端口
+        reason = "it requires TcpServer::kReusePort";
+    }
+    else if (!IoUring::supported())
+    {
+        reason = "io_uring is not available";
+    }
+    if (reason)
+    {
+        LOG_ERROR << "HttpServer[" << server_.name() << "] fall back to epoll: " << reason;
+        backend_ = kEpoll;
+        return;
     }
+    if (numAcceptors_ > 1)
+    {
+        LOG_WARN << "HttpServer[" << server_.name() << "] setReusePortAcceptors() is ignored by the io_uring backend";
+    }
+    LOG_WARN << "HttpServer[" << server_.name() << "] using io_uring backend";
 }
 
-void HttpServer::onConnection(const muduo::net::TcpConnectionPtr& conn)
+void HttpServer::startAcceptors()
 {
-    if (conn->connected())
+    if (!reusePort_)
     {
-        if (useSSL_)
+        // server_ 构造时已经不带 SO_REUSEPORT 绑定了端口，后面的 socket 会绑定失败
+        LOG_FATAL << "HttpServer[" << server_.name()
+                  << "] setReusePortAcceptors() requires TcpServer::kReusePort";
+    }
+
+    // 每个 acceptor 的 loop 只处理自己 accept 的连接，不再分发给 I/O 线程池；
+    // 线程数为 0 时 TcpServer::start() 在 loop 线程里对它自己调用线程初始化回调（创建时间轮）
+    server_.setThreadNum(0);
+    server_.start();
+    for (int i = 1; i < numAcceptors_; ++i)
+    {
+        std::string name = server_.name() + "#" + std::to_string(i);
+        acceptorThreads_.emplace_back(
+            new muduo::net::EventLoopThread(muduo::net::EventLoopThread::ThreadInitCallback(), name));
+        muduo::net::EventLoop* loop = acceptorThreads_.back()->startLoop();
+        acceptors_.emplace_back(
+            new muduo::net::TcpServer(loop, listenAddr_, name, muduo::net::TcpServer::kReusePort));
+        muduo::net::TcpServer* acceptor = acceptors_.back().get();
+        setCallbacks(acceptor);
+        // TcpServer::start() 要在它的 loop 线程调用；逐个等 listen 完成，
+        // 各 socket 加入 reuseport 组的顺序就是下标顺序，CBPF 返回的下标才对得上
+        runInLoopAndWait(loop, [acceptor]() { acceptor->start(); });
+    }
+
+    if (steerByCpu_ && !attachCpuSteering(listenAddr_, numAcceptors_))
+    {
+        LOG_SYSERR << "HttpServer[" << server_.name()
+                   << "] failed to attach reuseport CBPF, fall back to kernel hash";
+    }
+    LOG_WARN << "HttpServer[" << server_.name() << "] " << numAcceptors_ << " reuseport acceptors"
+             << (steerByCpu_ ? " steered by CPU" : "");
+}
+
+void HttpServer::drain(double timeout)
+{
+    mainLoop_.runInLoop(std::bind(&HttpServer::startDrain, this, timeout));
+}
+
+void HttpServer::startDrain(double timeout)
+{
+    if (draining_.exchange(true))
+    {
+        return;
+    }
+    LOG_WARN << "HttpServer[" << server_.name() << "] draining " << admission_.connections()
+             << " connections, timeout " << timeout << "s";
+    // io_uring 后端的监听 socket 被在途的 accept 引用着，由各 I/O 线程在 closeIdleConnections 里取消、关闭
+    if (backend_ == kEpoll)
+    {
+        stopListening();
+    }
+    drainDeadline_ = muduo::addTime(muduo::Timestamp::now(), timeout);
+    // 之后完成的响应都带 Connection: close（见 onRequest），这里只需处理已经空闲的连接
+    for (muduo::net::EventLoop *loop : ioLoops())
+    {
+        loop->runInLoop(std::bind(&HttpServer::closeIdleConnections, this));
+    }
+    mainLoop_.runEvery(kDrainCheckInterval, std::bind(&HttpServer::checkDrained, this));
+}
+
+void HttpServer::stopListening()
+{
+    // muduo 不暴露 Acceptor 的监听 fd，只能从 /proc/self/fd 里按端口找
+    DIR *dir = ::opendir("/proc/self/fd");
+    if (!dir)
+    {
+        LOG_SYSERR << "HttpServer[" << server_.name() << "] cannot stop listening";
+        return;
+    }
+    std::vector<int> fds;
+    while (struct dirent *entry = ::readdir(dir))
+    {
+        int fd = std::atoi(entry->d_name);
+        if (entry->d_name[0] != '.' && fd != ::dirfd(dir) && isListeningOn(fd, listenAddr_))
         {
-            auto sslConn = std::make_unique<ssl::SslConnection>(conn, sslCtx_.get());
-            sslConn->setMessageCallback(
-                std::bind(&HttpServer::onMessage, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-            sslConns_[conn] = std::move(sslConn);
-            sslConns_[conn]->startHandshake();
+            fds.push_back(fd);
         }
-        conn->setContext(HttpContext());
     }
-    else 
+    ::closedir(dir);
+
+    // 用 /dev/null dup 过去而不是 close：fd 号仍被占着，Acceptor 析构时关掉的不会是别人新打开的文件；
+    // 监听 socket 的最后一个引用没了，内核随之关闭它并从 epoll 里摘掉，
+    // Acceptor 析构时 EPOLL_CTL_DEL 失败只会打一行错误日志
+    std::string name = server_.name();
+    listenerDrain_.reset(new ListenerDrain(std::move(fds), &ListenerDrain::acceptQueueLength, [name](int fd)
     {
-        if (useSSL_)
+        int devNull = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (devNull < 0 || ::dup3(devNull, fd, O_CLOEXEC) < 0)
         {
-            sslConns_.erase(conn);
+            LOG_SYSERR << "HttpServer[" << name << "] cannot close listening socket " << fd;
         }
+        if (devNull >= 0)
+        {
+            ::close(devNull);
+        }
+    }));
+    listenerDeadline_ = muduo::addTime(muduo::Timestamp::now(), kListenerDrainTimeout);
+    size_t total = listenerDrain_->remaining();
+    size_t closed = listenerDrain_->poll(false);
+    LOG_WARN << "HttpServer[" << server_.name() << "] closed " << closed << " of " << total
+             << " listening sockets, the rest after their accept queues drain";
+}
+
+void HttpServer::closeListeners()
+{
+    bool force = !(muduo::Timestamp::now() < listenerDeadline_);
+    if (listenerDrain_->poll(force) == 0 || !listenerDrain_->done())
+    {
+        return;
+    }
+    LOG_WARN << "HttpServer[" << server_.name() << "] all listening sockets closed"
+             << (force ? " (timeout)" : "");
+    // 关闭监听之前还在 accept 的连接，这时可能已经空闲了
+    for (muduo::net::EventLoop *loop : ioLoops())
+    {
+        loop->runInLoop(std::bind(&HttpServer::closeIdleConnections, this));
     }
 }
 
-void HttpServer::onMessage(const muduo::net::TcpConnectionPtr &conn,
-                           muduo::net::Buffer *buf,
-                           muduo::Timestamp receiveTime)
+void HttpServer::closeIdleConnections()
 {
-    try
+    for (const muduo::net::TcpConnectionPtr &conn : t_connections)
     {
-        // 这层判断只是代表是否支持ssl
-        if (useSSL_)
+        HttpContext *context = HttpContext::of(conn);
+        if (Http2Session *session = context->http2())
         {
-            LOG_INFO << "onMessage useSSL_ is true";
-            // 1.查找对应的SSL连接
-            auto it = sslConns_.find(conn);
-            if (it != sslConns_.end())
-            {
-                LOG_INFO << "onMessage sslConns_ is not empty";
-                // 2. SSL连接处理数据
-                it->second->onRead(conn, buf, receiveTime);
-
-                // 3. 如果 SSL 握手还未完成，直接返回
-                if (!it->second->isHandshakeCompleted())
-                {
-                    LOG_INFO << "onMessage sslConns_ is not empty";
-                    return;
-                }
-
-                // 4. 从SSL连接的解密缓冲区获取数据
-                muduo::net::Buffer* decryptedBuf = it->second->getDecryptedBuffer();
-                if (decryptedBuf->readableBytes() == 0)
-                    return; // 没有解密后的数据
-
-                // 5. 使用解密后的数据进行HTTP 处理
-                buf = decryptedBuf; // 将 buf 指向解密后的数据
-                LOG_INFO << "onMessage decryptedBuf is not empty";
-            }
+            // GOAWAY：不再接受新的流，在途的流照常完成，之后会话关闭连接
+            session->shutdown();
+            continue;
         }
-        // HttpContext对象用于解析出buf中的请求报文，并把报文的关键信息封装到HttpRequest对象中
-        HttpContext *context = boost::any_cast<HttpContext>(conn->getMutableContext());
-        if (!context->parseRequest(buf, receiveTime)) // 解析一个http请求
+        if (WebSocket *ws = context->webSocket())
+        {
+            // 关闭握手完成后断开，客户端重连到新进程
+            ws->close(WebSocket::kGoingAway, "server is shutting down");
+            continue;
+        }
+        muduo::net::Buffer *input = context->ssl() ? context->ssl()->getDecryptedBuffer() : conn->inputBuffer();
+        if (isIdle(context, input))
         {
-            // 如果解析http报文过程中出错
-            conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
             conn->shutdown();
         }
-        // 如果buf缓冲区中解析出一个完整的数据包才封装响应报文
-        if (context->gotAll())
+    }
+    if (t_uring)
+    {
+        t_uring->stopAccepting();
+        for (const UringConnectionPtr &conn : t_uring->connections())
         {
-            onRequest(conn, context->request());
-            context->reset();
+            HttpContext *context = contextOf(conn);
+            if (context && isIdle(context, conn->inputBuffer()))
+            {
+                conn->shutdown();
+            }
         }
     }
-    catch (const std::exception &e)
+}
+
+bool HttpServer::isIdle(HttpContext *context, muduo::net::Buffer *input)
+{
+    // 空闲的 keep-alive 连接：在等下一个请求，缓冲区里也没有半个请求。
+    // 流式响应、SSE 以及正在收的请求都不在空闲超时上，等它们自己结束
+    return !context->suspended() &&
+           context->timeoutKind() == HttpContext::kIdleTimeout && context->timer().scheduled() &&
+           context->request().method() == HttpRequest::kInvalid && input->readableBytes() == 0;
+}
+
+void HttpServer::checkDrained()
+{
+    if (listenerDrain_ && !listenerDrain_->done())
     {
-        // 捕获异常，返回错误信息
-        LOG_ERROR << "Exception in onMessage: " << e.what();
-        conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-        conn->shutdown();
+        closeListeners();
+    }
+    size_t remaining = admission_.connections();
+    if (remaining == 0 && (!listenerDrain_ || listenerDrain_->done()))
+    {
+        LOG_WARN << "HttpServer[" << server_.name() << "] drained";
+        mainLoop_.quit();
+    }
+    else if (!(muduo::Timestamp::now() < drainDeadline_))
+    {
+        LOG_WARN << "HttpServer[" << server_.name() << "] drain timeout, close " << remaining
+                 << " remaining connections";
+        mainLoop_.quit();
     }
 }
 
-void HttpServer::onRequest(const muduo::net::TcpConnectionPtr &conn, const HttpRequest &req)
+std::vector<muduo::net::EventLoop*> HttpServer::ioLoops()
 {
-    const std::string &connection = req.getHeader("Connection");
-    bool close = ((connection == "close") ||
-                  (req.getVersion() == "HTTP/1.0" && connection != "Keep-Alive"));
-    HttpResponse response(close);
+    // 没有 I/O 线程时 getAllLoops() 返回主循环
+    std::vector<muduo::net::EventLoop*> loops = server_.threadPool()->getAllLoops();
+    for (const auto &acceptor : acceptors_)
+    {
+        loops.push_back(acceptor->getLoop());
+    }
+    return loops;
+}
 
-    response.setVersion(req.getVersion().empty() ? "HTTP/1.1" : req.getVersion());
+void HttpServer::upgrade(double drainTimeout)
+{
+    mainLoop_.runInLoop(std::bind(&HttpServer::startUpgrade, this, drainTimeout));
+}
 
-    // 根据请求报文信息来封装响应报文对象
-    // ★ 将 conn 一并传入，供 SSE handler 直接操作连接
-    handleRequest(conn, req, &response);
+void HttpServer::startUpgrade(double drainTimeout)
+{
+    if (!reusePort_)
+    {
+        // 新进程要在旧进程还在监听时绑定同一个端口
+        LOG_ERROR << "HttpServer[" << server_.name() << "] upgrade() requires TcpServer::kReusePort";
+        return;
+    }
+    if (draining() || upgradePid_ > 0)
+    {
+        LOG_WARN << "HttpServer[" << server_.name() << "] upgrade already in progress";
+        return;
+    }
 
-    // ★ SSE 升级后，握手头已在 handler 内直接发送给 conn，
-    //   此处跳过标准响应序列化，同时不关闭连接。
-    if (response.isSseUpgraded())
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0)
     {
+        LOG_SYSERR << "HttpServer[" << server_.name() << "] pipe2";
         return;
     }
+    // 只有写端留给新进程，监听 socket 等其余 fd 都是 CLOEXEC 的，不会被继承
+    ::fcntl(fds[1], F_SETFD, 0);
 
-    muduo::net::Buffer buf;
-    response.appendToBuffer(&buf);
-    LOG_DEBUG << "Sending response: status="
-              << response.getStatusCode()
-              << ", bytes=" << buf.readableBytes()
-              << ", close=" << (response.closeConnection() ? "true" : "false");
+    // 按原来的 argv[0] 启动而不是 /proc/self/exe：新版本通常是替换了磁盘上的文件，
+    // /proc/self/exe 指向的还是旧的
+    std::vector<std::string> args = selfCommandLine();
+    std::vector<std::string> env;
+    std::string prefix = std::string(kUpgradeReadyEnv) + "=";
+    for (char **e = environ; *e; ++e)
+    {
+        if (std::strncmp(*e, prefix.c_str(), prefix.size()) != 0)
+        {
+            env.push_back(*e);
+        }
+    }
+    env.push_back(prefix + std::to_string(fds[1]));
+    std::vector<char*> argv;
+    std::vector<char*> envp;
+    for (std::string &arg : args)
+    {
+        argv.push_back(&arg[0]);
+    }
+    for (std::string &var : env)
+    {
+        envp.push_back(&var[0]);
+    }
+    argv.push_back(nullptr);
+    envp.push_back(nullptr);
 
-    conn->send(&buf);
-    if (response.closeConnection())
+    // 本进程屏蔽了 drain/upgrade 的信号，新进程从空的屏蔽字开始
+    posix_spawnattr_t attr;
+    sigset_t empty;
+    ::sigemptyset(&empty);
+    ::posix_spawnattr_init(&attr);
+    ::posix_spawnattr_setsigmask(&attr, &empty);
+    ::posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    pid_t pid = -1;
+    int err = args.empty() ? ENOENT : ::posix_spawnp(&pid, argv[0], nullptr, &attr, argv.data(), envp.data());
+    ::posix_spawnattr_destroy(&attr);
+    ::close(fds[1]);
+    if (err != 0)
     {
-        conn->shutdown();
+        errno = err;
+        LOG_SYSERR << "HttpServer[" << server_.name() << "] failed to start new process";
+        ::close(fds[0]);
+        return;
     }
+
+    LOG_WARN << "HttpServer[" << server_.name() << "] started new process " << pid
+             << ", waiting for it to listen";
+    upgradePid_ = pid;
+    upgradeFd_ = fds[0];
+    upgradeChannel_.reset(new muduo::net::Channel(&mainLoop_, upgradeFd_));
+    upgradeChannel_->setReadCallback(std::bind(&HttpServer::onUpgradeReady, this, drainTimeout));
+    upgradeChannel_->enableReading();
 }
 
-// 执行请求对应的路由处理函数
-// ★ 新增 conn 参数，用于将底层连接注入 SSE handler
-void HttpServer::handleRequest(const muduo::net::TcpConnectionPtr &conn,
-                               const HttpRequest &req,
-                               HttpResponse *resp)
+void HttpServer::onUpgradeReady(double drainTimeout)
 {
-    try
+    char ready = 0;
+    ssize_t n = ::read(upgradeFd_, &ready, 1);
+    if (n < 0 && errno == EINTR)
+    {
+        return;
+    }
+    upgradeChannel_->disableAll();
+    upgradeChannel_->remove();
+    // Channel 不能在它自己的回调里析构
+    mainLoop_.queueInLoop([this]()
     {
-        // 处理请求前的中间件
-        HttpRequest mutableReq = req;
-        middlewareChain_.processBefore(mutableReq);
+        upgradeChannel_.reset();
+        ::close(upgradeFd_);
+        upgradeFd_ = -1;
+    });
 
-        // 路由时直接把 conn 作为参数传给 Handler，避免共享状态竞态
-        if (!router_.route(conn, mutableReq, resp))
+    if (n == 1)
+    {
+        // 新进程已经在同一端口上 accept，新连接由两边分担，直到这边停止监听
+        LOG_WARN << "HttpServer[" << server_.name() << "] new process " << upgradePid_ << " is listening";
+        startDrain(drainTimeout);
+    }
+    else
+    {
+        // 写端被关闭而没有收到通知：新进程在开始监听之前就退出了（端口冲突、配置错误等）
+        LOG_ERROR << "HttpServer[" << server_.name() << "] new process " << upgradePid_
+                  << " exited before listening, keep serving";
+        ::waitpid(upgradePid_, nullptr, WNOHANG);
+        upgradePid_ = -1;
+    }
+}
+
+void HttpServer::notifyUpgradeReady()
+{
+    const char *value = ::getenv(kUpgradeReadyEnv);
+    if (!value)
+    {
+        return;
+    }
+    int fd = std::atoi(value);
+    char ready = 1;
+    if (::write(fd, &ready, 1) != 1)
+    {
+        LOG_SYSERR << "HttpServer[" << server_.name() << "] failed to notify the old process";
+    }
+    ::close(fd);
+}
+
+void HttpServer::blockSignals()
+{
+    sigset_t mask = shutdownSignals();
+    ::pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+}
+
+void HttpServer::handleSignals(double drainTimeout)
+{
+    blockSignals();
+    drainTimeout_ = drainTimeout;
+    sigset_t mask = shutdownSignals();
+    signalFd_ = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd_ < 0)
+    {
+        LOG_SYSERR << "HttpServer[" << server_.name() << "] signalfd";
+        return;
+    }
+    signalChannel_.reset(new muduo::net::Channel(&mainLoop_, signalFd_));
+    signalChannel_->setReadCallback(std::bind(&HttpServer::onSignal, this));
+    signalChannel_->enableReading();
+}
+
+void HttpServer::onSignal()
+{
+    struct signalfd_siginfo info;
+    while (::read(signalFd_, &info, sizeof info) == static_cast<ssize_t>(sizeof info))
+    {
+        LOG_WARN << "HttpServer[" << server_.name() << "] received " << ::strsignal(static_cast<int>(info.ssi_signo));
+        if (info.ssi_signo == SIGUSR2)
         {
-            LOG_INFO << "请求的啥，url：" << req.method() << " " << req.path();
-            LOG_INFO << "未找到路由，返回404";
-            resp->setStatusCode(HttpResponse::k404NotFound);
-            resp->setStatusMessage("Not Found");
-            resp->setCloseConnection(true);
+            startUpgrade(drainTimeout_);
         }
-
-        // ★ SSE 升级后跳过后置中间件（响应已由 SseConnection 接管）
-        if (resp->isSseUpgraded())
+        else if (draining())
         {
-            return;
+            // drain 期间再收到一次 SIGTERM/SIGINT：不再等，立即退出
+            mainLoop_.quit();
+        }
+        else
+        {
+            startDrain(drainTimeout_);
         }
-
-        // 处理响应后的中间件
-        middlewareChain_.processAfter(*resp);
     }
-    catch (const HttpResponse& res) 
+}
+
+void HttpServer::onThreadInit(muduo::net::EventLoop *loop)
+{
+    if (cpuLayout_ && loop != &mainLoop_)
     {
-        // 处理中间件抛出的响应（如CORS预检请求）
-        *resp = res;
+        cpuLayout_->pinIoThread(ioThreadIndex_++);
     }
-    catch (const std::exception& e) 
+    t_timingWheel.reset(new TimingWheel(loop));
+    t_timingWheel->start();
+    admission_.startLagProbe(loop);
+    if (backend_ == kUring)
+    {
+        t_uring.reset(new UringTransport(loop, server_.name()));
+        t_uring->setConnectionCallback(
+            std::bind(&HttpServer::onUringConnection, this, std::placeholders::_1));
+        t_uring->setMessageCallback(
+            std::bind(&HttpServer::processUringInput, this,
+                      std::placeholders::_1,
+                      std::placeholders::_2,
+                      std::placeholders::_3));
+        // supported() 已经确认过内核支持，这里失败多半是 RLIMIT_MEMLOCK 或端口被不带 SO_REUSEPORT 的进程占用
+        if (!t_uring->valid() || !t_uring->listen(listenAddr_))
+        {
+            LOG_FATAL << "HttpServer[" << server_.name() << "] failed to start io_uring transport";
+        }
+    }
+}
+
+void HttpServer::setSslConfig(const ssl::SslConfig& config)
+{
+    if (useSSL_)
+    {
+        ssl::SslConfig sslConfig(config);
+        if (http2_ && Http2Session::supported() && sslConfig.getAlpnProtocols().empty())
+        {
+            sslConfig.setAlpnProtocols({ Http2Session::alpnProtocol().data(), "http/1.1" });
+        }
+        sslCtx_ = std::make_unique<ssl::SslContext>(sslConfig);
+        if (!sslCtx_->initialize())
+        {
+            LOG_ERROR << "Failed to initialize SSL context";
+            abort();
+        }
+    }
+}
+
+router::Router::HandlerPtr HttpServer::offloaded(const HttpCallback& cb)
+{
+    return std::make_shared<OffloadedCallback>(cb);
+}
+
+const std::shared_ptr<FileCache>& HttpServer::fileCache()
+{
+    if (!fileCache_)
+    {
+        fileCache_ = std::make_shared<FileCache>(&mainLoop_);
+    }
+    return fileCache_;
+}
+
+void HttpServer::serveStatic(const std::string& urlPrefix, const std::string& root,
+                             const std::string& cacheControl)
+{
+    auto handler = std::make_shared<router::StaticFileHandler>(fileCache(), urlPrefix, root, cacheControl);
+    router_.addPrefixHandler(HttpRequest::kGet, urlPrefix, handler);
+    router_.addPrefixHandler(HttpRequest::kHead, urlPrefix, handler);
+}
+
+void HttpServer::serveWebSocket(const std::string& path, std::shared_ptr<WebSocketHandler> handler)
+{
+    router_.registerHandler(HttpRequest::kGet, path, std::make_shared<WebSocketRoute>(std::move(handler)));
+}
+
+void HttpServer::serveFile(const std::string& path, const std::string& file,
+                           const std::string& cacheControl)
+{
+    auto handler = std::make_shared<router::StaticFileHandler>(fileCache(), path, file, cacheControl);
+    router_.registerHandler(HttpRequest::kGet, path, handler);
+    router_.registerHandler(HttpRequest::kHead, path, handler);
+}
+
+void HttpServer::onConnection(const muduo::net::TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        if (!admission_.acquireConnection(conn->peerAddress()))
+        {
+            // 不挂 HttpContext，之后到达的数据在 onMessage 里直接丢弃
+            LOG_DEBUG << "Too many connections (" << admission_.connections() << "), reject "
+                      << conn->peerAddress().toIpPort();
+            if (useSSL_)
+            {
+                conn->forceClose();
+                return;
+            }
+            muduo::net::Buffer output;
+            appendOverloadResponse(&output, admission_.limits().retryAfter);
+            conn->send(&output);
+            conn->shutdown();
+            conn->forceCloseWithDelay(1.0);
+            return;
+        }
+        // HttpRequest 内含 arena，不可拷贝，因此用 shared_ptr 放进 boost::any
+        auto context = std::make_shared<HttpContext>(limits_);
+        std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+        context->timer().setCallback(std::bind(&HttpServer::onTimeout, this, weakConn));
+        if (useSSL_)
+        {
+            // TLS 状态和 HttpContext 放在一起，随连接销毁，各 I/O 线程之间不共享任何表
+            context->setSsl(std::make_unique<ssl::SslConnection>(conn.get(), sslCtx_.get()));
+        }
+        conn->setContext(context);
+        t_connections.insert(conn);
+        if (useSSL_)
+        {
+            context->ssl()->startHandshake();
+        }
+        armTimeout(context.get(), 0);
+    }
+    else 
+    {
+        if (!conn->getContext().empty())
+        {
+            HttpContext *context = HttpContext::of(conn);
+            context->timer().cancel();
+            if (Http2Session *session = context->http2())
+            {
+                session->onDisconnected(); // 还开着的流逐个结束，释放它们占的在途请求
+            }
+            if (WebSocket *ws = context->webSocket())
+            {
+                ws->onDisconnected();
+            }
+            endRequest(context);
+            admission_.releaseConnection(conn->peerAddress());
+            t_connections.erase(conn);
+        }
+    }
+}
+
+void HttpServer::onMessage(const muduo::net::TcpConnectionPtr &conn,
+                           muduo::net::Buffer *buf,
+                           muduo::Timestamp receiveTime)
+{
+    // 被准入控制拒绝的连接，等它关闭
+    if (conn->getContext().empty())
+    {
+        buf->retrieveAll();
+        return;
+    }
+    try
+    {
+        // 这层判断只是代表是否支持ssl
+        if (useSSL_)
+        {
+            ssl::SslConnection *sslConn = HttpContext::of(conn)->ssl();
+            // 密文全部交给 SSL 连接：推进握手，或解密到它自己的缓冲区
+            if (!sslConn->onRead(buf) || !sslConn->isHandshakeCompleted())
+            {
+                return;
+            }
+            buf = sslConn->getDecryptedBuffer();
+            if (buf->readableBytes() == 0)
+            {
+                return; // 没有解密后的数据
+            }
+        }
+        processInput(conn, buf, receiveTime);
+    }
+    catch (const std::exception &e)
+    {
+        // 捕获异常，返回错误信息
+        LOG_ERROR << "Exception in onMessage: " << e.what();
+        HttpContext::send(conn, "HTTP/1.1 400 Bad Request\r\n\r\n");
+        conn->shutdown();
+    }
+}
+
+// 解析并处理 buf 中的请求；读回调和流式响应结束后都走这里
+void HttpServer::processInput(const muduo::net::TcpConnectionPtr &conn,
+                              muduo::net::Buffer *buf,
+                              muduo::Timestamp receiveTime)
+{
+    try
+    {
+        // 已经决定关闭的连接（如拒绝了 100-continue 的请求）上陆续到达的数据直接丢弃
+        if (!conn->connected())
+        {
+            buf->retrieveAll();
+            return;
+        }
+
+        // HttpContext对象用于解析出buf中的请求报文，并把报文的关键信息封装到HttpRequest对象中
+        HttpContext *context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext())->get();
+
+        // 流式响应还没发完、handler 还在工作线程里：新请求先留在缓冲区，完成后由 resume 接着处理。
+        // 正常客户端不会在后面堆积太多请求，超过请求头上限的视为滥用
+        if (context->suspended())
+        {
+            if (buf->readableBytes() > limits_.maxHeaderBytes)
+            {
+                LOG_WARN << "Too much pipelined data behind a stream, close " << conn->name();
+                conn->forceClose();
+            }
+            return;
+        }
+
+        if (context->http2())
+        {
+            processHttp2Input(context, buf);
+            return;
+        }
+        if (WebSocket *ws = context->webSocket())
+        {
+            // 有数据就顺延空闲超时，空闲超时到了由 keepAlive 发 ping
+            ws->onRead(buf);
+            scheduleTimeout(context, HttpContext::kIdleTimeout);
+            return;
+        }
+        // 连接上还没有请求时看是不是 HTTP/2：TLS 上 ALPN 选了 h2，或者明文连接直接发来了 HTTP/2 的连接前言
+        if (http2_ && context->inHeaderPhase() && context->request().method() == HttpRequest::kInvalid)
+        {
+            bool h2 = false;
+            if (context->ssl())
+            {
+                h2 = context->ssl()->alpnProtocol() == Http2Session::alpnProtocol();
+            }
+            else
+            {
+                std::string_view preface = Http2Session::clientPreface();
+                size_t n = std::min(buf->readableBytes(), preface.size());
+                if (std::string_view(buf->peek(), n) == preface.substr(0, n))
+                {
+                    if (n < preface.size())
+                    {
+                        armTimeout(context, n); // 前言还没收全
+                        return;
+                    }
+                    h2 = true;
+                }
+            }
+            if (h2)
+            {
+                startHttp2(conn, context)->start();
+                processHttp2Input(context, buf);
+                return;
+            }
+        }
+
+        // 支持 HTTP/1.1 pipelining：一次读回调里把缓冲区中所有完整的请求都处理掉，
+        // 按顺序把响应攒进 output，最后一次 send 出去，减少系统调用。
+        // output 属于连接的 HttpContext，send 之后保留容量给下一次读回调用
+        muduo::net::Buffer *output = context->outputBuffer();
+        RequestResult result = kContinue;
+        // 从 io_uring 交接过来的连接停在请求头刚解析完的地方，缓冲区里可能已经没有数据
+        while (result == kContinue && (buf->readableBytes() > 0 || context->gotHeaders()))
+        {
+            if (!context->parseRequest(buf, receiveTime)) // 解析一个http请求
+            {
+                // 如果解析http报文过程中出错，前面已经处理完的响应照常发出
+                appendErrorResponse(output, context->errorCode());
+                endRequest(context);
+                result = kClose;
+                break;
+            }
+            // 请求头已完整：先决定请求体怎么收（整份缓存还是交给路由的 BodySink），再继续解析
+            if (context->gotHeaders())
+            {
+                result = onHeaders(conn, context);
+                if (result != kContinue)
+                {
+                    endRequest(context);
+                    break;
+                }
+                if (!context->startBody())
+                {
+                    appendErrorResponse(output, context->errorCode());
+                    endRequest(context);
+                    result = kClose;
+                    break;
+                }
+                // 有请求体的接着解析；没有请求体的此时已经完整
+                if (!context->gotAll())
+                {
+                    continue;
+                }
+            }
+            // 缓冲区里剩下的不是一个完整请求，等下一次读回调
+            if (!context->gotAll())
+            {
+                break;
+            }
+            // 之后连接上跑的是 HTTP/2，缓冲区里剩下的数据（连接前言）交给会话
+            if (http2_ && !context->ssl() && upgradeHttp2(conn, context, buf))
+            {
+                return;
+            }
+
+            // 非安全方法（POST 等）的 handler 可能直接接管连接往外写（如 SSE），
+            // 先把攒下的响应发出去，保证响应顺序和请求顺序一致
+            if (output->readableBytes() > 0 && !isSafeMethod(context->request().method()))
+            {
+                HttpContext::send(conn, output);
+            }
+
+            result = onRequest(conn, context);
+            if (result == kContinue || result == kClose)
+            {
+                endRequest(context); // 其余情况在 resume() 里结束
+            }
+            if (result != kDeferred)
+            {
+                context->reset();
+            }
+        }
+
+        if (output->readableBytes() > 0)
+        {
+            HttpContext::send(conn, output);
+        }
+        if (output->internalCapacity() > kMaxRetainedOutputCapacity)
+        {
+            output->shrink(0); // 偶尔一次大响应撑大的缓冲区不长期占着
+        }
+        if (result == kClose)
+        {
+            conn->shutdown();
+            // 半关闭之后对方若一直不关连接，由空闲超时强制关闭
+            scheduleTimeout(context, HttpContext::kIdleTimeout);
+        }
+        else if (WebSocket *ws = context->webSocket())
+        {
+            // 升级之后连接只受连接数限制，不再算在途请求；紧跟着握手到达的帧接着处理
+            endRequest(context);
+            ws->onRead(buf);
+            scheduleTimeout(context, HttpContext::kIdleTimeout);
+        }
+        else if (result == kUpgraded || result == kDeferred)
+        {
+            // 连接已交给流式响应等长连接 handler，或在等 handler 完成，不再受请求超时约束
+            context->timer().cancel();
+        }
+        else
+        {
+            armTimeout(context, buf->readableBytes());
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // 捕获异常，返回错误信息
+        LOG_ERROR << "Exception in onMessage: " << e.what();
+        HttpContext::send(conn, "HTTP/1.1 400 Bad Request\r\n\r\n");
+        conn->shutdown();
+    }
+}
+
+HttpServer::RequestResult HttpServer::onRequest(const muduo::net::TcpConnectionPtr &conn,
+                                                HttpContext *context)
+{
+    HttpRequest &req = context->request();
+    bool close = closeAfter(req);
+
+    // 会阻塞的 handler 交给工作线程，I/O 线程接着服务别的连接
+    if (context->offload() && workerPool_)
+    {
+        return offloadRequest(conn, context, close);
+    }
+
+    // 复用连接上的响应对象，header 槽位和 body 的容量都留着
+    HttpResponse &response = context->response();
+    response.reset(close);
+
+    response.setVersion(req.getVersion().empty() ? "HTTP/1.1" : req.getVersion());
+
+    // 根据请求报文信息来封装响应报文对象
+    // ★ 将 conn 一并传入，供 SSE handler 直接操作连接
+    handleRequest(conn, req, &response, context->beforeMiddlewareDone());
+    return sendResponse(conn, context, req, response);
+}
+
+HttpServer::RequestResult HttpServer::sendResponse(const muduo::net::TcpConnectionPtr &conn,
+                                                   HttpContext *context,
+                                                   const HttpRequest &req,
+                                                   HttpResponse &response)
+{
+    muduo::net::Buffer *output = context->outputBuffer();
+
+    // ★ SSE 升级后，握手头已在 handler 内直接发送给 conn，
+    //   此处跳过标准响应序列化，同时不关闭连接；后面流水线上的请求也不再处理。
+    if (response.isSseUpgraded())
+    {
+        return kUpgraded;
+    }
+
+    // WebSocket 握手：101 连同前面流水线的响应发出，之后连接上收发的都是 WebSocket 帧
+    if (response.isWebSocket())
+    {
+        response.appendHeadersToBuffer(output);
+        HttpContext::send(conn, output);
+        context->setWebSocket(response.releaseWebSocket());
+        context->webSocket()->open();
+        return kUpgraded;
+    }
+
+    // 延迟完成：先把前面流水线的响应发出去，等 complete() 之后再回到 onDeferredComplete。
+    // 挂起期间输入缓冲区会继续收数据、可能搬移，请求体先拷进请求自己
+    if (response.isDeferred())
+    {
+        context->request().detachBody();
+        context->setSuspended(true);
+        std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+        response.releaseDeferred()->open(std::bind(&HttpServer::onDeferredComplete, this, weakConn));
+        return kDeferred;
+    }
+
+    // 流式响应：头部连同前面流水线的响应先发出，之后的数据由 ResponseStream 自己写
+    if (response.isStreaming())
+    {
+        response.appendHeadersToBuffer(output);
+        HttpContext::send(conn, output);
+        context->setSuspended(true);
+        std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+        response.releaseStream()->open(
+            std::bind(&HttpServer::resume, this, weakConn, response.closeConnection()));
+        return kUpgraded;
+    }
+
+    // HEAD 请求可能落到 GET 的 handler 上，头部照常（Content-Length 和 GET 一致），响应体不发
+    if (req.method() == HttpRequest::kHead)
+    {
+        response.discardBody();
+    }
+
+    // 大文件分片发送，和流式响应一样挂起连接，发完之后再处理后面的请求
+    if (response.bodySize() >= SlicedSender::kMinSize)
+    {
+        auto sender = std::make_shared<SlicedSender>(conn, response.releaseSegments(output));
+        HttpContext::send(conn, output);
+        context->setSuspended(true);
+        std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+        sender->start(std::bind(&HttpServer::resume, this, weakConn, response.closeConnection()));
+        return kUpgraded;
+    }
+    response.writeTo(conn, output);
+    LOG_DEBUG << "Queue response: status="
+              << response.getStatusCode()
+              << ", body bytes=" << response.bodySize()
+              << ", close=" << (response.closeConnection() ? "true" : "false");
+
+    return response.closeConnection() ? kClose : kContinue;
+}
+
+HttpServer::RequestResult HttpServer::offloadRequest(const muduo::net::TcpConnectionPtr &conn,
+                                                     HttpContext *context,
+                                                     bool close)
+{
+    // 请求和响应归任务独占，工作线程不碰 HttpContext；请求体先从输入缓冲区里拷出来
+    auto req = std::make_shared<HttpRequest>();
+    req->swap(context->request());
+    req->detachBody();
+    auto resp = std::make_shared<HttpResponse>(close);
+    resp->setVersion(req->getVersion().empty() ? "HTTP/1.1" : req->getVersion());
+    bool beforeDone = context->beforeMiddlewareDone();
+
+    bool queued = workerPool_->tryRun([this, conn, req, resp, beforeDone]()
+    {
+        handleRequest(conn, *req, resp.get(), beforeDone);
+        conn->getLoop()->runInLoop(std::bind(&HttpServer::onOffloadComplete, this, conn, req, resp));
+    });
+    if (!queued)
+    {
+        // 排队的请求已经多到处理不完，再排下去只会让每个请求都超时：立即拒绝
+        LOG_WARN << "Worker queue is full (" << workerPool_->queueSize() << "), reject " << conn->name();
+        context->request().swap(*req);
+        HttpResponse &response = context->response();
+        response.reset(close);
+        response.setVersion(context->request().getVersion().empty() ? "HTTP/1.1"
+                                                                    : context->request().getVersion());
+        response.setStatusCode(HttpResponse::k503ServiceUnavailable);
+        response.addHeader(HttpHeaders::kRetryAfter, std::to_string(admission_.limits().retryAfter));
+        return sendResponse(conn, context, context->request(), response);
+    }
+
+    context->setSuspended(true);
+    return kUpgraded;
+}
+
+void HttpServer::onOffloadComplete(const muduo::net::TcpConnectionPtr &conn,
+                                   const std::shared_ptr<HttpRequest> &req,
+                                   const std::shared_ptr<HttpResponse> &resp)
+{
+    if (!conn->connected())
+    {
+        return;
+    }
+    HttpContext *context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext())->get();
+    muduo::net::Buffer *output = context->outputBuffer();
+    RequestResult result = sendResponse(conn, context, *req, *resp);
+    if (output->readableBytes() > 0)
+    {
+        HttpContext::send(conn, output);
+    }
+
+    // 挂起期间不解析新请求，连接上的请求对象是空的：换回来，arena 等容量留给后面的请求
+    req->reset();
+    context->request().swap(*req);
+
+    // 工作线程里开始了流式响应的，等流结束再恢复；升级成 WebSocket 的立即恢复，缓冲区里的帧交给它
+    if (result != kUpgraded || context->webSocket())
+    {
+        resume(conn, result == kClose);
+    }
+}
+
+HttpServer::RequestResult HttpServer::onHeaders(const muduo::net::TcpConnectionPtr &conn,
+                                                HttpContext *context)
+{
+    HttpRequest &req = context->request();
+    router::Router::HandlerPtr handler;
+    bool routed = router_.findRoute(req, &handler);
+    context->setOffload(handler && handler->offload());
+
+    if (const char *overload = admitRequest(context))
+    {
+        LOG_DEBUG << "Overloaded (" << overload << "), reject " << conn->name();
+        return kClose;
+    }
+
+    // Expect: 100-continue —— 客户端在等我们表态之后才上传请求体，
+    // 先把路由、中间件（鉴权、限流）和 handler 的检查做完，不合格的直接回最终响应，请求体一个字节都不收
+    // （HTTP/1.0 的客户端不认识 100，按 RFC 9110 忽略 Expect）
+    std::string_view expect = req.getHeader(HttpHeaders::kExpect);
+    if (!expect.empty() && req.getVersion() == "HTTP/1.1" && context->hasBody())
+    {
+        muduo::net::Buffer *output = context->outputBuffer();
+        HttpResponse &response = context->response();
+        response.reset(true);
+        response.setVersion("HTTP/1.1");
+        if (!checkContinue(conn, context, expect, routed, handler.get()))
+        {
+            // 请求体还在路上，连接没法再复用
+            response.setCloseConnection(true);
+            response.appendToBuffer(output);
+            return kClose;
+        }
+        // 客户端在等，连同前面攒下的（流水线）响应立即发出
+        output->append("HTTP/1.1 100 Continue\r\n\r\n");
+        HttpContext::send(conn, output);
+    }
+
+    if (handler)
+    {
+        req.setBodySink(handler->createBodySink(conn, req));
+    }
+    return kContinue;
+}
+
+const char *HttpServer::admitRequest(HttpContext *context)
+{
+    // 过载时在收请求体之前就拒绝，不让已经处理不完的请求继续排队
+    bool offload = context->offload() && workerPool_;
+    const char *overload = admission_.admitRequest(offload, offload ? workerPool_->queueSize() : 0);
+    if (overload)
+    {
+        appendOverloadResponse(context->outputBuffer(), admission_.limits().retryAfter);
+        return overload;
+    }
+    context->setAdmitted(true);
+    return nullptr;
+}
+
+bool HttpServer::checkContinue(const muduo::net::TcpConnectionPtr &conn,
+                               HttpContext *context,
+                               std::string_view expect,
+                               bool routed,
+                               router::RouterHandler *handler)
+{
+    HttpRequest &req = context->request();
+    HttpResponse *resp = &context->response();
+
+    if (!equalsIgnoreCase(expect, "100-continue"))
+    {
+        resp->setStatusLine("HTTP/1.1", HttpResponse::k417ExpectationFailed, "Expectation Failed");
+        return false;
+    }
+    if (!routed)
+    {
+        resp->setStatusLine("HTTP/1.1", HttpResponse::k404NotFound, "Not Found");
+        return false;
+    }
+
+    try
+    {
+        middlewareChain_.processBefore(req);
+        context->setBeforeMiddlewareDone(true);
+    }
+    catch (const HttpResponse &res)
+    {
+        // 中间件拒绝（如限流 429）
+        *resp = res;
+        return false;
+    }
+
+    return !handler || handler->acceptHeaders(conn, req, resp);
+}
+
+// 根据连接当前所处的阶段（空闲 / 读请求头 / 读请求体）重新安排超时
+void HttpServer::armTimeout(HttpContext *context, size_t pendingBytes)
+{
+    if (context->inBodyPhase())
+    {
+        // 请求体：每收到一次数据就顺延
+        scheduleTimeout(context, HttpContext::kBodyTimeout);
+    }
+    else if (context->inHeaderPhase() &&
+             (pendingBytes > 0 || context->request().method() != HttpRequest::kInvalid))
+    {
+        // 请求头：从请求的第一个字节开始算总时间，之后再收到数据也不顺延，
+        // 否则每隔几秒发一个字节就能一直占着连接
+        if (context->timeoutKind() != HttpContext::kHeaderTimeout || !context->timer().scheduled())
+        {
+            scheduleTimeout(context, HttpContext::kHeaderTimeout);
+        }
+    }
+    else
+    {
+        scheduleTimeout(context, HttpContext::kIdleTimeout);
+    }
+}
+
+void HttpServer::scheduleTimeout(HttpContext *context, HttpContext::TimeoutKind kind)
+{
+    TimingWheel *wheel = t_timingWheel.get();
+    if (!wheel)
+    {
+        return;
+    }
+
+    int seconds = 0;
+    switch (kind)
+    {
+        case HttpContext::kIdleTimeout:   seconds = limits_.idleTimeout; break;
+        case HttpContext::kHeaderTimeout: seconds = limits_.headerTimeout; break;
+        case HttpContext::kBodyTimeout:   seconds = limits_.bodyTimeout; break;
+        default:                          break;
+    }
+
+    context->setTimeoutKind(kind);
+    if (seconds > 0)
+    {
+        wheel->schedule(&context->timer(), seconds);
+    }
+    else
+    {
+        context->timer().cancel();
+    }
+}
+
+void HttpServer::onTimeout(const std::weak_ptr<muduo::net::TcpConnection> &weakConn)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected())
+    {
+        return;
+    }
+    HttpContext *context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext())->get();
+
+    if (context->timeoutKind() == HttpContext::kIdleTimeout)
+    {
+        // 大响应还没写完（对方读得慢），继续等
+        if (conn->outputBuffer()->readableBytes() > 0)
+        {
+            scheduleTimeout(context, HttpContext::kIdleTimeout);
+            return;
+        }
+        if (WebSocket *ws = context->webSocket())
+        {
+            if (ws->keepAlive())
+            {
+                scheduleTimeout(context, HttpContext::kIdleTimeout);
+                return;
+            }
+            LOG_DEBUG << "WebSocket keepalive timeout, close connection " << conn->name();
+            conn->forceClose();
+            return;
+        }
+        if (Http2Session *session = context->http2())
+        {
+            // 先发 GOAWAY，客户端知道没有请求被丢掉
+            LOG_DEBUG << "Idle timeout, close HTTP/2 connection " << conn->name();
+            session->shutdown();
+            conn->forceCloseWithDelay(1.0);
+            return;
+        }
+        LOG_DEBUG << "Idle timeout, close connection " << conn->name();
+        conn->forceClose();
+        return;
+    }
+
+    // HTTP/2 的每个流各自计时，超时的流回 408，连接和其他流照常
+    if (Http2Session *session = context->http2())
+    {
+        session->expireStreams(muduo::Timestamp::now());
+        scheduleHttp2Timeout(context);
+        return;
+    }
+
+    // 请求头/请求体没有按时收完：回 408 后关闭连接
+    LOG_INFO << "Request timeout from " << conn->peerAddress().toIpPort();
+    muduo::net::Buffer *output = context->outputBuffer();
+    appendErrorResponse(output, HttpResponse::k408RequestTimeout);
+    HttpContext::send(conn, output);
+    conn->shutdown();
+    conn->forceCloseWithDelay(1.0);
+}
+
+// 流式响应的最后一块已交给连接：恢复成普通的 HTTP 连接，处理流期间积压的请求
+void HttpServer::onDeferredComplete(const std::weak_ptr<muduo::net::TcpConnection> &weakConn)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected())
+    {
+        return;
+    }
+    HttpContext *context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext())->get();
+    HttpRequest &req = context->request();
+    HttpResponse &response = context->response();
+    try
+    {
+        middlewareChain_.processAfter(req, response);
+    }
+    catch (const HttpResponse& res)
+    {
+        response = res;
+    }
+    catch (const std::exception& e)
+    {
+        response.setStatusCode(HttpResponse::k500InternalServerError);
+        response.setBody(e.what());
+    }
+
+    muduo::net::Buffer *output = context->outputBuffer();
+    RequestResult result = sendResponse(conn, context, req, response);
+    if (output->readableBytes() > 0)
+    {
+        HttpContext::send(conn, output);
+    }
+    context->reset();
+    if (result != kUpgraded || context->webSocket()) // 完成时开始了流式响应的，等流结束再恢复
+    {
+        resume(conn, result == kClose);
+    }
+}
+
+Http2Session *HttpServer::startHttp2(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    auto session = std::make_unique<Http2Session>(conn.get(), context->ssl(), limits_);
+    std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+    session->setHeadersCallback(std::bind(&HttpServer::onHttp2Headers, this, weakConn, std::placeholders::_1));
+    session->setRequestCallback(std::bind(&HttpServer::onHttp2Request, this, weakConn, std::placeholders::_1));
+    session->setCloseCallback(std::bind(&HttpServer::onHttp2StreamClose, this, weakConn, std::placeholders::_1));
+    Http2Session *h2 = session.get();
+    context->setHttp2(std::move(session));
+    LOG_DEBUG << "HTTP/2 on " << conn->name();
+    return h2;
+}
+
+void HttpServer::processHttp2Input(HttpContext *context, muduo::net::Buffer *buf)
+{
+    Http2Session *session = context->http2();
+    if (draining())
+    {
+        session->shutdown(); // drain 之后才升级上来的连接
+    }
+    if (!session->onRead(buf))
+    {
+        scheduleTimeout(context, HttpContext::kIdleTimeout); // 已发 GOAWAY 并关闭写端，对方不关时强制关闭
+        return;
+    }
+    scheduleHttp2Timeout(context);
+}
+
+void HttpServer::scheduleHttp2Timeout(HttpContext *context)
+{
+    // 没有流时按空闲计时；有流还在收请求头/请求体时按其中最早的期限计时；
+    // 其余的流都已经交给 handler（包括长时间的 SSE），不计时
+    Http2Session *session = context->http2();
+    if (session->idle())
+    {
+        scheduleTimeout(context, HttpContext::kIdleTimeout);
+        return;
+    }
+    TimingWheel *wheel = t_timingWheel.get();
+    muduo::Timestamp deadline = session->nextDeadline();
+    if (!wheel || !deadline.valid())
+    {
+        context->setTimeoutKind(HttpContext::kNoTimeout);
+        context->timer().cancel();
+        return;
+    }
+    // 时间轮按秒走，向上取整；到期时只结束期限已过的流，其余的重新计时
+    double seconds = muduo::timeDifference(deadline, muduo::Timestamp::now());
+    context->setTimeoutKind(HttpContext::kBodyTimeout);
+    wheel->schedule(&context->timer(), std::max(1, static_cast<int>(std::ceil(seconds))));
+}
+
+bool HttpServer::upgradeHttp2(const muduo::net::TcpConnectionPtr &conn,
+                              HttpContext *context,
+                              muduo::net::Buffer *buf)
+{
+    HttpRequest &req = context->request();
+    std::string_view settings = req.getHeader(HttpHeaders::kHttp2Settings);
+    // 带请求体的请求升级之后请求体还要按 HTTP/1.1 收，不值得支持，客户端收到普通的响应也能照常工作
+    if (settings.empty() || !equalsIgnoreCase(req.getHeader(HttpHeaders::kUpgrade), "h2c") ||
+        req.getVersion() != "HTTP/1.1" || context->hasBody())
+    {
+        return false;
+    }
+    Http2Session *session = startHttp2(conn, context);
+    Http2Session::StreamPtr stream = session->upgrade(settings, &req);
+    if (!stream)
+    {
+        context->setHttp2(nullptr);
+        return false;
+    }
+
+    // 前面流水线的响应先发出，101 之后就是 HTTP/2 的帧
+    muduo::net::Buffer *output = context->outputBuffer();
+    output->append("HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n");
+    HttpContext::send(conn, output);
+    session->start();
+
+    // 准入已经在请求头收完时做过，改由流关闭时结束
+    stream->admitted = context->admitted();
+    stream->offload = context->offload();
+    context->setAdmitted(false);
+    context->reset();
+    onHttp2Request(conn, stream);
+    processHttp2Input(context, buf);
+    return true;
+}
+
+bool HttpServer::onHttp2Headers(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                const Http2Session::StreamPtr &stream)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn)
+    {
+        return false;
+    }
+    HttpRequest &req = stream->request;
+    router::Router::HandlerPtr handler;
+    router_.findRoute(req, &handler);
+    stream->offload = handler && handler->offload();
+
+    // 过载时只拒绝这个流，连接上的其他流不受影响
+    bool offload = stream->offload && workerPool_;
+    if (const char *overload = admission_.admitRequest(offload, offload ? workerPool_->queueSize() : 0))
+    {
+        LOG_DEBUG << "Overloaded (" << overload << "), reject " << conn->name() << " stream " << stream->id;
+        HttpResponse &response = stream->response;
+        response.reset(false);
+        response.setStatusCode(HttpResponse::k503ServiceUnavailable);
+        response.addHeader(HttpHeaders::kRetryAfter, std::to_string(admission_.limits().retryAfter));
+        HttpContext::of(conn)->http2()->submitResponse(stream);
+        return false;
+    }
+    stream->admitted = true;
+
+    if (handler)
+    {
+        req.setBodySink(handler->createBodySink(conn, req));
+    }
+    return true;
+}
+
+void HttpServer::onHttp2Request(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                const Http2Session::StreamPtr &stream)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || stream->closed)
+    {
+        return;
+    }
+    HttpResponse &response = stream->response;
+    response.reset(false);
+    response.setVersion("HTTP/2");
+
+    // 请求和响应归流所有，流对象由任务持有；流在这期间被取消的，完成后不再发送
+    if (stream->offload && workerPool_)
+    {
+        stream->running = true;
+        bool queued = workerPool_->tryRun([this, conn, stream]()
+        {
+            handleRequest(conn, stream->request, &stream->response);
+            conn->getLoop()->runInLoop(std::bind(&HttpServer::onHttp2OffloadComplete, this, conn, stream));
+        });
+        if (queued)
+        {
+            return;
+        }
+        stream->running = false;
+        LOG_WARN << "Worker queue is full (" << workerPool_->queueSize() << "), reject " << conn->name()
+                 << " stream " << stream->id;
+        response.setStatusCode(HttpResponse::k503ServiceUnavailable);
+        response.addHeader(HttpHeaders::kRetryAfter, std::to_string(admission_.limits().retryAfter));
+    }
+    else
+    {
+        handleRequest(conn, stream->request, &response);
+    }
+    sendHttp2Response(conn, stream);
+}
+
+void HttpServer::onHttp2OffloadComplete(const muduo::net::TcpConnectionPtr &conn,
+                                        const Http2Session::StreamPtr &stream)
+{
+    stream->running = false;
+    // 流在 handler 执行期间关闭了（对方取消、连接断开）：在途请求到这里才算结束
+    if (stream->closed)
+    {
+        finishHttp2Stream(stream);
+        return;
+    }
+    sendHttp2Response(conn, stream);
+}
+
+void HttpServer::sendHttp2Response(const muduo::net::TcpConnectionPtr &conn, const Http2Session::StreamPtr &stream)
+{
+    if (!conn->connected() || stream->closed)
+    {
+        return;
+    }
+    Http2Session *session = HttpContext::of(conn)->http2();
+    HttpResponse &response = stream->response;
+
+    // 直接往连接上写 HTTP/1.1 报文的 handler 在 HTTP/2 连接上没法工作，流式响应要用 ResponseStream
+    if (response.isSseUpgraded())
+    {
+        LOG_ERROR << "Handler for " << std::string(stream->request.path()) << " writes to the connection directly, "
+                  << "which is not supported over HTTP/2";
+        session->resetStream(stream->id);
+        return;
+    }
+    if (response.isDeferred())
+    {
+        std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+        response.releaseDeferred()->open(std::bind(&HttpServer::onHttp2DeferredComplete, this, weakConn, stream));
+        return;
+    }
+    if (stream->request.method() == HttpRequest::kHead)
+    {
+        response.discardBody();
+    }
+    session->submitResponse(stream);
+    if (response.isStreaming())
+    {
+        // 流的结束由会话的流关闭回调收尾，不需要 onComplete
+        response.releaseStream()->open(ResponseStream::Callback());
+    }
+}
+
+void HttpServer::onHttp2DeferredComplete(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                         const Http2Session::StreamPtr &stream)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected() || stream->closed)
+    {
+        return;
+    }
+    HttpResponse &response = stream->response;
+    try
+    {
+        middlewareChain_.processAfter(stream->request, response);
+    }
+    catch (const HttpResponse& res)
+    {
+        response = res;
+    }
+    catch (const std::exception& e)
+    {
+        response.setStatusCode(HttpResponse::k500InternalServerError);
+        response.setBody(e.what());
+    }
+    sendHttp2Response(conn, stream);
+}
+
+void HttpServer::onHttp2StreamClose(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                    const Http2Session::StreamPtr &stream)
+{
+    finishHttp2Stream(stream);
+    // 连接断开时也会逐个关闭流，那时不再安排超时
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (conn && conn->connected())
+    {
+        scheduleHttp2Timeout(HttpContext::of(conn));
+    }
+}
+
+void HttpServer::finishHttp2Stream(const Http2Session::StreamPtr &stream)
+{
+    // 工作线程还在执行 handler 的，等 onHttp2OffloadComplete 再结束
+    if (stream->admitted && !stream->running)
+    {
+        stream->admitted = false;
+        admission_.finishRequest();
+    }
+}
+
+void HttpServer::endRequest(HttpContext *context)
+{
+    if (context->admitted())
+    {
+        context->setAdmitted(false);
+        admission_.finishRequest();
+    }
+}
+
+void HttpServer::resume(const std::weak_ptr<muduo::net::TcpConnection> &weakConn, bool close)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected())
+    {
+        return;
+    }
+    HttpContext *context = boost::any_cast<std::shared_ptr<HttpContext>>(conn->getMutableContext())->get();
+    context->setSuspended(false);
+    endRequest(context);
+    if (close || draining())
+    {
+        conn->shutdown();
+        scheduleTimeout(context, HttpContext::kIdleTimeout);
+        return;
+    }
+
+    muduo::net::Buffer *input = context->ssl() ? context->ssl()->getDecryptedBuffer() : conn->inputBuffer();
+    processInput(conn, input, muduo::Timestamp::now());
+}
+
+bool HttpServer::closeAfter(const HttpRequest &req) const
+{
+    // Connection 的取值同样不区分大小写
+    std::string_view connection = req.getHeader(HttpHeaders::kConnection);
+    // drain 期间每个响应之后都关闭连接，客户端改连新进程
+    return draining() || equalsIgnoreCase(connection, "close") ||
+           (req.getVersion() == "HTTP/1.0" && !equalsIgnoreCase(connection, "Keep-Alive"));
+}
+
+// 执行请求对应的路由处理函数
+// ★ 新增 conn 参数，用于将底层连接注入 SSE handler
+void HttpServer::handleRequest(const muduo::net::TcpConnectionPtr &conn,
+                               HttpRequest &req,
+                               HttpResponse *resp,
+                               bool beforeDone)
+{
+    try
+    {
+        // 处理请求前的中间件，直接在 HttpContext 持有的请求上修改，不再整份拷贝
+        // （100-continue 的请求在收请求体之前已经执行过）
+        if (!beforeDone)
+        {
+            middlewareChain_.processBefore(req);
+        }
+
+        // 路由时直接把 conn 作为参数传给 Handler，避免共享状态竞态
+        if (!router_.route(conn, req, resp))
+        {
+            LOG_INFO << "请求的啥，url：" << req.method() << " " << std::string(req.path());
+            LOG_INFO << "未找到路由，返回404";
+            resp->setStatusCode(HttpResponse::k404NotFound);
+            resp->setStatusMessage("Not Found");
+            resp->setCloseConnection(true);
+        }
+
+        // ★ SSE 升级后跳过后置中间件（响应已由 handler 直接写到连接上）；
+        //   ResponseStream 的头部还没发出，照常经过后置中间件；延迟完成的响应等完成后再执行
+        if (resp->isSseUpgraded() || resp->isDeferred())
+        {
+            return;
+        }
+
+        // 处理响应后的中间件
+        middlewareChain_.processAfter(req, *resp);
+    }
+    catch (const HttpResponse& res) 
+    {
+        // 处理中间件抛出的响应（如CORS预检请求）
+        *resp = res;
+    }
+    catch (const std::exception& e) 
     {
         // 错误处理
         resp->setStatusCode(HttpResponse::k500InternalServerError);
@@ -219,4 +1827,357 @@ void HttpServer::handleRequest(const muduo::net::TcpConnectionPtr &conn,
     }
 }
 
+void HttpServer::onUringConnection(const UringConnectionPtr &conn)
+{
+    if (conn->connected())
+    {
+        if (!admission_.acquireConnection(conn->peerAddress()))
+        {
+            // 不挂 HttpContext，之后到达的数据直接丢弃
+            LOG_DEBUG << "Too many connections (" << admission_.connections() << "), reject "
+                      << conn->peerAddress().toIpPort();
+            muduo::net::Buffer output;
+            appendOverloadResponse(&output, admission_.limits().retryAfter);
+            conn->send(&output);
+            conn->shutdown();
+            std::weak_ptr<UringConnection> weakConn(conn);
+            conn->getLoop()->runAfter(1.0, [weakConn]()
+            {
+                if (UringConnectionPtr c = weakConn.lock())
+                {
+                    c->forceClose();
+                }
+            });
+            return;
+        }
+        auto context = std::make_shared<HttpContext>(limits_);
+        std::weak_ptr<UringConnection> weakConn(conn);
+        context->timer().setCallback(std::bind(&HttpServer::onUringTimeout, this, weakConn));
+        conn->setContext(context);
+        armTimeout(context.get(), 0);
+    }
+    else if (HttpContext *context = contextOf(conn))
+    {
+        context->timer().cancel();
+        endRequest(context);
+        admission_.releaseConnection(conn->peerAddress());
+    }
+}
+
+void HttpServer::processUringInput(const UringConnectionPtr &conn,
+                                   muduo::net::Buffer *buf,
+                                   muduo::Timestamp receiveTime)
+{
+    // 被准入控制拒绝的连接，或已经决定关闭的连接
+    HttpContext *context = contextOf(conn);
+    if (!context || !conn->connected())
+    {
+        buf->retrieveAll();
+        return;
+    }
+    try
+    {
+        if (context->suspended())
+        {
+            if (buf->readableBytes() > limits_.maxHeaderBytes)
+            {
+                LOG_WARN << "Too much pipelined data behind a request, close " << conn->peerAddress().toIpPort();
+                conn->forceClose();
+            }
+            return;
+        }
+
+        muduo::net::Buffer *output = context->outputBuffer();
+        RequestResult result = kContinue;
+        while (result == kContinue && buf->readableBytes() > 0)
+        {
+            if (!context->parseRequest(buf, receiveTime))
+            {
+                appendErrorResponse(output, context->errorCode());
+                endRequest(context);
+                result = kClose;
+                break;
+            }
+            if (context->gotHeaders())
+            {
+                HttpRequest &req = context->request();
+                router::Router::HandlerPtr handler;
+                router_.findRoute(req, &handler);
+                // 要用到连接的路由交给 epoll；100-continue 的检查也在那边做，
+                // 请求头留在 context 里，交接之后从 onHeaders 接着处理
+                if ((handler && handler->needsConnection()) ||
+                    (!req.getHeader(HttpHeaders::kExpect).empty() && context->hasBody()))
+                {
+                    result = kHandOver;
+                    break;
+                }
+                context->setOffload(handler && handler->offload());
+                if (const char *overload = admitRequest(context))
+                {
+                    LOG_DEBUG << "Overloaded (" << overload << "), reject " << conn->peerAddress().toIpPort();
+                    result = kClose;
+                    break;
+                }
+                if (handler)
+                {
+                    req.setBodySink(handler->createBodySink(muduo::net::TcpConnectionPtr(), req));
+                }
+                if (!context->startBody())
+                {
+                    appendErrorResponse(output, context->errorCode());
+                    endRequest(context);
+                    result = kClose;
+                    break;
+                }
+                if (!context->gotAll())
+                {
+                    continue;
+                }
+            }
+            if (!context->gotAll())
+            {
+                break;
+            }
+
+            // 这里的 handler 不会直接往连接上写，攒下的响应不用提前发
+            result = onUringRequest(conn, context);
+            if (result == kContinue || result == kClose)
+            {
+                endRequest(context);
+            }
+            context->reset();
+        }
+
+        // send 把 output 整个换给连接，和同一批完成事件里其他连接的发送一起提交
+        if (output->readableBytes() > 0)
+        {
+            conn->send(output);
+        }
+        if (output->internalCapacity() > kMaxRetainedOutputCapacity)
+        {
+            output->shrink(0);
+        }
+        if (result == kClose)
+        {
+            conn->shutdown();
+            scheduleTimeout(context, HttpContext::kIdleTimeout);
+        }
+        else if (result == kUpgraded)
+        {
+            context->timer().cancel();
+        }
+        else if (result == kHandOver)
+        {
+            // 交接完成之前不计超时，交接之后由 epoll 那边重新安排
+            context->timer().cancel();
+            conn->detach(std::bind(&HttpServer::adoptConnection, this,
+                                   boost::any_cast<std::shared_ptr<HttpContext>>(conn->getContext()),
+                                   conn->getLoop(),
+                                   conn->peerAddress(),
+                                   std::placeholders::_1,
+                                   std::placeholders::_2,
+                                   std::placeholders::_3));
+        }
+        else
+        {
+            armTimeout(context, buf->readableBytes());
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "Exception in onMessage: " << e.what();
+        muduo::net::Buffer output;
+        output.append("HTTP/1.1 400 Bad Request\r\n\r\n");
+        conn->send(&output);
+        conn->shutdown();
+    }
+}
+
+HttpServer::RequestResult HttpServer::onUringRequest(const UringConnectionPtr &conn, HttpContext *context)
+{
+    HttpRequest &req = context->request();
+    bool close = closeAfter(req);
+
+    if (context->offload() && workerPool_)
+    {
+        return offloadUringRequest(conn, context, close);
+    }
+
+    HttpResponse &response = context->response();
+    response.reset(close);
+    response.setVersion(req.getVersion().empty() ? "HTTP/1.1" : req.getVersion());
+    handleRequest(muduo::net::TcpConnectionPtr(), req, &response, context->beforeMiddlewareDone());
+    return sendUringResponse(context, req, response);
+}
+
+HttpServer::RequestResult HttpServer::sendUringResponse(HttpContext *context,
+                                                        const HttpRequest &req,
+                                                        HttpResponse &response)
+{
+    if (response.isSseUpgraded() || response.isDeferred() || response.isStreaming())
+    {
+        // 没有连接可以交给 ResponseStream 等，这样的 handler 要让 needsConnection() 返回 true
+        LOG_ERROR << "Handler of " << std::string(req.path()) << " needs the connection";
+        response.reset(true);
+        response.setVersion("HTTP/1.1");
+        response.setStatusCode(HttpResponse::k500InternalServerError);
+    }
+    if (req.method() == HttpRequest::kHead)
+    {
+        response.discardBody();
+    }
+    // 大的响应体也整份拷进输出缓冲区，发送完成之前它要一直有效
+    response.appendToBuffer(context->outputBuffer());
+    return response.closeConnection() ? kClose : kContinue;
+}
+
+HttpServer::RequestResult HttpServer::offloadUringRequest(const UringConnectionPtr &conn,
+                                                          HttpContext *context,
+                                                          bool close)
+{
+    auto req = std::make_shared<HttpRequest>();
+    req->swap(context->request());
+    req->detachBody();
+    auto resp = std::make_shared<HttpResponse>(close);
+    resp->setVersion(req->getVersion().empty() ? "HTTP/1.1" : req->getVersion());
+    bool beforeDone = context->beforeMiddlewareDone();
+
+    bool queued = workerPool_->tryRun([this, conn, req, resp, beforeDone]()
+    {
+        handleRequest(muduo::net::TcpConnectionPtr(), *req, resp.get(), beforeDone);
+        conn->getLoop()->runInLoop(std::bind(&HttpServer::onUringOffloadComplete, this, conn, req, resp));
+    });
+    if (!queued)
+    {
+        LOG_WARN << "Worker queue is full (" << workerPool_->queueSize() << "), reject "
+                 << conn->peerAddress().toIpPort();
+        context->request().swap(*req);
+        HttpResponse &response = context->response();
+        response.reset(close);
+        response.setVersion(context->request().getVersion().empty() ? "HTTP/1.1"
+                                                                    : context->request().getVersion());
+        response.setStatusCode(HttpResponse::k503ServiceUnavailable);
+        response.addHeader(HttpHeaders::kRetryAfter, std::to_string(admission_.limits().retryAfter));
+        return sendUringResponse(context, context->request(), response);
+    }
+
+    context->setSuspended(true);
+    return kUpgraded;
+}
+
+void HttpServer::onUringOffloadComplete(const UringConnectionPtr &conn,
+                                        const std::shared_ptr<HttpRequest> &req,
+                                        const std::shared_ptr<HttpResponse> &resp)
+{
+    if (!conn->connected())
+    {
+        return;
+    }
+    HttpContext *context = contextOf(conn);
+    muduo::net::Buffer *output = context->outputBuffer();
+    RequestResult result = sendUringResponse(context, *req, *resp);
+    conn->send(output);
+
+    req->reset();
+    context->request().swap(*req);
+    resumeUring(conn, result == kClose);
+}
+
+void HttpServer::resumeUring(const UringConnectionPtr &conn, bool close)
+{
+    HttpContext *context = contextOf(conn);
+    context->setSuspended(false);
+    endRequest(context);
+    if (close || draining())
+    {
+        conn->shutdown();
+        scheduleTimeout(context, HttpContext::kIdleTimeout);
+        return;
+    }
+    processUringInput(conn, conn->inputBuffer(), muduo::Timestamp::now());
+}
+
+void HttpServer::onUringTimeout(const std::weak_ptr<UringConnection> &weakConn)
+{
+    UringConnectionPtr conn = weakConn.lock();
+    HttpContext *context = conn ? contextOf(conn) : nullptr;
+    if (!context)
+    {
+        return;
+    }
+
+    if (context->timeoutKind() == HttpContext::kIdleTimeout)
+    {
+        // 大响应还没写完（对方读得慢），继续等；已经半关闭的连接到期直接关掉
+        if (conn->connected() && conn->pendingBytes() > 0)
+        {
+            scheduleTimeout(context, HttpContext::kIdleTimeout);
+            return;
+        }
+        LOG_DEBUG << "Idle timeout, close connection " << conn->peerAddress().toIpPort();
+        conn->forceClose();
+        return;
+    }
+    if (!conn->connected())
+    {
+        return;
+    }
+
+    // 请求头/请求体没有按时收完：回 408 后关闭连接，对方不关的由空闲超时强制关闭
+    LOG_INFO << "Request timeout from " << conn->peerAddress().toIpPort();
+    muduo::net::Buffer *output = context->outputBuffer();
+    appendErrorResponse(output, HttpResponse::k408RequestTimeout);
+    conn->send(output);
+    conn->shutdown();
+    scheduleTimeout(context, HttpContext::kIdleTimeout);
+}
+
+void HttpServer::adoptConnection(const std::shared_ptr<HttpContext> &context,
+                                 muduo::net::EventLoop *loop,
+                                 const muduo::net::InetAddress &peer,
+                                 int fd,
+                                 muduo::net::Buffer *input,
+                                 muduo::net::Buffer *output)
+{
+    struct sockaddr_in6 local = {};
+    socklen_t len = sizeof local;
+    if (::getsockname(fd, reinterpret_cast<struct sockaddr*>(&local), &len) != 0)
+    {
+        LOG_SYSERR << "getsockname";
+    }
+    std::string name = server_.name() + "-" + peer.toIpPort() + "#uring" + std::to_string(fd);
+    auto conn = std::make_shared<muduo::net::TcpConnection>(loop, name, fd, muduo::net::InetAddress(local), peer);
+    conn->setContext(context);
+    std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+    context->timer().setCallback(std::bind(&HttpServer::onTimeout, this, weakConn));
+    // 准入在 io_uring 那边已经做过，建立时不再经过 onConnection，断开时照常释放
+    conn->setConnectionCallback([this](const muduo::net::TcpConnectionPtr &c)
+    {
+        if (!c->connected())
+        {
+            onConnection(c);
+        }
+    });
+    conn->setMessageCallback(
+        std::bind(&HttpServer::onMessage, this,
+                  std::placeholders::_1,
+                  std::placeholders::_2,
+                  std::placeholders::_3));
+    // 和 TcpServer::removeConnection() 一样，等本轮事件处理完再从 loop 里摘掉
+    conn->setCloseCallback([](const muduo::net::TcpConnectionPtr &c)
+    {
+        c->getLoop()->queueInLoop(std::bind(&muduo::net::TcpConnection::connectDestroyed, c));
+    });
+    t_connections.insert(conn);
+    conn->connectEstablished();
+
+    // 在 io_uring 上还没发完的响应先发，再从交接时停下的请求接着处理
+    if (output->readableBytes() > 0)
+    {
+        conn->send(output);
+    }
+    conn->inputBuffer()->swap(*input);
+    processInput(conn, conn->inputBuffer(), muduo::Timestamp::now());
+}
+
 } // namespace http
@@ -0,0 +1,139 @@
+#include "../../include/http/HttpTokenizer.h"
+
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace http
+{
+namespace tokenizer
+{
+
+namespace
+{
+
+inline unsigned countTrailingZeros(uint32_t mask)
+{
+    return static_cast<unsigned>(__builtin_ctz(mask));
+}
+
+} // namespace
+
+const char* findByte(const char* begin, const char* end, char c)
+{
+    const char* p = begin;
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(c);
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask != 0)
+        {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle16 = _mm_set1_epi8(c);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle16)));
+        if (mask != 0)
+        {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+#endif
+    // 尾部（或非 x86 平台）交给 memchr
+    const void* hit = p < end ? std::memchr(p, c, static_cast<size_t>(end - p)) : nullptr;
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+const char* findEither(const char* begin, const char* end, char a, char b)
+{
+    const char* p = begin;
+#if defined(__AVX2__)
+    const __m256i needleA = _mm256_set1_epi8(a);
+    const __m256i needleB = _mm256_set1_epi8(b);
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, needleA),
+                                     _mm256_cmpeq_epi8(chunk, needleB));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        if (mask != 0)
+        {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+#endif
+#if defined(__SSE4_2__)
+    // pcmpestri 一条指令完成“等于集合中任意一个字符”的比较
+    const char set[16] = { a, b };
+    const __m128i needles = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set));
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int idx = _mm_cmpestri(needles, 2, chunk, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16)
+        {
+            return p + idx;
+        }
+        p += 16;
+    }
+#elif defined(__SSE2__)
+    const __m128i needleA16 = _mm_set1_epi8(a);
+    const __m128i needleB16 = _mm_set1_epi8(b);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(chunk, needleA16),
+                                  _mm_cmpeq_epi8(chunk, needleB16));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        if (mask != 0)
+        {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p)
+    {
+        if (*p == a || *p == b)
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+const char* findCRLF(const char* begin, const char* end)
+{
+    // 先向量化地找 '\r'，再确认后面紧跟 '\n'
+    const char* p = begin;
+    while (p < end)
+    {
+        p = findByte(p, end, '\r');
+        if (p + 1 >= end)
+        {
+            return nullptr;
+        }
+        if (p[1] == '\n')
+        {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+} // namespace tokenizer
+} // namespace http
@@ -0,0 +1,392 @@
+#include "../../include/http/IoUring.h"
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+namespace
+{
+int ioUringSetup(unsigned entries, struct io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+// multishot recv 是 6.0 加入的，其余用到的特性（multishot accept、IOSQE_CQE_SKIP_SUCCESS）更早
+bool kernelAtLeast(int major, int minor)
+{
+    struct utsname name;
+    int kernelMajor = 0;
+    int kernelMinor = 0;
+    if (::uname(&name) != 0 || std::sscanf(name.release, "%d.%d", &kernelMajor, &kernelMinor) != 2)
+    {
+        return false;
+    }
+    return kernelMajor > major || (kernelMajor == major && kernelMinor >= minor);
+}
+
+void* mapRegion(int fd, size_t size, off_t offset)
+{
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+} // namespace
+
+IoUring::IoUring(unsigned entries, unsigned bufferCount, size_t bufferSize)
+    : ringFd_(-1)
+    , sqRing_(nullptr)
+    , sqRingSize_(0)
+    , cqRing_(nullptr)
+    , cqRingSize_(0)
+    , sqes_(nullptr)
+    , sqesSize_(0)
+    , sqHead_(nullptr)
+    , sqTail_(nullptr)
+    , sqMask_(0)
+    , sqEntries_(0)
+    , cqHead_(nullptr)
+    , cqTail_(nullptr)
+    , cqMask_(0)
+    , cqes_(nullptr)
+    , sqeTail_(0)
+    , submitted_(0)
+    , bufCount_(bufferCount)
+    , bufferSize_(bufferSize)
+    , buffers_(nullptr)
+{
+    if (!setupRing(entries) || !setupBuffers())
+    {
+        LOG_SYSERR << "IoUring setup failed";
+        if (ringFd_ >= 0)
+        {
+            ::close(ringFd_);
+            ringFd_ = -1;
+        }
+    }
+}
+
+IoUring::~IoUring()
+{
+    // 先关环：内核取消所有还没完成的请求，之后才能释放它们引用的内存
+    if (ringFd_ >= 0)
+    {
+        ::close(ringFd_);
+    }
+    if (buffers_)
+    {
+        ::munmap(buffers_, bufCount_ * bufferSize_);
+    }
+    if (sqes_)
+    {
+        ::munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ && cqRing_ != sqRing_)
+    {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_)
+    {
+        ::munmap(sqRing_, sqRingSize_);
+    }
+}
+
+bool IoUring::supported()
+{
+    if (!kernelAtLeast(6, 0))
+    {
+        return false;
+    }
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof params);
+    int fd = ioUringSetup(4, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const uint8_t opcodes[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND,
+                                IORING_OP_ASYNC_CANCEL, IORING_OP_PROVIDE_BUFFERS };
+    size_t probeSize = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    std::vector<char> storage(probeSize, 0);
+    struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(storage.data());
+    bool ok = (params.features & IORING_FEAT_NODROP) &&
+              ioUringRegister(fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (uint8_t op : opcodes)
+    {
+        ok = ok && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+    ::close(fd);
+    return ok;
+}
+
+bool IoUring::setupRing(unsigned entries)
+{
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof params);
+    // 完成事件的收尾工作等本线程下一次进入内核时再做，不用 IPI 打断正在处理请求的线程；
+    // 睡在 epoll_wait 里时照样会被唤醒（返回 EINTR，muduo 忽略后重新等待）
+    params.flags = IORING_SETUP_CLAMP | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    ringFd_ = ioUringSetup(entries, &params);
+    if (ringFd_ < 0)
+    {
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+    sqRing_ = mapRegion(ringFd_, sqRingSize_, IORING_OFF_SQ_RING);
+    if (!sqRing_)
+    {
+        return false;
+    }
+    cqRing_ = (params.features & IORING_FEAT_SINGLE_MMAP) ? sqRing_
+                                                          : mapRegion(ringFd_, cqRingSize_, IORING_OFF_CQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe*>(mapRegion(ringFd_, sqesSize_, IORING_OFF_SQES));
+    if (!cqRing_ || !sqes_)
+    {
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqRing_);
+    char* cq = static_cast<char*>(cqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // SQE 总是按顺序取用，索引数组固定为恒等映射，提交时只需移动 tail
+    unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries_; ++i)
+    {
+        array[i] = i;
+    }
+    sqeTail_ = submitted_ = *sqTail_;
+    return true;
+}
+
+bool IoUring::setupBuffers()
+{
+    void* buffers = ::mmap(nullptr, bufCount_ * bufferSize_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    buffers_ = buffers == MAP_FAILED ? nullptr : static_cast<char*>(buffers);
+    if (!buffers_)
+    {
+        return false;
+    }
+    struct io_uring_sqe* sqe = getSqe();
+    prepProvideBuffers(sqe, buffers_, static_cast<unsigned>(bufferSize_), bufCount_, 0);
+    // 第一次交给内核的结果在这里等着确认，之后的归还成功时都不产生 CQE
+    sqe->flags = 0;
+    struct io_uring_cqe result;
+    std::memset(&result, 0, sizeof result);
+    result.res = -EIO;
+    if (submitAndWait(1) < 0)
+    {
+        return false;
+    }
+    forEachCqe([&result](const struct io_uring_cqe* cqe) { result = *cqe; });
+    if (result.res < 0)
+    {
+        errno = -result.res;
+        return false;
+    }
+    return true;
+}
+
+struct io_uring_sqe* IoUring::getSqe()
+{
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqeTail_ - head >= sqEntries_)
+    {
+        submit();
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (sqeTail_ - head >= sqEntries_)
+        {
+            return nullptr;
+        }
+    }
+    struct io_uring_sqe* sqe = &sqes_[sqeTail_ & sqMask_];
+    ++sqeTail_;
+    std::memset(sqe, 0, sizeof *sqe);
+    return sqe;
+}
+
+int IoUring::submit()
+{
+    unsigned toSubmit = sqeTail_ - submitted_;
+    if (toSubmit == 0)
+    {
+        return 0;
+    }
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    int ret;
+    do
+    {
+        ret = ioUringEnter(ringFd_, toSubmit, 0, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0)
+    {
+        // EAGAIN/EBUSY：内核暂时收不下，SQE 还留在环里，下次提交时一起补上
+        if (errno != EAGAIN && errno != EBUSY)
+        {
+            LOG_SYSERR << "io_uring_enter";
+        }
+        return -1;
+    }
+    submitted_ += static_cast<unsigned>(ret);
+    return ret;
+}
+
+int IoUring::submitAndWait(unsigned minComplete)
+{
+    unsigned toSubmit = sqeTail_ - submitted_;
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    int ret;
+    do
+    {
+        ret = ioUringEnter(ringFd_, toSubmit, minComplete, IORING_ENTER_GETEVENTS);
+    } while (ret < 0 && errno == EINTR);
+    if (ret > 0)
+    {
+        submitted_ += static_cast<unsigned>(ret);
+    }
+    return ret;
+}
+
+unsigned IoUring::forEachCqe(const std::function<void (const struct io_uring_cqe*)>& fn)
+{
+    unsigned count = 0;
+    unsigned head = *cqHead_;
+    for (;;)
+    {
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        if (head == tail)
+        {
+            break;
+        }
+        // 回调之前先把槽位还给内核：回调里提交的请求可能立即完成，CQ 不会因此溢出
+        struct io_uring_cqe cqe = cqes_[head & cqMask_];
+        ++head;
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        fn(&cqe);
+        ++count;
+    }
+    return count;
+}
+
+void IoUring::recycleBuffer(uint16_t bid)
+{
+    // 和其他请求一起在下一次 submit() 时交给内核，不单独进入内核
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe)
+    {
+        unreturned_.push_back(bid);
+        return;
+    }
+    prepProvideBuffers(sqe, buffer(bid), static_cast<unsigned>(bufferSize_), 1, bid);
+}
+
+size_t IoUring::returnBuffers()
+{
+    while (!unreturned_.empty())
+    {
+        struct io_uring_sqe* sqe = getSqe();
+        if (!sqe)
+        {
+            break;
+        }
+        prepProvideBuffers(sqe, buffer(unreturned_.back()), static_cast<unsigned>(bufferSize_), 1,
+                           unreturned_.back());
+        unreturned_.pop_back();
+    }
+    return unreturned_.size();
+}
+
+void IoUring::prepProvideBuffers(struct io_uring_sqe* sqe, char* addr, unsigned len, unsigned count,
+                                 uint16_t firstBid)
+{
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->len = len;
+    sqe->off = firstBid;
+    sqe->buf_group = kBufferGroup;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+}
+
+void IoUring::prepAcceptMultishot(struct io_uring_sqe* sqe, int fd, uint64_t userData)
+{
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepRecvMultishot(struct io_uring_sqe* sqe, int fd, uint64_t userData)
+{
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepSend(struct io_uring_sqe* sqe, int fd, const void* data, size_t len, uint64_t userData)
+{
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepCancel(struct io_uring_sqe* sqe, uint64_t target, uint64_t userData)
+{
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepCancelAll(struct io_uring_sqe* sqe, uint64_t userData)
+{
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = userData;
+}
+
+} // namespace http
@@ -0,0 +1,46 @@
+#include "../../include/http/ListenerDrain.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+
+namespace http
+{
+
+ListenerDrain::ListenerDrain(std::vector<int> fds, QueueLength queueLength, Close close)
+    : fds_(std::move(fds))
+    , queueLength_(std::move(queueLength))
+    , close_(std::move(close))
+{
+}
+
+size_t ListenerDrain::poll(bool force)
+{
+    auto open = std::partition(fds_.begin(), fds_.end(), [this, force](int fd)
+    {
+        return !force && queueLength_(fd) > 0;
+    });
+    size_t closed = static_cast<size_t>(fds_.end() - open);
+    for (auto it = open; it != fds_.end(); ++it)
+    {
+        close_(*it);
+    }
+    fds_.erase(open, fds_.end());
+    return closed;
+}
+
+int ListenerDrain::acceptQueueLength(int fd)
+{
+    // 监听 socket 上 tcpi_unacked 是当前 accept 队列的长度，tcpi_sacked 是 backlog 上限
+    struct tcp_info info;
+    socklen_t len = sizeof info;
+    if (::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0)
+    {
+        return -1;
+    }
+    return static_cast<int>(info.tcpi_unacked);
+}
+
+} // namespace http
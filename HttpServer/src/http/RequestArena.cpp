@@ -0,0 +1,47 @@
+#include "../../include/http/RequestArena.h"
+
+namespace http
+{
+
+char* RequestArena::allocateSlow(size_t n)
+{
+    // 先看后面有没有上一轮请求留下、足够大的块
+    while (current_ + 1 < blocks_.size())
+    {
+        ++current_;
+        used_ = 0;
+        if (blocks_[current_].size >= n)
+        {
+            used_ = n;
+            return blocks_[current_].data.get();
+        }
+    }
+
+    // 超过常规块大小的请求（比如很长的 Cookie）单独分配一块
+    size_t size = n > blockSize_ ? n : blockSize_;
+    blocks_.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+    current_ = blocks_.size() - 1;
+    used_ = n;
+    return blocks_[current_].data.get();
+}
+
+void RequestArena::reset()
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < blocks_.size(); ++i)
+    {
+        if (blocks_[i].size <= blockSize_)
+        {
+            if (kept != i)
+            {
+                blocks_[kept] = std::move(blocks_[i]);
+            }
+            ++kept;
+        }
+    }
+    blocks_.resize(kept);
+    current_ = 0;
+    used_ = 0;
+}
+
+} // namespace http
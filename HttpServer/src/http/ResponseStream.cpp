@@ -0,0 +1,472 @@
+#include "../../include/http/ResponseStream.h"
+#include "../../include/http/HttpContext.h"
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+namespace
+{
+
+// muduo 默认的高水位，流结束后恢复
+const size_t kConnectionHighWaterMark = 64 * 1024 * 1024;
+
+// 按 '\n' 拆行（兼容 "\r\n"），对每一行调用 f
+template <typename F>
+void forEachLine(std::string_view data, F f)
+{
+    size_t start = 0;
+    while (true)
+    {
+        size_t end = data.find('\n', start);
+        std::string_view line = data.substr(start, end == std::string_view::npos ? std::string_view::npos
+                                                                                 : end - start);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        f(line);
+        if (end == std::string_view::npos)
+        {
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+} // namespace
+
+std::shared_ptr<ResponseStream> ResponseStream::start(const muduo::net::TcpConnectionPtr& conn,
+                                                      const HttpRequest& req,
+                                                      HttpResponse* resp)
+{
+    // HTTP/2 本身分帧：响应体直接作为 DATA 帧发送，不用 chunked，结束时也不关闭连接
+    int32_t streamId = req.streamId();
+    bool chunked = streamId == 0 && req.getVersion() == "HTTP/1.1";
+    std::shared_ptr<ResponseStream> stream(new ResponseStream(conn, chunked, streamId));
+    if (resp->getStatusCode() == HttpResponse::kUnknown)
+    {
+        resp->setStatusCode(HttpResponse::k200Ok);
+    }
+    if (chunked)
+    {
+        resp->addHeader(HttpHeaders::kTransferEncoding, "chunked");
+    }
+    else if (streamId == 0)
+    {
+        resp->setCloseConnection(true);
+    }
+    if (req.method() == HttpRequest::kHead)
+    {
+        // HEAD 只发头部：流一开始就是结束状态，生产者的写入都返回 false，也不写 chunked 结束块
+        stream->finished_ = true;
+    }
+    resp->setStream(stream);
+    return stream;
+}
+
+ResponseStream::ResponseStream(const muduo::net::TcpConnectionPtr& conn, bool chunked, int32_t streamId)
+    : conn_(conn)
+    , chunked_(chunked)
+    , streamId_(streamId)
+    , highWaterMark_(kDefaultHighWaterMark)
+    , maxBufferedBytes_(kDefaultMaxBufferedBytes)
+    , opened_(false)
+    , flushScheduled_(false)
+    , finished_(false)
+    , aborted_(false)
+    , completed_(false)
+    , paused_(false)
+{
+}
+
+void ResponseStream::appendChunkLocked(std::string_view data)
+{
+    if (chunked_)
+    {
+        char header[24];
+        int n = snprintf(header, sizeof header, "%zx\r\n", data.size());
+        pending_.append(header, n);
+        pending_.append(data.data(), data.size());
+        pending_.append("\r\n", 2);
+    }
+    else
+    {
+        pending_.append(data.data(), data.size());
+    }
+}
+
+bool ResponseStream::write(std::string_view data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_ || aborted_)
+    {
+        return false;
+    }
+    // 长度为 0 的块在 chunked 编码里表示结束，不能写出去
+    if (!data.empty())
+    {
+        appendChunkLocked(data);
+    }
+    return scheduleFlushLocked();
+}
+
+bool ResponseStream::sendEvent(std::string_view data, std::string_view event, std::string_view id)
+{
+    static const std::string_view kEvent = "event: ";
+    static const std::string_view kId = "id: ";
+    static const std::string_view kData = "data: ";
+
+    // 一个事件作为一个 chunk：先算出长度，再逐段追加，不拼接临时字符串
+    size_t size = 1; // 事件末尾的空行
+    if (!event.empty())
+    {
+        size += kEvent.size() + event.size() + 1;
+    }
+    if (!id.empty())
+    {
+        size += kId.size() + id.size() + 1;
+    }
+    forEachLine(data, [&](std::string_view line) { size += kData.size() + line.size() + 1; });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_ || aborted_)
+    {
+        return false;
+    }
+    if (chunked_)
+    {
+        char header[24];
+        int n = snprintf(header, sizeof header, "%zx\r\n", size);
+        pending_.append(header, n);
+    }
+    if (!event.empty())
+    {
+        pending_.append(kEvent.data(), kEvent.size());
+        pending_.append(event.data(), event.size());
+        pending_.append("\n", 1);
+    }
+    if (!id.empty())
+    {
+        pending_.append(kId.data(), kId.size());
+        pending_.append(id.data(), id.size());
+        pending_.append("\n", 1);
+    }
+    forEachLine(data, [this](std::string_view line)
+    {
+        pending_.append(kData.data(), kData.size());
+        pending_.append(line.data(), line.size());
+        pending_.append("\n", 1);
+    });
+    pending_.append("\n", 1);
+    if (chunked_)
+    {
+        pending_.append("\r\n", 2);
+    }
+    return scheduleFlushLocked();
+}
+
+bool ResponseStream::sendComment(std::string_view text)
+{
+    std::string line;
+    line.reserve(text.size() + 4);
+    line.append(": ").append(text.data(), text.size()).append("\n\n");
+    return write(line);
+}
+
+void ResponseStream::finish()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_ || aborted_)
+    {
+        return;
+    }
+    finished_ = true;
+    if (chunked_)
+    {
+        pending_.append("0\r\n\r\n", 5);
+    }
+    scheduleFlushLocked();
+}
+
+void ResponseStream::abort()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (aborted_ || completed_)
+    {
+        return;
+    }
+    aborted_ = true;
+    pending_.retrieveAll();
+    if (opened_)
+    {
+        conn_->getLoop()->queueInLoop(std::bind(&ResponseStream::abortInLoop, shared_from_this()));
+    }
+}
+
+bool ResponseStream::writable() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !finished_ && !aborted_ && !paused_ &&
+           pending_.readableBytes() < highWaterMark_ && conn_->connected();
+}
+
+bool ResponseStream::closed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_ || aborted_ || !conn_->connected();
+}
+
+void ResponseStream::setWritableCallback(Callback cb)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    writableCallback_ = std::move(cb);
+}
+
+bool ResponseStream::scheduleFlushLocked()
+{
+    if (pending_.readableBytes() > maxBufferedBytes_)
+    {
+        // 生产者不理会背压：放弃这个流，免得积压无限增长
+        LOG_WARN << "ResponseStream " << conn_->name() << " exceeds "
+                 << maxBufferedBytes_ << " buffered bytes, abort";
+        aborted_ = true;
+        pending_.retrieveAll();
+        if (opened_)
+        {
+            conn_->getLoop()->queueInLoop(std::bind(&ResponseStream::abortInLoop, shared_from_this()));
+        }
+        return false;
+    }
+
+    // 响应头发出之前只缓存，由 open() 统一发送
+    if (opened_ && !flushScheduled_)
+    {
+        flushScheduled_ = true;
+        conn_->getLoop()->queueInLoop(std::bind(&ResponseStream::flushInLoop, shared_from_this()));
+    }
+    return !finished_ && !paused_ && pending_.readableBytes() < highWaterMark_;
+}
+
+void ResponseStream::open(Callback onComplete)
+{
+    conn_->getLoop()->assertInLoopThread();
+    onComplete_ = std::move(onComplete);
+
+    std::weak_ptr<ResponseStream> weakSelf(shared_from_this());
+    if (streamId_ > 0)
+    {
+        // 连接由多个流共用，它的高水位、write complete 回调归 Http2Session，这里只看自己这个流
+        if (Http2Session* session = http2Session())
+        {
+            session->observeStream(streamId_,
+                [weakSelf]()
+                {
+                    if (auto self = weakSelf.lock())
+                    {
+                        self->onWriteComplete();
+                    }
+                },
+                [weakSelf]()
+                {
+                    if (auto self = weakSelf.lock())
+                    {
+                        self->onStreamClosed();
+                    }
+                });
+        }
+    }
+    else
+    {
+        conn_->setHighWaterMarkCallback(
+            [weakSelf](const muduo::net::TcpConnectionPtr&, size_t)
+            {
+                if (auto self = weakSelf.lock())
+                {
+                    self->onHighWaterMark();
+                }
+            },
+            highWaterMark_);
+        conn_->setWriteCompleteCallback(
+            [weakSelf](const muduo::net::TcpConnectionPtr&)
+            {
+                if (auto self = weakSelf.lock())
+                {
+                    self->onWriteComplete();
+                }
+            });
+    }
+
+    bool aborted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        opened_ = true;
+        aborted = aborted_;
+    }
+    if (aborted)
+    {
+        abortInLoop();
+    }
+    else
+    {
+        flushInLoop(); // handler 返回之前写入的数据
+    }
+}
+
+void ResponseStream::flushInLoop()
+{
+    bool done = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushScheduled_ = false;
+        if (aborted_)
+        {
+            return;
+        }
+        pending_.swap(sending_); // sending_ 在上次发送后已清空，两块缓冲区轮流使用，容量都保留
+        if (finished_ && !completed_)
+        {
+            completed_ = true;
+            done = true;
+        }
+    }
+
+    if (!conn_->connected())
+    {
+        sending_.retrieveAll();
+        return;
+    }
+    if (streamId_ > 0)
+    {
+        Http2Session* session = http2Session();
+        if (sending_.readableBytes() > 0 || done)
+        {
+            if (!session || !session->sendData(streamId_, &sending_, done))
+            {
+                onStreamClosed();
+                return;
+            }
+        }
+        size_t buffered = session ? session->bufferedBytes(streamId_) : 0;
+        if (buffered > maxBufferedBytes_)
+        {
+            LOG_WARN << "ResponseStream " << conn_->name() << " stream " << streamId_ << " peer is too slow, abort";
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                aborted_ = true;
+                pending_.retrieveAll();
+            }
+            abortInLoop();
+            return;
+        }
+        if (buffered >= highWaterMark_)
+        {
+            paused_ = true; // 对方的流量控制窗口跟不上，积压取空时（drained）恢复
+        }
+    }
+    else if (sending_.readableBytes() > 0)
+    {
+        HttpContext::send(conn_, &sending_);
+    }
+    if (streamId_ == 0 && conn_->outputBuffer()->readableBytes() > maxBufferedBytes_)
+    {
+        LOG_WARN << "ResponseStream " << conn_->name() << " peer is too slow, abort";
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            aborted_ = true;
+            pending_.retrieveAll();
+        }
+        abortInLoop();
+        return;
+    }
+    if (done)
+    {
+        detachInLoop();
+        if (onComplete_)
+        {
+            // 推迟到当前回调之后，避免在 HttpServer::onRequest 里重入
+            conn_->getLoop()->queueInLoop(std::move(onComplete_));
+            onComplete_ = nullptr;
+        }
+    }
+}
+
+void ResponseStream::abortInLoop()
+{
+    detachInLoop();
+    onComplete_ = nullptr;
+    if (streamId_ > 0)
+    {
+        // 同一连接上的其他流不受影响
+        if (Http2Session* session = http2Session())
+        {
+            session->resetStream(streamId_);
+        }
+    }
+    else if (conn_->connected())
+    {
+        conn_->forceClose();
+    }
+}
+
+void ResponseStream::detachInLoop()
+{
+    if (streamId_ > 0)
+    {
+        if (Http2Session* session = http2Session())
+        {
+            session->observeStream(streamId_, nullptr, nullptr);
+        }
+    }
+    else
+    {
+        conn_->setHighWaterMarkCallback(muduo::net::HighWaterMarkCallback(), kConnectionHighWaterMark);
+        conn_->setWriteCompleteCallback(muduo::net::WriteCompleteCallback());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    writableCallback_ = nullptr; // 生产者的回调里常常持有这个流，断开引用环
+}
+
+void ResponseStream::onHighWaterMark()
+{
+    paused_ = true;
+}
+
+void ResponseStream::onWriteComplete()
+{
+    if (!paused_.exchange(false))
+    {
+        return;
+    }
+    Callback cb;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cb = writableCallback_;
+    }
+    if (cb)
+    {
+        cb();
+    }
+}
+
+// HTTP/2 的流被对方取消（RST_STREAM）或者连接断开：和 abort() 一样，之后的写入都返回 false
+void ResponseStream::onStreamClosed()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        pending_.retrieveAll();
+    }
+    detachInLoop();
+    onComplete_ = nullptr;
+}
+
+Http2Session* ResponseStream::http2Session() const
+{
+    HttpContext* context = conn_->connected() ? HttpContext::of(conn_) : nullptr;
+    return context ? context->http2() : nullptr;
+}
+
+} // namespace http
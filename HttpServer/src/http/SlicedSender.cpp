@@ -0,0 +1,69 @@
+#include "../../include/http/SlicedSender.h"
+#include "../../include/http/HttpContext.h"
+
+#include <algorithm>
+
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+SlicedSender::SlicedSender(const muduo::net::TcpConnectionPtr& conn,
+                           std::vector<HttpResponse::BodySegment> segments)
+    : conn_(conn)
+    , segments_(std::move(segments))
+    , index_(0)
+    , offset_(0)
+{
+}
+
+void SlicedSender::start(Callback onComplete)
+{
+    muduo::net::TcpConnectionPtr conn = conn_.lock();
+    if (!conn)
+    {
+        return;
+    }
+    conn->getLoop()->assertInLoopThread();
+    onComplete_ = std::move(onComplete);
+    // 回调持有发送器，发送器只持有连接的 weak_ptr，不成环；
+    // muduo 调用 write complete 回调时用的是一份拷贝，在回调里把它换掉是安全的
+    std::shared_ptr<SlicedSender> self(shared_from_this());
+    conn->setWriteCompleteCallback([self](const muduo::net::TcpConnectionPtr&) { self->sendNext(); });
+    sendNext();
+}
+
+void SlicedSender::sendNext()
+{
+    muduo::net::TcpConnectionPtr conn = conn_.lock();
+    // TLS 加密后的一片可能分几次 send，每次都会排一个 write complete：输出缓冲区还没发空就不急着发下一片
+    if (!conn || !conn->connected() || conn->outputBuffer()->readableBytes() > 0)
+    {
+        return;
+    }
+
+    while (index_ < segments_.size() && offset_ == segments_[index_].data.size())
+    {
+        segments_[index_].owner.reset(); // 发完的段尽早释放（文件被替换时旧的映射可以解除）
+        ++index_;
+        offset_ = 0;
+    }
+    if (index_ == segments_.size())
+    {
+        conn->setWriteCompleteCallback(muduo::net::WriteCompleteCallback());
+        if (onComplete_)
+        {
+            // 推迟到当前回调之后，避免在 HttpServer::onRequest 里重入
+            conn->getLoop()->queueInLoop(std::move(onComplete_));
+            onComplete_ = nullptr;
+        }
+        return;
+    }
+
+    std::string_view data = segments_[index_].data;
+    size_t n = std::min(kSliceSize, data.size() - offset_);
+    HttpContext::send(conn, data.substr(offset_, n));
+    offset_ += n;
+}
+
+} // namespace http
@@ -0,0 +1,124 @@
+#include "../../include/http/TimingWheel.h"
+
+#include <cassert>
+
+namespace http
+{
+
+void TimingWheel::Entry::cancel()
+{
+    if (wheel_)
+    {
+        wheel_->unlink(this);
+    }
+}
+
+TimingWheel::TimingWheel(muduo::net::EventLoop *loop, size_t numSlots)
+    : loop_(loop)
+    , slots_(numSlots + 1, nullptr)
+    , current_(0)
+    , started_(false)
+{
+    assert(numSlots > 0);
+}
+
+TimingWheel::~TimingWheel()
+{
+    // 轮子和 EventLoop 同生命周期（线程退出时销毁），此时 loop 可能已经析构，不再去取消定时器。
+    // 还挂在轮子上的 Entry 全部摘下，之后它们析构时不会再访问轮子
+    for (Entry *&head : slots_)
+    {
+        while (head)
+        {
+            unlink(head);
+        }
+    }
+}
+
+void TimingWheel::start()
+{
+    loop_->assertInLoopThread();
+    if (!started_)
+    {
+        started_ = true;
+        timer_ = loop_->runEvery(1.0, std::bind(&TimingWheel::tick, this));
+    }
+}
+
+void TimingWheel::schedule(Entry *entry, int seconds)
+{
+    loop_->assertInLoopThread();
+    entry->cancel();
+
+    size_t numSlots = slots_.size() - 1;
+    size_t ticks = seconds > 0 ? static_cast<size_t>(seconds) : 1;
+    entry->rounds_ = (ticks - 1) / numSlots;
+    link(entry, (current_ + ticks) % numSlots);
+}
+
+void TimingWheel::tick()
+{
+    size_t numSlots = slots_.size() - 1;
+    current_ = (current_ + 1) % numSlots;
+
+    // 先把到期的 Entry 挪到专门的一格里再逐个触发：
+    // 回调里对别的 Entry 做 schedule/cancel（甚至析构）都不会打乱遍历
+    Entry *entry = slots_[current_];
+    while (entry)
+    {
+        Entry *next = entry->next_;
+        if (entry->rounds_ > 0)
+        {
+            --entry->rounds_;
+        }
+        else
+        {
+            unlink(entry);
+            link(entry, numSlots);
+        }
+        entry = next;
+    }
+
+    while (Entry *expired = slots_[numSlots])
+    {
+        unlink(expired);
+        if (expired->callback_)
+        {
+            expired->callback_();
+        }
+    }
+}
+
+void TimingWheel::link(Entry *entry, size_t slot)
+{
+    entry->wheel_ = this;
+    entry->slot_ = slot;
+    entry->prev_ = nullptr;
+    entry->next_ = slots_[slot];
+    if (entry->next_)
+    {
+        entry->next_->prev_ = entry;
+    }
+    slots_[slot] = entry;
+}
+
+void TimingWheel::unlink(Entry *entry)
+{
+    if (entry->prev_)
+    {
+        entry->prev_->next_ = entry->next_;
+    }
+    else
+    {
+        slots_[entry->slot_] = entry->next_;
+    }
+    if (entry->next_)
+    {
+        entry->next_->prev_ = entry->prev_;
+    }
+    entry->wheel_ = nullptr;
+    entry->prev_ = nullptr;
+    entry->next_ = nullptr;
+}
+
+} // namespace http
@@ -0,0 +1,618 @@
+#include "../../include/http/UringTransport.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+namespace
+{
+// ENOBUFS 之后隔多久重新挂 recv（秒），期间处理完的数据把缓冲区还回来
+const double kNoBufferRetry = 0.005;
+
+muduo::net::InetAddress peerAddressOf(int fd)
+{
+    struct sockaddr_in6 addr = {};
+    socklen_t len = sizeof addr;
+    if (::getpeername(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0)
+    {
+        LOG_SYSERR << "getpeername";
+    }
+    return muduo::net::InetAddress(addr);
+}
+} // namespace
+
+UringConnection::UringConnection(UringTransport* transport, int fd, const muduo::net::InetAddress& peer)
+    : transport_(transport)
+    , loop_(transport->getLoop())
+    , fd_(fd)
+    , peer_(peer)
+    , state_(kConnected)
+    , ops_(0)
+    , receiving_(false)
+    , sending_(false)
+    , queued_(false)
+    , detached_(false)
+{
+}
+
+UringConnection::~UringConnection()
+{
+    if (fd_ >= 0 && !detached_)
+    {
+        ::close(fd_);
+    }
+}
+
+void UringConnection::send(muduo::net::Buffer* buf)
+{
+    if (state_ != kConnected || !transport_)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    // 队列为空时直接交换，调用方的缓冲区换回一块空的，容量留着下次用
+    if (output_.readableBytes() == 0)
+    {
+        output_.swap(*buf);
+    }
+    else
+    {
+        output_.append(buf->peek(), buf->readableBytes());
+        buf->retrieveAll();
+    }
+    transport_->queueSend(this);
+}
+
+void UringConnection::shutdown()
+{
+    if (state_ != kConnected || !transport_)
+    {
+        return;
+    }
+    state_ = kDisconnecting;
+    transport_->queueSend(this);
+}
+
+void UringConnection::forceClose()
+{
+    if ((state_ != kConnected && state_ != kDisconnecting) || !transport_)
+    {
+        return;
+    }
+    // 和 TcpConnection::forceClose() 一样推迟到本轮回调之后，调用方手里的状态不会被关闭回调改掉
+    std::shared_ptr<UringConnection> self(shared_from_this());
+    loop_->queueInLoop([self]()
+    {
+        if (self->transport_)
+        {
+            self->transport_->closeConnection(self);
+            self->transport_->flush();
+        }
+    });
+}
+
+void UringConnection::detach(const DetachCallback& cb)
+{
+    if ((state_ != kConnected && state_ != kDisconnecting) || !transport_)
+    {
+        return;
+    }
+    state_ = kDetaching;
+    detachCallback_ = cb;
+    if (receiving_)
+    {
+        transport_->cancel(this);
+    }
+    std::shared_ptr<UringConnection> self(shared_from_this());
+    if (ops_ == 0)
+    {
+        loop_->queueInLoop([self]()
+        {
+            if (self->transport_)
+            {
+                self->transport_->release(self);
+            }
+        });
+    }
+    else if (!transport_->inBatch_)
+    {
+        transport_->flush();
+    }
+}
+
+UringTransport::UringTransport(muduo::net::EventLoop* loop, const std::string& name)
+    : loop_(loop)
+    , name_(name)
+    , ring_(kQueueDepth, kBufferCount, kBufferSize)
+    , listenFd_(-1)
+    , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    , accepting_(false)
+    , inBatch_(false)
+    , pendingOps_(0)
+    , retryScheduled_(false)
+{
+    if (ring_.valid())
+    {
+        channel_.reset(new muduo::net::Channel(loop_, ring_.fd()));
+        channel_->setReadCallback(std::bind(&UringTransport::onCompletion, this, std::placeholders::_1));
+        channel_->enableReading();
+    }
+}
+
+UringTransport::~UringTransport()
+{
+    if (retryScheduled_)
+    {
+        loop_->cancel(retryTimer_);
+    }
+    if (channel_)
+    {
+        channel_->disableAll();
+        channel_->remove();
+    }
+    accepting_ = false;
+    for (auto& entry : connections_)
+    {
+        UringConnection* conn = entry.first;
+        if (!conn->detached_)
+        {
+            // 让在途的 recv/send 立即返回
+            ::shutdown(conn->fd_, SHUT_RDWR);
+        }
+        conn->state_ = UringConnection::kClosed;
+    }
+    if (ring_.valid() && pendingOps_ > 0)
+    {
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        if (sqe)
+        {
+            IoUring::prepCancelAll(sqe, userData(nullptr, kCancel));
+            ++pendingOps_;
+        }
+        while (pendingOps_ > 0 && ring_.submitAndWait(1) >= 0)
+        {
+            ring_.forEachCqe([this](const struct io_uring_cqe* cqe)
+            {
+                if (cqe->user_data != 0 && !(cqe->flags & IORING_CQE_F_MORE))
+                {
+                    --pendingOps_;
+                }
+            });
+        }
+    }
+    for (auto& entry : connections_)
+    {
+        UringConnection* conn = entry.first;
+        if (!conn->detached_ && conn->fd_ >= 0)
+        {
+            ::close(conn->fd_);
+        }
+        conn->fd_ = -1;
+        conn->transport_ = nullptr;
+    }
+    connections_.clear();
+    if (listenFd_ >= 0)
+    {
+        ::close(listenFd_);
+    }
+    if (idleFd_ >= 0)
+    {
+        ::close(idleFd_);
+    }
+}
+
+bool UringTransport::listen(const muduo::net::InetAddress& addr)
+{
+    int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    int on = 1;
+    socklen_t len = addr.family() == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    if (fd < 0 ||
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) != 0 ||
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on) != 0 ||
+        ::bind(fd, addr.getSockAddr(), len) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        LOG_SYSERR << "UringTransport[" << name_ << "] listen on " << addr.toIpPort();
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+    listenFd_ = fd;
+    accepting_ = true;
+    armAccept();
+    flush();
+    return true;
+}
+
+void UringTransport::stopAccepting()
+{
+    if (!accepting_)
+    {
+        return;
+    }
+    accepting_ = false;
+    // 在途的 accept 引用着监听 socket，取消之后它才真正关闭
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (sqe)
+    {
+        IoUring::prepCancel(sqe, userData(nullptr, kAccept), userData(nullptr, kCancel));
+        ++pendingOps_;
+    }
+    ::close(listenFd_);
+    listenFd_ = -1;
+    if (!inBatch_)
+    {
+        flush();
+    }
+}
+
+std::vector<UringConnectionPtr> UringTransport::connections() const
+{
+    std::vector<UringConnectionPtr> result;
+    result.reserve(connections_.size());
+    for (const auto& entry : connections_)
+    {
+        if (entry.second->state_ != UringConnection::kClosed)
+        {
+            result.push_back(entry.second);
+        }
+    }
+    return result;
+}
+
+void UringTransport::onCompletion(muduo::Timestamp receiveTime)
+{
+    // 一批完成事件共用 epoll 返回的时间；处理期间产生的发送、归还缓冲区、重新 recv 最后一起提交
+    inBatch_ = true;
+    ring_.forEachCqe([this, receiveTime](const struct io_uring_cqe* cqe)
+    {
+        handleCompletion(cqe, receiveTime);
+    });
+    inBatch_ = false;
+    flush();
+}
+
+void UringTransport::handleCompletion(const struct io_uring_cqe* cqe, muduo::Timestamp now)
+{
+    if (cqe->user_data == 0)
+    {
+        // 归还缓冲区只在失败时才有 CQE
+        errno = -cqe->res;
+        LOG_SYSERR << "UringTransport[" << name_ << "] provide buffers";
+        return;
+    }
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+    if (!more)
+    {
+        --pendingOps_;
+    }
+    Op op = static_cast<Op>(cqe->user_data & 7);
+    UringConnection* raw = reinterpret_cast<UringConnection*>(cqe->user_data & ~static_cast<uint64_t>(7));
+    if (op == kAccept)
+    {
+        handleAccept(cqe);
+        return;
+    }
+    if (!raw)
+    {
+        return; // 取消 accept 的结果
+    }
+    auto it = connections_.find(raw);
+    if (it == connections_.end())
+    {
+        return;
+    }
+    UringConnectionPtr conn = it->second;
+    if (!more)
+    {
+        --conn->ops_;
+    }
+    if (op == kRecv)
+    {
+        handleRecv(conn, cqe, now);
+    }
+    else if (op == kSend)
+    {
+        handleSend(conn, cqe);
+    }
+    if (conn->ops_ == 0 &&
+        (conn->state_ == UringConnection::kClosed || conn->state_ == UringConnection::kDetaching))
+    {
+        release(conn);
+    }
+}
+
+void UringTransport::handleAccept(const struct io_uring_cqe* cqe)
+{
+    if (cqe->res >= 0)
+    {
+        int fd = cqe->res;
+        if (!accepting_)
+        {
+            ::close(fd);
+        }
+        else
+        {
+            UringConnectionPtr conn = std::make_shared<UringConnection>(this, fd, peerAddressOf(fd));
+            connections_[conn.get()] = conn;
+            armRecv(conn.get());
+            if (connectionCallback_)
+            {
+                connectionCallback_(conn);
+            }
+        }
+    }
+    else if (cqe->res == -EMFILE && accepting_)
+    {
+        // 和 muduo 的 Acceptor 一样：腾出备用的 fd 把这个连接接下来关掉，否则它一直留在队列里，
+        // accept 每次都立即失败
+        ::close(idleFd_);
+        idleFd_ = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        ::close(idleFd_);
+        idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    else if (cqe->res != -ECANCELED)
+    {
+        errno = -cqe->res;
+        LOG_SYSERR << "UringTransport[" << name_ << "] accept";
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE) && accepting_)
+    {
+        armAccept();
+    }
+}
+
+void UringTransport::handleRecv(const UringConnectionPtr& conn,
+                                const struct io_uring_cqe* cqe,
+                                muduo::Timestamp now)
+{
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+    {
+        conn->receiving_ = false;
+    }
+    if (cqe->res > 0)
+    {
+        uint16_t bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        conn->input_.append(ring_.buffer(bid), static_cast<size_t>(cqe->res));
+        ring_.recycleBuffer(bid);
+        if (conn->state_ == UringConnection::kConnected)
+        {
+            messageCallback_(conn, &conn->input_, now);
+        }
+        else if (conn->state_ != UringConnection::kDetaching)
+        {
+            conn->input_.retrieveAll(); // 已经 shutdown 的连接，等对方关闭
+        }
+    }
+    else if (cqe->res == 0 || (cqe->res != -ENOBUFS && cqe->res != -ECANCELED))
+    {
+        // 对端关闭或连接出错
+        closeConnection(conn);
+        return;
+    }
+    // 内核结束了 multishot 时重新挂上；归还的缓冲区先于它提交。
+    // 缓冲区用完（ENOBUFS）时立即重挂只会马上再收到 ENOBUFS，退避一下
+    if (!conn->receiving_ &&
+        (conn->state_ == UringConnection::kConnected || conn->state_ == UringConnection::kDisconnecting))
+    {
+        if (cqe->res == -ENOBUFS)
+        {
+            waitForBuffers(conn);
+        }
+        else
+        {
+            armRecv(conn.get());
+        }
+    }
+}
+
+void UringTransport::handleSend(const UringConnectionPtr& conn, const struct io_uring_cqe* cqe)
+{
+    conn->sending_ = false;
+    if (cqe->res < 0)
+    {
+        if (cqe->res != -ECANCELED && conn->state_ != UringConnection::kClosed)
+        {
+            errno = -cqe->res;
+            LOG_SYSERR << "UringTransport[" << name_ << "] send to " << conn->peer_.toIpPort();
+            closeConnection(conn);
+        }
+        return;
+    }
+    // 没写完的部分（对方接收窗口满时）接着发
+    conn->inflight_.retrieve(static_cast<size_t>(cqe->res));
+    startSend(conn.get());
+}
+
+void UringTransport::armAccept()
+{
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (!sqe)
+    {
+        LOG_ERROR << "UringTransport[" << name_ << "] submission queue full, accept not armed";
+        return;
+    }
+    IoUring::prepAcceptMultishot(sqe, listenFd_, userData(nullptr, kAccept));
+    ++pendingOps_;
+}
+
+void UringTransport::armRecv(UringConnection* conn)
+{
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (!sqe)
+    {
+        LOG_ERROR << "UringTransport[" << name_ << "] submission queue full, close " << conn->peer_.toIpPort();
+        conn->forceClose();
+        return;
+    }
+    IoUring::prepRecvMultishot(sqe, conn->fd_, userData(conn, kRecv));
+    conn->receiving_ = true;
+    ++conn->ops_;
+    ++pendingOps_;
+}
+
+void UringTransport::cancel(UringConnection* conn)
+{
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (sqe)
+    {
+        IoUring::prepCancel(sqe, userData(conn, kRecv), userData(conn, kCancel));
+        ++conn->ops_;
+        ++pendingOps_;
+    }
+}
+
+void UringTransport::queueSend(UringConnection* conn)
+{
+    // 有 send 在途的连接，等它完成时接着发
+    if (conn->queued_ || conn->sending_)
+    {
+        return;
+    }
+    conn->queued_ = true;
+    sendQueue_.push_back(conn->shared_from_this());
+    if (!inBatch_)
+    {
+        flush();
+    }
+}
+
+void UringTransport::startSend(UringConnection* conn)
+{
+    if (conn->sending_ ||
+        (conn->state_ != UringConnection::kConnected && conn->state_ != UringConnection::kDisconnecting))
+    {
+        return;
+    }
+    if (conn->inflight_.readableBytes() == 0)
+    {
+        conn->inflight_.swap(conn->output_);
+    }
+    if (conn->inflight_.readableBytes() == 0)
+    {
+        if (conn->state_ == UringConnection::kDisconnecting)
+        {
+            ::shutdown(conn->fd_, SHUT_WR);
+        }
+        return;
+    }
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (!sqe)
+    {
+        LOG_ERROR << "UringTransport[" << name_ << "] submission queue full, close " << conn->peer_.toIpPort();
+        conn->forceClose();
+        return;
+    }
+    IoUring::prepSend(sqe, conn->fd_, conn->inflight_.peek(), conn->inflight_.readableBytes(),
+                      userData(conn, kSend));
+    conn->sending_ = true;
+    ++conn->ops_;
+    ++pendingOps_;
+}
+
+void UringTransport::waitForBuffers(const UringConnectionPtr& conn)
+{
+    starved_.push_back(conn);
+    scheduleRetry();
+}
+
+void UringTransport::scheduleRetry()
+{
+    if (!retryScheduled_)
+    {
+        retryScheduled_ = true;
+        retryTimer_ = loop_->runAfter(kNoBufferRetry, std::bind(&UringTransport::retryRecv, this));
+    }
+}
+
+void UringTransport::retryRecv()
+{
+    retryScheduled_ = false;
+    std::vector<UringConnectionPtr> starved;
+    starved.swap(starved_);
+    for (const UringConnectionPtr& conn : starved)
+    {
+        if (!conn->receiving_ &&
+            (conn->state_ == UringConnection::kConnected || conn->state_ == UringConnection::kDisconnecting))
+        {
+            armRecv(conn.get());
+        }
+    }
+    flush();
+}
+
+void UringTransport::flush()
+{
+    for (const UringConnectionPtr& conn : sendQueue_)
+    {
+        conn->queued_ = false;
+        startSend(conn.get());
+    }
+    sendQueue_.clear();
+    // SQ 满时没能归还的接收缓冲区在这里补交，仍然交不出去的稍后再试
+    if (ring_.returnBuffers() > 0)
+    {
+        scheduleRetry();
+    }
+    if (ring_.pending() > 0)
+    {
+        ring_.submit();
+    }
+}
+
+void UringTransport::closeConnection(const UringConnectionPtr& conn)
+{
+    if (conn->state_ == UringConnection::kClosed)
+    {
+        return;
+    }
+    conn->state_ = UringConnection::kClosed;
+    // 在途的 recv/send 随之返回；fd 等它们都结束之后再关
+    ::shutdown(conn->fd_, SHUT_RDWR);
+    if (conn->receiving_)
+    {
+        cancel(conn.get());
+    }
+    if (connectionCallback_)
+    {
+        connectionCallback_(conn);
+    }
+    if (conn->ops_ == 0)
+    {
+        release(conn);
+    }
+}
+
+void UringTransport::release(const UringConnectionPtr& conn)
+{
+    if (conn->ops_ > 0 || connections_.erase(conn.get()) == 0)
+    {
+        return;
+    }
+    if (conn->state_ == UringConnection::kDetaching)
+    {
+        // 在途的 send 没写完的部分排在还没发的输出前面，一起交出去
+        conn->inflight_.append(conn->output_.peek(), conn->output_.readableBytes());
+        conn->output_.retrieveAll();
+        conn->state_ = UringConnection::kClosed;
+        conn->detached_ = true;
+        UringConnection::DetachCallback cb;
+        cb.swap(conn->detachCallback_);
+        cb(conn->fd_, &conn->input_, &conn->inflight_);
+        return;
+    }
+    ::close(conn->fd_);
+    conn->fd_ = -1;
+}
+
+} // namespace http
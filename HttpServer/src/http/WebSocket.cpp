@@ -0,0 +1,844 @@
+#include "../../include/http/WebSocket.h"
+#include "../../include/http/HttpContext.h"
+#include "../../include/http/HttpHeaders.h"
+
+#include <cstring>
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <zlib.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+namespace
+{
+
+// 握手时和 Sec-WebSocket-Key 拼接后取 SHA-1（RFC 6455 1.3）
+const char kGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// 发出的消息的压缩窗口。对方允许的上限是 15，用小窗口只是少占内存（约 48 KB/连接），
+// 聊天这类重复的 JSON 结构在几 KB 之内就能找到
+const int kDeflateWindowBits = 12;
+const int kDeflateMemLevel = 6;
+
+// 拼接分片、解压用的缓冲区超过这个容量时释放，偶尔一条大消息不长期占着内存
+const size_t kMaxRetainedCapacity = 64 * 1024;
+
+// 按 delimiter 拆开，对每一段（去掉首尾空白）调用 f，f 返回 false 时停止
+template <typename F>
+void forEachToken(std::string_view value, char delimiter, F f)
+{
+    while (!value.empty())
+    {
+        size_t end = value.find(delimiter);
+        if (!f(trim(value.substr(0, end))) || end == std::string_view::npos)
+        {
+            break;
+        }
+        value.remove_prefix(end + 1);
+    }
+}
+
+// 逗号分隔的字段值里有没有 token（Connection: keep-alive, Upgrade）
+bool hasToken(std::string_view value, std::string_view token)
+{
+    bool found = false;
+    forEachToken(value, ',', [&](std::string_view item)
+    {
+        found = equalsIgnoreCase(item, token);
+        return !found;
+    });
+    return found;
+}
+
+// permessage-deflate 协商的结果
+struct DeflateOffer
+{
+    bool valid = true;
+    bool serverNoContextTakeover = false;
+    bool clientNoContextTakeover = false;
+    int  serverMaxWindowBits = 0; // 0 表示对方没有限制
+};
+
+// 解析一个 permessage-deflate 的提议（RFC 7692 7.1），参数不认识或者不合法的提议整个放弃
+DeflateOffer parseDeflateOffer(std::string_view params)
+{
+    DeflateOffer offer;
+    forEachToken(params, ';', [&](std::string_view param)
+    {
+        size_t eq = param.find('=');
+        std::string_view name = trim(param.substr(0, eq));
+        std::string_view value = eq == std::string_view::npos ? std::string_view() : trim(param.substr(eq + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        {
+            value = value.substr(1, value.size() - 2);
+        }
+        int bits = 0;
+        if (!value.empty())
+        {
+            if (value.size() > 2 || value.find_first_not_of("0123456789") != std::string_view::npos)
+            {
+                offer.valid = false;
+                return false;
+            }
+            bits = std::atoi(std::string(value).c_str());
+        }
+        if (equalsIgnoreCase(name, "server_no_context_takeover") && value.empty())
+        {
+            offer.serverNoContextTakeover = true;
+        }
+        else if (equalsIgnoreCase(name, "client_no_context_takeover") && value.empty())
+        {
+            offer.clientNoContextTakeover = true;
+        }
+        else if (equalsIgnoreCase(name, "server_max_window_bits") && bits >= 8 && bits <= 15)
+        {
+            // zlib 的 raw deflate 不支持 8，只能拒绝这个提议
+            offer.valid = bits >= 9;
+            offer.serverMaxWindowBits = bits;
+        }
+        else if (equalsIgnoreCase(name, "client_max_window_bits") && (value.empty() || (bits >= 8 && bits <= 15)))
+        {
+            // 解压一律用最大窗口，对方用多大都能解
+        }
+        else
+        {
+            offer.valid = false;
+        }
+        return offer.valid;
+    });
+    return offer;
+}
+
+bool isValidUtf8(std::string_view s)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s.data());
+    size_t n = s.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        // ASCII 一次看 8 个字节
+        if (i + 8 <= n)
+        {
+            uint64_t chunk;
+            std::memcpy(&chunk, p + i, 8);
+            if ((chunk & 0x8080808080808080ULL) == 0)
+            {
+                i += 8;
+                continue;
+            }
+        }
+        if (p[i] < 0x80)
+        {
+            ++i;
+            continue;
+        }
+        size_t length;
+        uint32_t cp;
+        if ((p[i] & 0xE0) == 0xC0)
+        {
+            length = 2;
+            cp = p[i] & 0x1F;
+        }
+        else if ((p[i] & 0xF0) == 0xE0)
+        {
+            length = 3;
+            cp = p[i] & 0x0F;
+        }
+        else if ((p[i] & 0xF8) == 0xF0)
+        {
+            length = 4;
+            cp = p[i] & 0x07;
+        }
+        else
+        {
+            return false;
+        }
+        if (i + length > n)
+        {
+            return false;
+        }
+        for (size_t k = 1; k < length; ++k)
+        {
+            if ((p[i + k] & 0xC0) != 0x80)
+            {
+                return false;
+            }
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        // 超长编码、UTF-16 代理区、超出 Unicode 范围
+        if ((length == 2 && cp < 0x80) || (length == 3 && cp < 0x800) || (length == 4 && cp < 0x10000) ||
+            cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+// 对方可以发的关闭状态码（RFC 6455 7.4）
+bool isValidCloseCode(uint16_t code)
+{
+    return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) || (code >= 3000 && code <= 4999);
+}
+
+void unmask(const char* in, size_t length, const uint8_t* mask, char* out)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        out[i] = static_cast<char>(in[i] ^ mask[i & 3]);
+    }
+}
+
+} // namespace
+
+// 发出的消息的压缩上下文，第一次压缩时才创建
+class WebSocket::Deflater
+{
+public:
+    Deflater(int windowBits, bool noContextTakeover)
+        : noContextTakeover_(noContextTakeover)
+    {
+        stream_ = z_stream();
+        ok_ = deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -windowBits, kDeflateMemLevel,
+                           Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    ~Deflater()
+    {
+        if (ok_)
+        {
+            deflateEnd(&stream_);
+        }
+    }
+
+    // 压缩一条消息：Z_SYNC_FLUSH 之后去掉末尾的 00 00 ff ff（RFC 7692 7.2.1）
+    bool compress(std::string_view in, std::string* out)
+    {
+        if (!ok_)
+        {
+            return false;
+        }
+        out->resize(deflateBound(&stream_, static_cast<uLong>(in.size())) + 16);
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        stream_.avail_in = static_cast<uInt>(in.size());
+        size_t produced = 0;
+        do
+        {
+            if (produced == out->size())
+            {
+                out->resize(out->size() * 2);
+            }
+            stream_.next_out = reinterpret_cast<Bytef*>(&(*out)[produced]);
+            stream_.avail_out = static_cast<uInt>(out->size() - produced);
+            int rv = deflate(&stream_, Z_SYNC_FLUSH);
+            if (rv != Z_OK && rv != Z_BUF_ERROR)
+            {
+                return false;
+            }
+            produced = out->size() - stream_.avail_out;
+        } while (stream_.avail_out == 0);
+        if (noContextTakeover_)
+        {
+            deflateReset(&stream_);
+        }
+        if (produced < 4)
+        {
+            return false;
+        }
+        out->resize(produced - 4);
+        return true;
+    }
+
+private:
+    z_stream stream_;
+    bool     ok_;
+    bool     noContextTakeover_;
+};
+
+// 收到的消息的解压上下文，第一条压缩消息到达时才创建
+class WebSocket::Inflater
+{
+public:
+    Inflater()
+    {
+        stream_ = z_stream();
+        ok_ = inflateInit2(&stream_, -15) == Z_OK;
+    }
+
+    ~Inflater()
+    {
+        if (ok_)
+        {
+            inflateEnd(&stream_);
+        }
+    }
+
+    // 解压一条消息（会在 in 末尾补上 00 00 ff ff）；成功返回 0，否则返回关闭状态码
+    uint16_t decompress(std::string* in, size_t maxSize, std::string* out)
+    {
+        if (!ok_)
+        {
+            return kInternalError;
+        }
+        static const char kTail[4] = { 0x00, 0x00, static_cast<char>(0xFF), static_cast<char>(0xFF) };
+        in->append(kTail, sizeof kTail);
+        stream_.next_in = reinterpret_cast<Bytef*>(&(*in)[0]);
+        stream_.avail_in = static_cast<uInt>(in->size());
+        out->resize(std::min(maxSize + 1, std::max<size_t>(1024, in->size() * 4)));
+        size_t produced = 0;
+        while (true)
+        {
+            if (produced == out->size())
+            {
+                // 解压后超限的（包括压缩炸弹）在超出的那一刻就停下
+                if (out->size() > maxSize)
+                {
+                    return kMessageTooBig;
+                }
+                out->resize(std::min(maxSize + 1, out->size() * 2));
+            }
+            stream_.next_out = reinterpret_cast<Bytef*>(&(*out)[produced]);
+            stream_.avail_out = static_cast<uInt>(out->size() - produced);
+            int rv = inflate(&stream_, Z_SYNC_FLUSH);
+            produced = out->size() - stream_.avail_out;
+            if (rv == Z_STREAM_END)
+            {
+                // 对方用 BFINAL 结束了这条消息，下一条从新的 deflate 流开始
+                inflateReset(&stream_);
+                break;
+            }
+            if (rv != Z_OK && rv != Z_BUF_ERROR)
+            {
+                return kInvalidPayload;
+            }
+            if (stream_.avail_in == 0 && stream_.avail_out > 0)
+            {
+                break;
+            }
+        }
+        if (produced > maxSize)
+        {
+            return kMessageTooBig;
+        }
+        out->resize(produced);
+        return 0;
+    }
+
+private:
+    z_stream stream_;
+    bool     ok_;
+};
+
+WebSocketPtr WebSocket::accept(const muduo::net::TcpConnectionPtr& conn,
+                               const HttpRequest& req,
+                               HttpResponse* resp,
+                               std::shared_ptr<WebSocketHandler> handler)
+{
+    // RFC 6455 4.2.1。HTTP/2 上的 WebSocket（RFC 8441）不支持，浏览器会另开一条 HTTP/1.1 连接
+    std::string_view key = trim(req.getHeader(HttpHeaders::kSecWebSocketKey));
+    if (!conn || req.method() != HttpRequest::kGet || req.getVersion() != "HTTP/1.1" ||
+        !hasToken(req.getHeader(HttpHeaders::kUpgrade), "websocket") ||
+        !hasToken(req.getHeader(HttpHeaders::kConnection), "upgrade") || key.size() != 24)
+    {
+        resp->setStatusCode(HttpResponse::k400BadRequest);
+        resp->setContentType("text/plain");
+        resp->setBody("Not a WebSocket handshake");
+        return nullptr;
+    }
+    if (trim(req.getHeader(HttpHeaders::kSecWebSocketVersion)) != "13")
+    {
+        resp->setStatusCode(HttpResponse::k426UpgradeRequired);
+        resp->addHeader(HttpHeaders::kSecWebSocketVersion, "13");
+        return nullptr;
+    }
+    if (handler && !handler->acceptHandshake(req, resp))
+    {
+        return nullptr;
+    }
+
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    std::string input(key);
+    input.append(kGuid, sizeof kGuid - 1);
+    SHA1(reinterpret_cast<const unsigned char*>(input.data()), input.size(), digest);
+    char accept[32];
+    int n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(accept), digest, SHA_DIGEST_LENGTH);
+
+    WebSocketPtr ws(new WebSocket(conn, std::string(req.path()), std::move(handler)));
+    resp->setStatusCode(HttpResponse::k101SwitchingProtocols);
+    resp->addHeader(HttpHeaders::kUpgrade, "websocket");
+    resp->addHeader(HttpHeaders::kSecWebSocketAccept, std::string_view(accept, n));
+
+    // 按客户端的顺序接受第一个能满足的 permessage-deflate 提议
+    forEachToken(req.getHeader(HttpHeaders::kSecWebSocketExtensions), ',', [&](std::string_view extension)
+    {
+        size_t semicolon = extension.find(';');
+        if (!equalsIgnoreCase(trim(extension.substr(0, semicolon)), "permessage-deflate"))
+        {
+            return true;
+        }
+        DeflateOffer offer = parseDeflateOffer(semicolon == std::string_view::npos ? std::string_view()
+                                                                                   : extension.substr(semicolon + 1));
+        if (!offer.valid)
+        {
+            return true;
+        }
+        std::string response = "permessage-deflate";
+        if (offer.serverNoContextTakeover)
+        {
+            response += "; server_no_context_takeover";
+        }
+        if (offer.clientNoContextTakeover)
+        {
+            response += "; client_no_context_takeover";
+        }
+        ws->deflate_ = true;
+        ws->deflateNoContextTakeover_ = offer.serverNoContextTakeover;
+        ws->deflateWindowBits_ = kDeflateWindowBits;
+        if (offer.serverMaxWindowBits > 0)
+        {
+            ws->deflateWindowBits_ = std::min(kDeflateWindowBits, offer.serverMaxWindowBits);
+            response += "; server_max_window_bits=" + std::to_string(offer.serverMaxWindowBits);
+        }
+        resp->addHeader(HttpHeaders::kSecWebSocketExtensions, response);
+        return false;
+    });
+
+    resp->setWebSocket(ws);
+    return ws;
+}
+
+WebSocket::WebSocket(const muduo::net::TcpConnectionPtr& conn,
+                     std::string path,
+                     std::shared_ptr<WebSocketHandler> handler)
+    : conn_(conn)
+    , loop_(conn->getLoop())
+    , path_(std::move(path))
+    , handler_(std::move(handler))
+    , maxMessageSize_(kDefaultMaxMessageSize)
+    , deflate_(false)
+    , deflateNoContextTakeover_(false)
+    , deflateWindowBits_(kDeflateWindowBits)
+    , opened_(false)
+    , flushScheduled_(false)
+    , closeSent_(false)
+    , messageOpcode_(kContinuation)
+    , messageCompressed_(false)
+    , closeReceived_(false)
+    , closeNotified_(false)
+    , failed_(false)
+    , pingSent_(false)
+{
+}
+
+WebSocket::~WebSocket() = default;
+
+bool WebSocket::sendMessage(Opcode opcode, std::string_view message)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closeSent_)
+    {
+        return false;
+    }
+    if (deflate_ && message.size() >= kMinDeflateSize)
+    {
+        if (!deflater_)
+        {
+            deflater_ = std::make_unique<Deflater>(deflateWindowBits_, deflateNoContextTakeover_);
+        }
+        if (deflater_->compress(message, &compressed_))
+        {
+            appendFrameLocked(opcode, compressed_, true);
+            return scheduleFlushLocked();
+        }
+    }
+    appendFrameLocked(opcode, message, false);
+    return scheduleFlushLocked();
+}
+
+bool WebSocket::ping(std::string_view payload)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closeSent_)
+    {
+        return false;
+    }
+    appendFrameLocked(kPing, payload.substr(0, 125), false);
+    return scheduleFlushLocked();
+}
+
+void WebSocket::close(uint16_t code, std::string_view reason)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closeSent_)
+    {
+        return;
+    }
+    closeSent_ = true;
+    char payload[125];
+    payload[0] = static_cast<char>(code >> 8);
+    payload[1] = static_cast<char>(code & 0xFF);
+    size_t n = std::min(reason.size(), sizeof payload - 2);
+    std::memcpy(payload + 2, reason.data(), n);
+    appendFrameLocked(kClose, std::string_view(payload, n + 2), false);
+    scheduleFlushLocked();
+}
+
+bool WebSocket::closed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closeSent_;
+}
+
+void WebSocket::appendFrameLocked(Opcode opcode, std::string_view payload, bool compressed)
+{
+    // 服务端发出的帧不加掩码，每条消息一帧
+    char header[10];
+    size_t n = 2;
+    uint64_t length = payload.size();
+    header[0] = static_cast<char>(0x80 | (compressed ? 0x40 : 0) | opcode);
+    if (length < 126)
+    {
+        header[1] = static_cast<char>(length);
+    }
+    else if (length <= 0xFFFF)
+    {
+        header[1] = 126;
+        header[2] = static_cast<char>(length >> 8);
+        header[3] = static_cast<char>(length & 0xFF);
+        n = 4;
+    }
+    else
+    {
+        header[1] = 127;
+        for (int i = 0; i < 8; ++i)
+        {
+            header[2 + i] = static_cast<char>(length >> (56 - 8 * i));
+        }
+        n = 10;
+    }
+    pending_.append(header, n);
+    pending_.append(payload.data(), payload.size());
+}
+
+bool WebSocket::scheduleFlushLocked()
+{
+    if (pending_.readableBytes() > kMaxBufferedBytes)
+    {
+        // 生产者不理会对方的接收速度：断开，免得积压无限增长
+        LOG_WARN << "WebSocket " << path_ << " exceeds " << kMaxBufferedBytes << " buffered bytes, close";
+        closeSent_ = true;
+        pending_.retrieveAll();
+        std::weak_ptr<muduo::net::TcpConnection> weakConn(conn_);
+        loop_->queueInLoop([weakConn]()
+        {
+            if (muduo::net::TcpConnectionPtr conn = weakConn.lock())
+            {
+                conn->forceClose();
+            }
+        });
+        return false;
+    }
+    // 101 发出之前只缓存，由 open() 统一发送
+    if (opened_ && !flushScheduled_)
+    {
+        flushScheduled_ = true;
+        loop_->queueInLoop(std::bind(&WebSocket::flushInLoop, shared_from_this()));
+    }
+    return true;
+}
+
+void WebSocket::flushInLoop()
+{
+    bool closing = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushScheduled_ = false;
+        pending_.swap(sending_);
+        closing = closeSent_;
+    }
+    muduo::net::TcpConnectionPtr conn = conn_.lock();
+    if (!conn || !conn->connected())
+    {
+        sending_.retrieveAll();
+        return;
+    }
+    if (sending_.readableBytes() > 0)
+    {
+        HttpContext::send(conn, &sending_);
+    }
+    if (conn->outputBuffer()->readableBytes() > kMaxBufferedBytes)
+    {
+        LOG_WARN << "WebSocket " << conn->name() << " peer is too slow, close";
+        conn->forceClose();
+        return;
+    }
+    // 关闭握手完成（或者因为协议错误放弃）：关闭帧发出去之后关闭写端
+    if (closing && (closeReceived_ || failed_))
+    {
+        conn->shutdown();
+    }
+}
+
+void WebSocket::open()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        opened_ = true;
+    }
+    flushInLoop(); // handler 返回之前写入的消息
+    if (handler_)
+    {
+        handler_->onOpen(shared_from_this());
+    }
+}
+
+void WebSocket::onRead(muduo::net::Buffer* buf)
+{
+    WebSocketPtr self(shared_from_this()); // 回调里可能放掉最后一个外部引用
+    pingSent_ = false;                     // 收到任何数据都说明连接还活着
+    while (!failed_ && !closeReceived_ && buf->readableBytes() >= 2)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(buf->peek());
+        bool fin = p[0] & 0x80;
+        bool compressed = p[0] & 0x40;
+        int opcode = p[0] & 0x0F;
+        bool masked = p[1] & 0x80;
+        uint64_t length = p[1] & 0x7F;
+        size_t headerSize = 2 + (length == 126 ? 2 : length == 127 ? 8 : 0) + 4;
+        if (!masked || (p[0] & 0x30) || (compressed && !deflate_))
+        {
+            // 客户端发的帧必须加掩码；RSV2/RSV3 没有扩展使用
+            fail(kProtocolError, "invalid frame header");
+            break;
+        }
+        if (buf->readableBytes() < headerSize)
+        {
+            break;
+        }
+        if (length == 126)
+        {
+            length = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+        }
+        else if (length == 127)
+        {
+            length = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                length = (length << 8) | p[2 + i];
+            }
+        }
+
+        // 控制帧不能分片、不超过 125 字节；数据帧在收完之前就能判断是否超限
+        if (opcode >= kClose)
+        {
+            if (!fin || length > 125 || compressed)
+            {
+                fail(kProtocolError, "invalid control frame");
+                break;
+            }
+        }
+        else if (length > maxMessageSize_ - message_.size())
+        {
+            fail(kMessageTooBig, "message too big");
+            break;
+        }
+        if (buf->readableBytes() - headerSize < length)
+        {
+            break;
+        }
+
+        const uint8_t* mask = p + headerSize - 4;
+        const char* data = buf->peek() + headerSize;
+        if (opcode >= kClose)
+        {
+            char payload[125];
+            unmask(data, length, mask, payload);
+            buf->retrieve(headerSize + length);
+            onControlFrame(opcode, std::string_view(payload, length));
+            continue;
+        }
+        if (opcode == kContinuation)
+        {
+            // RSV1 只出现在消息的第一帧
+            if (messageOpcode_ == kContinuation || compressed)
+            {
+                fail(kProtocolError, "unexpected continuation frame");
+                break;
+            }
+        }
+        else if (messageOpcode_ != kContinuation || (opcode != kText && opcode != kBinary))
+        {
+            fail(kProtocolError, messageOpcode_ != kContinuation ? "expected continuation frame" : "unknown opcode");
+            break;
+        }
+        else
+        {
+            messageOpcode_ = opcode;
+            messageCompressed_ = compressed;
+        }
+        size_t offset = message_.size();
+        message_.resize(offset + length);
+        unmask(data, length, mask, &message_[offset]);
+        buf->retrieve(headerSize + length);
+        if (fin)
+        {
+            onMessage();
+        }
+    }
+    if (failed_ || closeReceived_)
+    {
+        buf->retrieveAll(); // 关闭之后的数据不再处理
+    }
+}
+
+void WebSocket::onMessage()
+{
+    bool binary = messageOpcode_ == kBinary;
+    std::string_view message = message_;
+    if (messageCompressed_)
+    {
+        if (!inflater_)
+        {
+            inflater_ = std::make_unique<Inflater>();
+        }
+        uint16_t code = inflater_->decompress(&message_, maxMessageSize_, &inflated_);
+        if (code != 0)
+        {
+            fail(code, code == kMessageTooBig ? "message too big" : "invalid compressed data");
+            return;
+        }
+        message = inflated_;
+    }
+    if (!binary && !isValidUtf8(message))
+    {
+        fail(kInvalidPayload, "invalid UTF-8 in text message");
+        return;
+    }
+    messageOpcode_ = kContinuation;
+    if (handler_ && !closeNotified_)
+    {
+        handler_->onMessage(shared_from_this(), message, binary);
+    }
+    message_.clear();
+    inflated_.clear();
+    if (message_.capacity() > kMaxRetainedCapacity)
+    {
+        std::string().swap(message_);
+    }
+    if (inflated_.capacity() > kMaxRetainedCapacity)
+    {
+        std::string().swap(inflated_);
+    }
+}
+
+void WebSocket::onControlFrame(int opcode, std::string_view payload)
+{
+    switch (opcode)
+    {
+        case kPing:
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!closeSent_)
+            {
+                appendFrameLocked(kPong, payload, false);
+                scheduleFlushLocked();
+            }
+            break;
+        }
+        case kPong:
+            break; // 只用来确认连接还活着，pingSent_ 已经清掉
+        case kClose:
+        {
+            uint16_t code = kNoStatus;
+            if (payload.size() >= 2)
+            {
+                code = static_cast<uint16_t>((static_cast<uint8_t>(payload[0]) << 8) | static_cast<uint8_t>(payload[1]));
+            }
+            if (payload.size() == 1 || (payload.size() >= 2 && (!isValidCloseCode(code) || !isValidUtf8(payload.substr(2)))))
+            {
+                fail(kProtocolError, "invalid close frame");
+                return;
+            }
+            closeReceived_ = true;
+            {
+                // 回一个同样状态码的关闭帧（对方没给状态码时不带），发出去之后关闭写端；
+                // 我们先发过关闭帧的，这里只触发关闭写端
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!closeSent_)
+                {
+                    closeSent_ = true;
+                    appendFrameLocked(kClose, payload.substr(0, code == kNoStatus ? 0 : 2), false);
+                }
+                scheduleFlushLocked();
+            }
+            notifyClose(code);
+            break;
+        }
+        default:
+            fail(kProtocolError, "unknown opcode");
+            break;
+    }
+}
+
+void WebSocket::fail(uint16_t code, std::string_view reason)
+{
+    LOG_DEBUG << "WebSocket " << path_ << " closed: " << std::string(reason);
+    failed_ = true;
+    message_.clear();
+    messageOpcode_ = kContinuation;
+    close(code, reason);
+    {
+        // 我们先发过关闭帧、正在等对方回的，close() 什么也不做，这里补一次 flush 关闭写端
+        std::lock_guard<std::mutex> lock(mutex_);
+        scheduleFlushLocked();
+    }
+    notifyClose(code);
+}
+
+void WebSocket::notifyClose(uint16_t code)
+{
+    if (closeNotified_)
+    {
+        return;
+    }
+    closeNotified_ = true;
+    if (handler_)
+    {
+        handler_->onClose(shared_from_this(), code);
+    }
+}
+
+bool WebSocket::keepAlive()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closeSent_)
+        {
+            return false; // 关闭握手过了一个空闲周期还没完成
+        }
+    }
+    if (pingSent_)
+    {
+        return false;
+    }
+    pingSent_ = true;
+    return ping();
+}
+
+void WebSocket::onDisconnected()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeSent_ = true;
+        pending_.retrieveAll();
+    }
+    notifyClose(kAbnormalClosure);
+}
+
+} // namespace http
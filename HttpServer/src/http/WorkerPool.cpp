@@ -0,0 +1,114 @@
+#include "../../include/http/WorkerPool.h"
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+WorkerPool::WorkerPool(const std::string& name, int numThreads, size_t maxQueueSize)
+    : name_(name)
+    , numThreads_(numThreads)
+    , maxQueueSize_(maxQueueSize)
+    , running_(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_)
+        {
+            return;
+        }
+        running_ = true;
+    }
+    threads_.reserve(numThreads_);
+    for (int i = 0; i < numThreads_; ++i)
+    {
+        threads_.emplace_back(new muduo::Thread(std::bind(&WorkerPool::runInThread, this),
+                                                name_ + std::to_string(i)));
+        threads_.back()->start();
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+        queue_.clear();
+    }
+    notEmpty_.notify_all();
+    for (auto& thread : threads_)
+    {
+        thread->join();
+    }
+    threads_.clear();
+}
+
+bool WorkerPool::tryRun(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || queue_.size() >= maxQueueSize_)
+        {
+            return false;
+        }
+        queue_.push_back(std::move(task));
+    }
+    notEmpty_.notify_one();
+    return true;
+}
+
+size_t WorkerPool::queueSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void WorkerPool::runInThread()
+{
+    if (threadInitCallback_)
+    {
+        threadInitCallback_();
+    }
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            if (!running_)
+            {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR << "Exception in worker " << name_ << ": " << e.what();
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Unknown exception in worker " << name_;
+        }
+    }
+}
+
+} // namespace http
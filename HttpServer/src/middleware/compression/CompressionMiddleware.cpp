@@ -0,0 +1,362 @@
+#include "../../../include/middleware/compression/CompressionMiddleware.h"
+
+#include <iterator>
+
+#include <zlib.h>
+#ifdef HTTP_WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace http
+{
+namespace middleware
+{
+
+namespace
+{
+
+/*
+    z_stream 初始化时要分配几百 KB 的窗口和哈希表，每个响应都 deflateInit/deflateEnd 代价很高。
+    每个 I/O 线程留一个，用完 deflateReset 即可复用；级别变化时才重新初始化。
+ */
+class ZlibCompressor
+{
+public:
+    explicit ZlibCompressor(bool gzip)
+        : gzip_(gzip)
+        , level_(-1)
+    {
+    }
+
+    ~ZlibCompressor()
+    {
+        if (level_ >= 0)
+        {
+            deflateEnd(&stream_);
+        }
+    }
+
+    ZlibCompressor(const ZlibCompressor&) = delete;
+    ZlibCompressor& operator=(const ZlibCompressor&) = delete;
+
+    bool compress(int level, std::string_view in, std::string* out)
+    {
+        if (level != level_)
+        {
+            if (level_ >= 0)
+            {
+                deflateEnd(&stream_);
+                level_ = -1;
+            }
+            stream_ = z_stream();
+            // windowBits 加 16 输出 gzip 格式，否则是 zlib 格式（HTTP 的 deflate 指的就是它）
+            if (deflateInit2(&stream_, level, Z_DEFLATED, gzip_ ? 15 + 16 : 15, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                return false;
+            }
+            level_ = level;
+        }
+        else
+        {
+            deflateReset(&stream_);
+        }
+
+        out->resize(deflateBound(&stream_, static_cast<uLong>(in.size())));
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        stream_.avail_in = static_cast<uInt>(in.size());
+        stream_.next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+        stream_.avail_out = static_cast<uInt>(out->size());
+        // 输出空间按 deflateBound 分配，一次 Z_FINISH 就能完成
+        if (deflate(&stream_, Z_FINISH) != Z_STREAM_END)
+        {
+            return false;
+        }
+        out->resize(stream_.total_out);
+        return true;
+    }
+
+private:
+    bool     gzip_;
+    int      level_;  // 当前初始化所用的级别，-1 表示未初始化
+    z_stream stream_;
+};
+
+thread_local ZlibCompressor t_gzip(true);
+thread_local ZlibCompressor t_deflate(false);
+
+bool startsWithIgnoreCase(std::string_view s, std::string_view prefix)
+{
+    return s.size() >= prefix.size() && equalsIgnoreCase(s.substr(0, prefix.size()), prefix);
+}
+
+// "q=0" / "q=0.0" / "q=0.000" 表示明确拒绝
+bool rejected(std::string_view params)
+{
+    size_t pos = params.find("q=");
+    if (pos == std::string_view::npos)
+    {
+        return false;
+    }
+    std::string_view q = trim(params.substr(pos + 2));
+    if (q.empty() || q[0] != '0')
+    {
+        return false;
+    }
+    for (size_t i = 1; i < q.size(); ++i)
+    {
+        if (q[i] != '.' && q[i] != '0')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* encodingName(CompressionMiddleware::Encoding encoding)
+{
+    switch (encoding)
+    {
+        case CompressionMiddleware::kDeflate: return "deflate";
+        case CompressionMiddleware::kGzip:    return "gzip";
+        case CompressionMiddleware::kBrotli:  return "br";
+        default:                              return "identity";
+    }
+}
+
+} // namespace
+
+CompressionMiddleware::CompressionMiddleware(const CompressionConfig& config) : config_(config) {}
+
+CompressionMiddleware::Encoding CompressionMiddleware::negotiate(std::string_view acceptEncoding)
+{
+    // 不看 q 值的相对大小，按服务端偏好（压缩率）选，只排除 q=0
+    bool deflate = false;
+    bool gzip = false;
+    bool brotli = false;
+    while (!acceptEncoding.empty())
+    {
+        size_t comma = acceptEncoding.find(',');
+        std::string_view item = acceptEncoding.substr(0, comma);
+        acceptEncoding = comma == std::string_view::npos ? std::string_view()
+                                                         : acceptEncoding.substr(comma + 1);
+
+        size_t semicolon = item.find(';');
+        std::string_view coding = trim(item.substr(0, semicolon));
+        if (semicolon != std::string_view::npos && rejected(item.substr(semicolon + 1)))
+        {
+            continue;
+        }
+        if (equalsIgnoreCase(coding, "gzip") || coding == "*")
+        {
+            gzip = true;
+        }
+        else if (equalsIgnoreCase(coding, "deflate"))
+        {
+            deflate = true;
+        }
+        else if (equalsIgnoreCase(coding, "br"))
+        {
+            brotli = true;
+        }
+    }
+
+#ifdef HTTP_WITH_BROTLI
+    if (brotli)
+    {
+        return kBrotli;
+    }
+#else
+    (void)brotli;
+#endif
+    if (gzip)
+    {
+        return kGzip;
+    }
+    return deflate ? kDeflate : kIdentity;
+}
+
+bool CompressionMiddleware::compress(Encoding encoding, std::string_view in, std::string* out) const
+{
+    switch (encoding)
+    {
+        case kGzip:
+            return t_gzip.compress(config_.level, in, out);
+        case kDeflate:
+            return t_deflate.compress(config_.level, in, out);
+#ifdef HTTP_WITH_BROTLI
+        case kBrotli:
+        {
+            // brotli 的一次性接口内部自己管理状态，不需要跨响应复用
+            size_t size = BrotliEncoderMaxCompressedSize(in.size());
+            if (size == 0)
+            {
+                return false;
+            }
+            out->resize(size);
+            if (!BrotliEncoderCompress(config_.brotliQuality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                       in.size(), reinterpret_cast<const uint8_t*>(in.data()),
+                                       &size, reinterpret_cast<uint8_t*>(&(*out)[0])))
+            {
+                return false;
+            }
+            out->resize(size);
+            return true;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+bool CompressionMiddleware::shouldCompress(const HttpRequest& request, const HttpResponse& response) const
+{
+    // HEAD 和 GET 走同样的判断：handler 给出的响应体照常压缩，Content-Encoding、ETag、
+    // Content-Length 都和 GET 一致，响应体由 sendResponse 的 discardBody() 丢掉不发
+    if (response.isStreaming() || response.isSseUpgraded())
+    {
+        return false;
+    }
+
+    int code = response.getStatusCode();
+    if (code < 200 || code == HttpResponse::k204NoContent || code == HttpResponse::k206PartialContent ||
+        code == HttpResponse::k304NotModified)
+    {
+        return false;
+    }
+    if (!response.getHeader(HttpHeaders::kContentEncoding).empty())
+    {
+        return false;
+    }
+
+    std::string_view type = response.getHeader(HttpHeaders::kContentType);
+    bool matched = false;
+    for (const auto& prefix : config_.mimeTypes)
+    {
+        if (startsWithIgnoreCase(type, prefix))
+        {
+            matched = true;
+            break;
+        }
+    }
+    if (!matched)
+    {
+        return false;
+    }
+
+    for (const auto& prefix : config_.excludedPaths)
+    {
+        if (request.path().substr(0, prefix.size()) == prefix)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompressionMiddleware::after(const HttpRequest& request, HttpResponse& response)
+{
+    if (!shouldCompress(request, response))
+    {
+        return;
+    }
+
+    // 可压缩的内容无论这次是否压缩，缓存都要区分 Accept-Encoding
+    std::string_view vary = response.getHeader(HttpHeaders::kVary);
+    if (vary.empty())
+    {
+        response.addHeader(HttpHeaders::kVary, "Accept-Encoding");
+    }
+    else if (vary.find("Accept-Encoding") == std::string_view::npos)
+    {
+        response.addHeader(HttpHeaders::kVary, std::string(vary) + ", Accept-Encoding");
+    }
+
+    size_t size = response.bodySize();
+    if (size < config_.minSize)
+    {
+        return;
+    }
+    Encoding encoding = negotiate(request.getHeader(HttpHeaders::kAcceptEncoding));
+    if (encoding == kIdentity)
+    {
+        return;
+    }
+
+    if (const HttpResponse::BodySegment* shared = response.sharedBody())
+    {
+        std::shared_ptr<const std::string> encoded = compressShared(encoding, *shared);
+        if (!encoded)
+        {
+            return;
+        }
+        response.setBody(std::move(encoded));
+    }
+    else
+    {
+        std::string encoded;
+        if (!compress(encoding, response.body(), &encoded) || encoded.size() >= size)
+        {
+            return;
+        }
+        response.setBody(std::move(encoded));
+    }
+    response.addHeader(HttpHeaders::kContentEncoding, encodingName(encoding));
+
+    // 强 ETag 标识的是字节完全相同的表示，压缩后降为弱 ETag；
+    // 条件请求按弱比较处理，客户端带回 W/"..." 时仍能命中 304
+    std::string_view etag = response.getHeader(HttpHeaders::kETag);
+    if (!etag.empty() && etag[0] == '"')
+    {
+        response.addHeader(HttpHeaders::kETag, "W/" + std::string(etag));
+    }
+}
+
+std::shared_ptr<const std::string> CompressionMiddleware::compressShared(Encoding encoding,
+                                                                         const HttpResponse::BodySegment& body)
+{
+    const void* key = body.data.data();
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end() && !it->second.owner.expired() && it->second.size == body.data.size() &&
+            it->second.encoded[encoding])
+        {
+            return it->second.encoded[encoding];
+        }
+    }
+
+    // 压缩放在锁外，多个线程同时未命中时各自压缩一次，结果相同，后写入的覆盖先写入的
+    auto encoded = std::make_shared<std::string>();
+    if (!compress(encoding, body.data, encoded.get()) || encoded->size() >= body.data.size())
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    auto it = cache_.find(key);
+    if (it == cache_.end() || it->second.owner.expired() || it->second.size != body.data.size())
+    {
+        if (cache_.size() >= kMaxCacheEntries)
+        {
+            for (auto i = cache_.begin(); i != cache_.end();)
+            {
+                i = i->second.owner.expired() ? cache_.erase(i) : std::next(i);
+            }
+            if (cache_.size() >= kMaxCacheEntries)
+            {
+                cache_.clear();
+            }
+        }
+        CacheEntry& entry = cache_[key];
+        entry = CacheEntry();
+        entry.owner = body.owner;
+        entry.size = body.data.size();
+        it = cache_.find(key);
+    }
+    it->second.encoded[encoding] = encoded;
+    return encoded;
+}
+
+} // namespace middleware
+} // namespace http
@@ -57,7 +57,7 @@ bool CorsMiddleware::isOriginAllowed(const std::string& origin) const
 void CorsMiddleware::handlePreflightRequest(const HttpRequest& request, 
                                           HttpResponse& response) 
 {
-    const std::string& origin = request.getHeader("Origin");
+    std::string origin(request.getHeader(HttpHeaders::kOrigin));
     
     if (!isOriginAllowed(origin)) 
     {
@@ -0,0 +1,101 @@
+#include "../../../include/middleware/etag/EtagMiddleware.h"
+
+#include "../../../include/utils/HashUtil.h"
+
+namespace http
+{
+namespace middleware
+{
+
+namespace
+{
+
+// 弱比较：去掉 W/ 前缀后比较引号里的部分
+std::string_view opaqueTag(std::string_view tag)
+{
+    if (tag.size() >= 2 && tag[0] == 'W' && tag[1] == '/')
+    {
+        tag.remove_prefix(2);
+    }
+    return tag;
+}
+
+} // namespace
+
+EtagMiddleware::EtagMiddleware(const EtagConfig& config) : config_(config) {}
+
+bool EtagMiddleware::matches(std::string_view ifNoneMatch, std::string_view etag)
+{
+    std::string_view opaque = opaqueTag(etag);
+    while (!ifNoneMatch.empty())
+    {
+        size_t comma = ifNoneMatch.find(',');
+        std::string_view tag = trim(ifNoneMatch.substr(0, comma));
+        if (tag == "*" || opaqueTag(tag) == opaque)
+        {
+            return true;
+        }
+        ifNoneMatch = comma == std::string_view::npos ? std::string_view() : ifNoneMatch.substr(comma + 1);
+    }
+    return false;
+}
+
+bool EtagMiddleware::shouldTag(const HttpRequest& request, const HttpResponse& response) const
+{
+    HttpRequest::Method method = request.method();
+    if (method != HttpRequest::kGet && method != HttpRequest::kHead)
+    {
+        return false;
+    }
+    if (response.getStatusCode() != HttpResponse::k200Ok || response.isStreaming() ||
+        response.isSseUpgraded() || response.bodySize() > config_.maxSize)
+    {
+        return false;
+    }
+    if (!response.getHeader(HttpHeaders::kETag).empty())
+    {
+        return false;
+    }
+
+    if (config_.paths.empty())
+    {
+        return true;
+    }
+    for (const auto& prefix : config_.paths)
+    {
+        if (request.path().substr(0, prefix.size()) == prefix)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EtagMiddleware::after(const HttpRequest& request, HttpResponse& response)
+{
+    if (!shouldTag(request, response))
+    {
+        return;
+    }
+
+    // HEAD 同样执行了 handler，响应体到发送前才丢弃，算出的 ETag 和 GET 一致
+    char etag[2 + 1 + 16 + 1 + 1] = "W/\"";
+    size_t n = 3 + HashUtil::toHex(HashUtil::hash64(response.body()), etag + 3);
+    etag[n++] = '"';
+    response.addHeader(HttpHeaders::kETag, std::string_view(etag, n));
+    if (!config_.cacheControl.empty() && response.getHeader(HttpHeaders::kCacheControl).empty())
+    {
+        response.addHeader(HttpHeaders::kCacheControl, config_.cacheControl);
+    }
+
+    std::string_view ifNoneMatch = request.getHeader(HttpHeaders::kIfNoneMatch);
+    if (!ifNoneMatch.empty() && matches(ifNoneMatch, std::string_view(etag, n)))
+    {
+        response.setStatusCode(HttpResponse::k304NotModified);
+        response.setStatusMessage(std::string_view()); // handler 设置的 "OK" 不能留在 304 的状态行里
+        response.setBody(std::string());
+    }
+}
+
+} // namespace middleware
+} // namespace http
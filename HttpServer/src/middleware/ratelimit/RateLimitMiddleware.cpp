@@ -26,15 +26,16 @@ RateLimitMiddleware::RateLimitMiddleware(const std::string& redisUri,
 void RateLimitMiddleware::before(HttpRequest& request)
 {
     // 优先取 X-Forwarded-For，否则用 X-Real-IP，再退回 "unknown"
-    std::string ip = request.getHeader("X-Forwarded-For");
-    if (ip.empty()) ip = request.getHeader("X-Real-IP");
+    std::string_view ip = request.getHeader(HttpHeaders::kXForwardedFor);
+    if (ip.empty()) ip = request.getHeader(HttpHeaders::kXRealIp);
     if (ip.empty()) ip = "unknown";
 
     // 截取第一个 IP（X-Forwarded-For 可能是逗号分隔列表）
     auto comma = ip.find(',');
-    if (comma != std::string::npos) ip = ip.substr(0, comma);
+    if (comma != std::string_view::npos) ip = ip.substr(0, comma);
 
-    std::string key = config_.keyPrefix + ip;
+    std::string key = config_.keyPrefix;
+    key.append(ip.data(), ip.size());
 
     long long count = 0;
     try
@@ -48,7 +49,7 @@ void RateLimitMiddleware::before(HttpRequest& request)
         return;
     }
 
-    LOG_DEBUG << "RateLimitMiddleware: ip=" << ip << " count=" << count
+    LOG_DEBUG << "RateLimitMiddleware: ip=" << std::string(ip) << " count=" << count
               << " limit=" << config_.maxRequests;
 
     if (count > config_.maxRequests)
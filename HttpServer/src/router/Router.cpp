@@ -7,22 +7,67 @@ namespace router
 
 void Router::registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler)
 {
-    RouteKey key{method, path};
+    RouteKey key{method, internPath(path)};
     handlers_[key] = handler;
 }
 
 void Router::registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback)
 {
-    RouteKey key{method, path};
+    RouteKey key{method, internPath(path)};
     callbacks_[key] = callback;
 }
 
+void Router::addPrefixHandler(HttpRequest::Method method, const std::string &prefix, HandlerPtr handler)
+{
+    auto pos = prefixHandlers_.begin();
+    while (pos != prefixHandlers_.end() && pos->prefix_.size() >= prefix.size())
+    {
+        ++pos;
+    }
+    prefixHandlers_.insert(pos, RoutePrefixObj{method, prefix, handler});
+}
+
+const Router::RoutePrefixObj *Router::findPrefixRoute(HttpRequest::Method method, std::string_view path) const
+{
+    for (const auto &routeObj : prefixHandlers_)
+    {
+        if (routeObj.method_ == method && path.compare(0, routeObj.prefix_.size(), routeObj.prefix_) == 0)
+        {
+            return &routeObj;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view Router::internPath(const std::string &path)
+{
+    for (const auto &p : paths_)
+    {
+        if (p == path)
+        {
+            return p;
+        }
+    }
+    paths_.push_back(path);
+    return paths_.back();
+}
+
 // ★ 新增 conn 参数版本，替换原来的 route(req, resp)
 bool Router::route(const muduo::net::TcpConnectionPtr &conn,
                    const HttpRequest &req,
                    HttpResponse *resp)
 {
-    RouteKey key{req.method(), req.path()};
+    // 没有单独注册 HEAD 的路由交给 GET 的 handler，响应体由 HttpServer 在发送前丢弃
+    return dispatch(req.method(), conn, req, resp) ||
+           (req.method() == HttpRequest::kHead && dispatch(HttpRequest::kGet, conn, req, resp));
+}
+
+bool Router::dispatch(HttpRequest::Method method,
+                      const muduo::net::TcpConnectionPtr &conn,
+                      const HttpRequest &req,
+                      HttpResponse *resp)
+{
+    RouteKey key{method, req.path()};
 
     // 1. 精确匹配 Handler
     auto handlerIt = handlers_.find(key);
@@ -40,13 +85,20 @@ bool Router::route(const muduo::net::TcpConnectionPtr &conn,
         return true;
     }
 
-    // 3. 正则匹配 Handler
-    std::string path = req.path();
+    // 3. 前缀匹配 Handler
+    std::string_view path = req.path();
+    if (const RoutePrefixObj *prefixRoute = findPrefixRoute(method, path))
+    {
+        prefixRoute->handler_->handle(conn, req, resp);
+        return true;
+    }
+
+    // 4. 正则匹配 Handler（直接在 path 的 view 上匹配，不再拷贝出一份 std::string）
     for (auto &routeObj : regexHandlers_)
     {
-        std::smatch match;
-        if (routeObj.method_ == req.method() &&
-            std::regex_match(path, match, routeObj.pathRegex_))
+        std::cmatch match;
+        if (routeObj.method_ == method &&
+            std::regex_match(path.data(), path.data() + path.size(), match, routeObj.pathRegex_))
         {
             extractPathParameters(match, const_cast<HttpRequest &>(req));
             routeObj.handler_->handle(conn, req, resp);
@@ -54,12 +106,12 @@ bool Router::route(const muduo::net::TcpConnectionPtr &conn,
         }
     }
 
-    // 4. 正则匹配 Callback
+    // 5. 正则匹配 Callback
     for (auto &routeObj : regexCallbacks_)
     {
-        std::smatch match;
-        if (routeObj.method_ == req.method() &&
-            std::regex_match(path, match, routeObj.pathRegex_))
+        std::cmatch match;
+        if (routeObj.method_ == method &&
+            std::regex_match(path.data(), path.data() + path.size(), match, routeObj.pathRegex_))
         {
             extractPathParameters(match, const_cast<HttpRequest &>(req));
             routeObj.callback_(req, resp);
@@ -70,6 +122,54 @@ bool Router::route(const muduo::net::TcpConnectionPtr &conn,
     return false;
 }
 
+bool Router::findRoute(HttpRequest &req, HandlerPtr *handler) const
+{
+    return lookup(req.method(), req, handler) ||
+           (req.method() == HttpRequest::kHead && lookup(HttpRequest::kGet, req, handler));
+}
+
+bool Router::lookup(HttpRequest::Method method, HttpRequest &req, HandlerPtr *handler) const
+{
+    RouteKey key{method, req.path()};
+    auto handlerIt = handlers_.find(key);
+    if (handlerIt != handlers_.end())
+    {
+        *handler = handlerIt->second;
+        return true;
+    }
+    if (callbacks_.count(key))
+    {
+        return true;
+    }
+
+    std::string_view path = req.path();
+    if (const RoutePrefixObj *prefixRoute = findPrefixRoute(method, path))
+    {
+        *handler = prefixRoute->handler_;
+        return true;
+    }
+    for (const auto &routeObj : regexHandlers_)
+    {
+        std::cmatch match;
+        if (routeObj.method_ == method &&
+            std::regex_match(path.data(), path.data() + path.size(), match, routeObj.pathRegex_))
+        {
+            extractPathParameters(match, req);
+            *handler = routeObj.handler_;
+            return true;
+        }
+    }
+    for (const auto &routeObj : regexCallbacks_)
+    {
+        if (routeObj.method_ == method &&
+            std::regex_match(path.data(), path.data() + path.size(), routeObj.pathRegex_))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 // ★ 保留旧签名作为兼容重载（内部委托给新版本，conn 传空）
 bool Router::route(const HttpRequest &req, HttpResponse *resp)
 {
@@ -0,0 +1,258 @@
+#include "../../include/router/StaticFileHandler.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+
+#include "../../include/middleware/etag/EtagMiddleware.h"
+#include "../../include/utils/DateUtil.h"
+#include "../../include/utils/UrlUtil.h"
+
+namespace http
+{
+namespace router
+{
+
+namespace
+{
+
+bool parseNumber(std::string_view s, uint64_t* value)
+{
+    if (s.empty() || s.size() > 19)
+    {
+        return false;
+    }
+    *value = 0;
+    for (char c : s)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        *value = *value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+StaticFileHandler::StaticFileHandler(std::shared_ptr<FileCache> cache,
+                                     const std::string& urlPrefix,
+                                     const std::string& root,
+                                     const std::string& cacheControl)
+    : cache_(std::move(cache))
+    , urlPrefix_(urlPrefix)
+    , root_(root)
+    , singleFile_(false)
+    , cacheControl_(cacheControl)
+{
+    while (root_.size() > 1 && root_.back() == '/')
+    {
+        root_.pop_back();
+    }
+    struct stat st;
+    singleFile_ = ::stat(root_.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+bool StaticFileHandler::resolve(std::string_view urlPath, std::string* path) const
+{
+    if (singleFile_)
+    {
+        *path = root_;
+        return true;
+    }
+    if (urlPath.compare(0, urlPrefix_.size(), urlPrefix_) != 0)
+    {
+        return false;
+    }
+    urlPath.remove_prefix(urlPrefix_.size());
+
+    std::string decoded(urlPath.size(), '\0');
+    decoded.resize(UrlUtil::decode(urlPath, &decoded[0], false));
+    if (decoded.find('\0') != std::string::npos)
+    {
+        return false;
+    }
+
+    // 逐段拼接，跳过空段和 "."，遇到 ".." 直接拒绝
+    *path = root_;
+    size_t start = 0;
+    while (start <= decoded.size())
+    {
+        size_t slash = decoded.find('/', start);
+        if (slash == std::string::npos)
+        {
+            slash = decoded.size();
+        }
+        std::string_view segment(decoded.data() + start, slash - start);
+        if (segment == "..")
+        {
+            return false;
+        }
+        if (!segment.empty() && segment != ".")
+        {
+            path->push_back('/');
+            path->append(segment.data(), segment.size());
+        }
+        start = slash + 1;
+    }
+    if (decoded.empty() || decoded.back() == '/')
+    {
+        path->append("/index.html");
+    }
+    return true;
+}
+
+bool StaticFileHandler::notModified(const HttpRequest& req, const CachedFile& file)
+{
+    // If-None-Match 优先，存在时忽略 If-Modified-Since
+    std::string_view ifNoneMatch = req.getHeader(HttpHeaders::kIfNoneMatch);
+    if (!ifNoneMatch.empty())
+    {
+        return middleware::EtagMiddleware::matches(ifNoneMatch, file.etag);
+    }
+
+    time_t since = 0;
+    return DateUtil::parse(req.getHeader(HttpHeaders::kIfModifiedSince), &since) && file.mtime <= since;
+}
+
+int StaticFileHandler::parseRange(std::string_view range, uint64_t size, uint64_t* first, uint64_t* last)
+{
+    static const std::string_view kBytes = "bytes=";
+    if (range.compare(0, kBytes.size(), kBytes) != 0)
+    {
+        return -1;
+    }
+    range.remove_prefix(kBytes.size());
+    size_t dash = range.find('-');
+    if (range.find(',') != std::string_view::npos || dash == std::string_view::npos)
+    {
+        return -1; // 多区间或格式不对：按整个文件返回
+    }
+
+    std::string_view from = trim(range.substr(0, dash));
+    std::string_view to = trim(range.substr(dash + 1));
+    if (from.empty())
+    {
+        // "-n"：最后 n 个字节
+        uint64_t suffix = 0;
+        if (!parseNumber(to, &suffix))
+        {
+            return -1;
+        }
+        if (suffix == 0 || size == 0)
+        {
+            return 0;
+        }
+        *first = suffix >= size ? 0 : size - suffix;
+        *last = size - 1;
+        return 1;
+    }
+
+    if (!parseNumber(from, first))
+    {
+        return -1;
+    }
+    if (to.empty())
+    {
+        *last = size - 1;
+    }
+    else if (!parseNumber(to, last) || *last < *first)
+    {
+        return -1;
+    }
+    if (*first >= size)
+    {
+        return 0;
+    }
+    if (*last >= size)
+    {
+        *last = size - 1;
+    }
+    return 1;
+}
+
+void StaticFileHandler::handle(const muduo::net::TcpConnectionPtr& conn,
+                               const HttpRequest& req,
+                               HttpResponse* resp)
+{
+    std::string path;
+    std::shared_ptr<const CachedFile> file;
+    if (resolve(req.path(), &path))
+    {
+        file = cache_->get(path);
+    }
+    if (!file)
+    {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+        resp->setContentType("text/plain; charset=utf-8");
+        resp->setBody(std::string("Not Found"));
+        return;
+    }
+
+    resp->addHeader(HttpHeaders::kETag, file->etag);
+    resp->addHeader(HttpHeaders::kLastModified, file->lastModified);
+    if (!cacheControl_.empty())
+    {
+        resp->addHeader(HttpHeaders::kCacheControl, cacheControl_);
+    }
+    if (notModified(req, *file))
+    {
+        resp->setStatusCode(HttpResponse::k304NotModified);
+        return;
+    }
+
+    resp->setContentType(file->contentType);
+    resp->addHeader(HttpHeaders::kAcceptRanges, "bytes");
+    uint64_t size = file->data.size();
+
+    std::string_view range = req.getHeader(HttpHeaders::kRange);
+    std::string_view ifRange = req.getHeader(HttpHeaders::kIfRange);
+    // If-Range 不匹配（文件已经变了）时忽略 Range，返回整个文件；ETag 要求强比较
+    if (!range.empty() && (ifRange.empty() || ifRange == file->etag || ifRange == file->lastModified))
+    {
+        uint64_t first = 0;
+        uint64_t last = 0;
+        int result = parseRange(range, size, &first, &last);
+        char buf[64];
+        if (result == 0)
+        {
+            resp->setStatusCode(HttpResponse::k416RangeNotSatisfiable);
+            int n = snprintf(buf, sizeof buf, "bytes */%llu", static_cast<unsigned long long>(size));
+            resp->addHeader(HttpHeaders::kContentRange, std::string_view(buf, n));
+            return;
+        }
+        if (result > 0)
+        {
+            resp->setStatusCode(HttpResponse::k206PartialContent);
+            int n = snprintf(buf, sizeof buf, "bytes %llu-%llu/%llu", static_cast<unsigned long long>(first),
+                             static_cast<unsigned long long>(last), static_cast<unsigned long long>(size));
+            resp->addHeader(HttpHeaders::kContentRange, std::string_view(buf, n));
+            if (req.method() == HttpRequest::kHead)
+            {
+                resp->setContentLength(last - first + 1);
+            }
+            else
+            {
+                resp->addBodySegment(file->owner, file->data.substr(first, last - first + 1));
+            }
+            return;
+        }
+    }
+
+    resp->setStatusCode(HttpResponse::k200Ok);
+    if (req.method() == HttpRequest::kHead)
+    {
+        resp->setContentLength(size);
+    }
+    else
+    {
+        // 直接引用缓存里的内容（大文件是 mmap 的页），组响应时不拷贝。这里没有 sendfile：
+        // 内核一次写不完的部分 muduo 会拷进连接的输出缓冲区，所以 1 MB 以上的由 HttpServer 交给
+        // SlicedSender 分片发送，每片最多 256 KB 进堆，慢客户端不会让整个文件在堆上再拷一份
+        resp->addBodySegment(file->owner, file->data);
+    }
+}
+
+} // namespace router
+} // namespace http
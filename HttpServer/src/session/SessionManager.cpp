@@ -42,12 +42,30 @@ std::shared_ptr<Session> SessionManager::getSession(const HttpRequest& req, Http
     return session;
 }
 
+std::shared_ptr<Session> SessionManager::findSession(const HttpRequest& req)
+{
+    std::string sessionId = getSessionIdFromCookie(req);
+    if (sessionId.empty())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Session> session = storage_->load(sessionId);
+    if (!session || session->isExpired())
+    {
+        return nullptr;
+    }
+    session->setManager(this);
+    return session;
+}
+
 // 生成唯一的会话标识符，确保会话的唯一性和安全性
 std::string SessionManager::generateSessionId()
 {
     std::stringstream ss;
     std::uniform_int_distribution<> dist(0, 15);
 
+    std::lock_guard<std::mutex> lock(rngMutex_);
     // 生成32个字符的会话ID，每个字符是一个十六进制数字
     for (int i = 0; i < 32; ++i)
     {
@@ -71,22 +89,22 @@ void SessionManager::cleanExpiredSessions()
 std::string SessionManager::getSessionIdFromCookie(const HttpRequest& req)
 {
     std::string sessionId;
-    std::string cookie = req.getHeader("Cookie");
+    std::string_view cookie = req.getHeader(HttpHeaders::kCookie);
 
     if (!cookie.empty())
     {
         size_t pos = cookie.find("sessionId=");
-        if (pos != std::string::npos)
+        if (pos != std::string_view::npos)
         {
             pos += 10; // 跳过"sessionId="
             size_t end = cookie.find(';', pos);
-            if (end != std::string::npos)
+            if (end != std::string_view::npos)
             {
-                sessionId = cookie.substr(pos, end - pos);
+                sessionId.assign(cookie.substr(pos, end - pos));
             }
             else
             {
-                sessionId = cookie.substr(pos);
+                sessionId.assign(cookie.substr(pos));
             }
         }
     }
@@ -1,176 +1,195 @@
 #include "../../include/ssl/SslConnection.h"
 #include <muduo/base/Logging.h>
 #include <openssl/err.h>
+#include <algorithm>
+#include <climits>
 
 namespace ssl
 {
 
-// 自定义 BIO 方法
-static BIO_METHOD* createCustomBioMethod() 
-{
-    BIO_METHOD* method = BIO_meth_new(BIO_TYPE_MEM, "custom");
-    BIO_meth_set_write(method, SslConnection::bioWrite);
-    BIO_meth_set_read(method, SslConnection::bioRead);
-    BIO_meth_set_ctrl(method, SslConnection::bioCtrl);
-    return method;
-}
-
-SslConnection::SslConnection(const TcpConnectionPtr& conn, SslContext* ctx)
+SslConnection::SslConnection(muduo::net::TcpConnection* conn, SslContext* ctx)
     : ssl_(nullptr)
     , ctx_(ctx)
     , conn_(conn)
     , state_(SSLState::HANDSHAKE)
     , readBio_(nullptr)
     , writeBio_(nullptr)
-    , messageCallback_(nullptr)
 {
     // 创建 SSL 对象
     ssl_ = SSL_new(ctx_->getNativeHandle());
     if (!ssl_) {
         LOG_ERROR << "Failed to create SSL object: " << ERR_error_string(ERR_get_error(), nullptr);
+        state_ = SSLState::ERROR;
         return;
     }
 
     // 创建 BIO
     readBio_ = BIO_new(BIO_s_mem());
     writeBio_ = BIO_new(BIO_s_mem());
-    
+
     if (!readBio_ || !writeBio_) {
         LOG_ERROR << "Failed to create BIO objects";
+        BIO_free(readBio_);
+        BIO_free(writeBio_);
         SSL_free(ssl_);
         ssl_ = nullptr;
+        state_ = SSLState::ERROR;
         return;
     }
 
     SSL_set_bio(ssl_, readBio_, writeBio_);
     SSL_set_accept_state(ssl_);  // 设置为服务器模式
-    
+
     // 设置 SSL 选项
     SSL_set_mode(ssl_, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
     SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE);
-    
-    // 设置连接回调
-    conn_->setMessageCallback(
-        std::bind(&SslConnection::onRead, this, std::placeholders::_1,
-                 std::placeholders::_2, std::placeholders::_3));
 }
 
-SslConnection::~SslConnection() 
+SslConnection::~SslConnection()
 {
-    if (ssl_) 
+    if (ssl_)
     {
         SSL_free(ssl_);  // 这会同时释放 BIO
     }
 }
 
-void SslConnection::startHandshake() 
+void SslConnection::startHandshake()
 {
-    SSL_set_accept_state(ssl_);
+    if (!ssl_) {
+        conn_->forceClose();
+        return;
+    }
     handleHandshake();
 }
 
-void SslConnection::send(const void* data, size_t len) 
+void SslConnection::send(const void* data, size_t len)
 {
     if (state_ != SSLState::ESTABLISHED) {
         LOG_ERROR << "Cannot send data before SSL handshake is complete";
         return;
     }
-    
-    int written = SSL_write(ssl_, data, len);
-    if (written <= 0) {
-        int err = SSL_get_error(ssl_, written);
-        LOG_ERROR << "SSL_write failed: " << ERR_error_string(err, nullptr);
-        return;
-    }
-    
-    char buf[4096];
-    int pending;
-    while ((pending = BIO_pending(writeBio_)) > 0) {
-        int bytes = BIO_read(writeBio_, buf, 
-                           std::min(pending, static_cast<int>(sizeof(buf))));
-        if (bytes > 0) {
-            conn_->send(buf, bytes);
+
+    // 写进内存 BIO 不会阻塞，部分写入只是因为单条记录有上限，循环写完即可
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        int written = SSL_write(ssl_, p, static_cast<int>(std::min(len, static_cast<size_t>(INT_MAX))));
+        if (written <= 0) {
+            handleError(getLastError(written));
+            return;
         }
+        p += written;
+        len -= static_cast<size_t>(written);
     }
+    flush();
 }
 
-void SslConnection::onRead(const TcpConnectionPtr& conn, BufferPtr buf, 
-                         muduo::Timestamp time) 
+bool SslConnection::onRead(muduo::net::Buffer* buf)
 {
+    if (state_ == SSLState::ERROR) {
+        buf->retrieveAll();
+        return false;
+    }
+    // 将数据写入 BIO，内存 BIO 总能全部接收
+    BIO_write(readBio_, buf->peek(), static_cast<int>(buf->readableBytes()));
+    buf->retrieveAll();
+
     if (state_ == SSLState::HANDSHAKE) {
-        // 将数据写入 BIO
-        BIO_write(readBio_, buf->peek(), buf->readableBytes());
-        buf->retrieve(buf->readableBytes());
         handleHandshake();
-        return;
-    } else if (state_ == SSLState::ESTABLISHED) {
-        // 解密数据
-        char decryptedData[4096];
-        int ret = SSL_read(ssl_, decryptedData, sizeof(decryptedData));
-        if (ret > 0) {
-            // 创建新的 Buffer 存储解密后的数据
-            muduo::net::Buffer decryptedBuffer;
-            decryptedBuffer.append(decryptedData, ret);
-            
-            // 调用上层回调处理解密后的数据
-            if (messageCallback_) {
-                messageCallback_(conn, &decryptedBuffer, time);
-            }
-        }
     }
+    // 客户端常在 Finished 之后紧跟着发请求，同一批数据里可能已经有应用数据
+    if (state_ == SSLState::ESTABLISHED) {
+        decrypt();
+    }
+    return state_ != SSLState::ERROR;
+}
+
+std::string_view SslConnection::alpnProtocol() const
+{
+    const unsigned char* data = nullptr;
+    unsigned int len = 0;
+    if (ssl_) {
+        SSL_get0_alpn_selected(ssl_, &data, &len);
+    }
+    return data ? std::string_view(reinterpret_cast<const char*>(data), len) : std::string_view();
 }
 
-void SslConnection::handleHandshake() 
+void SslConnection::handleHandshake()
 {
     int ret = SSL_do_handshake(ssl_);
-    
+    // 无论成功与否，握手消息（包括失败时的 alert）都要发出去
+    flush();
+
     if (ret == 1) {
         state_ = SSLState::ESTABLISHED;
-        LOG_INFO << "SSL handshake completed successfully";
-        LOG_INFO << "Using cipher: " << SSL_get_cipher(ssl_);
-        LOG_INFO << "Protocol version: " << SSL_get_version(ssl_);
-        
-        // 握手完成后，确保设置了正确的回调
-        if (!messageCallback_) {
-            LOG_WARN << "No message callback set after SSL handshake";
-        }
+        LOG_DEBUG << "SSL handshake completed, cipher: " << SSL_get_cipher(ssl_)
+                  << ", protocol: " << SSL_get_version(ssl_);
         return;
     }
-    
+
     int err = SSL_get_error(ssl_, ret);
     switch (err) {
         case SSL_ERROR_WANT_READ:
         case SSL_ERROR_WANT_WRITE:
             // 正常的握手过程，需要继续
             break;
-            
+
         default: {
             // 获取详细的错误信息
             char errBuf[256];
             unsigned long errCode = ERR_get_error();
             ERR_error_string_n(errCode, errBuf, sizeof(errBuf));
             LOG_ERROR << "SSL handshake failed: " << errBuf;
+            state_ = SSLState::ERROR;
             conn_->shutdown();  // 关闭连接
             break;
         }
     }
 }
 
-void SslConnection::onEncrypted(const char* data, size_t len) 
+void SslConnection::decrypt()
 {
-    writeBuffer_.append(data, len);
-    conn_->send(&writeBuffer_);
+    // 一直读到 readBio_ 里没有完整的记录为止，直接解密进 decryptedBuffer_，不经过中间缓冲
+    for (;;) {
+        decryptedBuffer_.ensureWritableBytes(16 * 1024);
+        int ret = SSL_read(ssl_, decryptedBuffer_.beginWrite(),
+                           static_cast<int>(decryptedBuffer_.writableBytes()));
+        if (ret > 0) {
+            decryptedBuffer_.hasWritten(static_cast<size_t>(ret));
+            continue;
+        }
+        if (SSL_get_error(ssl_, ret) == SSL_ERROR_ZERO_RETURN) {
+            // 对端发来 close_notify
+            state_ = SSLState::SHUTDOWN;
+            conn_->shutdown();
+        } else {
+            handleError(getLastError(ret));
+        }
+        break;
+    }
+    // TLS 1.3 的 NewSessionTicket、KeyUpdate 回应等
+    flush();
 }
 
-void SslConnection::onDecrypted(const char* data, size_t len) 
+void SslConnection::flush()
 {
-    decryptedBuffer_.append(data, len);
+    int pending;
+    while ((pending = BIO_pending(writeBio_)) > 0) {
+        writeBuffer_.ensureWritableBytes(static_cast<size_t>(pending));
+        int bytes = BIO_read(writeBio_, writeBuffer_.beginWrite(), pending);
+        if (bytes <= 0) {
+            break;
+        }
+        writeBuffer_.hasWritten(static_cast<size_t>(bytes));
+    }
+    if (writeBuffer_.readableBytes() > 0) {
+        conn_->send(&writeBuffer_);
+    }
 }
 
-SSLError SslConnection::getLastError(int ret) 
+SSLError SslConnection::getLastError(int ret)
 {
     int err = SSL_get_error(ssl_, ret);
-    switch (err) 
+    switch (err)
     {
         case SSL_ERROR_NONE:
             return SSLError::NONE;
@@ -187,9 +206,9 @@ SSLError SslConnection::getLastError(int ret)
     }
 }
 
-void SslConnection::handleError(SSLError error) 
+void SslConnection::handleError(SSLError error)
 {
-    switch (error) 
+    switch (error)
     {
         case SSLError::WANT_READ:
         case SSLError::WANT_WRITE:
@@ -200,6 +219,7 @@ void SslConnection::handleError(SSLError error)
         case SSLError::UNKNOWN:
             LOG_ERROR << "SSL error occurred: " << ERR_error_string(ERR_get_error(), nullptr);
             state_ = SSLState::ERROR;
+            flush(); // 可能有 alert
             conn_->shutdown();
             break;
         default:
@@ -207,42 +227,4 @@ void SslConnection::handleError(SSLError error)
     }
 }
 
-int SslConnection::bioWrite(BIO* bio, const char* data, int len) 
-{
-    SslConnection* conn = static_cast<SslConnection*>(BIO_get_data(bio));
-    if (!conn) return -1;
-
-    conn->conn_->send(data, len);
-    return len;
-}
-
-int SslConnection::bioRead(BIO* bio, char* data, int len) 
-{
-    SslConnection* conn = static_cast<SslConnection*>(BIO_get_data(bio));
-    if (!conn) return -1;
-
-    size_t readable = conn->readBuffer_.readableBytes();
-    if (readable == 0) 
-    {
-        return -1;  // 无数据可读
-    }
-
-    size_t toRead = std::min(static_cast<size_t>(len), readable);
-    memcpy(data, conn->readBuffer_.peek(), toRead);
-    conn->readBuffer_.retrieve(toRead);
-    return toRead;
-}
-
-long SslConnection::bioCtrl(BIO* bio, int cmd, long num, void* ptr) 
-{
-    switch (cmd) 
-    {
-        case BIO_CTRL_FLUSH:
-            return 1;
-        default:
-            return 0;
-    }
-}
-
-
-} // namespace ssl 
\ No newline at end of file
+} // namespace ssl
@@ -55,6 +55,9 @@ bool SslContext::initialize()
     // 设置会话缓存
     setupSessionCache();
 
+    // ALPN 协商（HTTP/2）
+    setupAlpn();
+
     LOG_INFO << "SSL context initialized successfully";
     return true;
 }
@@ -140,6 +143,39 @@ void SslContext::setupSessionCache()
     SSL_CTX_set_timeout(ctx_, config_.getSessionTimeout());
 }
 
+void SslContext::setupAlpn()
+{
+    const std::vector<std::string>& protocols = config_.getAlpnProtocols();
+    if (protocols.empty())
+    {
+        return;
+    }
+    alpnWire_.clear();
+    for (const std::string& protocol : protocols)
+    {
+        alpnWire_.push_back(static_cast<unsigned char>(protocol.size()));
+        alpnWire_.insert(alpnWire_.end(), protocol.begin(), protocol.end());
+    }
+    SSL_CTX_set_alpn_select_cb(ctx_, &SslContext::selectAlpn, this);
+}
+
+int SslContext::selectAlpn(SSL*, const unsigned char** out, unsigned char* outLen,
+                           const unsigned char* in, unsigned int inLen, void* arg)
+{
+    SslContext* self = static_cast<SslContext*>(arg);
+    unsigned char* selected = nullptr;
+    // 第一组参数是服务端的列表：按服务端的优先顺序选
+    if (SSL_select_next_proto(&selected, outLen, self->alpnWire_.data(),
+                              static_cast<unsigned int>(self->alpnWire_.size()),
+                              in, inLen) != OPENSSL_NPN_NEGOTIATED)
+    {
+        // 没有共同的协议：不选，按没有 ALPN 处理（HTTP/1.1）
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
 void SslContext::handleSslError(const char* msg)
 {
     char buf[256];
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <muduo/net/Buffer.h>
+
+#include "http/HttpContext.h"
+
+/*
+    测试用的最小断言工具，不依赖测试框架：
+      - CHECK / CHECK_EQ 失败时打印位置并计数，继续执行后面的检查
+      - main 最后 return test::finish()，有失败时返回非 0，由 ctest 判定
+      - parse() 把一个只有请求头的请求喂给 HttpContext，供中间件的测试构造请求
+ */
+namespace test
+{
+
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline std::string printable(std::string_view s)
+{
+    std::string out;
+    for (unsigned char c : s)
+    {
+        if (c == '\r')
+        {
+            out += "\\r";
+        }
+        else if (c == '\n')
+        {
+            out += "\\n";
+        }
+        else if (c < 0x20 || c >= 0x7f)
+        {
+            char hex[8];
+            std::snprintf(hex, sizeof hex, "\\x%02x", c);
+            out += hex;
+        }
+        else
+        {
+            out += static_cast<char>(c);
+        }
+    }
+    return out;
+}
+
+inline std::string toString(std::string_view s)
+{ return "\"" + printable(s) + "\""; }
+
+inline std::string toString(const std::string& s)
+{ return toString(std::string_view(s)); }
+
+inline std::string toString(const char* s)
+{ return toString(std::string_view(s)); }
+
+inline std::string toString(bool b)
+{ return b ? "true" : "false"; }
+
+template <typename T>
+std::string toString(const T& v)
+{ return std::to_string(v); }
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+// 解析 requestLine 加 Host 和给出的请求头，返回请求是否完整解析。
+// 没有请求体的请求也停在 gotHeaders，这里替调用方 startBody()
+inline bool parse(http::HttpContext* context, const std::string& requestLine, const Headers& headers)
+{
+    std::string text = requestLine + "\r\nHost: localhost\r\n";
+    for (const auto& header : headers)
+    {
+        text += header.first + ": " + header.second + "\r\n";
+    }
+    text += "\r\n";
+    muduo::net::Buffer buf;
+    buf.append(text.data(), text.size());
+    context->reset();
+    if (!context->parseRequest(&buf, muduo::Timestamp()))
+    {
+        return false;
+    }
+    return context->gotHeaders() && context->startBody() && context->gotAll();
+}
+
+// 只带一个请求头（value 为空时不带）
+inline bool parse(http::HttpContext* context, const std::string& requestLine,
+                  const std::string& name = std::string(), const std::string& value = std::string())
+{
+    Headers headers;
+    if (!value.empty())
+    {
+        headers.emplace_back(name, value);
+    }
+    return parse(context, requestLine, headers);
+}
+
+inline int finish()
+{
+    if (failures() == 0)
+    {
+        std::printf("all checks passed\n");
+        return 0;
+    }
+    std::printf("%d check(s) failed\n", failures());
+    return 1;
+}
+
+} // namespace test
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            ++test::failures(); \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const auto& a_ = (actual); \
+        const auto& e_ = (expected); \
+        if (!(a_ == e_)) \
+        { \
+            ++test::failures(); \
+            std::printf("%s:%d: CHECK_EQ(%s, %s) failed: %s != %s\n", __FILE__, __LINE__, \
+                        #actual, #expected, test::toString(a_).c_str(), test::toString(e_).c_str()); \
+        } \
+    } while (0)
@@ -0,0 +1,91 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <cstring>
+
+#include "http/AdmissionControl.h"
+#include "TestUtil.h"
+
+/*
+    AdmissionControl：总连接数和单 IP 连接数上限、被拒绝的连接不计数、
+    在途请求和工作线程排队深度超过阈值时拒绝新请求
+ */
+
+using namespace http;
+
+namespace
+{
+
+muduo::net::InetAddress peer(const char* ip, uint16_t port)
+{
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, ip, &addr.sin_addr);
+    return muduo::net::InetAddress(addr);
+}
+
+void testConnections()
+{
+    AdmissionLimits limits;
+    limits.maxConnections = 3;
+    limits.maxConnectionsPerIp = 2;
+    AdmissionControl admission(limits);
+    CHECK_EQ(admission.maxConnections(), static_cast<size_t>(3));
+
+    // 同一 IP 不同端口算同一个客户端
+    CHECK(admission.acquireConnection(peer("10.0.0.1", 1000)));
+    CHECK(admission.acquireConnection(peer("10.0.0.1", 1001)));
+    CHECK(!admission.acquireConnection(peer("10.0.0.1", 1002)));
+    CHECK_EQ(admission.connections(), static_cast<size_t>(2));
+
+    CHECK(admission.acquireConnection(peer("10.0.0.2", 1000)));
+    CHECK(!admission.acquireConnection(peer("10.0.0.3", 1000))); // 总数已满
+    CHECK_EQ(admission.connections(), static_cast<size_t>(3));
+
+    admission.releaseConnection(peer("10.0.0.1", 1000));
+    CHECK(admission.acquireConnection(peer("10.0.0.1", 1003)));
+    admission.releaseConnection(peer("10.0.0.2", 1000));
+    CHECK(admission.acquireConnection(peer("10.0.0.3", 1000)));
+    CHECK_EQ(admission.connections(), static_cast<size_t>(3));
+}
+
+void testDefaultLimit()
+{
+    // 不设上限时按 fd 上限推算，总是留出余量
+    AdmissionControl admission;
+    CHECK(admission.maxConnections() == 0 || admission.maxConnections() > AdmissionControl::kReservedFds / 2);
+}
+
+void testRequests()
+{
+    AdmissionLimits limits;
+    limits.maxInflightRequests = 2;
+    limits.maxWorkerQueue = 4;
+    AdmissionControl admission(limits);
+
+    CHECK(admission.admitRequest(false, 0) == nullptr);
+    CHECK(admission.admitRequest(true, 3) == nullptr);
+    CHECK(admission.admitRequest(false, 0) != nullptr); // 在途请求已满
+    CHECK_EQ(admission.inflightRequests(), static_cast<size_t>(2));
+
+    admission.finishRequest();
+    // 排队深度只对要 offload 的请求检查
+    CHECK(admission.admitRequest(true, 4) != nullptr);
+    CHECK(admission.admitRequest(false, 4) == nullptr);
+    CHECK_EQ(admission.inflightRequests(), static_cast<size_t>(2));
+
+    // 没有采样过的线程，事件循环延迟为 0
+    CHECK_EQ(AdmissionControl::loopLagMs(), 0.0);
+}
+
+} // namespace
+
+int main()
+{
+    testConnections();
+    testDefaultLimit();
+    testRequests();
+    return test::finish();
+}
@@ -0,0 +1,211 @@
+#include <memory>
+#include <string>
+
+#include <zlib.h>
+
+#include "http/HttpContext.h"
+#include "middleware/compression/CompressionMiddleware.h"
+#include "TestUtil.h"
+
+/*
+    CompressionMiddleware：Accept-Encoding 协商、跳过不该压缩的响应、
+    gzip/deflate 结果能被 zlib 还原、共享响应体的压缩结果被缓存复用
+ */
+
+using namespace http;
+using middleware::CompressionMiddleware;
+
+namespace
+{
+
+// zlib 格式（windowBits 15）或 gzip 格式（15 + 16）解压
+std::string inflateAll(std::string_view in, int windowBits)
+{
+    z_stream stream = z_stream();
+    if (inflateInit2(&stream, windowBits) != Z_OK)
+    {
+        return std::string();
+    }
+    std::string out(1 << 20, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    stream.avail_in = static_cast<uInt>(in.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int rc = inflate(&stream, Z_FINISH);
+    out.resize(rc == Z_STREAM_END ? stream.total_out : 0);
+    inflateEnd(&stream);
+    return out;
+}
+
+std::string textBody()
+{
+    std::string body;
+    for (int i = 0; i < 200; ++i)
+    {
+        body += "{\"id\":" + std::to_string(i) + ",\"role\":\"assistant\",\"content\":\"hello\"},";
+    }
+    return body;
+}
+
+void prepare(HttpResponse* response, std::string_view type)
+{
+    response->reset(false);
+    response->setVersion("HTTP/1.1");
+    response->setStatusCode(HttpResponse::k200Ok);
+    response->setContentType(type);
+}
+
+void testNegotiate()
+{
+    CHECK_EQ(CompressionMiddleware::negotiate(""), CompressionMiddleware::kIdentity);
+    CHECK_EQ(CompressionMiddleware::negotiate("gzip, deflate"), CompressionMiddleware::kGzip);
+    CHECK_EQ(CompressionMiddleware::negotiate("deflate"), CompressionMiddleware::kDeflate);
+    CHECK_EQ(CompressionMiddleware::negotiate("GZip;q=0.5"), CompressionMiddleware::kGzip);
+    CHECK_EQ(CompressionMiddleware::negotiate("gzip;q=0, deflate"), CompressionMiddleware::kDeflate);
+    CHECK_EQ(CompressionMiddleware::negotiate("gzip; q=0.000"), CompressionMiddleware::kIdentity);
+    CHECK_EQ(CompressionMiddleware::negotiate("identity"), CompressionMiddleware::kIdentity);
+    CHECK_EQ(CompressionMiddleware::negotiate("*"), CompressionMiddleware::kGzip);
+#ifndef HTTP_WITH_BROTLI
+    CHECK_EQ(CompressionMiddleware::negotiate("br"), CompressionMiddleware::kIdentity);
+#endif
+}
+
+void testCompress()
+{
+    CompressionMiddleware compression;
+    HttpContext context;
+    HttpResponse& response = context.response();
+    const std::string body = textBody();
+
+    CHECK(test::parse(&context, "GET /api/messages HTTP/1.1", "Accept-Encoding", "gzip, deflate"));
+    prepare(&response, "application/json");
+    response.addHeader("ETag", "\"v1\"");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK_EQ(response.getHeader(HttpHeaders::kContentEncoding), std::string_view("gzip"));
+    CHECK_EQ(response.getHeader(HttpHeaders::kVary), std::string_view("Accept-Encoding"));
+    CHECK_EQ(response.getHeader(HttpHeaders::kETag), std::string_view("W/\"v1\""));
+    CHECK(response.bodySize() < body.size());
+    CHECK(inflateAll(response.body(), 15 + 16) == body);
+
+    // 同一线程复用 z_stream，连续压缩结果仍然正确
+    CHECK(test::parse(&context, "GET /api/messages HTTP/1.1", "Accept-Encoding", "deflate"));
+    prepare(&response, "application/json");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK_EQ(response.getHeader(HttpHeaders::kContentEncoding), std::string_view("deflate"));
+    CHECK(inflateAll(response.body(), 15) == body);
+}
+
+// HEAD 的头部和同一资源的 GET 完全一致，丢掉响应体后 Content-Length 仍是压缩后的长度
+void testHead()
+{
+    CompressionMiddleware compression;
+    HttpContext context;
+    HttpResponse& response = context.response();
+    const std::string body = textBody();
+
+    CHECK(test::parse(&context, "GET /api/messages HTTP/1.1", "Accept-Encoding", "gzip"));
+    prepare(&response, "application/json");
+    response.addHeader("ETag", "\"v1\"");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    const int64_t getLength = response.contentLengthValue();
+
+    CHECK(test::parse(&context, "HEAD /api/messages HTTP/1.1", "Accept-Encoding", "gzip"));
+    CHECK(context.request().method() == HttpRequest::kHead);
+    prepare(&response, "application/json");
+    response.addHeader("ETag", "\"v1\"");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK_EQ(response.getHeader(HttpHeaders::kContentEncoding), std::string_view("gzip"));
+    CHECK_EQ(response.getHeader(HttpHeaders::kVary), std::string_view("Accept-Encoding"));
+    CHECK_EQ(response.getHeader(HttpHeaders::kETag), std::string_view("W/\"v1\""));
+    response.discardBody();
+    CHECK_EQ(response.bodySize(), size_t(0));
+    CHECK_EQ(response.contentLengthValue(), getLength);
+}
+
+void testSkip()
+{
+    middleware::CompressionConfig config = middleware::CompressionConfig::defaultConfig();
+    config.excludedPaths = {"/download/"};
+    CompressionMiddleware compression(config);
+    HttpContext context;
+    HttpResponse& response = context.response();
+    const std::string body = textBody();
+
+    // 太小：不压缩，但仍然声明 Vary
+    CHECK(test::parse(&context, "GET /api/messages HTTP/1.1", "Accept-Encoding", "gzip"));
+    prepare(&response, "application/json");
+    response.setBody(std::string("{}"));
+    compression.after(context.request(), response);
+    CHECK(response.getHeader(HttpHeaders::kContentEncoding).empty());
+    CHECK_EQ(response.getHeader(HttpHeaders::kVary), std::string_view("Accept-Encoding"));
+
+    // 非文本类型
+    prepare(&response, "image/png");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK(response.getHeader(HttpHeaders::kContentEncoding).empty());
+    CHECK_EQ(response.bodySize(), body.size());
+
+    // handler 显式要求不压缩
+    prepare(&response, "text/plain");
+    response.addHeader("Content-Encoding", "identity");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK_EQ(response.getHeader(HttpHeaders::kContentEncoding), std::string_view("identity"));
+    CHECK_EQ(response.bodySize(), body.size());
+
+    // 客户端不接受压缩
+    CHECK(test::parse(&context, "GET /api/messages HTTP/1.1"));
+    prepare(&response, "text/plain");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK(response.getHeader(HttpHeaders::kContentEncoding).empty());
+
+    // 排除的路由
+    CHECK(test::parse(&context, "GET /download/export.json HTTP/1.1", "Accept-Encoding", "gzip"));
+    prepare(&response, "application/json");
+    response.setBody(body);
+    compression.after(context.request(), response);
+    CHECK(response.getHeader(HttpHeaders::kContentEncoding).empty());
+    CHECK(response.getHeader(HttpHeaders::kVary).empty());
+}
+
+void testSharedBodyCache()
+{
+    CompressionMiddleware compression;
+    HttpContext context;
+    HttpResponse& response = context.response();
+    auto page = std::make_shared<const std::string>(textBody());
+
+    CHECK(test::parse(&context, "GET / HTTP/1.1", "Accept-Encoding", "gzip"));
+    prepare(&response, "text/html; charset=utf-8");
+    response.setBody(page);
+    compression.after(context.request(), response);
+    const HttpResponse::BodySegment* first = response.sharedBody();
+    CHECK(first != nullptr);
+    const char* encoded = first ? first->data.data() : nullptr;
+    CHECK(first && inflateAll(first->data, 15 + 16) == *page);
+
+    // 同一份共享响应体再压一次，直接拿到缓存里同一块内存
+    prepare(&response, "text/html; charset=utf-8");
+    response.setBody(page);
+    compression.after(context.request(), response);
+    const HttpResponse::BodySegment* second = response.sharedBody();
+    CHECK(second != nullptr && second->data.data() == encoded);
+}
+
+} // namespace
+
+int main()
+{
+    testNegotiate();
+    testCompress();
+    testHead();
+    testSkip();
+    testSharedBodyCache();
+    return test::finish();
+}
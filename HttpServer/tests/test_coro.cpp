@@ -0,0 +1,112 @@
+#include <stdexcept>
+#include <string>
+
+#include "coro/CoroutineHandler.h"
+#include "TestUtil.h"
+
+/*
+    coro::Task / CoroutineHandler：嵌套协程的返回值和异常沿 co_await 链传回，
+    没有工作线程池时 runBlocking 就地执行；一次都没挂起的协程 handler 和普通 handler 一样同步完成，
+    抛出的 HttpResponse 直接作为响应，其他异常回 500
+ */
+
+using namespace http;
+
+namespace
+{
+
+coro::Task<int> leaf(int value)
+{
+    if (value < 0)
+    {
+        throw std::runtime_error("negative");
+    }
+    co_return value * 2;
+}
+
+// 嵌套很深也不会爆栈：结束时对称转移回等待者
+coro::Task<int> chain(int depth)
+{
+    if (depth == 0)
+    {
+        co_return co_await leaf(1);
+    }
+    co_return 1 + co_await chain(depth - 1);
+}
+
+class TestHandler : public coro::CoroutineHandler
+{
+public:
+    explicit TestHandler(int mode)
+        : mode_(mode)
+    {}
+
+protected:
+    coro::Task<> handleAsync(muduo::net::TcpConnectionPtr,
+                             const HttpRequest&,
+                             HttpResponse* resp) override
+    {
+        int value = co_await chain(1000);
+        // pool 为空：fn 在当前线程执行，不挂起
+        std::string body = co_await coro::runBlocking(nullptr, [value]() { return std::to_string(value); });
+        if (mode_ == 1)
+        {
+            HttpResponse busy;
+            busy.setStatusCode(HttpResponse::k503ServiceUnavailable);
+            throw busy;
+        }
+        if (mode_ == 2)
+        {
+            co_await leaf(-1);
+        }
+        if (mode_ == 3)
+        {
+            throw 42; // 不是 std::exception
+        }
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setBody(body);
+    }
+
+private:
+    int mode_;
+};
+
+void testTask()
+{
+    TestHandler ok(0);
+    HttpRequest req;
+    HttpResponse resp;
+    ok.handle(muduo::net::TcpConnectionPtr(), req, &resp);
+    CHECK_EQ(resp.getStatusCode(), HttpResponse::k200Ok);
+    CHECK_EQ(resp.body(), std::string_view("1002"));
+}
+
+void testExceptions()
+{
+    HttpRequest req;
+
+    TestHandler busy(1);
+    HttpResponse resp;
+    busy.handle(muduo::net::TcpConnectionPtr(), req, &resp);
+    CHECK_EQ(resp.getStatusCode(), HttpResponse::k503ServiceUnavailable);
+
+    TestHandler failing(2);
+    HttpResponse failed;
+    failing.handle(muduo::net::TcpConnectionPtr(), req, &failed);
+    CHECK_EQ(failed.getStatusCode(), HttpResponse::k500InternalServerError);
+    CHECK_EQ(failed.body(), std::string_view("negative"));
+
+    TestHandler unknown(3);
+    HttpResponse crashed;
+    unknown.handle(muduo::net::TcpConnectionPtr(), req, &crashed);
+    CHECK_EQ(crashed.getStatusCode(), HttpResponse::k500InternalServerError);
+}
+
+} // namespace
+
+int main()
+{
+    testTask();
+    testExceptions();
+    return test::finish();
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "http/CpuLayout.h"
+#include "TestUtil.h"
+
+/*
+    CpuLayout：CPU 列表的解析和格式化、配置串的划分规则（各组不重叠、I/O 线程每个物理核一个），
+    配置出错时保持原来的划分
+ */
+
+using namespace http;
+
+namespace
+{
+
+void testCpuList()
+{
+    std::vector<int> cpus;
+    CHECK(CpuLayout::parseCpuList("0-3,8", &cpus));
+    CHECK(cpus == std::vector<int>({0, 1, 2, 3, 8}));
+    CHECK_EQ(CpuLayout::formatCpuList(cpus), std::string("0-3,8"));
+    CHECK_EQ(CpuLayout::formatCpuList({9, 1, 2, 4, 3, 7}), std::string("1-4,7,9"));
+    CHECK_EQ(CpuLayout::formatCpuList({}), std::string());
+
+    CHECK(CpuLayout::parseCpuList("5", &cpus) && cpus == std::vector<int>({5}));
+    CHECK(!CpuLayout::parseCpuList("", &cpus));
+    CHECK(!CpuLayout::parseCpuList("3-1", &cpus));
+    CHECK(!CpuLayout::parseCpuList("1,,2", &cpus));
+    CHECK(!CpuLayout::parseCpuList("a-b", &cpus));
+    CHECK(!CpuLayout::parseCpuList("0-100000", &cpus));
+}
+
+void testConfigure()
+{
+    CpuLayout& layout = CpuLayout::instance();
+    // 默认不绑核，I/O 线程数按可用的物理核数
+    CHECK(!layout.pinning());
+    CHECK(!layout.available().empty());
+    CHECK(layout.ioThreads() > 0);
+
+    CHECK(layout.configure("io=3; pin=1"));
+    CHECK_EQ(layout.ioThreads(), 3);
+    CHECK(layout.pinning());
+    CHECK(layout.cpus("db").empty());
+
+    // 配置有误：返回 false，原来的划分不变
+    CHECK(!layout.configure("db"));
+    CHECK(!layout.configure("db=x"));
+    CHECK(!layout.configure("db=100000"));
+    CHECK(!layout.configure("db=0-0 llm=0-0"));
+    CHECK_EQ(layout.ioThreads(), 3);
+    CHECK(layout.pinning());
+
+    if (layout.available().size() >= 2)
+    {
+        // 按个数划分的组从末尾取，和 I/O 线程的 CPU 不重叠
+        CHECK(layout.configure("db=1"));
+        const std::vector<int>& db = layout.cpus("db");
+        CHECK_EQ(db.size(), static_cast<size_t>(1));
+        CHECK(db.size() == 1 && db[0] == layout.available().back());
+        for (int cpu : layout.ioCpus())
+        {
+            CHECK(std::find(db.begin(), db.end(), cpu) == db.end());
+        }
+        CHECK(layout.describe().find("db=") != std::string::npos);
+    }
+
+    // 指定列表的组正好拿到这些 CPU
+    std::string first = std::to_string(layout.available().front());
+    if (layout.available().size() >= 2)
+    {
+        CHECK(layout.configure("tools=" + first + "-" + first));
+        CHECK(layout.cpus("tools") == std::vector<int>({layout.available().front()}));
+        CHECK(std::find(layout.ioCpus().begin(), layout.ioCpus().end(), layout.available().front())
+              == layout.ioCpus().end());
+    }
+
+    // 全部 CPU 都划给工作线程组时，I/O 线程没有 CPU 可用
+    CHECK(!layout.configure("db=" + std::to_string(layout.available().size())));
+
+    CHECK(layout.configure("pin=0"));
+    CHECK(!layout.pinning());
+}
+
+} // namespace
+
+int main()
+{
+    testCpuList();
+    testConfigure();
+    return test::finish();
+}
@@ -0,0 +1,128 @@
+#include <string>
+
+#include "http/HttpContext.h"
+#include "middleware/etag/EtagMiddleware.h"
+#include "utils/HashUtil.h"
+#include "TestUtil.h"
+
+/*
+    EtagMiddleware：相同的响应体得到相同的弱 ETag，If-None-Match 命中时回不带响应体的 304，
+    不该打标签的响应保持原样
+ */
+
+using namespace http;
+using middleware::EtagMiddleware;
+
+namespace
+{
+
+// 和 handler 一样设置响应（带原因短语）
+void respond(HttpResponse* response, const std::string& body)
+{
+    response->reset(false);
+    response->setVersion("HTTP/1.1");
+    response->setStatusCode(HttpResponse::k200Ok);
+    response->setStatusMessage("OK");
+    response->setContentType("application/json");
+    response->setBody(body);
+}
+
+void testHash()
+{
+    CHECK_EQ(HashUtil::hash64("[]"), HashUtil::hash64(std::string("[]")));
+    CHECK(HashUtil::hash64("[1]") != HashUtil::hash64("[2]"));
+    // 覆盖各个长度分支：0-3、4-16、17-48、更长
+    std::string text(300, 'a');
+    for (size_t len : {0u, 3u, 4u, 16u, 17u, 48u, 49u, 300u})
+    {
+        std::string other = text.substr(0, len);
+        if (len > 0)
+        {
+            other[len - 1] = 'b';
+        }
+        CHECK(len == 0 || HashUtil::hash64(text.substr(0, len)) != HashUtil::hash64(other));
+    }
+
+    char hex[17];
+    CHECK_EQ(HashUtil::toHex(0x1234abcdULL, hex), static_cast<size_t>(16));
+    CHECK_EQ(std::string(hex, 16), std::string("000000001234abcd"));
+}
+
+void testNotModified()
+{
+    middleware::EtagConfig config;
+    config.paths = {"/api/conversations"};
+    EtagMiddleware etag(config);
+    HttpContext context;
+    HttpResponse& response = context.response();
+    const std::string body = "[{\"id\":1,\"title\":\"hello\"}]";
+
+    CHECK(test::parse(&context, "GET /api/conversations HTTP/1.1"));
+    respond(&response, body);
+    etag.after(context.request(), response);
+    std::string tag(response.getHeader(HttpHeaders::kETag));
+    CHECK_EQ(tag.substr(0, 3), std::string("W/\""));
+    CHECK_EQ(tag.size(), static_cast<size_t>(20));
+    CHECK_EQ(response.getHeader(HttpHeaders::kCacheControl), std::string_view("private, no-cache"));
+    CHECK_EQ(response.getStatusCode(), HttpResponse::k200Ok);
+
+    // 带上次的 ETag 再来：304，没有响应体，状态行用标准原因短语
+    CHECK(test::parse(&context, "GET /api/conversations HTTP/1.1", "If-None-Match", "\"other\", " + tag));
+    respond(&response, body);
+    etag.after(context.request(), response);
+    CHECK_EQ(response.getStatusCode(), HttpResponse::k304NotModified);
+    CHECK_EQ(response.bodySize(), static_cast<size_t>(0));
+    muduo::net::Buffer out;
+    response.appendToBuffer(&out);
+    CHECK_EQ(out.retrieveAllAsString().substr(0, 27), std::string("HTTP/1.1 304 Not Modified\r\n"));
+
+    // 内容变了：照常 200
+    CHECK(test::parse(&context, "GET /api/conversations HTTP/1.1", "If-None-Match", tag));
+    respond(&response, body + " ");
+    etag.after(context.request(), response);
+    CHECK_EQ(response.getStatusCode(), HttpResponse::k200Ok);
+    CHECK(response.getHeader(HttpHeaders::kETag) != std::string_view(tag));
+
+    CHECK(EtagMiddleware::matches("*", tag));
+    CHECK(EtagMiddleware::matches(tag.substr(2), tag));
+    CHECK(!EtagMiddleware::matches("\"a\", \"b\"", "W/\"c\""));
+}
+
+void testSkip()
+{
+    middleware::EtagConfig config;
+    config.paths = {"/api/conversations"};
+    EtagMiddleware etag(config);
+    HttpContext context;
+    HttpResponse& response = context.response();
+
+    // 不在配置的路径下
+    CHECK(test::parse(&context, "GET /api/user HTTP/1.1"));
+    respond(&response, "{}");
+    etag.after(context.request(), response);
+    CHECK(response.getHeader(HttpHeaders::kETag).empty());
+
+    // 非 GET/HEAD
+    CHECK(test::parse(&context, "DELETE /api/conversations HTTP/1.1"));
+    respond(&response, "{}");
+    etag.after(context.request(), response);
+    CHECK(response.getHeader(HttpHeaders::kETag).empty());
+
+    // handler 已经给了 ETag
+    CHECK(test::parse(&context, "GET /api/conversations HTTP/1.1", "If-None-Match", "\"v7\""));
+    respond(&response, "{}");
+    response.addHeader(HttpHeaders::kETag, "\"v7\"");
+    etag.after(context.request(), response);
+    CHECK_EQ(response.getHeader(HttpHeaders::kETag), std::string_view("\"v7\""));
+    CHECK_EQ(response.getStatusCode(), HttpResponse::k200Ok);
+}
+
+} // namespace
+
+int main()
+{
+    testHash();
+    testNotModified();
+    testSkip();
+    return test::finish();
+}
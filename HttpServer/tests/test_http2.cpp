@@ -0,0 +1,428 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nghttp2/nghttp2.h>
+
+#include <muduo/net/Buffer.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "http/Http2Session.h"
+#include "TestUtil.h"
+
+/*
+    Http2Session：请求和响应的往返、每个流各自的请求体期限（到期回 408 加 RST_STREAM，
+    别的流不受影响）、连接上缓存的请求体超过上限之后暂扣流量控制窗口，有流结束之后再归还。
+    服务端一侧是 socketpair 上的 TcpConnection，客户端是 nghttp2 的客户端会话，
+    测试在两边之间搬运数据，不跑事件循环。需要以 HTTP_WITH_NGHTTP2 编译
+ */
+
+using namespace http;
+
+namespace
+{
+
+nghttp2_nv makeNv(const char* name, const char* value)
+{
+    nghttp2_nv nv;
+    nv.name = reinterpret_cast<uint8_t*>(const_cast<char*>(name));
+    nv.namelen = std::strlen(name);
+    nv.value = reinterpret_cast<uint8_t*>(const_cast<char*>(value));
+    nv.valuelen = std::strlen(value);
+    nv.flags = NGHTTP2_NV_FLAG_NONE;
+    return nv;
+}
+
+// 客户端：每个流记下状态码、响应体和对方的 RST_STREAM
+class Client
+{
+public:
+    struct Stream
+    {
+        int         status = 0;
+        std::string body;
+        bool        reset = false;
+        uint32_t    errorCode = 0;
+        bool        closed = false;
+    };
+
+    // 请求体；end 为 false 时发完 data 之后暂停，模拟发得慢的客户端
+    struct Upload
+    {
+        std::string data;
+        size_t      offset = 0;
+        bool        end = true;
+    };
+
+    Client()
+    {
+        nghttp2_session_callbacks* callbacks;
+        nghttp2_session_callbacks_new(&callbacks);
+        nghttp2_session_callbacks_set_on_header_callback(callbacks, &Client::onHeader);
+        nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &Client::onDataChunkRecv);
+        nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, &Client::onFrameRecv);
+        nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &Client::onStreamClose);
+        nghttp2_session_client_new(&session_, callbacks, this);
+        nghttp2_session_callbacks_del(callbacks);
+        nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, nullptr, 0);
+    }
+
+    ~Client()
+    { nghttp2_session_del(session_); }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    int32_t request(const char* method, const char* path, std::shared_ptr<Upload> upload = nullptr)
+    {
+        nghttp2_nv nva[] = {
+            makeNv(":method", method), makeNv(":scheme", "http"),
+            makeNv(":authority", "example.com"), makeNv(":path", path),
+        };
+        nghttp2_data_provider provider;
+        provider.source.ptr = upload.get();
+        provider.read_callback = &Client::readBody;
+        int32_t id = nghttp2_submit_request(session_, nullptr, nva, sizeof nva / sizeof nva[0],
+                                            upload ? &provider : nullptr, nullptr);
+        uploads_[id] = std::move(upload);
+        return id;
+    }
+
+    void cancel(int32_t id)
+    { nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, id, NGHTTP2_CANCEL); }
+
+    // 要发给服务端的数据
+    std::string take()
+    {
+        std::string out;
+        const uint8_t* data;
+        ssize_t n;
+        while ((n = nghttp2_session_mem_send(session_, &data)) > 0)
+        {
+            out.append(reinterpret_cast<const char*>(data), static_cast<size_t>(n));
+        }
+        return out;
+    }
+
+    bool receive(const std::string& in)
+    {
+        ssize_t n = nghttp2_session_mem_recv(session_, reinterpret_cast<const uint8_t*>(in.data()), in.size());
+        return n == static_cast<ssize_t>(in.size());
+    }
+
+    Stream& stream(int32_t id)
+    { return streams_[id]; }
+
+private:
+    static Client* self(void* userData)
+    { return static_cast<Client*>(userData); }
+
+    static int onHeader(nghttp2_session*, const nghttp2_frame* frame, const uint8_t* name, size_t nameLen,
+                        const uint8_t* value, size_t valueLen, uint8_t, void* userData)
+    {
+        if (std::string(reinterpret_cast<const char*>(name), nameLen) == ":status")
+        {
+            self(userData)->streams_[frame->hd.stream_id].status =
+                std::atoi(std::string(reinterpret_cast<const char*>(value), valueLen).c_str());
+        }
+        return 0;
+    }
+
+    static int onDataChunkRecv(nghttp2_session*, uint8_t, int32_t streamId, const uint8_t* data, size_t len,
+                               void* userData)
+    {
+        self(userData)->streams_[streamId].body.append(reinterpret_cast<const char*>(data), len);
+        return 0;
+    }
+
+    static int onFrameRecv(nghttp2_session*, const nghttp2_frame* frame, void* userData)
+    {
+        if (frame->hd.type == NGHTTP2_RST_STREAM)
+        {
+            Stream& stream = self(userData)->streams_[frame->hd.stream_id];
+            stream.reset = true;
+            stream.errorCode = frame->rst_stream.error_code;
+        }
+        return 0;
+    }
+
+    static int onStreamClose(nghttp2_session*, int32_t streamId, uint32_t, void* userData)
+    {
+        self(userData)->streams_[streamId].closed = true;
+        return 0;
+    }
+
+    static ssize_t readBody(nghttp2_session*, int32_t, uint8_t* buf, size_t length, uint32_t* dataFlags,
+                            nghttp2_data_source* source, void*)
+    {
+        auto* upload = static_cast<Upload*>(source->ptr);
+        size_t n = std::min(length, upload->data.size() - upload->offset);
+        std::memcpy(buf, upload->data.data() + upload->offset, n);
+        upload->offset += n;
+        if (upload->offset == upload->data.size())
+        {
+            if (upload->end)
+            {
+                *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+            }
+            else if (n == 0)
+            {
+                return NGHTTP2_ERR_DEFERRED;
+            }
+        }
+        return static_cast<ssize_t>(n);
+    }
+
+    nghttp2_session*                                  session_;
+    std::map<int32_t, Stream>                         streams_;
+    std::map<int32_t, std::shared_ptr<Upload>>        uploads_;
+};
+
+// 服务端：收完的请求记下来，路径不是 /slow 的立即回 200，响应体是收到的请求体长度
+class Server
+{
+public:
+    Server(muduo::net::EventLoop* loop, const HttpLimits& limits)
+    {
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds_) != 0)
+        {
+            std::abort();
+        }
+        muduo::net::InetAddress addr(0);
+        conn_ = std::make_shared<muduo::net::TcpConnection>(loop, "h2", fds_[0], addr, addr);
+        conn_->setConnectionCallback([](const muduo::net::TcpConnectionPtr&) {});
+        conn_->connectEstablished();
+
+        session_ = std::make_unique<Http2Session>(conn_.get(), nullptr, limits);
+        session_->setRequestCallback([this](const Http2Session::StreamPtr& stream)
+        {
+            requests.push_back(stream);
+            if (stream->request.path() != "/slow")
+            {
+                respond(stream);
+            }
+        });
+        session_->setCloseCallback([this](const Http2Session::StreamPtr& stream)
+        { closed.push_back(stream->id); });
+        session_->start();
+    }
+
+    ~Server()
+    {
+        session_.reset();
+        conn_->connectDestroyed();
+        ::close(fds_[1]);
+    }
+
+    void respond(const Http2Session::StreamPtr& stream)
+    {
+        HttpResponse& response = stream->response;
+        response.reset(false);
+        response.setVersion("HTTP/2");
+        response.setStatusCode(HttpResponse::k200Ok);
+        response.setBody(std::to_string(stream->request.getBody().size()));
+        session_->submitResponse(stream);
+    }
+
+    // 要发给客户端的数据
+    std::string take()
+    {
+        std::string out;
+        char buf[65536];
+        ssize_t n;
+        while ((n = ::read(fds_[1], buf, sizeof buf)) > 0)
+        {
+            out.append(buf, static_cast<size_t>(n));
+        }
+        return out;
+    }
+
+    Http2Session& session()
+    { return *session_; }
+
+    std::vector<Http2Session::StreamPtr> requests;
+    std::vector<int32_t>                 closed;
+
+private:
+    int                                  fds_[2];
+    muduo::net::TcpConnectionPtr         conn_;
+    std::unique_ptr<Http2Session>        session_;
+};
+
+// 两边来回搬运数据，直到都没有要发的
+void exchange(Client& client, Server& server)
+{
+    for (int i = 0; i < 100000; ++i)
+    {
+        std::string request = client.take();
+        if (!request.empty())
+        {
+            muduo::net::Buffer buf;
+            buf.append(request.data(), request.size());
+            CHECK(server.session().onRead(&buf));
+        }
+        std::string response = server.take();
+        if (!response.empty())
+        {
+            CHECK(client.receive(response));
+        }
+        if (request.empty() && response.empty())
+        {
+            return;
+        }
+    }
+    CHECK(false); // 没有停下来
+}
+
+void testRoundTrip(muduo::net::EventLoop* loop)
+{
+    Server server(loop, HttpLimits());
+    Client client;
+    int32_t get = client.request("GET", "/hello?name=h2");
+    auto upload = std::make_shared<Client::Upload>();
+    upload->data.assign(100000, 'x'); // 超过初始的 64 KB 窗口，要靠服务端归还
+    int32_t post = client.request("POST", "/upload", upload);
+    exchange(client, server);
+
+    CHECK_EQ(server.requests.size(), size_t(2));
+    for (const auto& stream : server.requests)
+    {
+        const HttpRequest& req = stream->request;
+        CHECK_EQ(req.getHeader(HttpHeaders::kHost), std::string_view("example.com"));
+        CHECK_EQ(req.getVersion(), std::string_view("HTTP/2"));
+        if (stream->id == get)
+        {
+            CHECK(req.method() == HttpRequest::kGet);
+            CHECK_EQ(req.path(), std::string_view("/hello"));
+        }
+        else
+        {
+            CHECK(req.method() == HttpRequest::kPost);
+            CHECK(req.getBody() == upload->data);
+        }
+    }
+    CHECK_EQ(client.stream(get).status, 200);
+    CHECK_EQ(client.stream(get).body, std::string("0"));
+    CHECK_EQ(client.stream(post).status, 200);
+    CHECK_EQ(client.stream(post).body, std::string("100000"));
+    CHECK(server.session().idle());
+    CHECK_EQ(server.closed.size(), size_t(2));
+    CHECK_EQ(server.session().bufferedBody(), size_t(0));
+}
+
+void testDeadlines(muduo::net::EventLoop* loop)
+{
+    HttpLimits limits;
+    limits.headerTimeout = 10;
+    limits.bodyTimeout = 30;
+    Server server(loop, limits);
+    Client client;
+
+    // 一个请求收完了在等 handler（不计时），一个请求体发了一半就停下
+    int32_t slow = client.request("GET", "/slow");
+    auto upload = std::make_shared<Client::Upload>();
+    upload->data = "part of the body";
+    upload->end = false;
+    int32_t stalled = client.request("POST", "/upload", upload);
+    muduo::Timestamp start = muduo::Timestamp::now();
+    exchange(client, server);
+
+    CHECK_EQ(server.requests.size(), size_t(1));
+    CHECK(!server.session().idle());
+    muduo::Timestamp deadline = server.session().nextDeadline();
+    CHECK(deadline.valid());
+    double seconds = muduo::timeDifference(deadline, start);
+    CHECK(seconds >= 29.0 && seconds <= 31.0);
+
+    // 期限没到什么也不做
+    server.session().expireStreams(start);
+    exchange(client, server);
+    CHECK_EQ(client.stream(stalled).status, 0);
+
+    // 期限过了：发得慢的流回 408 并 RST_STREAM(NO_ERROR)，在等 handler 的流不受影响
+    server.session().expireStreams(muduo::addTime(start, 31));
+    exchange(client, server);
+    CHECK_EQ(client.stream(stalled).status, 408);
+    CHECK(client.stream(stalled).reset);
+    CHECK_EQ(client.stream(stalled).errorCode, uint32_t(NGHTTP2_NO_ERROR));
+    CHECK(client.stream(stalled).closed);
+    CHECK_EQ(client.stream(slow).status, 0);
+    CHECK(!server.session().nextDeadline().valid());
+    CHECK(!server.session().idle());
+
+    server.respond(server.requests[0]);
+    exchange(client, server);
+    CHECK_EQ(client.stream(slow).status, 200);
+    CHECK(server.session().idle());
+}
+
+void testBufferedBodyCap(muduo::net::EventLoop* loop)
+{
+    // 三个 7 MB 的请求体（每个都不超过 maxBodySize），合计超过 kMaxBufferedBody
+    Server server(loop, HttpLimits());
+    Client client;
+    const size_t bodySize = 7 * 1024 * 1024;
+    std::vector<int32_t> ids;
+    for (int i = 0; i < 3; ++i)
+    {
+        auto upload = std::make_shared<Client::Upload>();
+        upload->data.assign(bodySize, static_cast<char>('a' + i));
+        ids.push_back(client.request("POST", "/upload", upload));
+    }
+    exchange(client, server);
+
+    // 超过上限之后不再归还窗口，客户端最多再发完手上的连接窗口（64 KB）就得停下
+    size_t buffered = server.session().bufferedBody();
+    CHECK(buffered > Http2Session::kMaxBufferedBody);
+    CHECK(buffered <= Http2Session::kMaxBufferedBody + 128 * 1024);
+    CHECK(server.requests.size() < 3);
+
+    // 一个流取消之后内存降下来，暂扣的窗口归还，剩下的请求都能收完
+    int32_t cancelled = -1;
+    for (int32_t id : ids)
+    {
+        bool done = false;
+        for (const auto& stream : server.requests)
+        {
+            done = done || stream->id == id;
+        }
+        if (!done)
+        {
+            cancelled = id;
+            break;
+        }
+    }
+    client.cancel(cancelled);
+    exchange(client, server);
+    CHECK_EQ(server.requests.size(), size_t(2));
+    for (int32_t id : ids)
+    {
+        if (id != cancelled)
+        {
+            CHECK_EQ(client.stream(id).status, 200);
+            CHECK_EQ(client.stream(id).body, std::to_string(bodySize));
+        }
+    }
+    CHECK(server.session().idle());
+    CHECK_EQ(server.session().bufferedBody(), size_t(0));
+}
+
+} // namespace
+
+int main()
+{
+    muduo::net::EventLoop loop;
+    testRoundTrip(&loop);
+    testDeadlines(&loop);
+    testBufferedBodyCap(&loop);
+    return test::finish();
+}
@@ -0,0 +1,161 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "http/IoUring.h"
+#include "TestUtil.h"
+
+/*
+    IoUring：multishot recv 从 provided buffers 里取缓冲区、用完归还后能继续接收，
+    send 的结果和 user_data 原样带回；缓冲区用完（ENOBUFS）结束 multishot，归还之后重新挂上能收到剩下的数据。
+    内核不支持（或被禁用）时跳过
+ */
+
+using namespace http;
+
+namespace
+{
+
+const uint64_t kRecv = 1;
+const uint64_t kSend = 2;
+
+void testRecvSend()
+{
+    int fds[2];
+    CHECK_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    // 只有两块缓冲区：不归还的话第三次接收就会 ENOBUFS
+    IoUring ring(8, 2, 64);
+    CHECK(ring.valid());
+    CHECK_EQ(ring.bufferSize(), static_cast<size_t>(64));
+    IoUring::prepRecvMultishot(ring.getSqe(), fds[0], kRecv);
+    CHECK_EQ(ring.pending(), 1u);
+    CHECK_EQ(ring.submit(), 1);
+    CHECK_EQ(ring.pending(), 0u);
+
+    std::string received;
+    for (int i = 0; i < 4; ++i)
+    {
+        std::string chunk = "chunk" + std::to_string(i);
+        CHECK_EQ(::write(fds[1], chunk.data(), chunk.size()), static_cast<ssize_t>(chunk.size()));
+        CHECK(ring.submitAndWait(1) >= 0);
+        unsigned n = ring.forEachCqe([&](const struct io_uring_cqe* cqe)
+        {
+            CHECK_EQ(cqe->user_data, kRecv);
+            CHECK(cqe->res > 0);
+            CHECK(cqe->flags & IORING_CQE_F_BUFFER);
+            CHECK(cqe->flags & IORING_CQE_F_MORE); // multishot 仍在进行
+            uint16_t bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            received.append(ring.buffer(bid), cqe->res > 0 ? cqe->res : 0);
+            ring.recycleBuffer(bid);
+        });
+        CHECK_EQ(n, 1u);
+    }
+    CHECK_EQ(received, std::string("chunk0chunk1chunk2chunk3"));
+
+    static const char kReply[] = "pong";
+    IoUring::prepSend(ring.getSqe(), fds[0], kReply, sizeof kReply - 1, kSend);
+    CHECK(ring.submitAndWait(1) >= 0);
+    int sent = -1;
+    ring.forEachCqe([&](const struct io_uring_cqe* cqe)
+    {
+        if (cqe->user_data == kSend)
+        {
+            sent = cqe->res;
+        }
+    });
+    CHECK_EQ(sent, 4);
+    char buf[8];
+    CHECK_EQ(::read(fds[1], buf, sizeof buf), static_cast<ssize_t>(4));
+    CHECK_EQ(std::string(buf, 4), std::string("pong"));
+
+    // 取消 multishot recv：最后一个 CQE 不再带 IORING_CQE_F_MORE
+    IoUring::prepCancel(ring.getSqe(), kRecv, 0);
+    CHECK(ring.submitAndWait(2) >= 0);
+    bool ended = false;
+    ring.forEachCqe([&](const struct io_uring_cqe* cqe)
+    {
+        if (cqe->user_data == kRecv)
+        {
+            ended = !(cqe->flags & IORING_CQE_F_MORE);
+        }
+    });
+    CHECK(ended);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+void testNoBuffers()
+{
+    int fds[2];
+    CHECK_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    IoUring ring(8, 2, 64);
+    CHECK(ring.valid());
+    IoUring::prepRecvMultishot(ring.getSqe(), fds[0], kRecv);
+    CHECK_EQ(ring.submit(), 1);
+
+    // 两块缓冲区都不归还，第三段数据来时 multishot 以 ENOBUFS 结束
+    std::vector<uint16_t> held;
+    bool noBuffers = false;
+    for (int i = 0; i < 3 && !noBuffers; ++i)
+    {
+        CHECK_EQ(::write(fds[1], "data", 4), static_cast<ssize_t>(4));
+        CHECK(ring.submitAndWait(1) >= 0);
+        ring.forEachCqe([&](const struct io_uring_cqe* cqe)
+        {
+            if (cqe->res > 0)
+            {
+                held.push_back(static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+            else
+            {
+                noBuffers = cqe->res == -ENOBUFS && !(cqe->flags & IORING_CQE_F_MORE);
+            }
+        });
+    }
+    CHECK(noBuffers);
+    CHECK_EQ(held.size(), static_cast<size_t>(2));
+
+    // 归还之后（和重新挂上的 recv 一起提交）留在 socket 里的数据照常收到
+    for (uint16_t bid : held)
+    {
+        ring.recycleBuffer(bid);
+    }
+    CHECK_EQ(ring.returnBuffers(), static_cast<size_t>(0));
+    IoUring::prepRecvMultishot(ring.getSqe(), fds[0], kRecv);
+    CHECK(ring.submitAndWait(1) >= 0);
+    std::string received;
+    ring.forEachCqe([&](const struct io_uring_cqe* cqe)
+    {
+        if (cqe->user_data == kRecv && cqe->res > 0)
+        {
+            uint16_t bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            received.append(ring.buffer(bid), cqe->res);
+            ring.recycleBuffer(bid);
+        }
+    });
+    CHECK_EQ(received, std::string("data"));
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+} // namespace
+
+int main()
+{
+    if (!IoUring::supported())
+    {
+        std::printf("io_uring not supported, skipped\n");
+        return 0;
+    }
+    testRecvSend();
+    testNoBuffers();
+    return test::finish();
+}
@@ -0,0 +1,142 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <muduo/net/Buffer.h>
+
+#include "http/HttpContext.h"
+#include "router/Router.h"
+#include "TestUtil.h"
+
+/*
+    同一条 keep-alive 连接上重复的 GET（精确路由、固定响应体）在预热之后不再分配堆内存。
+    按 HttpServer::onRequest 的顺序走一遍：解析 → 复用连接上的响应对象 → 路由 → 序列化进输出缓冲区 → reset，
+    替换全局 operator new 统计这期间的分配次数
+ */
+
+namespace
+{
+
+std::atomic<bool>   g_counting { false };
+std::atomic<size_t> g_allocations { 0 };
+
+void* allocate(size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{ return allocate(size); }
+
+void* operator new[](size_t size)
+{ return allocate(size); }
+
+void operator delete(void* p) noexcept
+{ std::free(p); }
+
+void operator delete[](void* p) noexcept
+{ std::free(p); }
+
+void operator delete(void* p, size_t) noexcept
+{ std::free(p); }
+
+void operator delete[](void* p, size_t) noexcept
+{ std::free(p); }
+
+using namespace http;
+
+namespace
+{
+
+const std::string kRequest =
+    "GET /api/status HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: bench_login/1.0\r\n"
+    "Accept: application/json\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+const std::string kBody = "{\"status\":\"ok\",\"connections\":128,\"uptime\":86400}";
+
+// 一次读回调：解析、路由、把响应追加到输出缓冲区，再像发给连接一样清空
+bool serveOnce(HttpContext& context, router::Router& router, muduo::net::Buffer& input)
+{
+    input.append(kRequest.data(), kRequest.size());
+    if (!context.parseRequest(&input, muduo::Timestamp()))
+    {
+        return false;
+    }
+    if (context.gotHeaders() && !context.startBody())
+    {
+        return false;
+    }
+    if (!context.gotAll())
+    {
+        return false;
+    }
+
+    HttpResponse& response = context.response();
+    response.reset(false);
+    response.setVersion(context.request().getVersion());
+    if (!router.route(context.request(), &response))
+    {
+        return false;
+    }
+    muduo::net::Buffer* output = context.outputBuffer();
+    response.appendToBuffer(output);
+    bool ok = output->readableBytes() > kBody.size();
+    output->retrieveAll();
+    context.reset();
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    router::Router router;
+    router.registerCallback(HttpRequest::kGet, "/api/status",
+                            [](const HttpRequest& req, HttpResponse* resp)
+                            {
+                                resp->setStatusCode(HttpResponse::k200Ok);
+                                resp->setStatusMessage("OK");
+                                resp->setContentType("application/json");
+                                resp->setBody(kBody);
+                            });
+
+    HttpContext context;
+    muduo::net::Buffer input;
+
+    // 预热：arena、header 槽位、各个缓冲区长到稳定的容量
+    for (int i = 0; i < 16; ++i)
+    {
+        CHECK(serveOnce(context, router, input));
+    }
+
+    const int kRequests = 10000;
+    int served = 0;
+    g_counting = true;
+    for (int i = 0; i < kRequests; ++i)
+    {
+        served += serveOnce(context, router, input) ? 1 : 0;
+    }
+    g_counting = false;
+
+    CHECK_EQ(served, kRequests);
+    CHECK_EQ(g_allocations.load(), static_cast<size_t>(0));
+    std::printf("%d requests, %zu allocations\n", kRequests, g_allocations.load());
+    return test::finish();
+}
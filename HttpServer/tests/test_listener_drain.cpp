@@ -0,0 +1,99 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include "http/ListenerDrain.h"
+#include "TestUtil.h"
+
+/*
+    ListenerDrain：accept 队列不空的监听 socket 留着继续 accept，空了才关闭；
+    查询失败的直接关闭，force 时全部关闭。acceptQueueLength 用真实的回环 socket 验证
+ */
+
+using namespace http;
+
+namespace
+{
+
+void testPoll()
+{
+    std::map<int, int> queue = {{3, 0}, {4, 2}, {5, 1}, {6, -1}};
+    std::vector<int> closed;
+    ListenerDrain drain({3, 4, 5, 6},
+                        [&queue](int fd) { return queue[fd]; },
+                        [&closed](int fd) { closed.push_back(fd); });
+    CHECK(!drain.done());
+
+    // 3 的队列已空，6 查询失败：都关闭；4、5 还有连接在排队
+    CHECK_EQ(drain.poll(false), size_t(2));
+    CHECK_EQ(drain.remaining(), size_t(2));
+    CHECK_EQ(closed.size(), size_t(2));
+
+    // 队列没有变化时不关闭
+    CHECK_EQ(drain.poll(false), size_t(0));
+
+    // Acceptor 接走了 5 的连接
+    queue[5] = 0;
+    CHECK_EQ(drain.poll(false), size_t(1));
+    CHECK_EQ(closed.back(), 5);
+
+    // 4 一直不空：到期强制关闭
+    CHECK_EQ(drain.poll(true), size_t(1));
+    CHECK_EQ(closed.back(), 4);
+    CHECK(drain.done());
+    CHECK_EQ(drain.poll(true), size_t(0));
+    CHECK_EQ(closed.size(), size_t(4));
+}
+
+void testAcceptQueueLength()
+{
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = sockaddr_in();
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof addr;
+    if (listener < 0 || ::bind(listener, reinterpret_cast<struct sockaddr*>(&addr), len) != 0 ||
+        ::listen(listener, 16) != 0 ||
+        ::getsockname(listener, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0)
+    {
+        std::printf("no loopback socket, skip\n");
+        return;
+    }
+    CHECK_EQ(ListenerDrain::acceptQueueLength(listener), 0);
+
+    // 握手由内核完成，还没有 accept 的连接留在队列里
+    std::vector<int> clients;
+    for (int i = 0; i < 2; ++i)
+    {
+        int client = ::socket(AF_INET, SOCK_STREAM, 0);
+        CHECK(::connect(client, reinterpret_cast<struct sockaddr*>(&addr), len) == 0);
+        clients.push_back(client);
+    }
+    CHECK_EQ(ListenerDrain::acceptQueueLength(listener), 2);
+
+    int accepted = ::accept(listener, nullptr, nullptr);
+    CHECK(accepted >= 0);
+    CHECK_EQ(ListenerDrain::acceptQueueLength(listener), 1);
+
+    CHECK_EQ(ListenerDrain::acceptQueueLength(-1), -1);
+
+    ::close(accepted);
+    for (int client : clients)
+    {
+        ::close(client);
+    }
+    ::close(listener);
+}
+
+} // namespace
+
+int main()
+{
+    testPoll();
+    testAcceptQueueLength();
+    return test::finish();
+}
@@ -0,0 +1,640 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <muduo/net/Buffer.h>
+
+#include "http/HttpContext.h"
+#include "TestUtil.h"
+
+/*
+    HttpContext（HttpTokenizer 向量化扫描）和原来逐字节扫描的解析器的对照测试。
+    LegacyParser 是改用 HttpTokenizer 之前 HttpContext::parseRequest 的逻辑，用 std::string::find 实现，
+    只跟着有意的行为改动做调整：识别 HEAD；请求头的值只去掉空格和水平制表符（RFC 9110 的 OWS）；
+    请求体按 RFC 9112 6.3 由 Transfer-Encoding: chunked 或 Content-Length 决定，和请求方法无关；
+    请求头的字段名不区分大小写，重复的字段保留第一次出现的写法和位置：列表字段和不认识的字段按顺序
+    用 ", " 接起来（Cookie 用 "; "），其余字段以最后一次的值为准；
+    重复的 Host、Transfer-Encoding 以及取值不同的 Content-Length 报错。
+
+    每段输入分别整段、逐字节、按随机位置切开喂给 HttpContext，解析出的请求序列都要和 LegacyParser 一致。
+    输入来自 corpus/parser/*.txt，另外再按长度生成一批，让分隔符落在向量宽度的各个位置上。
+
+    语料文件的格式：文件里的换行会被忽略，报文的字节用转义写出（\r \n \t \\ \xHH），
+    一个文件可以包含多个流水线请求，也可以以不完整的请求结尾
+ */
+
+using http::HttpContext;
+using http::HttpRequest;
+
+namespace
+{
+
+using Pair = std::pair<std::string, std::string>;
+
+struct ParsedRequest
+{
+    HttpRequest::Method method = HttpRequest::kInvalid;
+    std::string         path;
+    std::string         version;
+    std::vector<Pair>   headers;
+    std::vector<Pair>   query;
+    std::string         body;
+};
+
+struct ParseOutcome
+{
+    std::vector<ParsedRequest> requests;
+    bool                       error = false;
+};
+
+// ---------------------------------------------------------------- LegacyParser
+
+HttpRequest::Method legacyMethod(const std::string& m)
+{
+    if (m == "GET") return HttpRequest::kGet;
+    if (m == "POST") return HttpRequest::kPost;
+    if (m == "HEAD") return HttpRequest::kHead;
+    if (m == "PUT") return HttpRequest::kPut;
+    if (m == "DELETE") return HttpRequest::kDelete;
+    if (m == "OPTIONS") return HttpRequest::kOptions;
+    return HttpRequest::kInvalid;
+}
+
+bool isOws(char c)
+{ return c == ' ' || c == '\t'; }
+
+int legacyHex(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// application/x-www-form-urlencoded 解码：%xx 和 '+'，非法的 %xx 原样保留
+std::string legacyDecode(const std::string& s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '%' && i + 2 < s.size() && legacyHex(s[i + 1]) >= 0 && legacyHex(s[i + 2]) >= 0)
+        {
+            out += static_cast<char>(legacyHex(s[i + 1]) * 16 + legacyHex(s[i + 2]));
+            i += 2;
+        }
+        else
+        {
+            out += (s[i] == '+') ? ' ' : s[i];
+        }
+    }
+    return out;
+}
+
+// 按出现顺序保留全部参数（包括重复的 key），没有 '=' 的参数值为空，空段跳过
+void legacyQuery(const std::string& query, std::vector<Pair>* params)
+{
+    size_t prev = 0;
+    while (prev < query.size())
+    {
+        size_t pos = query.find('&', prev);
+        if (pos == std::string::npos)
+        {
+            pos = query.size();
+        }
+        std::string pair = query.substr(prev, pos - prev);
+        if (!pair.empty())
+        {
+            size_t equal = pair.find('=');
+            std::string value = (equal == std::string::npos) ? std::string() : pair.substr(equal + 1);
+            params->emplace_back(legacyDecode(pair.substr(0, equal)), legacyDecode(value));
+        }
+        prev = pos + 1;
+    }
+}
+
+bool legacyRequestLine(const std::string& line, ParsedRequest* req)
+{
+    size_t space = line.find(' ');
+    if (space == std::string::npos)
+    {
+        return false;
+    }
+    req->method = legacyMethod(line.substr(0, space));
+    if (req->method == HttpRequest::kInvalid)
+    {
+        return false;
+    }
+    size_t start = space + 1;
+    space = line.find(' ', start);
+    if (space == std::string::npos)
+    {
+        return false;
+    }
+    std::string target = line.substr(start, space - start);
+    size_t question = target.find('?');
+    req->path = target.substr(0, question);
+    if (question != std::string::npos)
+    {
+        legacyQuery(target.substr(question + 1), &req->query);
+    }
+    req->version = line.substr(space + 1);
+    return req->version == "HTTP/1.1" || req->version == "HTTP/1.0";
+}
+
+// 和 std::from_chars 一样：非空、全是数字、不溢出
+bool legacyContentLength(const std::string& value, uint64_t* length)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+    uint64_t n = 0;
+    for (char c : value)
+    {
+        if (c < '0' || c > '9' || n > (UINT64_MAX - (c - '0')) / 10)
+        {
+            return false;
+        }
+        n = n * 10 + (c - '0');
+    }
+    *length = n;
+    return true;
+}
+
+bool equalsIgnoreCase(const std::string& a, const std::string& b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(),
+                      [](char x, char y) { return std::tolower(static_cast<unsigned char>(x)) ==
+                                                  std::tolower(static_cast<unsigned char>(y)); });
+}
+
+// HttpHeaders::isList 里的字段，外加不认识的字段；其余常用字段重复时以最后一次为准
+bool legacyJoins(const std::string& key)
+{
+    static const char* const kLists[] = {
+        "Connection", "Cookie", "X-Forwarded-For", "Expect", "Accept", "Accept-Encoding",
+        "If-None-Match", "Upgrade", "Sec-WebSocket-Extensions", "Sec-WebSocket-Protocol",
+        "Access-Control-Request-Headers", "Cache-Control", "Keep-Alive", "TE",
+    };
+    for (const char* name : kLists)
+    {
+        if (equalsIgnoreCase(key, name))
+        {
+            return true;
+        }
+    }
+    return http::HttpHeaders::lookup(key) == http::HttpHeaders::kUnknown;
+}
+
+std::string legacyHeader(const ParsedRequest& req, const std::string& name)
+{
+    for (const auto& header : req.headers)
+    {
+        if (equalsIgnoreCase(header.first, name))
+        {
+            return header.second;
+        }
+    }
+    return std::string();
+}
+
+enum ChunkResult
+{
+    kChunkDone,
+    kChunkIncomplete,
+    kChunkError,
+};
+
+// chunk-size [ ";" ext ] CRLF data CRLF ... 0 CRLF *(trailer CRLF) CRLF，trailer 丢弃
+ChunkResult legacyChunked(const std::string& input, size_t* pos, std::string* body)
+{
+    while (true)
+    {
+        size_t lineEnd = input.find("\r\n", *pos);
+        if (lineEnd == std::string::npos)
+        {
+            return kChunkIncomplete;
+        }
+        std::string line = input.substr(*pos, lineEnd - *pos);
+        size_t digits = 0;
+        uint64_t size = 0;
+        while (digits < line.size() && std::isxdigit(static_cast<unsigned char>(line[digits])))
+        {
+            if (size > (UINT64_MAX >> 4))
+            {
+                return kChunkError;
+            }
+            size = (size << 4) | static_cast<uint64_t>(std::stoi(line.substr(digits, 1), nullptr, 16));
+            ++digits;
+        }
+        size_t rest = digits;
+        while (rest < line.size() && isOws(line[rest]))
+        {
+            ++rest;
+        }
+        if (digits == 0 || (rest != line.size() && line[rest] != ';'))
+        {
+            return kChunkError;
+        }
+        *pos = lineEnd + 2;
+
+        if (size == 0)
+        {
+            while (true)
+            {
+                lineEnd = input.find("\r\n", *pos);
+                if (lineEnd == std::string::npos)
+                {
+                    return kChunkIncomplete;
+                }
+                bool last = (lineEnd == *pos);
+                *pos = lineEnd + 2;
+                if (last)
+                {
+                    return kChunkDone;
+                }
+            }
+        }
+
+        if (input.size() - *pos < size + 2)
+        {
+            return kChunkIncomplete;
+        }
+        body->append(input, *pos, size);
+        *pos += size;
+        if (input.compare(*pos, 2, "\r\n") != 0)
+        {
+            return kChunkError;
+        }
+        *pos += 2;
+    }
+}
+
+ParseOutcome legacyParse(const std::string& input)
+{
+    ParseOutcome outcome;
+    size_t pos = 0;
+    while (true)
+    {
+        size_t lineEnd = input.find("\r\n", pos);
+        if (lineEnd == std::string::npos)
+        {
+            return outcome;
+        }
+        ParsedRequest req;
+        if (!legacyRequestLine(input.substr(pos, lineEnd - pos), &req))
+        {
+            outcome.error = true;
+            return outcome;
+        }
+        pos = lineEnd + 2;
+
+        while (true)
+        {
+            lineEnd = input.find("\r\n", pos);
+            if (lineEnd == std::string::npos)
+            {
+                return outcome;
+            }
+            std::string line = input.substr(pos, lineEnd - pos);
+            pos = lineEnd + 2;
+            if (line.empty())
+            {
+                break;
+            }
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+            {
+                outcome.error = true;
+                return outcome;
+            }
+            size_t valueStart = colon + 1;
+            while (valueStart < line.size() && isOws(line[valueStart]))
+            {
+                ++valueStart;
+            }
+            size_t valueEnd = line.size();
+            while (valueEnd > valueStart && isOws(line[valueEnd - 1]))
+            {
+                --valueEnd;
+            }
+            std::string key = line.substr(0, colon);
+            std::string value = line.substr(valueStart, valueEnd - valueStart);
+            auto it = std::find_if(req.headers.begin(), req.headers.end(),
+                                   [&](const Pair& h) { return equalsIgnoreCase(h.first, key); });
+            if (it != req.headers.end())
+            {
+                if (equalsIgnoreCase(key, "Host") || equalsIgnoreCase(key, "Transfer-Encoding") ||
+                    (equalsIgnoreCase(key, "Content-Length") && it->second != value))
+                {
+                    outcome.error = true;
+                    return outcome;
+                }
+                if (!legacyJoins(key) || it->second.empty())
+                {
+                    it->second = value;
+                }
+                else if (!value.empty())
+                {
+                    it->second += equalsIgnoreCase(key, "Cookie") ? "; " : ", ";
+                    it->second += value;
+                }
+            }
+            else
+            {
+                req.headers.emplace_back(key, value);
+            }
+        }
+
+        std::string transferEncoding = legacyHeader(req, "Transfer-Encoding");
+        std::string contentLength = legacyHeader(req, "Content-Length");
+        if (!transferEncoding.empty())
+        {
+            if (!contentLength.empty() || !equalsIgnoreCase(transferEncoding, "chunked"))
+            {
+                outcome.error = true;
+                return outcome;
+            }
+            ChunkResult result = legacyChunked(input, &pos, &req.body);
+            if (result == kChunkError)
+            {
+                outcome.error = true;
+                return outcome;
+            }
+            if (result == kChunkIncomplete)
+            {
+                return outcome;
+            }
+        }
+        else if (!contentLength.empty())
+        {
+            uint64_t length = 0;
+            if (!legacyContentLength(contentLength, &length))
+            {
+                outcome.error = true;
+                return outcome;
+            }
+            if (input.size() - pos < length)
+            {
+                return outcome;
+            }
+            req.body = input.substr(pos, length);
+            pos += length;
+        }
+        outcome.requests.push_back(std::move(req));
+    }
+}
+
+// ---------------------------------------------------------------- HttpContext
+
+std::string describe(const ParsedRequest& req)
+{
+    std::string out = "request method=" + std::to_string(req.method) +
+                      " path=" + test::printable(req.path) +
+                      " version=" + test::printable(req.version) + "\n";
+    for (const auto& header : req.headers)
+    {
+        out += "  header " + test::printable(header.first) + ": " + test::printable(header.second) + "\n";
+    }
+    for (const auto& param : req.query)
+    {
+        out += "  query " + test::printable(param.first) + "=" + test::printable(param.second) + "\n";
+    }
+    return out + "  body " + test::printable(req.body) + "\n";
+}
+
+std::string describe(const ParseOutcome& outcome)
+{
+    std::string out;
+    for (const auto& req : outcome.requests)
+    {
+        out += describe(req);
+    }
+    return out + (outcome.error ? "error\n" : "ok\n");
+}
+
+ParsedRequest capture(const HttpRequest& request)
+{
+    ParsedRequest req;
+    req.method = request.method();
+    req.path = std::string(request.path());
+    req.version = std::string(request.getVersion());
+    for (const auto& header : request.headers())
+    {
+        req.headers.emplace_back(std::string(header.first), std::string(header.second));
+    }
+    for (const auto& param : request.queryParameters())
+    {
+        req.query.emplace_back(std::string(param.first), std::string(param.second));
+    }
+    req.body = std::string(request.getBody());
+    return req;
+}
+
+// cuts 是递增的切分位置：每切一段就像一次读回调一样追加到缓冲区，再把里面完整的请求都解析出来
+std::string runContext(const std::string& input, const std::vector<size_t>& cuts)
+{
+    std::string out;
+    HttpContext context;
+    muduo::net::Buffer buf;
+    size_t fed = 0;
+    for (size_t i = 0; i <= cuts.size(); ++i)
+    {
+        size_t next = i < cuts.size() ? cuts[i] : input.size();
+        buf.append(input.data() + fed, next - fed);
+        fed = next;
+        while (true)
+        {
+            if (!context.parseRequest(&buf, muduo::Timestamp()))
+            {
+                return out + "error\n";
+            }
+            // 请求头收完之后由调用方决定开始读请求体（HttpServer 在这里挂 BodySink）
+            if (context.gotHeaders())
+            {
+                if (!context.startBody())
+                {
+                    return out + "error\n";
+                }
+                continue;
+            }
+            if (!context.gotAll())
+            {
+                break;
+            }
+            out += describe(capture(context.request()));
+            context.reset();
+        }
+    }
+    return out + "ok\n";
+}
+
+// ---------------------------------------------------------------- 输入
+
+std::string unescape(const std::string& text)
+{
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '\n' || c == '\r')
+        {
+            continue;
+        }
+        if (c != '\\' || i + 1 >= text.size())
+        {
+            out += c;
+            continue;
+        }
+        char e = text[++i];
+        switch (e)
+        {
+            case 'r':  out += '\r'; break;
+            case 'n':  out += '\n'; break;
+            case 't':  out += '\t'; break;
+            case '\\': out += '\\'; break;
+            case 'x':
+                out += static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+                break;
+            default:   out += '\\'; out += e; break;
+        }
+    }
+    return out;
+}
+
+std::vector<Pair> loadCorpus(const std::string& dir)
+{
+    std::vector<Pair> inputs;
+    for (const auto& entry : std::filesystem::directory_iterator(dir))
+    {
+        if (entry.path().extension() != ".txt")
+        {
+            continue;
+        }
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        inputs.emplace_back(entry.path().filename().string(), unescape(content.str()));
+    }
+    std::sort(inputs.begin(), inputs.end());
+    return inputs;
+}
+
+// 分隔符落在 16/32 字节向量的每个位置上，也覆盖尾部不足一个向量宽度的情况
+std::vector<Pair> generateInputs()
+{
+    std::vector<Pair> inputs;
+    for (size_t n = 0; n <= 70; ++n)
+    {
+        std::string filler(n, 'a');
+        std::string spaces(n % 5, ' ');
+        std::string input = "GET /" + filler + "?k=" + filler + "&x=1 HTTP/1.1\r\n" +
+                            "X-" + filler + ":" + spaces + "v" + filler + "\t" + spaces + "\r\n" +
+                            "Host: h\r\n\r\n" +
+                            "POST /p HTTP/1.1\r\nContent-Length: " + std::to_string(n) + "\r\n\r\n" +
+                            std::string(n, 'b');
+        inputs.emplace_back("generated-" + std::to_string(n), input);
+    }
+    return inputs;
+}
+
+void checkInput(const std::string& name, const std::string& input, std::mt19937& rng)
+{
+    ParseOutcome expected = legacyParse(input);
+    std::string want = describe(expected);
+
+    std::string whole = runContext(input, {});
+    if (whole != want)
+    {
+        ++test::failures();
+        std::printf("%s (whole): mismatch\n--- legacy\n%s--- context\n%s", name.c_str(), want.c_str(), whole.c_str());
+        return;
+    }
+
+    std::vector<size_t> bytes;
+    for (size_t i = 1; i < input.size(); ++i)
+    {
+        bytes.push_back(i);
+    }
+    std::string byByte = runContext(input, bytes);
+    if (byByte != want)
+    {
+        ++test::failures();
+        std::printf("%s (byte by byte): mismatch\n--- legacy\n%s--- context\n%s", name.c_str(), want.c_str(), byByte.c_str());
+        return;
+    }
+
+    for (int round = 0; round < 20 && input.size() > 1; ++round)
+    {
+        std::uniform_int_distribution<size_t> pick(1, input.size() - 1);
+        std::vector<size_t> cuts;
+        for (int i = 0; i < 3; ++i)
+        {
+            cuts.push_back(pick(rng));
+        }
+        std::sort(cuts.begin(), cuts.end());
+        cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+        std::string split = runContext(input, cuts);
+        if (split != want)
+        {
+            ++test::failures();
+            std::printf("%s (split): mismatch\n--- legacy\n%s--- context\n%s", name.c_str(), want.c_str(), split.c_str());
+            return;
+        }
+    }
+}
+
+} // namespace
+
+// 对照之外再钉住合并后的取值，防止两边一起改错
+void testMergedHeaders()
+{
+    std::string input =
+        "GET / HTTP/1.1\r\nHost: h\r\nAccept-Encoding: gzip\r\nCookie: a=1\r\n"
+        "accept-encoding: br\r\ncookie: b=2\r\nX-Forwarded-For: 10.0.0.1\r\n"
+        "X-Forwarded-For: 10.0.0.2\r\nUser-Agent: a\r\nUser-Agent: b\r\n\r\n";
+    HttpContext context;
+    muduo::net::Buffer buf;
+    buf.append(input.data(), input.size());
+    CHECK(context.parseRequest(&buf, muduo::Timestamp()));
+    CHECK(context.gotHeaders());
+    const HttpRequest& req = context.request();
+    CHECK_EQ(req.getHeader("Accept-Encoding"), "gzip, br");
+    CHECK_EQ(req.getHeader("Cookie"), "a=1; b=2");
+    CHECK_EQ(req.getHeader("X-Forwarded-For"), "10.0.0.1, 10.0.0.2");
+    CHECK_EQ(req.getHeader("User-Agent"), "b");
+    CHECK_EQ(req.headers().size(), 5u);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <corpus dir>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Pair> inputs = loadCorpus(argv[1]);
+    CHECK(!inputs.empty());
+    std::vector<Pair> generated = generateInputs();
+    inputs.insert(inputs.end(), generated.begin(), generated.end());
+
+    testMergedHeaders();
+
+    std::mt19937 rng(20240601);
+    for (const auto& input : inputs)
+    {
+        checkInput(input.first, input.second, rng);
+    }
+    std::printf("%zu inputs\n", inputs.size());
+    return test::finish();
+}
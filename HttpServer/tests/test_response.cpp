@@ -0,0 +1,172 @@
+#include <memory>
+#include <string>
+
+#include <muduo/net/Buffer.h>
+
+#include "http/HttpResponse.h"
+#include "TestUtil.h"
+
+/*
+    HttpResponse 直接写进输出缓冲区的序列化：预格式化的状态行、缓存的 Date、
+    统一生成的 Content-Length / Connection，以及常用字段名按 id 归一
+ */
+
+using namespace http;
+
+namespace
+{
+
+std::string serialize(const HttpResponse& response)
+{
+    muduo::net::Buffer buf;
+    response.appendToBuffer(&buf);
+    return buf.retrieveAllAsString();
+}
+
+// Date 每秒变化，比较前换成固定的占位
+std::string maskDate(const std::string& text)
+{
+    size_t begin = text.find("\r\nDate: ");
+    if (begin == std::string::npos)
+    {
+        return text;
+    }
+    begin += 2;
+    size_t end = text.find("\r\n", begin);
+    std::string line = text.substr(begin, end - begin);
+    // "Date: Sun, 06 Nov 1994 08:49:37 GMT"
+    bool wellFormed = line.size() == 35 && line[9] == ',' && line.compare(line.size() - 4, 4, " GMT") == 0;
+    return text.substr(0, begin) + (wellFormed ? "Date: <now>" : line) + text.substr(end);
+}
+
+void testBasic()
+{
+    HttpResponse response(false);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k200Ok);
+    response.setStatusMessage("OK");
+    response.setContentType("text/plain");
+    response.setBody(std::string("hello"));
+    CHECK_EQ(maskDate(serialize(response)),
+             std::string("HTTP/1.1 200 OK\r\n"
+                         "Date: <now>\r\n"
+                         "Connection: Keep-Alive\r\n"
+                         "Content-Length: 5\r\n"
+                         "Content-Type: text/plain\r\n"
+                         "\r\n"
+                         "hello"));
+}
+
+void testStatusLine()
+{
+    HttpResponse response(true);
+    response.setVersion("HTTP/1.0");
+    response.setStatusCode(HttpResponse::k404NotFound);
+    CHECK_EQ(maskDate(serialize(response)),
+             std::string("HTTP/1.0 404 Not Found\r\n"
+                         "Date: <now>\r\n"
+                         "Connection: close\r\n"
+                         "Content-Length: 0\r\n"
+                         "\r\n"));
+
+    // 自定义的原因短语和不在表里的状态码现场格式化
+    response.reset(true);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k200Ok);
+    response.setStatusMessage("Fine");
+    CHECK_EQ(serialize(response).substr(0, 19), std::string("HTTP/1.1 200 Fine\r\n"));
+
+    response.reset(true);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(static_cast<HttpResponse::HttpStatusCode>(299));
+    response.setStatusMessage("Custom");
+    CHECK_EQ(serialize(response).substr(0, 21), std::string("HTTP/1.1 299 Custom\r\n"));
+
+    CHECK_EQ(HttpResponse::reasonPhrase(404), std::string_view("Not Found"));
+    CHECK_EQ(HttpResponse::reasonPhrase(431), std::string_view("Request Header Fields Too Large"));
+    CHECK(HttpResponse::reasonPhrase(299).empty());
+}
+
+void testNoContentLength()
+{
+    HttpResponse response(false);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k304NotModified);
+    response.addHeader("ETag", "\"abc\"");
+    CHECK_EQ(maskDate(serialize(response)),
+             std::string("HTTP/1.1 304 Not Modified\r\n"
+                         "Date: <now>\r\n"
+                         "Connection: Keep-Alive\r\n"
+                         "ETag: \"abc\"\r\n"
+                         "\r\n"));
+
+    response.reset(false);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k204NoContent);
+    CHECK(serialize(response).find("Content-Length") == std::string::npos);
+}
+
+void testHeaders()
+{
+    HttpResponse response(false);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k200Ok);
+    // 常用字段名不区分大小写归一，输出规范写法；同名字段覆盖旧值
+    response.addHeader("content-type", "text/html");
+    response.setContentType("application/json");
+    response.addHeader("X-Trace", "1");
+    response.addHeader("x-trace", "2");
+    // Content-Length 统一生成，Connection: close 等价于 setCloseConnection(true)
+    response.addHeader("Content-Length", "99");
+    response.addHeader("Connection", "close");
+    // 显式的 Date 不再追加缓存的那一份
+    response.addHeader("Date", "Thu, 01 Jan 1970 00:00:00 GMT");
+    response.setBody(std::string("{}"));
+    CHECK_EQ(serialize(response),
+             std::string("HTTP/1.1 200 OK\r\n"
+                         "Connection: close\r\n"
+                         "Content-Length: 2\r\n"
+                         "Content-Type: application/json\r\n"
+                         "X-Trace: 2\r\n"
+                         "Date: Thu, 01 Jan 1970 00:00:00 GMT\r\n"
+                         "\r\n"
+                         "{}"));
+
+    // HEAD：响应体为空，Content-Length 按显式设置的值
+    response.reset(false);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k200Ok);
+    response.setContentLength(1234);
+    CHECK(serialize(response).find("Content-Length: 1234\r\n") != std::string::npos);
+}
+
+void testSharedBody()
+{
+    auto page = std::make_shared<const std::string>(10000, 'x');
+    HttpResponse response(false);
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(HttpResponse::k200Ok);
+    response.setBody(page);
+    response.addBodySegment(page, std::string_view(*page).substr(0, 10));
+    CHECK_EQ(response.bodySize(), static_cast<size_t>(10010));
+    CHECK_EQ(page.use_count(), 3L);
+
+    std::string text = serialize(response);
+    CHECK(text.find("Content-Length: 10010\r\n") != std::string::npos);
+    CHECK_EQ(text.size() - text.find("\r\n\r\n") - 4, static_cast<size_t>(10010));
+
+    response.reset(false);
+    CHECK_EQ(page.use_count(), 1L);
+}
+
+} // namespace
+
+int main()
+{
+    testBasic();
+    testStatusLine();
+    testNoContentLength();
+    testHeaders();
+    testSharedBody();
+    return test::finish();
+}
@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <muduo/net/EventLoop.h>
+
+#include "http/FileCache.h"
+#include "http/HttpContext.h"
+#include "router/StaticFileHandler.h"
+#include "TestUtil.h"
+
+/*
+    StaticFileHandler：单区间 Range（含后缀区间和越界截断）、不可满足时的 416、
+    If-Range 的强比较、If-None-Match / If-Modified-Since 的 304 以及两者的优先级；
+    FileCache 满了之后只淘汰最久没访问的一个
+ */
+
+using namespace http;
+using router::StaticFileHandler;
+
+namespace
+{
+
+// 0..99 循环的 100 个字节，第 i 个字节是 'a' + i % 26
+std::string fileContent()
+{
+    std::string content;
+    for (int i = 0; i < 100; ++i)
+    {
+        content.push_back(static_cast<char>('a' + i % 26));
+    }
+    return content;
+}
+
+class Fixture
+{
+public:
+    Fixture()
+        : cache_(std::make_shared<FileCache>(&loop_))
+    {
+        char dir[] = "/tmp/test_static_file.XXXXXX";
+        if (::mkdtemp(dir))
+        {
+            dir_ = dir;
+            std::ofstream(dir_ + "/a.txt", std::ios::binary) << fileContent();
+        }
+        handler_.reset(new StaticFileHandler(cache_, "/static/", dir_));
+        // ETag、Last-Modified 取自缓存，和 handler 用的是同一份
+        if (auto file = cache_->get(dir_ + "/a.txt"))
+        {
+            etag_ = file->etag;
+            lastModified_ = file->lastModified;
+        }
+    }
+
+    ~Fixture()
+    {
+        ::unlink((dir_ + "/a.txt").c_str());
+        ::rmdir(dir_.c_str());
+    }
+
+    bool ready() const
+    { return !dir_.empty() && !etag_.empty(); }
+
+    FileCache& cache()
+    { return *cache_; }
+
+    const std::string& dir() const
+    { return dir_; }
+
+    const std::string& etag() const
+    { return etag_; }
+
+    const std::string& lastModified() const
+    { return lastModified_; }
+
+    // 发一个请求，返回 handler 填好的响应
+    HttpResponse& get(const test::Headers& headers, const std::string& method = "GET")
+    {
+        CHECK(test::parse(&context_, method + " /static/a.txt HTTP/1.1", headers));
+        HttpResponse& response = context_.response();
+        response.reset(false);
+        response.setVersion("HTTP/1.1");
+        handler_->handle(muduo::net::TcpConnectionPtr(), context_.request(), &response);
+        return response;
+    }
+
+private:
+    muduo::net::EventLoop              loop_;
+    std::shared_ptr<FileCache>         cache_;
+    std::string                        dir_;
+    std::unique_ptr<StaticFileHandler> handler_;
+    std::string                        etag_;
+    std::string                        lastModified_;
+    HttpContext                        context_;
+};
+
+void testRange(Fixture& f)
+{
+    const std::string content = fileContent();
+
+    HttpResponse* r = &f.get({});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+    CHECK_EQ(r->bodySize(), size_t(100));
+    CHECK_EQ(r->getHeader(HttpHeaders::kAcceptRanges), std::string_view("bytes"));
+
+    r = &f.get({{"Range", "bytes=10-19"}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k206PartialContent);
+    CHECK_EQ(r->getHeader(HttpHeaders::kContentRange), std::string_view("bytes 10-19/100"));
+    CHECK(r->body() == std::string_view(content).substr(10, 10));
+
+    // 后缀区间：最后 n 个字节，n 超过文件大小时就是整个文件
+    r = &f.get({{"Range", "bytes=-10"}});
+    CHECK_EQ(r->getHeader(HttpHeaders::kContentRange), std::string_view("bytes 90-99/100"));
+    CHECK(r->body() == std::string_view(content).substr(90));
+    r = &f.get({{"Range", "bytes=-500"}});
+    CHECK_EQ(r->getHeader(HttpHeaders::kContentRange), std::string_view("bytes 0-99/100"));
+
+    // 开放区间和越界的结尾截断到文件末尾
+    r = &f.get({{"Range", "bytes=95-"}});
+    CHECK_EQ(r->getHeader(HttpHeaders::kContentRange), std::string_view("bytes 95-99/100"));
+    r = &f.get({{"Range", "bytes=50-1000"}});
+    CHECK_EQ(r->getHeader(HttpHeaders::kContentRange), std::string_view("bytes 50-99/100"));
+    CHECK_EQ(r->bodySize(), size_t(50));
+
+    // HEAD：206 的头部，Content-Length 是区间长度，不带响应体
+    r = &f.get({{"Range", "bytes=0-9"}}, "HEAD");
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k206PartialContent);
+    CHECK_EQ(r->contentLengthValue(), int64_t(10));
+    CHECK_EQ(r->bodySize(), size_t(0));
+
+    // 不可满足：416 带 "bytes */大小"，没有响应体
+    for (const char* range : {"bytes=100-", "bytes=100-200", "bytes=-0"})
+    {
+        r = &f.get({{"Range", range}});
+        CHECK_EQ(r->getStatusCode(), HttpResponse::k416RangeNotSatisfiable);
+        CHECK_EQ(r->getHeader(HttpHeaders::kContentRange), std::string_view("bytes */100"));
+        CHECK_EQ(r->bodySize(), size_t(0));
+    }
+
+    // 处理不了的（多区间、单位不对、格式错误、结尾在开头之前）按整个文件返回
+    for (const char* range : {"bytes=0-1,5-6", "items=0-9", "bytes=abc", "bytes=9-3", "bytes=-", "bytes 0-9"})
+    {
+        r = &f.get({{"Range", range}});
+        CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+        CHECK_EQ(r->bodySize(), size_t(100));
+        CHECK(r->getHeader(HttpHeaders::kContentRange).empty());
+    }
+}
+
+void testIfRange(Fixture& f)
+{
+    // ETag 或 Last-Modified 和当前文件一致：照常 206
+    HttpResponse* r = &f.get({{"Range", "bytes=0-9"}, {"If-Range", f.etag()}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k206PartialContent);
+    r = &f.get({{"Range", "bytes=0-9"}, {"If-Range", f.lastModified()}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k206PartialContent);
+
+    // 文件变了，或者带的是弱 ETag（If-Range 要求强比较）：忽略 Range，返回整个文件
+    r = &f.get({{"Range", "bytes=0-9"}, {"If-Range", "\"stale\""}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+    CHECK_EQ(r->bodySize(), size_t(100));
+    r = &f.get({{"Range", "bytes=0-9"}, {"If-Range", "W/" + f.etag()}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+
+    // If-Range 不匹配时连不可满足的区间也忽略
+    r = &f.get({{"Range", "bytes=500-"}, {"If-Range", "\"stale\""}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+}
+
+void testNotModified(Fixture& f)
+{
+    // If-None-Match 按弱比较：原样、带 W/、列表中的一项、"*" 都命中
+    for (const std::string& tag : {f.etag(), "W/" + f.etag(), "\"x\", " + f.etag() + " ,\"y\"", std::string("*")})
+    {
+        HttpResponse* r = &f.get({{"If-None-Match", tag}});
+        CHECK_EQ(r->getStatusCode(), HttpResponse::k304NotModified);
+        CHECK_EQ(r->bodySize(), size_t(0));
+        CHECK_EQ(r->getHeader(HttpHeaders::kETag), std::string_view(f.etag()));
+    }
+    HttpResponse* r = &f.get({{"If-None-Match", "\"other\""}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+
+    // If-Modified-Since：文件在那之后没改过才 304
+    r = &f.get({{"If-Modified-Since", f.lastModified()}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k304NotModified);
+    r = &f.get({{"If-Modified-Since", "Thu, 01 Jan 1970 00:00:01 GMT"}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+    r = &f.get({{"If-Modified-Since", "not a date"}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+
+    // 两者都有时只看 If-None-Match
+    r = &f.get({{"If-None-Match", "\"other\""}, {"If-Modified-Since", f.lastModified()}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k200Ok);
+
+    // 304 优先于 Range
+    r = &f.get({{"If-None-Match", f.etag()}, {"Range", "bytes=0-9"}});
+    CHECK_EQ(r->getStatusCode(), HttpResponse::k304NotModified);
+}
+
+void testEviction(Fixture& f)
+{
+    // 先装满 kMaxEntries 个，之前缓存的 a.txt 等都会被挤掉；最后一个留着再加载
+    const size_t count = FileCache::kMaxEntries + 1;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < count; ++i)
+    {
+        paths.push_back(f.dir() + "/lru" + std::to_string(i));
+        std::ofstream(paths.back(), std::ios::binary) << i;
+    }
+    std::vector<std::shared_ptr<const CachedFile>> files;
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        files.push_back(f.cache().get(paths[i]));
+    }
+
+    // 再访问一次 lru0，最久没访问的就变成 lru1；加载最后一个只挤掉 lru1（原来会把整个缓存清空）
+    CHECK(f.cache().get(paths[0]) == files[0]);
+    CHECK(f.cache().get(paths[count - 1]) != nullptr);
+    CHECK(f.cache().get(paths[0]) == files[0]);
+    CHECK(f.cache().get(paths[2]) == files[2]);
+    CHECK(f.cache().get(paths[count - 2]) == files[count - 2]);
+    CHECK(f.cache().get(paths[1]) != files[1]);
+
+    for (const auto& path : paths)
+    {
+        ::unlink(path.c_str());
+    }
+}
+
+} // namespace
+
+int main()
+{
+    Fixture fixture;
+    CHECK(fixture.ready());
+    if (fixture.ready())
+    {
+        testRange(fixture);
+        testIfRange(fixture);
+        testNotModified(fixture);
+        testEviction(fixture);
+    }
+    return test::finish();
+}
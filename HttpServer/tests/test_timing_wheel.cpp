@@ -0,0 +1,143 @@
+#include <string>
+#include <vector>
+
+#include <muduo/net/EventLoop.h>
+
+#include "http/TimingWheel.h"
+#include "TestUtil.h"
+
+/*
+    TimingWheel：按秒数落到对应的格子、超过一圈的按圈数延后、重新计时和取消，
+    以及回调里对别的 Entry 做 schedule/cancel。测试里不 start()，直接调用 tick() 推进时间
+ */
+
+using namespace http;
+
+namespace
+{
+
+// 推进 n 格（n 秒）
+void advance(TimingWheel* wheel, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        wheel->tick();
+    }
+}
+
+void testExpiry()
+{
+    muduo::net::EventLoop loop;
+    TimingWheel wheel(&loop, 4);
+    std::vector<std::string> fired;
+    TimingWheel::Entry a, b, c, d, e;
+    a.setCallback([&] { fired.push_back("a"); });
+    b.setCallback([&] { fired.push_back("b"); });
+    c.setCallback([&] { fired.push_back("c"); });
+    d.setCallback([&] { fired.push_back("d"); });
+    e.setCallback([&] { fired.push_back("e"); });
+
+    wheel.schedule(&a, 1);
+    wheel.schedule(&b, 3);
+    wheel.schedule(&c, 4);  // 正好一圈：落回当前格
+    wheel.schedule(&d, 9);  // 两圈多
+    wheel.schedule(&e, 0);  // 不足一秒按一格算
+    CHECK(a.scheduled() && d.scheduled());
+
+    advance(&wheel, 1);
+    CHECK(fired == std::vector<std::string>({"e", "a"}) || fired == std::vector<std::string>({"a", "e"}));
+    CHECK(!a.scheduled() && !e.scheduled());
+    fired.clear();
+
+    advance(&wheel, 2);
+    CHECK(fired == std::vector<std::string>({"b"}));
+    advance(&wheel, 1);
+    CHECK(fired == std::vector<std::string>({"b", "c"}));
+
+    // d 和 c 落在同一格，但还要再转一圈
+    advance(&wheel, 4);
+    CHECK(fired == std::vector<std::string>({"b", "c"}));
+    CHECK(d.scheduled());
+    advance(&wheel, 1);
+    CHECK(fired == std::vector<std::string>({"b", "c", "d"}));
+    CHECK(!d.scheduled());
+}
+
+void testReschedule()
+{
+    muduo::net::EventLoop loop;
+    TimingWheel wheel(&loop, 8);
+    int count = 0;
+    TimingWheel::Entry entry;
+    entry.setCallback([&] { ++count; });
+
+    // 连接上每来一次数据就重新计时：只要在到期前续上就不会触发
+    wheel.schedule(&entry, 3);
+    for (int i = 0; i < 10; ++i)
+    {
+        advance(&wheel, 2);
+        wheel.schedule(&entry, 3);
+    }
+    CHECK_EQ(count, 0);
+    advance(&wheel, 3);
+    CHECK_EQ(count, 1);
+
+    // 从长超时换成短超时（如读请求头 → 空闲），旧的圈数不能留下
+    wheel.schedule(&entry, 20);
+    wheel.schedule(&entry, 1);
+    advance(&wheel, 1);
+    CHECK_EQ(count, 2);
+
+    wheel.schedule(&entry, 2);
+    entry.cancel();
+    CHECK(!entry.scheduled());
+    advance(&wheel, 20);
+    CHECK_EQ(count, 2);
+
+    // 析构时自动摘下
+    {
+        TimingWheel::Entry temporary;
+        temporary.setCallback([&] { ++count; });
+        wheel.schedule(&temporary, 1);
+    }
+    advance(&wheel, 2);
+    CHECK_EQ(count, 2);
+}
+
+void testCallbacks()
+{
+    muduo::net::EventLoop loop;
+    TimingWheel wheel(&loop, 4);
+    int aCount = 0;
+    int bCount = 0;
+    TimingWheel::Entry a, b;
+    // 同一格里先触发的回调取消了另一个，并给自己重新计时
+    a.setCallback([&] { ++aCount; b.cancel(); wheel.schedule(&a, 2); });
+    b.setCallback([&] { ++bCount; a.cancel(); wheel.schedule(&b, 2); });
+    wheel.schedule(&a, 1);
+    wheel.schedule(&b, 1);
+
+    advance(&wheel, 1);
+    CHECK_EQ(aCount + bCount, 1);
+    CHECK(a.scheduled() != b.scheduled());
+    advance(&wheel, 2);
+    CHECK_EQ(aCount + bCount, 2);
+
+    // 轮子先析构，之后 Entry 析构不再访问它
+    TimingWheel::Entry survivor;
+    {
+        TimingWheel temporary(&loop, 4);
+        temporary.schedule(&survivor, 3);
+    }
+    CHECK(!survivor.scheduled());
+}
+
+} // namespace
+
+int main()
+{
+    testExpiry();
+    testReschedule();
+    testCallbacks();
+    return test::finish();
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "http/HttpTokenizer.h"
+#include "TestUtil.h"
+
+/*
+    HttpTokenizer 各个扫描函数和标量实现（std::find / std::search）的对照测试。
+    CMakeLists.txt 把这个文件和 HttpTokenizer.cpp 按 SSE2、SSE4.2、AVX2 各编译一份，
+    CPU 不支持的那一档直接跳过（返回 77，ctest 记为 skipped）
+ */
+
+using namespace http;
+
+namespace
+{
+
+const char* scalarFindCRLF(const char* begin, const char* end)
+{
+    static const char crlf[] = "\r\n";
+    const char* p = std::search(begin, end, crlf, crlf + 2);
+    return p == end ? nullptr : p;
+}
+
+const char* scalarFindEither(const char* begin, const char* end, char a, char b)
+{
+    return std::find_if(begin, end, [=](char c) { return c == a || c == b; });
+}
+
+// 从 data 的每个起始偏移、每个长度扫描，让命中位置和尾部落在向量宽度的每个位置上
+void checkAllRanges(const std::vector<char>& data)
+{
+    const char* base = data.data();
+    for (size_t from = 0; from < 40 && from <= data.size(); ++from)
+    {
+        for (size_t to = from; to <= data.size(); ++to)
+        {
+            const char* b = base + from;
+            const char* e = base + to;
+            CHECK(tokenizer::findByte(b, e, ':') == std::find(b, e, ':'));
+            CHECK(tokenizer::findByte(b, e, '\0') == std::find(b, e, '\0'));
+            CHECK(tokenizer::findEither(b, e, ':', '\r') == scalarFindEither(b, e, ':', '\r'));
+            CHECK(tokenizer::findEither(b, e, '\xff', ' ') == scalarFindEither(b, e, '\xff', ' '));
+            CHECK(tokenizer::findCRLF(b, e) == scalarFindCRLF(b, e));
+            if (test::failures() > 0)
+            {
+                std::printf("  range [%zu, %zu)\n", from, to);
+                return;
+            }
+        }
+    }
+}
+
+void checkScanners()
+{
+    std::mt19937 rng(7);
+    const char alphabet[] = { 'a', 'b', ':', '\r', '\n', ' ', '\0', '\xff' };
+    for (int round = 0; round < 200 && test::failures() == 0; ++round)
+    {
+        size_t size = rng() % 100;
+        std::vector<char> data(size);
+        // 大部分是普通字符，分隔符稀疏出现；偶数轮只在末尾附近放分隔符
+        for (size_t i = 0; i < size; ++i)
+        {
+            bool sparse = (round % 2 == 0) ? (i + 3 >= size) : (rng() % 8 == 0);
+            data[i] = sparse ? alphabet[rng() % sizeof alphabet] : static_cast<char>('a' + rng() % 26);
+        }
+        checkAllRanges(data);
+    }
+
+    // 单独的 '\r' 紧挨在向量边界两侧
+    for (size_t pos = 0; pos < 70; ++pos)
+    {
+        std::string s(80, 'x');
+        s[pos] = '\r';
+        s[pos + 2] = '\r';
+        s[pos + 3] = '\n';
+        CHECK(tokenizer::findCRLF(s.data(), s.data() + s.size()) == s.data() + pos + 2);
+        CHECK(tokenizer::findCRLF(s.data(), s.data() + pos + 1) == nullptr);
+    }
+}
+
+void checkMethods()
+{
+    struct Case
+    {
+        const char*         name;
+        HttpRequest::Method method;
+    };
+    const Case cases[] = {
+        { "GET", HttpRequest::kGet },
+        { "POST", HttpRequest::kPost },
+        { "HEAD", HttpRequest::kHead },
+        { "PUT", HttpRequest::kPut },
+        { "DELETE", HttpRequest::kDelete },
+        { "OPTIONS", HttpRequest::kOptions },
+        { "get", HttpRequest::kInvalid },
+        { "GETS", HttpRequest::kInvalid },
+        { "GE", HttpRequest::kInvalid },
+        { "PATCH", HttpRequest::kInvalid },
+        { "OPTIONSX", HttpRequest::kInvalid },
+        { "", HttpRequest::kInvalid },
+    };
+    for (const auto& c : cases)
+    {
+        size_t len = std::strlen(c.name);
+        CHECK_EQ(static_cast<int>(tokenizer::parseMethod(c.name, c.name + len)), static_cast<int>(c.method));
+    }
+    // 方法名后面紧跟的字节不参与判断
+    const char line[] = "POST /x";
+    CHECK_EQ(static_cast<int>(tokenizer::parseMethod(line, line + 4)), static_cast<int>(HttpRequest::kPost));
+}
+
+bool cpuSupported()
+{
+#if defined(__AVX2__)
+    return __builtin_cpu_supports("avx2");
+#elif defined(__SSE4_2__)
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return true;
+#endif
+}
+
+} // namespace
+
+int main()
+{
+    if (!cpuSupported())
+    {
+        std::printf("skipped: CPU does not support this build's instruction set\n");
+        return 77;
+    }
+    checkScanners();
+    checkMethods();
+    return test::finish();
+}
@@ -0,0 +1,638 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include <muduo/net/Buffer.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "http/HttpContext.h"
+#include "http/WebSocket.h"
+#include "TestUtil.h"
+
+/*
+    WebSocket：握手和 permessage-deflate 协商、帧解析和去掩码、分片拼接（中间插控制帧）、
+    关闭状态码、文本消息的 UTF-8 检查、消息大小和解压后大小的上限、压缩消息的双向往返。
+    服务端一侧是 socketpair 上的 TcpConnection，不跑事件循环：收到的帧直接交给 onRead，
+    open() 之前发出的帧都缓存着，open() 时一次写到 socket，测试从另一端读出来解析
+ */
+
+using namespace http;
+
+namespace
+{
+
+const char kSampleKey[] = "dGhlIHNhbXBsZSBub25jZQ==";
+const uint8_t kMask[4] = { 0x37, 0xfa, 0x21, 0x3d };
+
+// 记录 handler 收到的消息和关闭状态码
+class Recorder : public WebSocketHandler
+{
+public:
+    void onMessage(const WebSocketPtr&, std::string_view message, bool binary) override
+    { messages.emplace_back(std::string(message), binary); }
+
+    void onClose(const WebSocketPtr&, uint16_t code) override
+    { closeCodes.push_back(code); }
+
+    std::vector<std::pair<std::string, bool>> messages;
+    std::vector<uint16_t>                     closeCodes;
+};
+
+// 客户端发的帧：默认加掩码、FIN 置位
+std::string frame(int opcode, std::string_view payload, bool fin = true, bool rsv1 = false, bool masked = true)
+{
+    std::string out;
+    out.push_back(static_cast<char>((fin ? 0x80 : 0) | (rsv1 ? 0x40 : 0) | opcode));
+    char maskBit = masked ? static_cast<char>(0x80) : 0;
+    uint64_t length = payload.size();
+    if (length < 126)
+    {
+        out.push_back(static_cast<char>(maskBit | length));
+    }
+    else if (length <= 0xFFFF)
+    {
+        out.push_back(static_cast<char>(maskBit | 126));
+        out.push_back(static_cast<char>(length >> 8));
+        out.push_back(static_cast<char>(length & 0xFF));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(maskBit | 127));
+        for (int i = 0; i < 8; ++i)
+        {
+            out.push_back(static_cast<char>(length >> (56 - 8 * i)));
+        }
+    }
+    if (masked)
+    {
+        out.append(reinterpret_cast<const char*>(kMask), 4);
+    }
+    for (size_t i = 0; i < payload.size(); ++i)
+    {
+        out.push_back(masked ? static_cast<char>(payload[i] ^ kMask[i & 3]) : payload[i]);
+    }
+    return out;
+}
+
+std::string closePayload(uint16_t code, std::string_view reason = std::string_view())
+{
+    std::string payload;
+    payload.push_back(static_cast<char>(code >> 8));
+    payload.push_back(static_cast<char>(code & 0xFF));
+    payload.append(reason.data(), reason.size());
+    return payload;
+}
+
+// 服务端发出的帧（不加掩码）
+struct Frame
+{
+    bool        fin;
+    bool        rsv1;
+    int         opcode;
+    std::string payload;
+};
+
+std::vector<Frame> parseFrames(std::string_view data)
+{
+    std::vector<Frame> frames;
+    while (data.size() >= 2)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+        uint64_t length = p[1] & 0x7F;
+        size_t header = 2;
+        if (length == 126)
+        {
+            length = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+            header = 4;
+        }
+        else if (length == 127)
+        {
+            length = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                length = (length << 8) | p[2 + i];
+            }
+            header = 10;
+        }
+        if ((p[1] & 0x80) || data.size() < header + length)
+        {
+            break;
+        }
+        frames.push_back(Frame{ (p[0] & 0x80) != 0, (p[0] & 0x40) != 0, p[0] & 0x0F,
+                                std::string(data.substr(header, length)) });
+        data.remove_prefix(header + length);
+    }
+    return frames;
+}
+
+// 客户端一侧的 permessage-deflate：保留上下文（context takeover），去掉 Z_SYNC_FLUSH 的 00 00 ff ff
+class ClientDeflater
+{
+public:
+    ClientDeflater()
+    {
+        stream_ = z_stream();
+        deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    }
+
+    ~ClientDeflater()
+    { deflateEnd(&stream_); }
+
+    std::string compress(std::string_view in)
+    {
+        std::string out(deflateBound(&stream_, static_cast<uLong>(in.size())) + 64, '\0');
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        stream_.avail_in = static_cast<uInt>(in.size());
+        stream_.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream_.avail_out = static_cast<uInt>(out.size());
+        deflate(&stream_, Z_SYNC_FLUSH);
+        out.resize(out.size() - stream_.avail_out - 4);
+        return out;
+    }
+
+private:
+    z_stream stream_;
+};
+
+class ClientInflater
+{
+public:
+    ClientInflater()
+    {
+        stream_ = z_stream();
+        inflateInit2(&stream_, -15);
+    }
+
+    ~ClientInflater()
+    { inflateEnd(&stream_); }
+
+    std::string decompress(std::string in)
+    {
+        in.append("\x00\x00\xff\xff", 4);
+        std::string out(1 << 20, '\0');
+        stream_.next_in = reinterpret_cast<Bytef*>(&in[0]);
+        stream_.avail_in = static_cast<uInt>(in.size());
+        stream_.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream_.avail_out = static_cast<uInt>(out.size());
+        int rv = inflate(&stream_, Z_SYNC_FLUSH);
+        out.resize(rv == Z_OK ? out.size() - stream_.avail_out : 0);
+        return out;
+    }
+
+private:
+    z_stream stream_;
+};
+
+// 一条 socketpair 上的连接：fds_[0] 归服务端的 TcpConnection，fds_[1] 由测试读
+class Peer
+{
+public:
+    explicit Peer(muduo::net::EventLoop* loop)
+        : recorder_(std::make_shared<Recorder>())
+    {
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds_) != 0)
+        {
+            fds_[0] = fds_[1] = -1;
+            return;
+        }
+        muduo::net::InetAddress addr(0);
+        conn_ = std::make_shared<muduo::net::TcpConnection>(loop, "ws", fds_[0], addr, addr);
+        conn_->setConnectionCallback([](const muduo::net::TcpConnectionPtr&) {});
+        conn_->connectEstablished();
+    }
+
+    ~Peer()
+    {
+        if (conn_)
+        {
+            conn_->connectDestroyed();
+        }
+        if (fds_[1] >= 0)
+        {
+            ::close(fds_[1]);
+        }
+    }
+
+    // 发握手请求；extensions 为空时不带 Sec-WebSocket-Extensions
+    WebSocketPtr handshake(const std::string& extensions = std::string(),
+                           const std::string& requestLine = "GET /chat HTTP/1.1",
+                           const std::string& version = "13")
+    {
+        test::Headers headers = { {"Upgrade", "websocket"}, {"Connection", "keep-alive, Upgrade"},
+                                  {"Sec-WebSocket-Key", kSampleKey}, {"Sec-WebSocket-Version", version} };
+        if (!extensions.empty())
+        {
+            headers.emplace_back("Sec-WebSocket-Extensions", extensions);
+        }
+        CHECK(test::parse(&context_, requestLine, headers));
+        response_.reset(false);
+        response_.setVersion("HTTP/1.1");
+        if (!conn_)
+        {
+            return nullptr;
+        }
+        ws_ = WebSocket::accept(conn_, context_.request(), &response_, recorder_);
+        return ws_;
+    }
+
+    // 客户端发来的数据：不完整的帧留在缓冲区里，等后面的数据
+    void feed(std::string_view data)
+    {
+        input_.append(data.data(), data.size());
+        ws_->onRead(&input_);
+    }
+
+    // open() 把缓存的帧一次写到 socket，从另一端读出来
+    std::vector<Frame> open()
+    {
+        ws_->open();
+        std::string out;
+        char buf[65536];
+        ssize_t n;
+        while ((n = ::read(fds_[1], buf, sizeof buf)) > 0)
+        {
+            out.append(buf, n);
+        }
+        return parseFrames(out);
+    }
+
+    HttpResponse& response()
+    { return response_; }
+
+    Recorder& recorder()
+    { return *recorder_; }
+
+    uint16_t lastCloseCode() const
+    { return recorder_->closeCodes.empty() ? 0 : recorder_->closeCodes.back(); }
+
+private:
+    int                               fds_[2];
+    muduo::net::TcpConnectionPtr      conn_;
+    std::shared_ptr<Recorder>         recorder_;
+    HttpContext                       context_;
+    HttpResponse                      response_;
+    WebSocketPtr                      ws_;
+    muduo::net::Buffer                input_;
+};
+
+void testHandshake(muduo::net::EventLoop* loop)
+{
+    {
+        // RFC 6455 1.3 的例子
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake();
+        CHECK(ws != nullptr);
+        CHECK_EQ(peer.response().getStatusCode(), HttpResponse::k101SwitchingProtocols);
+        CHECK_EQ(peer.response().getHeader(HttpHeaders::kSecWebSocketAccept),
+                 std::string_view("s3pPLMBiTxaQ9kYGzzhZRbK+xOo="));
+        CHECK(peer.response().getHeader(HttpHeaders::kSecWebSocketExtensions).empty());
+        CHECK(ws && !ws->deflateEnabled());
+        CHECK(ws && ws->path() == "/chat");
+    }
+    {
+        Peer peer(loop);
+        CHECK(peer.handshake("", "POST /chat HTTP/1.1") == nullptr);
+        CHECK_EQ(peer.response().getStatusCode(), HttpResponse::k400BadRequest);
+    }
+    {
+        Peer peer(loop);
+        CHECK(peer.handshake("", "GET /chat HTTP/1.1", "8") == nullptr);
+        CHECK_EQ(peer.response().getStatusCode(), HttpResponse::k426UpgradeRequired);
+        CHECK_EQ(peer.response().getHeader(HttpHeaders::kSecWebSocketVersion), std::string_view("13"));
+    }
+
+    // permessage-deflate：按顺序接受第一个能满足的提议
+    struct Case
+    {
+        const char* offer;
+        const char* accepted; // 空串表示不启用
+    };
+    const Case cases[] = {
+        { "permessage-deflate; client_max_window_bits", "permessage-deflate" },
+        { "permessage-deflate; server_max_window_bits=10; client_no_context_takeover",
+          "permessage-deflate; client_no_context_takeover; server_max_window_bits=10" },
+        { "permessage-deflate; server_no_context_takeover",
+          "permessage-deflate; server_no_context_takeover" },
+        // zlib 不支持 8 位窗口，放弃这个提议，接受后面的
+        { "permessage-deflate; server_max_window_bits=8, permessage-deflate", "permessage-deflate" },
+        { "permessage-deflate; unknown_param", "" },
+        { "permessage-deflate; server_max_window_bits=16", "" },
+        { "x-webkit-deflate-frame", "" },
+    };
+    for (const Case& c : cases)
+    {
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake(c.offer);
+        CHECK(ws != nullptr);
+        CHECK_EQ(peer.response().getHeader(HttpHeaders::kSecWebSocketExtensions), std::string_view(c.accepted));
+        CHECK(ws && ws->deflateEnabled() == (c.accepted[0] != '\0'));
+    }
+}
+
+void testFrames(muduo::net::EventLoop* loop)
+{
+    Peer peer(loop);
+    CHECK(peer.handshake() != nullptr);
+
+    // RFC 6455 5.7：带掩码的 "Hello"
+    peer.feed(std::string("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 11));
+    // 16 位和 64 位长度
+    std::string medium(300, 'm');
+    std::string large(70000, 'l');
+    peer.feed(frame(WebSocket::kText, medium));
+    peer.feed(frame(WebSocket::kBinary, large));
+    // 二进制消息不检查 UTF-8
+    peer.feed(frame(WebSocket::kBinary, std::string("\xff\x00\xfe", 3)));
+
+    // 一帧分几次到达：头部不完整、载荷不完整时都等后面的数据
+    std::string split = frame(WebSocket::kText, "split frame");
+    peer.feed(split.substr(0, 1));
+    peer.feed(split.substr(1, 5));
+    CHECK_EQ(peer.recorder().messages.size(), size_t(4));
+    peer.feed(split.substr(6));
+
+    const auto& messages = peer.recorder().messages;
+    CHECK_EQ(messages.size(), size_t(5));
+    if (messages.size() == 5)
+    {
+        CHECK(messages[0] == std::make_pair(std::string("Hello"), false));
+        CHECK(messages[1] == std::make_pair(medium, false));
+        CHECK(messages[2] == std::make_pair(large, true));
+        CHECK(messages[3] == std::make_pair(std::string("\xff\x00\xfe", 3), true));
+        CHECK(messages[4] == std::make_pair(std::string("split frame"), false));
+    }
+    CHECK(peer.recorder().closeCodes.empty());
+}
+
+void testFragmentation(muduo::net::EventLoop* loop)
+{
+    {
+        // 分片中间插一个 ping：消息照常拼好，ping 原样回 pong
+        Peer peer(loop);
+        CHECK(peer.handshake() != nullptr);
+        peer.feed(frame(WebSocket::kText, "Hel", false));
+        peer.feed(frame(WebSocket::kPing, "are you there"));
+        peer.feed(frame(WebSocket::kContinuation, "lo, ", false));
+        peer.feed(frame(WebSocket::kContinuation, "world"));
+        CHECK_EQ(peer.recorder().messages.size(), size_t(1));
+        CHECK(!peer.recorder().messages.empty() && peer.recorder().messages[0].first == "Hello, world");
+
+        std::vector<Frame> frames = peer.open();
+        CHECK_EQ(frames.size(), size_t(1));
+        CHECK(!frames.empty() && frames[0].opcode == WebSocket::kPong && frames[0].payload == "are you there");
+    }
+
+    // 协议错误：回 1002 并关闭
+    const std::vector<std::string> invalid = {
+        frame(WebSocket::kContinuation, "orphan"),                       // 没有开头的续帧
+        frame(WebSocket::kText, "a", false) + frame(WebSocket::kText, "b"), // 分片没结束又开始新消息
+        frame(WebSocket::kText, "unmasked", true, false, false),          // 客户端的帧没加掩码
+        frame(WebSocket::kPing, "x", false),                              // 控制帧分片
+        frame(WebSocket::kPing, std::string(126, 'p')),                   // 控制帧超过 125 字节
+        frame(WebSocket::kText, "rsv1", true, true),                      // 没协商压缩却置了 RSV1
+        frame(0x3, "reserved opcode"),
+        frame(0xB, "reserved control opcode"),
+        std::string("\xa1\x80\x00\x00\x00\x00", 6),                        // RSV2
+    };
+    for (const std::string& data : invalid)
+    {
+        Peer peer(loop);
+        CHECK(peer.handshake() != nullptr);
+        peer.feed(data);
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kProtocolError));
+        CHECK(peer.recorder().messages.empty());
+        CHECK_EQ(peer.recorder().closeCodes.size(), size_t(1));
+    }
+}
+
+void testCloseCodes(muduo::net::EventLoop* loop)
+{
+    struct Case
+    {
+        std::string payload;
+        uint16_t    reported; // onClose 收到的状态码
+    };
+    const Case cases[] = {
+        { closePayload(1000, "bye"), 1000 },
+        { closePayload(1001), 1001 },
+        { closePayload(3000), 3000 },
+        { closePayload(4999, "app"), 4999 },
+        { std::string(), WebSocket::kNoStatus },
+        // 不能出现在帧里的、保留的、超出范围的状态码，只有 1 个字节的载荷，原因不是 UTF-8
+        { closePayload(1005), WebSocket::kProtocolError },
+        { closePayload(1006), WebSocket::kProtocolError },
+        { closePayload(1004), WebSocket::kProtocolError },
+        { closePayload(999), WebSocket::kProtocolError },
+        { closePayload(2999), WebSocket::kProtocolError },
+        { closePayload(5000), WebSocket::kProtocolError },
+        { std::string("\x03", 1), WebSocket::kProtocolError },
+        { closePayload(1000, "\xc3\x28"), WebSocket::kProtocolError },
+    };
+    for (const Case& c : cases)
+    {
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake();
+        CHECK(ws != nullptr);
+        peer.feed(frame(WebSocket::kClose, c.payload));
+        CHECK_EQ(peer.lastCloseCode(), c.reported);
+        CHECK(ws && ws->closed());
+        // 关闭之后的数据不再处理
+        peer.feed(frame(WebSocket::kText, "after close"));
+        CHECK(peer.recorder().messages.empty());
+        CHECK_EQ(peer.recorder().closeCodes.size(), size_t(1));
+    }
+}
+
+void testUtf8(muduo::net::EventLoop* loop)
+{
+    const std::vector<std::string> valid = {
+        "plain ascii, longer than eight bytes",
+        "\xe4\xbd\xa0\xe5\xa5\xbd",         // 你好
+        "\xf0\x9f\x98\x80 emoji",           // U+1F600
+        "\xf4\x8f\xbf\xbf",                 // U+10FFFF
+        "\xed\x9f\xbf",                     // U+D7FF，代理区之前
+        std::string(),
+    };
+    for (const std::string& text : valid)
+    {
+        Peer peer(loop);
+        CHECK(peer.handshake() != nullptr);
+        peer.feed(frame(WebSocket::kText, text));
+        CHECK_EQ(peer.recorder().messages.size(), size_t(1));
+        CHECK(peer.recorder().closeCodes.empty());
+    }
+
+    const std::vector<std::string> invalid = {
+        "\xc0\x80",                         // 超长编码
+        "\xe0\x80\xaf",                     // 超长编码
+        "\xed\xa0\x80",                     // UTF-16 代理
+        "\xf4\x90\x80\x80",                 // 超过 U+10FFFF
+        "\xe4\xbd",                         // 截断
+        "abcdefgh\x80",                     // ASCII 快速路径之后的孤立续字节
+        "\xf8\x88\x80\x80\x80",             // 5 字节序列
+    };
+    for (const std::string& text : invalid)
+    {
+        Peer peer(loop);
+        CHECK(peer.handshake() != nullptr);
+        peer.feed(frame(WebSocket::kText, text));
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kInvalidPayload));
+        CHECK(peer.recorder().messages.empty());
+    }
+
+    {
+        // 多字节字符跨分片：拼好之后才检查
+        Peer peer(loop);
+        CHECK(peer.handshake() != nullptr);
+        peer.feed(frame(WebSocket::kText, "\xe4\xbd", false));
+        peer.feed(frame(WebSocket::kContinuation, "\xa0"));
+        CHECK_EQ(peer.recorder().messages.size(), size_t(1));
+        CHECK(peer.recorder().closeCodes.empty());
+    }
+}
+
+void testMessageSize(muduo::net::EventLoop* loop)
+{
+    {
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake();
+        CHECK(ws != nullptr);
+        ws->setMaxMessageSize(100);
+        peer.feed(frame(WebSocket::kText, std::string(100, 'a')));
+        CHECK_EQ(peer.recorder().messages.size(), size_t(1));
+        peer.feed(frame(WebSocket::kText, std::string(101, 'a')));
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kMessageTooBig));
+    }
+    {
+        // 分片加起来超限，不必等最后一片
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake();
+        CHECK(ws != nullptr);
+        ws->setMaxMessageSize(100);
+        peer.feed(frame(WebSocket::kBinary, std::string(60, 'a'), false));
+        peer.feed(frame(WebSocket::kContinuation, std::string(60, 'a'), false));
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kMessageTooBig));
+        CHECK(peer.recorder().messages.empty());
+    }
+}
+
+void testInflateLimit(muduo::net::EventLoop* loop)
+{
+    const size_t limit = 64 * 1024;
+    {
+        // 压缩炸弹：1 MB 的 0 压缩后只有 1 KB 左右，解压到超限的那一刻就停下
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake("permessage-deflate");
+        CHECK(ws && ws->deflateEnabled());
+        ws->setMaxMessageSize(limit);
+        ClientDeflater deflater;
+        std::string bomb = deflater.compress(std::string(1024 * 1024, '\0'));
+        CHECK(bomb.size() < limit);
+        peer.feed(frame(WebSocket::kBinary, bomb, true, true));
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kMessageTooBig));
+        CHECK(peer.recorder().messages.empty());
+    }
+    {
+        // 解压后正好等于上限的可以
+        Peer peer(loop);
+        WebSocketPtr ws = peer.handshake("permessage-deflate");
+        CHECK(ws != nullptr);
+        ws->setMaxMessageSize(limit);
+        ClientDeflater deflater;
+        peer.feed(frame(WebSocket::kText, deflater.compress(std::string(limit, 'a')), true, true));
+        CHECK_EQ(peer.recorder().messages.size(), size_t(1));
+        CHECK(!peer.recorder().messages.empty() && peer.recorder().messages[0].first.size() == limit);
+        CHECK(peer.recorder().closeCodes.empty());
+    }
+    {
+        // 不是合法的 deflate 数据（保留的块类型）
+        Peer peer(loop);
+        CHECK(peer.handshake("permessage-deflate") != nullptr);
+        peer.feed(frame(WebSocket::kText, std::string("\xff\xff\xff", 3), true, true));
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kInvalidPayload));
+    }
+    {
+        // RSV1 只能出现在消息的第一帧
+        Peer peer(loop);
+        CHECK(peer.handshake("permessage-deflate") != nullptr);
+        ClientDeflater deflater;
+        std::string data = deflater.compress("fragmented and compressed");
+        peer.feed(frame(WebSocket::kText, data.substr(0, 4), false, true));
+        peer.feed(frame(WebSocket::kContinuation, data.substr(4), true, true));
+        CHECK_EQ(peer.lastCloseCode(), uint16_t(WebSocket::kProtocolError));
+    }
+}
+
+void testDeflateRoundTrip(muduo::net::EventLoop* loop)
+{
+    Peer peer(loop);
+    WebSocketPtr ws = peer.handshake("permessage-deflate; client_max_window_bits");
+    CHECK(ws && ws->deflateEnabled());
+    if (!ws)
+    {
+        return;
+    }
+
+    // 收：客户端保留压缩上下文，后面的消息引用前面的内容；压缩消息也可以分片
+    ClientDeflater deflater;
+    const std::string json = "{\"type\":\"token\",\"conversation\":42,\"content\":\"hello\"}";
+    peer.feed(frame(WebSocket::kText, deflater.compress(json), true, true));
+    std::string second = deflater.compress(json);
+    peer.feed(frame(WebSocket::kText, second.substr(0, 3), false, true));
+    peer.feed(frame(WebSocket::kContinuation, second.substr(3)));
+    peer.feed(frame(WebSocket::kText, "not compressed"));
+    const auto& messages = peer.recorder().messages;
+    CHECK_EQ(messages.size(), size_t(3));
+    if (messages.size() == 3)
+    {
+        CHECK_EQ(messages[0].first, json);
+        CHECK_EQ(messages[1].first, json);
+        CHECK_EQ(messages[2].first, std::string("not compressed"));
+    }
+
+    // 发：够长的消息压缩（RSV1），服务端同样保留上下文，第二条更短；短消息原样发出
+    CHECK(ws->sendText(json));
+    CHECK(ws->sendText(json));
+    CHECK(ws->sendText("short"));
+    const std::string binary(4096, '\x7f');
+    CHECK(ws->sendBinary(binary));
+    std::vector<Frame> frames = peer.open();
+    CHECK_EQ(frames.size(), size_t(4));
+    if (frames.size() == 4)
+    {
+        ClientInflater inflater;
+        CHECK(frames[0].fin && frames[0].rsv1 && frames[0].opcode == WebSocket::kText);
+        CHECK_EQ(inflater.decompress(frames[0].payload), json);
+        CHECK(frames[1].rsv1);
+        CHECK(frames[1].payload.size() < frames[0].payload.size());
+        CHECK_EQ(inflater.decompress(frames[1].payload), json);
+        CHECK(!frames[2].rsv1 && frames[2].payload == "short");
+        CHECK(frames[3].rsv1 && frames[3].opcode == WebSocket::kBinary);
+        CHECK(frames[3].payload.size() < binary.size());
+        CHECK(inflater.decompress(frames[3].payload) == binary);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    muduo::net::EventLoop loop;
+    testHandshake(&loop);
+    testFrames(&loop);
+    testFragmentation(&loop);
+    testCloseCodes(&loop);
+    testUtf8(&loop);
+    testMessageSize(&loop);
+    testInflateLimit(&loop);
+    testDeflateRoundTrip(&loop);
+    return test::finish();
+}
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "http/WorkerPool.h"
+#include "TestUtil.h"
+
+/*
+    WorkerPool：任务在工作线程上执行；队列满时 tryRun() 立即失败而不是阻塞调用方（EventLoop）；
+    任务抛出的异常不会带走工作线程；stop() 丢弃还没开始的任务
+ */
+
+using namespace http;
+
+namespace
+{
+
+// 让工作线程停在任务里，直到 open()
+class Gate
+{
+public:
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++waiting_;
+        changed_.notify_all();
+        changed_.wait(lock, [this] { return open_; });
+    }
+
+    void waitForWaiters(int n)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this, n] { return waiting_ >= n; });
+    }
+
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        changed_.notify_all();
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable changed_;
+    int                     waiting_ { 0 };
+    bool                    open_ { false };
+};
+
+bool waitFor(const std::atomic<int>& value, int expected)
+{
+    for (int i = 0; i < 500 && value.load() != expected; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return value.load() == expected;
+}
+
+void testBoundedQueue()
+{
+    WorkerPool pool("test-worker", 2, 3);
+    CHECK(!pool.tryRun([] {})); // 还没 start
+
+    pool.start();
+    Gate gate;
+    std::atomic<int> done { 0 };
+
+    // 两个线程都卡在任务里，之后的任务只能排队
+    for (int i = 0; i < 2; ++i)
+    {
+        CHECK(pool.tryRun([&] { gate.wait(); ++done; }));
+    }
+    gate.waitForWaiters(2);
+    for (int i = 0; i < 3; ++i)
+    {
+        CHECK(pool.tryRun([&] { ++done; }));
+    }
+    CHECK_EQ(pool.queueSize(), static_cast<size_t>(3));
+    CHECK(!pool.tryRun([&] { ++done; })); // 队列已满，立即失败
+
+    gate.open();
+    CHECK(waitFor(done, 5));
+    CHECK(pool.tryRun([&] { ++done; }));
+    CHECK(waitFor(done, 6));
+    pool.stop();
+    CHECK(!pool.tryRun([] {}));
+}
+
+void testException()
+{
+    WorkerPool pool("test-worker", 1, 8);
+    pool.start();
+    std::atomic<int> done { 0 };
+    CHECK(pool.tryRun([] { throw std::runtime_error("db down"); }));
+    CHECK(pool.tryRun([&] { ++done; }));
+    CHECK(waitFor(done, 1));
+}
+
+void testStopDropsQueued()
+{
+    WorkerPool pool("test-worker", 1, 8);
+    pool.start();
+    Gate gate;
+    std::atomic<int> done { 0 };
+    CHECK(pool.tryRun([&] { gate.wait(); ++done; }));
+    gate.waitForWaiters(1);
+    CHECK(pool.tryRun([&] { ++done; }));
+
+    std::thread opener([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gate.open();
+    });
+    pool.stop(); // 等正在执行的任务结束，排队的那个不再执行
+    opener.join();
+    CHECK_EQ(done.load(), 1);
+}
+
+} // namespace
+
+int main()
+{
+    testBoundedQueue();
+    testException();
+    testStopDropsQueued();
+    return test::finish();
+}
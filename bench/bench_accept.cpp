@@ -0,0 +1,187 @@
+// bench_accept.cpp - Connection churn benchmark: one request per TCP connection
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+
+using namespace std;
+using namespace chrono;
+
+struct Stats {
+    atomic<uint64_t> success{0};
+    atomic<uint64_t> connect_failed{0};
+    atomic<uint64_t> io_failed{0};
+    atomic<uint64_t> http_non_200{0};
+};
+
+// One short-lived connection: connect, send a request with Connection: close,
+// read until the server closes. Returns the HTTP status, 0 on I/O error, -1 on connect error.
+int one_shot(const sockaddr_in& addr, const string& req) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+
+    int flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    if (::connect(sock, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+
+    if (send(sock, req.c_str(), req.size(), 0) != (ssize_t)req.size()) {
+        close(sock);
+        return 0;
+    }
+
+    // The server closes first, so TIME_WAIT stays on the server side and
+    // the client does not run out of ephemeral ports.
+    char buf[4096];
+    string head;
+    ssize_t n;
+    while ((n = recv(sock, buf, sizeof(buf), 0)) > 0) {
+        if (head.size() < 16) head.append(buf, n);
+    }
+    close(sock);
+
+    if (n < 0 || head.size() < 12 || head.compare(0, 5, "HTTP/") != 0) return 0;
+    return atoi(head.substr(9, 3).c_str());
+}
+
+void worker_thread(const sockaddr_in& addr, const string& req, steady_clock::time_point deadline,
+                   Stats& stats, vector<uint64_t>& latencies) {
+    while (steady_clock::now() < deadline) {
+        auto start = steady_clock::now();
+        int status = one_shot(addr, req);
+        auto end = steady_clock::now();
+
+        if (status == 200) {
+            stats.success++;
+            latencies.push_back(duration_cast<microseconds>(end - start).count());
+        } else if (status < 0) {
+            stats.connect_failed++;
+        } else if (status == 0) {
+            stats.io_failed++;
+        } else {
+            stats.http_non_200++;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " <host> <port> <threads> [--duration 10] [--path /api/health] [--csv-out <path>]\n";
+        cerr << "Example: " << argv[0] << " 127.0.0.1 8080 64 --duration 20\n";
+        return 1;
+    }
+
+    string host = argv[1];
+    int port = atoi(argv[2]);
+    int num_threads = atoi(argv[3]);
+    int duration = 10;
+    string path = "/api/health";
+    string csv_out;
+
+    for (int i = 4; i + 1 < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--duration") {
+            duration = atoi(argv[++i]);
+        } else if (arg == "--path") {
+            path = argv[++i];
+        } else if (arg == "--csv-out") {
+            csv_out = argv[++i];
+        }
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        cerr << "Invalid IPv4 address: " << host << "\n";
+        return 1;
+    }
+
+    string req = "GET " + path + " HTTP/1.1\r\n"
+                 "Host: " + host + "\r\n"
+                 "Connection: close\r\n"
+                 "\r\n";
+
+    cout << "=== Accept (Connection Churn) Benchmark ===\n";
+    cout << "Target: " << host << ":" << port << path << "\n";
+    cout << "Threads: " << num_threads << "\n";
+    cout << "Duration: " << duration << " seconds\n\n";
+
+    Stats stats;
+    vector<vector<uint64_t>> latencies(num_threads);
+
+    auto start = steady_clock::now();
+    auto deadline = start + seconds(duration);
+
+    vector<thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back(worker_thread, cref(addr), cref(req), deadline,
+                             ref(stats), ref(latencies[i]));
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto end = steady_clock::now();
+    double elapsed = duration_cast<milliseconds>(end - start).count() / 1000.0;
+    if (elapsed <= 0.0) elapsed = 0.001;
+
+    vector<uint64_t> all;
+    for (auto& v : latencies) all.insert(all.end(), v.begin(), v.end());
+    sort(all.begin(), all.end());
+
+    auto percentile = [&](double p) -> uint64_t {
+        if (all.empty()) return 0;
+        size_t idx = (size_t)(all.size() * p);
+        if (idx >= all.size()) idx = all.size() - 1;
+        return all[idx];
+    };
+
+    cout << "=== Results ===\n";
+    cout << "Elapsed: " << elapsed << " seconds\n";
+    cout << "Success: " << stats.success << "\n";
+    cout << "Connect failed: " << stats.connect_failed << "\n";
+    cout << "I/O failed: " << stats.io_failed << "\n";
+    cout << "HTTP non-200: " << stats.http_non_200 << "\n";
+    cout << "Connections/sec: " << (stats.success / elapsed) << "\n\n";
+
+    cout << "=== Connect-to-close latency (microseconds) ===\n";
+    cout << "P50: " << percentile(0.50) << " us\n";
+    cout << "P95: " << percentile(0.95) << " us\n";
+    cout << "P99: " << percentile(0.99) << " us\n";
+    cout << "Max: " << (all.empty() ? 0 : all.back()) << " us\n";
+
+    if (!csv_out.empty()) {
+        ofstream ofs(csv_out);
+        if (!ofs.is_open()) {
+            cerr << "Failed to write csv: " << csv_out << "\n";
+            return 1;
+        }
+        ofs << "metric,value\n";
+        ofs << "elapsed_sec," << elapsed << "\n";
+        ofs << "success," << stats.success << "\n";
+        ofs << "connect_failed," << stats.connect_failed << "\n";
+        ofs << "io_failed," << stats.io_failed << "\n";
+        ofs << "http_non_200," << stats.http_non_200 << "\n";
+        ofs << "conn_per_sec," << (stats.success / elapsed) << "\n";
+        ofs << "p50_us," << percentile(0.50) << "\n";
+        ofs << "p95_us," << percentile(0.95) << "\n";
+        ofs << "p99_us," << percentile(0.99) << "\n";
+        ofs << "max_us," << (all.empty() ? 0 : all.back()) << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+// bench_tls_handshake.cpp - TLS handshake rate benchmark (full or resumed handshakes)
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+using namespace std;
+using namespace chrono;
+
+struct Stats {
+    atomic<uint64_t> success{0};
+    atomic<uint64_t> resumed{0};
+    atomic<uint64_t> connect_failed{0};
+    atomic<uint64_t> handshake_failed{0};
+    atomic<uint64_t> http_failed{0};
+};
+
+struct Options {
+    sockaddr_in addr{};
+    string host;
+    bool resume = false;
+    bool request = false;
+    string path = "/api/health";
+};
+
+int tcp_connect(const sockaddr_in& addr) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    int flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    if (::connect(sock, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Send one request with Connection: close and read until the server closes.
+bool do_request(SSL* ssl, const Options& opt) {
+    string req = "GET " + opt.path + " HTTP/1.1\r\n"
+                 "Host: " + opt.host + "\r\n"
+                 "Connection: close\r\n"
+                 "\r\n";
+    if (SSL_write(ssl, req.data(), (int)req.size()) <= 0) return false;
+
+    char buf[4096];
+    string head;
+    int n;
+    while ((n = SSL_read(ssl, buf, sizeof(buf))) > 0) {
+        if (head.size() < 16) head.append(buf, n);
+    }
+    return head.size() >= 12 && head.compare(0, 7, "HTTP/1.") == 0 && head.compare(9, 3, "200") == 0;
+}
+
+void worker_thread(SSL_CTX* ctx, const Options& opt, steady_clock::time_point deadline,
+                   Stats& stats, vector<uint64_t>& latencies) {
+    SSL_SESSION* session = nullptr;
+
+    while (steady_clock::now() < deadline) {
+        auto start = steady_clock::now();
+        int sock = tcp_connect(opt.addr);
+        if (sock < 0) {
+            stats.connect_failed++;
+            continue;
+        }
+
+        SSL* ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, sock);
+        SSL_set_tlsext_host_name(ssl, opt.host.c_str());
+        if (opt.resume && session) SSL_set_session(ssl, session);
+
+        if (SSL_connect(ssl) != 1) {
+            stats.handshake_failed++;
+            ERR_clear_error();
+            SSL_free(ssl);
+            close(sock);
+            continue;
+        }
+        auto handshaken = steady_clock::now();
+
+        bool ok = true;
+        if (opt.request) ok = do_request(ssl, opt);
+
+        if (ok) {
+            stats.success++;
+            if (SSL_session_reused(ssl)) stats.resumed++;
+            latencies.push_back(duration_cast<microseconds>(handshaken - start).count());
+        } else {
+            stats.http_failed++;
+        }
+
+        // TLS 1.3 tickets arrive after the handshake; take the session once it is resumable
+        if (opt.resume) {
+            SSL_SESSION* latest = SSL_get1_session(ssl);
+            if (latest && SSL_SESSION_is_resumable(latest)) {
+                if (session) SSL_SESSION_free(session);
+                session = latest;
+            } else if (latest) {
+                SSL_SESSION_free(latest);
+            }
+        }
+
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+        close(sock);
+    }
+
+    if (session) SSL_SESSION_free(session);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " <host> <port> <threads> [--duration 10] [--resume] [--request] [--path /api/health] [--csv-out <path>]\n";
+        cerr << "Example: " << argv[0] << " 127.0.0.1 8443 32 --duration 20\n";
+        return 1;
+    }
+
+    Options opt;
+    opt.host = argv[1];
+    int port = atoi(argv[2]);
+    int num_threads = atoi(argv[3]);
+    int duration = 10;
+    string csv_out;
+
+    for (int i = 4; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--duration" && i + 1 < argc) {
+            duration = atoi(argv[++i]);
+        } else if (arg == "--resume") {
+            opt.resume = true;
+        } else if (arg == "--request") {
+            opt.request = true;
+        } else if (arg == "--path" && i + 1 < argc) {
+            opt.path = argv[++i];
+        } else if (arg == "--csv-out" && i + 1 < argc) {
+            csv_out = argv[++i];
+        }
+    }
+
+    // TLS 1.3 sends session tickets after the handshake; they are only read along with a response
+    if (opt.resume) opt.request = true;
+
+    opt.addr.sin_family = AF_INET;
+    opt.addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, opt.host.c_str(), &opt.addr.sin_addr) != 1) {
+        cerr << "Invalid IPv4 address: " << opt.host << "\n";
+        return 1;
+    }
+
+    // The benchmark measures the server's handshake cost; certificates are not verified
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    if (!ctx) {
+        cerr << "SSL_CTX_new failed\n";
+        return 1;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+
+    cout << "=== TLS Handshake Benchmark ===\n";
+    cout << "Target: " << opt.host << ":" << port << "\n";
+    cout << "Threads: " << num_threads << "\n";
+    cout << "Duration: " << duration << " seconds\n";
+    cout << "Mode: " << (opt.resume ? "session resumption" : "full handshake")
+         << (opt.request ? " + one request" : "") << "\n\n";
+
+    Stats stats;
+    vector<vector<uint64_t>> latencies(num_threads);
+
+    auto start = steady_clock::now();
+    auto deadline = start + seconds(duration);
+
+    vector<thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back(worker_thread, ctx, cref(opt), deadline,
+                             ref(stats), ref(latencies[i]));
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto end = steady_clock::now();
+    double elapsed = duration_cast<milliseconds>(end - start).count() / 1000.0;
+    if (elapsed <= 0.0) elapsed = 0.001;
+    SSL_CTX_free(ctx);
+
+    vector<uint64_t> all;
+    for (auto& v : latencies) all.insert(all.end(), v.begin(), v.end());
+    sort(all.begin(), all.end());
+
+    auto percentile = [&](double p) -> uint64_t {
+        if (all.empty()) return 0;
+        size_t idx = (size_t)(all.size() * p);
+        if (idx >= all.size()) idx = all.size() - 1;
+        return all[idx];
+    };
+
+    cout << "=== Results ===\n";
+    cout << "Elapsed: " << elapsed << " seconds\n";
+    cout << "Success: " << stats.success << "\n";
+    cout << "  - Resumed: " << stats.resumed << "\n";
+    cout << "Connect failed: " << stats.connect_failed << "\n";
+    cout << "Handshake failed: " << stats.handshake_failed << "\n";
+    cout << "HTTP failed: " << stats.http_failed << "\n";
+    cout << "Handshakes/sec: " << (stats.success / elapsed) << "\n\n";
+
+    cout << "=== Connect + handshake latency (microseconds) ===\n";
+    cout << "P50: " << percentile(0.50) << " us\n";
+    cout << "P95: " << percentile(0.95) << " us\n";
+    cout << "P99: " << percentile(0.99) << " us\n";
+    cout << "Max: " << (all.empty() ? 0 : all.back()) << " us\n";
+
+    if (!csv_out.empty()) {
+        ofstream ofs(csv_out);
+        if (!ofs.is_open()) {
+            cerr << "Failed to write csv: " << csv_out << "\n";
+            return 1;
+        }
+        ofs << "metric,value\n";
+        ofs << "elapsed_sec," << elapsed << "\n";
+        ofs << "success," << stats.success << "\n";
+        ofs << "resumed," << stats.resumed << "\n";
+        ofs << "connect_failed," << stats.connect_failed << "\n";
+        ofs << "handshake_failed," << stats.handshake_failed << "\n";
+        ofs << "http_failed," << stats.http_failed << "\n";
+        ofs << "handshakes_per_sec," << (stats.success / elapsed) << "\n";
+        ofs << "p50_us," << percentile(0.50) << "\n";
+        ofs << "p95_us," << percentile(0.95) << "\n";
+        ofs << "p99_us," << percentile(0.99) << "\n";
+        ofs << "max_us," << (all.empty() ? 0 : all.back()) << "\n";
+    }
+
+    return 0;
+}
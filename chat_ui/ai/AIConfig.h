@@ -26,7 +26,8 @@ namespace ai
 //      },
 //      "doubao": { ... },
 //      "wenxin": { ... }
-//    }
+//    },
+//    "cpu_layout": "db=2 llm=4 tools=1"   // 可选，见 http::CpuLayout
 //  }
 // ════════════════════════════════════════════════════════════
 
@@ -43,6 +44,7 @@ public:
         raw_ = oss.str();
 
         defaultModel_ = extractString(raw_, "default_model");
+        cpuLayout_    = extractString(raw_, "cpu_layout");
 
         auto modelsStart = raw_.find("\"models\"");
         if (modelsStart == std::string::npos) return true;
@@ -94,6 +96,9 @@ public:
 
     const std::string& defaultModel() const { return defaultModel_; }
 
+    // 线程放置配置串，未配置时为空
+    const std::string& cpuLayout() const { return cpuLayout_; }
+
     ModelConfig getConfig(const std::string& providerKey) const
     {
         auto it = configs_.find(providerKey);
@@ -108,6 +113,7 @@ public:
 private:
     std::string raw_;
     std::string defaultModel_;
+    std::string cpuLayout_;
     std::unordered_map<std::string, ModelConfig> configs_;
 
     static std::string extractString(const std::string& json, const std::string& key)
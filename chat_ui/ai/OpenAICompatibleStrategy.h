@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AIStrategy.h"
+#include "../include/http/CpuLayout.h"
 #include <thread>
 #include <sstream>
 #include <curl/curl.h>
@@ -54,6 +55,8 @@ public:
         ErrorCallback onError) override
     {
         std::thread([this, messages, onToken, onDone, onError]() {
+            // 从 I/O 线程创建，会继承它的单核绑定
+            http::CpuLayout::instance().pinCurrentThread("llm");
             doStream(messages, onToken, onDone, onError);
         }).detach();
     }
@@ -22,6 +22,20 @@ public:
         : sessionManager_(sm)
     {}
 
+    // 读写 MySQL，放到工作线程池执行
+    bool offload() const override { return true; }
+
+    // 不用 conn，io_uring 后端上直接处理
+    bool needsConnection() const override { return false; }
+
+    // 带 Expect: 100-continue 的请求，未登录时在上传请求体之前就回 401
+    bool acceptHeaders(const muduo::net::TcpConnectionPtr&,
+                       const http::HttpRequest& req,
+                       http::HttpResponse* resp) override
+    {
+        return auth::AuthMiddleware::checkHeaders(req, resp, sessionManager_);
+    }
+
     void handle(const muduo::net::TcpConnectionPtr&,
                 const http::HttpRequest& req,
                 http::HttpResponse* resp) override
@@ -32,7 +46,7 @@ public:
         if (!auth::AuthMiddleware::check(req, resp, sessionManager_, userId))
             return;
 
-        if (req.method() == http::HttpRequest::kGet)
+        if (req.method() == http::HttpRequest::kGet || req.method() == http::HttpRequest::kHead)
         {
             auto convs = dao::ConversationDao::listByUser(userId);
             std::string json = "[";
@@ -51,7 +65,7 @@ public:
         }
         else if (req.method() == http::HttpRequest::kPost)
         {
-            std::string body = req.getBody();
+            std::string body(req.getBody());
             std::string title = extractField(body, "title");
             if (title.empty()) title = "New Chat";
 
@@ -112,6 +126,20 @@ public:
         : sessionManager_(sm)
     {}
 
+    // 读写 MySQL，放到工作线程池执行
+    bool offload() const override { return true; }
+
+    // 不用 conn，io_uring 后端上直接处理
+    bool needsConnection() const override { return false; }
+
+    // 带 Expect: 100-continue 的请求，未登录时在上传请求体之前就回 401
+    bool acceptHeaders(const muduo::net::TcpConnectionPtr&,
+                       const http::HttpRequest& req,
+                       http::HttpResponse* resp) override
+    {
+        return auth::AuthMiddleware::checkHeaders(req, resp, sessionManager_);
+    }
+
     void handle(const muduo::net::TcpConnectionPtr&,
                 const http::HttpRequest& req,
                 http::HttpResponse* resp) override
@@ -122,7 +150,7 @@ public:
         if (!auth::AuthMiddleware::check(req, resp, sessionManager_, userId))
             return;
 
-        std::string idStr = req.getPathParameters("param1");
+        std::string idStr(req.getPathParameters("param1"));
         if (idStr.empty())
         {
             resp->setStatusCode(http::HttpResponse::k400BadRequest);
@@ -139,7 +167,7 @@ public:
         }
         else if (req.method() == http::HttpRequest::kPut)
         {
-            std::string body = req.getBody();
+            std::string body(req.getBody());
             std::string title = extractField(body, "title");
             if (title.empty())
             {
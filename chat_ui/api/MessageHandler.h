@@ -3,9 +3,10 @@
 #include <string>
 #include <vector>
 
+#include "../include/coro/CoroutineHandler.h"
 #include "../include/http/HttpRequest.h"
 #include "../include/http/HttpResponse.h"
-#include "../include/router/RouterHandler.h"
+#include "../include/http/WorkerPool.h"
 #include "../include/session/SessionManager.h"
 #include "../auth/AuthMiddleware.h"
 #include "../dao/ConversationDao.h"
@@ -15,42 +16,53 @@ namespace api
 {
 
 // GET /api/conversations/:id/messages
-class MessageHandler : public http::router::RouterHandler
+// 协程 handler：Redis 会话和 MySQL 查询在工作线程里执行，等待期间 I/O 线程继续服务其他连接
+class MessageHandler : public http::coro::CoroutineHandler
 {
 public:
-    explicit MessageHandler(http::session::SessionManager* sm)
+    MessageHandler(http::session::SessionManager* sm, http::WorkerPool* pool)
         : sessionManager_(sm)
+        , pool_(pool)
     {}
 
-    void handle(const muduo::net::TcpConnectionPtr&,
-                const http::HttpRequest& req,
-                http::HttpResponse* resp) override
+protected:
+    http::coro::Task<> handleAsync(muduo::net::TcpConnectionPtr,
+                                   const http::HttpRequest& req,
+                                   http::HttpResponse* resp) override
     {
         resp->setContentType("application/json");
 
+        // 工作线程执行期间协程挂起，req、resp 不会被 I/O 线程同时访问
         int64_t userId = 0;
-        if (!auth::AuthMiddleware::check(req, resp, sessionManager_, userId))
-            return;
+        bool authed = co_await http::coro::runBlocking(pool_, [&]() {
+            return auth::AuthMiddleware::check(req, resp, sessionManager_, userId);
+        });
+        if (!authed)
+            co_return;
 
-        std::string idStr = req.getPathParameters("param1");
+        std::string idStr(req.getPathParameters("param1"));
         if (idStr.empty())
         {
             resp->setStatusCode(http::HttpResponse::k400BadRequest);
             resp->setBody(R"({"error":"missing conversation id"})");
-            return;
+            co_return;
         }
         int64_t convId = std::stoll(idStr);
 
         // 校验会话归属
-        auto conv = dao::ConversationDao::findById(convId, userId);
+        auto conv = co_await http::coro::runBlocking(pool_, [convId, userId]() {
+            return dao::ConversationDao::findById(convId, userId);
+        });
         if (conv.id == 0)
         {
             resp->setStatusCode(http::HttpResponse::k404NotFound);
             resp->setBody(R"({"error":"conversation not found"})");
-            return;
+            co_return;
         }
 
-        auto messages = dao::MessageDao::listByConversation(convId);
+        auto messages = co_await http::coro::runBlocking(pool_, [convId]() {
+            return dao::MessageDao::listByConversation(convId);
+        });
         std::string json = "[";
         for (size_t i = 0; i < messages.size(); ++i)
         {
@@ -86,6 +98,7 @@ private:
     }
 
     http::session::SessionManager* sessionManager_;
+    http::WorkerPool*              pool_;
 };
 
 } // namespace api
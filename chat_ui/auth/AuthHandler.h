@@ -20,13 +20,19 @@ public:
         : sessionManager_(sm)
     {}
 
+    // 访问 MySQL / Redis 会话存储，放到工作线程池执行
+    bool offload() const override { return true; }
+
+    // 不用 conn，io_uring 后端上直接处理
+    bool needsConnection() const override { return false; }
+
     void handle(const muduo::net::TcpConnectionPtr&,
                 const http::HttpRequest& req,
                 http::HttpResponse* resp) override
     {
         resp->setContentType("application/json");
 
-        std::string body = req.getBody();
+        std::string body(req.getBody());
         std::string username = extractField(body, "username");
         std::string password = extractField(body, "password");
 
@@ -107,13 +113,19 @@ public:
         : sessionManager_(sm)
     {}
 
+    // 访问 MySQL / Redis 会话存储，放到工作线程池执行
+    bool offload() const override { return true; }
+
+    // 不用 conn，io_uring 后端上直接处理
+    bool needsConnection() const override { return false; }
+
     void handle(const muduo::net::TcpConnectionPtr&,
                 const http::HttpRequest& req,
                 http::HttpResponse* resp) override
     {
         resp->setContentType("application/json");
 
-        std::string body = req.getBody();
+        std::string body(req.getBody());
         std::string username = extractField(body, "username");
         std::string password = extractField(body, "password");
 
@@ -179,6 +191,12 @@ public:
         : sessionManager_(sm)
     {}
 
+    // 访问 MySQL / Redis 会话存储，放到工作线程池执行
+    bool offload() const override { return true; }
+
+    // 不用 conn，io_uring 后端上直接处理
+    bool needsConnection() const override { return false; }
+
     void handle(const muduo::net::TcpConnectionPtr&,
                 const http::HttpRequest& req,
                 http::HttpResponse* resp) override
@@ -45,6 +45,23 @@ public:
         return true;
     }
 
+    // 只看请求头的登录检查（用于 100-continue 之前），不会创建新会话
+    // 失败返回 false，并设置 401 响应
+    static bool checkHeaders(const http::HttpRequest& req,
+                             http::HttpResponse* resp,
+                             http::session::SessionManager* sm)
+    {
+        auto session = sm ? sm->findSession(req) : nullptr;
+        if (!session || session->getValue("user_id").empty())
+        {
+            resp->setStatusLine("HTTP/1.1", http::HttpResponse::k401Unauthorized, "Unauthorized");
+            resp->setContentType("application/json");
+            resp->setBody(R"({"error":"not logged in"})");
+            return false;
+        }
+        return true;
+    }
+
     // 简化版：只返回 userId，0 表示未登录（不自动写响应）
     static int64_t getUserId(const http::HttpRequest& req,
                              http::HttpResponse* resp,
@@ -8,15 +8,18 @@
  * - SSE 流式推送 + 多模型工厂 (策略模式 + 注册式工厂)
  */
 
+#include <unistd.h>
+
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
 #include <string>
 #include <cstdlib>
 
 #include "http/HttpServer.h"
 #include "http/HttpRequest.h"
 #include "http/HttpResponse.h"
+#include "middleware/compression/CompressionMiddleware.h"
+#include "middleware/etag/EtagMiddleware.h"
 #include "session/SessionManager.h"
 #include "session/SessionStorage.h"
 #include "session/RedisSessionStorage.h"
@@ -38,21 +41,14 @@
 #include "mcp/BuiltinTools.h"
 
 // ─── 静态资源 ────────────────────────────────────────────────
-static std::string g_htmlPage;
-
-static std::string loadFile(const std::string& path)
-{
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) return "";
-    std::ostringstream oss;
-    oss << ifs.rdbuf();
-    return oss.str();
-}
-
-static bool loadHtml(const std::string& base)
+// 页面由 HttpServer::serveFile 提供（带 ETag / 304），找不到文件时用内置的提示页
+static std::string findHtml()
 {
-    g_htmlPage = loadFile(base + "chat_ui.html");
-    return !g_htmlPage.empty();
+    for (const char* path : {"./chat_ui.html", "../chat_ui/chat_ui.html"})
+    {
+        if (::access(path, R_OK) == 0) return path;
+    }
+    return "";
 }
 
 static std::string getEnv(const char* name, const std::string& defaultVal = "")
@@ -64,21 +60,12 @@ static std::string getEnv(const char* name, const std::string& defaultVal = "")
 // ─── 主函数 ──────────────────────────────────────────────────
 int main(int argc, char* argv[])
 {
+    // 数据库连接池等会创建线程，信号要在那之前屏蔽，之后由服务器的 signalfd 统一处理
+    http::HttpServer::blockSignals();
+
     int port = 8080;
     if (argc > 1) port = std::atoi(argv[1]);
 
-    // ─── 加载静态资源 ────────────────────────────────────
-    if (!loadHtml("./") && !loadHtml("../chat_ui/"))
-    {
-        g_htmlPage = R"(<!DOCTYPE html>
-<html><head><meta charset="UTF-8"><title>Chat</title>
-<style>body{background:#0e0e10;color:#e8e8ed;display:flex;align-items:center;
-justify-content:center;height:100vh;font-family:sans-serif;}</style>
-</head><body><div style="text-align:center">
-<h2>Chat UI</h2><p>chat_ui.html not found</p>
-</div></body></html>)";
-    }
-
     // ─── 数据库初始化 ────────────────────────────────────
     std::string dbHost = getEnv("DB_HOST", "localhost");
     std::string dbUser = getEnv("DB_USER", "root");
@@ -145,8 +132,63 @@ justify-content:center;height:100vh;font-family:sans-serif;}</style>
     mcp::registerBuiltinTools();
 
     // ─── 创建 HTTP Server ────────────────────────────────
-    http::HttpServer server(port, "ChatServer");
-    server.setThreadNum(4);
+    // HTTP_ACCEPTORS > 1 时用 SO_REUSEPORT 开多个监听 socket，每个 acceptor 线程处理自己的连接，
+    // 适合大量短连接；HTTP_ACCEPT_STEER_CPU=1 时按 CPU 分配连接
+    int acceptors = std::atoi(getEnv("HTTP_ACCEPTORS", "0").c_str());
+    // HTTP_BACKEND=uring 时 accept/recv/send 走 io_uring，每个 I/O 线程一个监听 socket；
+    // 需要以 HTTP_WITH_IO_URING 编译，否则以及内核不支持、启用 HTTPS 时退回 epoll
+    bool uring = getEnv("HTTP_BACKEND") == "uring";
+    // SIGUSR2 热升级时新旧进程同时监听同一端口，需要 SO_REUSEPORT（HTTP_REUSEPORT=1、多 acceptor 或 io_uring）
+    bool reusePort = acceptors > 1 || uring || getEnv("HTTP_REUSEPORT") == "1";
+    // 同时设置 HTTPS_CERT 和 HTTPS_KEY（PEM 文件）时以 HTTPS 提供服务
+    std::string certFile = getEnv("HTTPS_CERT");
+    std::string keyFile  = getEnv("HTTPS_KEY");
+    bool useSSL = !certFile.empty() && !keyFile.empty();
+    http::HttpServer server(port, "ChatServer", useSSL,
+                            reusePort ? muduo::net::TcpServer::kReusePort
+                                      : muduo::net::TcpServer::kNoReusePort);
+    // I/O 线程数按可用的物理核数，各自绑核；数据库、LLM、工具调用的线程可以各划一组 CPU，
+    // 如 HTTP_CPU_LAYOUT="db=2 llm=4 tools=1"（环境变量优先，其次 config.json 的 "cpu_layout"）
+    http::CpuLayout& cpuLayout = http::CpuLayout::instance();
+    if (!cpuLayout.configure(getEnv("HTTP_CPU_LAYOUT", aiConfig.cpuLayout())))
+    {
+        return 1;
+    }
+    std::cout << "[CPU] " << cpuLayout.describe() << "\n";
+    server.setThreadPlacement(cpuLayout);
+    // HTTP2=1 时启用 HTTP/2（HTTPS 上经 ALPN 协商，HTTP 上支持 h2c），需要以 HTTP_WITH_NGHTTP2 编译；
+    // 同一条连接上的多个 SSE 流不再受浏览器每个域名 6 条连接的限制
+    server.enableHttp2(getEnv("HTTP2") == "1");
+    if (useSSL)
+    {
+        ssl::SslConfig sslConfig;
+        sslConfig.setCertificateFile(certFile);
+        sslConfig.setPrivateKeyFile(keyFile);
+        server.setSslConfig(sslConfig);
+    }
+    if (uring)
+    {
+        server.setBackend(http::HttpServer::kUring);
+    }
+    if (acceptors > 1)
+    {
+        server.setReusePortAcceptors(acceptors, getEnv("HTTP_ACCEPT_STEER_CPU") == "1");
+    }
+    // 查库的 handler 在工作线程里执行，线程数和连接池一致，多了也只是等连接
+    server.setWorkerThreadNum(dbPoolSize);
+    if (server.workerPool())
+    {
+        server.workerPool()->setThreadInitCallback([&cpuLayout]() { cpuLayout.pinCurrentThread("db"); });
+    }
+
+    // 准入控制：连接数默认按 fd 上限；事件循环被拖慢 200ms 以上时新请求直接回 503，不再排队
+    http::AdmissionLimits admission;
+    admission.maxConnections      = std::atoi(getEnv("HTTP_MAX_CONNECTIONS", "0").c_str());
+    admission.maxConnectionsPerIp = std::atoi(getEnv("HTTP_MAX_CONNECTIONS_PER_IP", "0").c_str());
+    admission.maxInflightRequests = std::atoi(getEnv("HTTP_MAX_INFLIGHT", "0").c_str());
+    admission.maxLoopLagMs        = std::atoi(getEnv("HTTP_MAX_LOOP_LAG_MS", "200").c_str());
+    admission.maxWorkerQueue      = std::atoi(getEnv("HTTP_MAX_WORKER_QUEUE", "0").c_str());
+    server.setAdmissionLimits(admission);
 
     // ─── Session 管理器 ──────────────────────────────────
     std::string redisUri = getEnv("REDIS_URI", "tcp://127.0.0.1:6379");
@@ -160,14 +202,39 @@ justify-content:center;height:100vh;font-family:sans-serif;}</style>
     // 单机部署时注释掉此行即可退回本地模式
     http::sse::SseManager::instance().initRedis(redisUri);
 
+    // ─── 响应压缩 ────────────────────────────────────────
+    // 首页和消息历史都是大段文本；流式的 /api/chat/stream 不经过压缩
+    server.addMiddleware(std::make_shared<http::middleware::CompressionMiddleware>());
+
+    // ─── 会话列表、消息历史的 ETag ───────────────────────
+    // 前端切换会话时反复拉取，内容没变就回 304；要在压缩之后注册，先算 ETag 再压缩
+    http::middleware::EtagConfig etagConfig;
+    etagConfig.paths = {"/api/conversations"};
+    server.addMiddleware(std::make_shared<http::middleware::EtagMiddleware>(etagConfig));
+
     // ─── 路由注册 ────────────────────────────────────────
 
     // 首页
-    server.Get("/", [](const http::HttpRequest&, http::HttpResponse* resp) {
-        resp->setStatusCode(http::HttpResponse::k200Ok);
-        resp->setContentType("text/html; charset=utf-8");
-        resp->setBody(g_htmlPage);
-    });
+    std::string htmlPath = findHtml();
+    if (!htmlPath.empty())
+    {
+        server.serveFile("/", htmlPath);
+    }
+    else
+    {
+        static const auto notFoundPage = std::make_shared<const std::string>(R"(<!DOCTYPE html>
+<html><head><meta charset="UTF-8"><title>Chat</title>
+<style>body{background:#0e0e10;color:#e8e8ed;display:flex;align-items:center;
+justify-content:center;height:100vh;font-family:sans-serif;}</style>
+</head><body><div style="text-align:center">
+<h2>Chat UI</h2><p>chat_ui.html not found</p>
+</div></body></html>)");
+        server.Get("/", [](const http::HttpRequest&, http::HttpResponse* resp) {
+            resp->setStatusCode(http::HttpResponse::k200Ok);
+            resp->setContentType("text/html; charset=utf-8");
+            resp->setBody(notFoundPage);
+        });
+    }
 
     // 健康检查（新增返回可用模型列表）
     server.Get("/api/health", [](const http::HttpRequest&, http::HttpResponse* resp) {
@@ -186,8 +253,8 @@ justify-content:center;height:100vh;font-family:sans-serif;}</style>
         resp->setBody(R"({"status":"ok","models":)" + modelsJson + "}");
     });
 
-    // Session 检查接口（不变）
-    server.Get("/api/auth/me", [sm](const http::HttpRequest& req, http::HttpResponse* resp) {
+    // Session 检查接口（查 Redis 会话，放到工作线程池执行）
+    server.Get("/api/auth/me", http::HttpServer::offloaded([sm](const http::HttpRequest& req, http::HttpResponse* resp) {
         resp->setContentType("application/json");
 
         int64_t userId = 0;
@@ -201,7 +268,7 @@ justify-content:center;height:100vh;font-family:sans-serif;}</style>
 
         resp->setStatusCode(http::HttpResponse::k200Ok);
         resp->setBody(R"({"ok":true,"username":")" + username + R"("})");
-    });
+    }));
 
     // 认证路由（不变）
     server.Post("/api/auth/register", std::make_shared<auth::RegisterHandler>(sm));
@@ -220,7 +287,7 @@ justify-content:center;height:100vh;font-family:sans-serif;}</style>
     server.addRoute(http::HttpRequest::kDelete,
                     "/api/conversations/:id", convDetailHandler);
 
-    auto msgHandler = std::make_shared<api::MessageHandler>(sm);
+    auto msgHandler = std::make_shared<api::MessageHandler>(sm, server.workerPool());
     server.addRoute(http::HttpRequest::kGet,
                     "/api/conversations/:id/messages", msgHandler);
 
@@ -230,6 +297,9 @@ justify-content:center;height:100vh;font-family:sans-serif;}</style>
     server.Post("/api/chat/stream", chatHandler);
 
     // ─── 启动 ────────────────────────────────────────────
+    // SIGTERM/SIGINT：停止 accept，等在途请求和 SSE 流结束（最多 HTTP_DRAIN_TIMEOUT 秒）后退出；
+    // SIGUSR2：启动新版本进程，它开始监听后本进程按同样方式退出
+    server.handleSignals(std::atof(getEnv("HTTP_DRAIN_TIMEOUT", "30").c_str()));
     server.start();
 
     return 0;
@@ -6,6 +6,7 @@
 #include <thread>
 #include <unordered_map>
 
+#include "../include/http/CpuLayout.h"
 #include "../include/http/HttpRequest.h"
 #include "../include/http/HttpResponse.h"
 #include "../include/router/RouterHandler.h"
@@ -64,7 +65,7 @@ public:
             return;
         }
 
-        std::string body = req.getBody();
+        std::string body(req.getBody());
         if (body.empty())
         {
             resp->setStatusCode(HttpResponse::k400BadRequest);
@@ -145,10 +146,11 @@ public:
             return;
         }
 
-        conn->send(buildSseHandshake());
+        // 握手头由 HttpServer 在 handler 返回后发出，这之前推送的事件先缓存在流里
+        auto stream = startSseStream(conn, req, resp);
 
         std::string userIdStr = userId > 0 ? std::to_string(userId) : "";
-        std::string connId = SseManager::instance().addConnection(conn, userIdStr);
+        std::string connId = SseManager::instance().addConnection(stream, userIdStr);
         auto sseConn = SseManager::instance().getConnection(connId);
         if (!sseConn) return;
 
@@ -212,9 +214,8 @@ public:
             sseConn->send(
                 R"({"error":"unknown model: )" + modelKey + R"("})",
                 "error");
+            sseConn->close();
             SseManager::instance().removeConnection(connId);
-            resp->setStatusCode(HttpResponse::k200Ok);
-            resp->markAsSseUpgraded();
             return;
         }
 
@@ -259,7 +260,10 @@ public:
             if (!capturedUserIdStr.empty())
                 SseManager::instance().publishToUser(capturedUserIdStr, data, connId);
             else if (sseConn && !sseConn->isClosed())
+            {
                 sseConn->send(data, "error");
+                sseConn->close();
+            }
             SseManager::instance().removeConnection(connId);
         };
 
@@ -274,6 +278,7 @@ public:
             auto agentPtr = std::make_shared<mcp::MCPAgent>(3); // 最多 3 轮工具调用
             std::thread([agentPtr, strategyPtr, messages, onToken, onDone, onError,
                          sseConn, capturedUserIdStr, connId]() {
+                http::CpuLayout::instance().pinCurrentThread("tools");
                 agentPtr->chat(
                     strategyPtr.get(),
                     messages,
@@ -294,9 +299,6 @@ public:
                 );
             }).detach();
         }
-
-        resp->setStatusCode(HttpResponse::k200Ok);
-        resp->markAsSseUpgraded();
     }
 
 private:
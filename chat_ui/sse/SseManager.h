@@ -10,6 +10,9 @@
 #include <muduo/net/TcpConnection.h>
 #include <muduo/base/Logging.h>
 
+#include "../include/http/HttpRequest.h"
+#include "../include/http/HttpResponse.h"
+#include "../include/http/ResponseStream.h"
 #include "RedisPubSub.h"
 
 namespace http
@@ -17,71 +20,46 @@ namespace http
 namespace sse
 {
 
+// 一个 SSE 客户端。帧格式、跨线程投递和背压都由 ResponseStream 负责
 class SseConnection
 {
 public:
-    explicit SseConnection(const muduo::net::TcpConnectionPtr& conn)
-        : conn_(conn)
-        , closed_(false)
+    explicit SseConnection(std::shared_ptr<ResponseStream> stream)
+        : stream_(std::move(stream))
     {}
 
-    // 发送 SSE 数据帧（线程安全：通过 runInLoop 投递到 I/O 线程）
-    void send(const std::string& data, const std::string& event = "")
+    // 发送 SSE 数据帧（线程安全）；返回 false 表示对端读得慢，调用方可以暂缓推送
+    bool send(const std::string& data, const std::string& event = "")
     {
-        if (closed_ || !conn_->connected())
-        {
-            closed_ = true;
-            return;
-        }
-
-        std::string frame;
-        if (!event.empty())
-            frame += "event: " + event + "\n";
-        frame += "data: " + data + "\n\n";
-
-        auto conn = conn_;
-        conn_->getLoop()->runInLoop([conn, frame = std::move(frame)]() {
-            if (conn->connected()) conn->send(frame);
-        });
+        return stream_->sendEvent(data, event);
     }
 
-    // 发送结束帧
+    // 发送结束帧，并结束这次响应（连接回到 keep-alive）
     void sendDone()
     {
-        if (closed_ || !conn_->connected()) { closed_ = true; return; }
-        auto conn = conn_;
-        conn_->getLoop()->runInLoop([conn]() {
-            if (conn->connected()) conn->send("data: [DONE]\n\n");
-        });
-        closed_ = true;
+        stream_->sendEvent("[DONE]");
+        stream_->finish();
     }
 
     // 发送心跳（防止连接超时）
     void sendHeartbeat()
     {
-        if (closed_ || !conn_->connected()) return;
-        auto conn = conn_;
-        conn_->getLoop()->runInLoop([conn]() {
-            if (conn->connected()) conn->send(": heartbeat\n\n");
-        });
+        stream_->sendComment("heartbeat");
     }
 
-    bool isClosed() const { return closed_ || !conn_->connected(); }
+    bool isClosed() const { return stream_->closed(); }
+
+    muduo::net::TcpConnectionPtr getConn() const { return stream_->connection(); }
 
-    muduo::net::TcpConnectionPtr getConn() const { return conn_; }
+    const std::shared_ptr<ResponseStream>& stream() const { return stream_; }
 
     void close()
     {
-        closed_ = true;
-        if (conn_->connected())
-        {
-            conn_->shutdown();
-        }
+        stream_->finish();
     }
 
 private:
-    muduo::net::TcpConnectionPtr conn_;
-    bool                         closed_;
+    std::shared_ptr<ResponseStream> stream_;
 };
 
 
@@ -107,12 +85,17 @@ public:
     }
 
     // 注册新 SSE 连接；userId 非空时订阅对应 Redis channel
-    ConnectionId addConnection(const muduo::net::TcpConnectionPtr& conn,
+    ConnectionId addConnection(const std::shared_ptr<ResponseStream>& stream,
                                const std::string& userId = "")
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto sseConn = std::make_shared<SseConnection>(conn);
-        std::string id = conn->name();
+        auto sseConn = std::make_shared<SseConnection>(stream);
+        // HTTP/2 的多个 SSE 流共用一条连接，再加上流 id 区分
+        std::string id = stream->connection()->name();
+        if (stream->streamId() > 0)
+        {
+            id += "#" + std::to_string(stream->streamId());
+        }
         connections_[id] = sseConn;
 
         if (!userId.empty() && pubsub_)
@@ -194,21 +177,20 @@ private:
 
 
 /**
- * 辅助函数：向 HttpResponse 写入 SSE 握手头（HTTP 200 + SSE headers）
- * 调用此函数后，连接保持打开，后续通过 SseConnection::send() 推送数据
+ * 辅助函数：把 resp 设置为 SSE 响应（HTTP 200 + SSE headers），返回对应的流。
+ * 头部由 HttpServer 在 handler 返回后发出，后续通过 SseConnection::send() 推送数据
  */
-inline std::string buildSseHandshake()
+inline std::shared_ptr<ResponseStream> startSseStream(const muduo::net::TcpConnectionPtr& conn,
+                                                      const HttpRequest& req,
+                                                      HttpResponse* resp)
 {
-    std::string resp;
-    resp += "HTTP/1.1 200 OK\r\n";
-    resp += "Content-Type: text/event-stream\r\n";
-    resp += "Cache-Control: no-cache\r\n";
-    resp += "Connection: keep-alive\r\n";
-    resp += "Access-Control-Allow-Origin: *\r\n";
-    resp += "Access-Control-Allow-Headers: Content-Type\r\n";
-    resp += "X-Accel-Buffering: no\r\n";  // 关闭 nginx 缓冲
-    resp += "\r\n";                          // 头部结束
-    return resp;
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setContentType("text/event-stream");
+    resp->addHeader("Cache-Control", "no-cache");
+    resp->addHeader("Access-Control-Allow-Origin", "*");
+    resp->addHeader("Access-Control-Allow-Headers", "Content-Type");
+    resp->addHeader("X-Accel-Buffering", "no");  // 关闭 nginx 缓冲
+    return ResponseStream::start(conn, req, resp);
 }
 
 } // namespace sse